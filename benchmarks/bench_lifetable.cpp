@@ -0,0 +1,757 @@
+//
+// Speed of the lifetable kernels across age schemas, population counts,
+// interval widths, and precision.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "fundem/adjoint.hpp"
+#include "fundem/decrement.hpp"
+#include "fundem/expansion.hpp"
+#include "fundem/fit.hpp"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/hazards.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/projection.hpp"
+#include "fundem/ragged.hpp"
+#include "fundem/scenario.hpp"
+#include "fundem/schema.hpp"
+
+using namespace fundem;
+
+
+namespace {
+
+const int64_t kAgeCounts[] = {20, 23, 96, 111};
+const int64_t kPopulationCounts[] = {1, 100, 10000, 1000000};
+
+
+// A million populations of 111 ages is close to a gigabyte per array,
+// so FUNDEM_BENCH_MAX_POPULATIONS can cap the grid on smaller machines.
+int64_t MaxPopulations()
+{
+    const char* limit = std::getenv("FUNDEM_BENCH_MAX_POPULATIONS");
+    return (nullptr != limit) ? std::atoll(limit) : kPopulationCounts[3];
+}
+
+
+// Arguments are (age_cnt, pop_cnt, mixed), where mixed nx splits the
+// first year into neonatal intervals, as the GBD age groups do.
+void Grid(benchmark::internal::Benchmark* bench, bool mixed_allowed)
+{
+    bench->ArgNames({"ages", "pops", "mixed"});
+    for (auto age_cnt: kAgeCounts) {
+        for (auto pop_cnt: kPopulationCounts) {
+            if (pop_cnt > MaxPopulations()) {
+                continue;
+            }
+            bench->Args({age_cnt, pop_cnt, 0});
+            if (mixed_allowed) {
+                bench->Args({age_cnt, pop_cnt, 1});
+            }
+        }
+    }
+}
+
+
+void UniformAndMixed(benchmark::internal::Benchmark* bench) { Grid(bench, true); }
+// Preston's graduation needs equal intervals.
+void UniformOnly(benchmark::internal::Benchmark* bench) { Grid(bench, false); }
+
+
+// Five-year groups only, for kernels that convert them to single years.
+void FiveYearOnly(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgNames({"ages", "pops", "mixed"});
+    for (auto pop_cnt: kPopulationCounts) {
+        if (pop_cnt <= MaxPopulations()) {
+            bench->Args({kAgeCounts[0], pop_cnt, 0});
+        }
+    }
+}
+
+
+/*! Siler mortality for every population, with constant-mortality ax.
+ *  Short schemas use five-year intervals and long ones single years.
+ */
+template<typename REAL>
+struct Inputs {
+    explicit Inputs(const benchmark::State& state)
+        : age_cnt(static_cast<int>(state.range(0))),
+          pop_cnt(static_cast<size_t>(state.range(1))),
+          nx(age_cnt), mx(age_cnt * pop_cnt), ax(age_cnt * pop_cnt),
+          out(age_cnt * pop_cnt), out2(age_cnt * pop_cnt)
+    {
+        const REAL width = (age_cnt > 50) ? 1 : 5;
+        std::fill(nx.begin(), nx.end(), width);
+        if (state.range(2)) {
+            nx[0] = REAL(7) / 365;
+            nx[1] = REAL(28) / 365;
+            nx[2] = REAL(365 - 7 - 28) / 365;
+            nx[3] = (width > 1) ? width - 1 : width;
+        }
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            REAL x = 0;
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                mx[pop_idx * age_cnt + age_idx] = siler_default<REAL>(
+                        x + nx[age_idx] / 2, REAL(pop_idx % 100));
+                x += nx[age_idx];
+            }
+        }
+        ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt);
+    }
+
+    int age_cnt;
+    size_t pop_cnt;
+    std::vector<REAL> nx;
+    std::vector<REAL> mx;
+    std::vector<REAL> ax;
+    std::vector<REAL> out;
+    std::vector<REAL> out2;
+};
+
+
+// Populations per second, and bytes per second for the arrays that
+// are read or written, counting each once.
+template<typename REAL>
+void Report(benchmark::State& state, const Inputs<REAL>& inputs, int array_cnt)
+{
+    state.counters["pops_per_second"] = benchmark::Counter(
+            static_cast<double>(inputs.pop_cnt), benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(
+            inputs.pop_cnt * inputs.age_cnt * sizeof(REAL) * array_cnt));
+}
+
+}
+
+
+template<typename REAL>
+void BM_FirstMomentSurvival(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        FirstMomentSurvival(&in.mx[0], &in.ax[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 3);
+}
+BENCHMARK_TEMPLATE(BM_FirstMomentSurvival, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_FirstMomentSurvival, float)->Apply(UniformAndMixed);
+
+
+template<typename REAL>
+void BM_FirstMomentPopulation(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        FirstMomentPopulation(&in.mx[0], &in.ax[0], &in.nx[0], &in.out[0], &in.out2[0],
+                in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 4);
+}
+BENCHMARK_TEMPLATE(BM_FirstMomentPopulation, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_FirstMomentPopulation, float)->Apply(UniformAndMixed);
+
+
+template<typename REAL>
+void BM_FirstMomentPeriodLifeExpectancy(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        FirstMomentPeriodLifeExpectancy(&in.mx[0], &in.ax[0], &in.nx[0], &in.out[0],
+                in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 3);
+}
+BENCHMARK_TEMPLATE(BM_FirstMomentPeriodLifeExpectancy, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_FirstMomentPeriodLifeExpectancy, float)->Apply(UniformAndMixed);
+
+
+template<typename REAL>
+void BM_ConstantMortalityMeanAge(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        ConstantMortalityMeanAge(&in.mx[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 2);
+}
+BENCHMARK_TEMPLATE(BM_ConstantMortalityMeanAge, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_ConstantMortalityMeanAge, float)->Apply(UniformAndMixed);
+
+
+template<typename REAL>
+void BM_ConstantMortalityMeanAgeVectorized(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        ConstantMortalityMeanAgeVectorized(&in.mx[0], &in.nx[0], &in.out[0],
+                in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 2);
+}
+BENCHMARK_TEMPLATE(BM_ConstantMortalityMeanAgeVectorized, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_ConstantMortalityMeanAgeVectorized, float)->Apply(UniformAndMixed);
+
+
+template<typename REAL>
+void BM_GraduationMethod(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        GraduationMethod(&in.mx[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 2);
+}
+BENCHMARK_TEMPLATE(BM_GraduationMethod, double)->Apply(UniformOnly);
+BENCHMARK_TEMPLATE(BM_GraduationMethod, float)->Apply(UniformOnly);
+
+
+template<typename REAL>
+void BM_GraduationMethodSteffen(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        GraduationMethodSteffen(&in.mx[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 2);
+}
+BENCHMARK_TEMPLATE(BM_GraduationMethodSteffen, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_GraduationMethodSteffen, float)->Apply(UniformAndMixed);
+
+
+// The same, with a workspace that lives across calls, as a loop over
+// small batches would keep one.
+template<typename REAL>
+void BM_GraduationMethodSteffenWorkspace(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    LifeTableWorkspace<REAL> workspace(in.age_cnt);
+    for (auto _: state) {
+        GraduationMethodSteffen(&in.mx[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt,
+                workspace);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 2);
+}
+BENCHMARK_TEMPLATE(BM_GraduationMethodSteffenWorkspace, double)->Apply(UniformAndMixed);
+
+
+// Graduation with a monitor, against `NullGraduationMonitor`, which
+// should cost nothing. Arguments are (ages, pops, mixed, monitor),
+// where monitor 1 records iterations, difference, and outcome, and 2
+// also times each population.
+void MonitorGrid(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgNames({"ages", "pops", "mixed", "monitor"});
+    const int64_t pop_cnt = std::min(kPopulationCounts[2], MaxPopulations());
+    for (int64_t age_cnt: {kAgeCounts[0], kAgeCounts[2]}) {
+        for (int64_t monitor = 0; monitor < 3; monitor++) {
+            bench->Args({age_cnt, pop_cnt, 0, monitor});
+        }
+    }
+}
+
+
+template<typename REAL>
+void BM_GraduationMethodMonitored(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    std::vector<int> iterations(in.pop_cnt), outcome(in.pop_cnt);
+    std::vector<double> difference(in.pop_cnt), seconds(in.pop_cnt);
+    GraduationRecorder recorder;
+    recorder.iterations = &iterations[0];
+    recorder.difference = &difference[0];
+    recorder.outcome = &outcome[0];
+    if (2 == state.range(3)) {
+        recorder.seconds = &seconds[0];
+    }
+    LifeTableWorkspace<REAL> workspace(in.age_cnt);
+    for (auto _: state) {
+        if (state.range(3)) {
+            GraduationMethod(&in.mx[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt,
+                    workspace, recorder);
+        } else {
+            GraduationMethod(&in.mx[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt,
+                    workspace, NullGraduationMonitor());
+        }
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 2);
+}
+BENCHMARK_TEMPLATE(BM_GraduationMethodMonitored, double)->Apply(MonitorGrid);
+
+
+// Plain graduation against Anderson mixing, on Siler rates and on
+// rates with the Poisson noise of deaths in a population of a few
+// thousand. Arguments are (ages, steffen, noisy, anderson), iterations
+// counts the mean per population, and unconverged counts populations
+// left with constant-mortality ax.
+void AcceleratedGrid(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgNames({"ages", "steffen", "noisy", "anderson"});
+    for (int64_t age_cnt: {kAgeCounts[0], kAgeCounts[2]}) {
+        for (int64_t steffen = 0; steffen < 2; steffen++) {
+            for (int64_t noisy = 0; noisy < 2; noisy++) {
+                for (int64_t anderson = 0; anderson < 2; anderson++) {
+                    bench->Args({age_cnt, steffen, noisy, anderson});
+                }
+            }
+        }
+    }
+}
+
+
+template<typename REAL>
+void BM_GraduationAccelerated(benchmark::State& state)
+{
+    const int age_cnt = static_cast<int>(state.range(0));
+    const size_t pop_cnt = 10000;
+    const REAL width = (age_cnt > 50) ? 1 : 5;
+    std::vector<REAL> nx(age_cnt, width), mx(age_cnt * pop_cnt), ax(mx.size());
+    std::mt19937_64 rng(pop_cnt);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const REAL rate = siler_default<REAL>(width * (age_idx + REAL(0.5)),
+                    REAL(pop_idx % 100));
+            const double exposure = 2000 * width * std::exp(-0.02 * width * age_idx);
+            std::poisson_distribution<int> deaths(rate * exposure);
+            mx[pop_idx * age_cnt + age_idx] = state.range(2) ?
+                    REAL(std::max(deaths(rng), 1) / exposure) : rate;
+        }
+    }
+    const auto iteration = state.range(3) ?
+            GraduationIteration::Anderson : GraduationIteration::Plain;
+    std::vector<int> iterations(pop_cnt), outcome(pop_cnt);
+    GraduationRecorder recorder;
+    recorder.iterations = &iterations[0];
+    recorder.outcome = &outcome[0];
+    LifeTableWorkspace<REAL> workspace(age_cnt);
+    for (auto _: state) {
+        if (state.range(1)) {
+            GraduationMethodSteffen(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt, workspace,
+                    recorder, iteration);
+        } else {
+            GraduationMethod(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt, workspace,
+                    recorder, iteration);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.counters["pops_per_second"] = benchmark::Counter(
+            static_cast<double>(pop_cnt), benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["iterations"] = std::accumulate(iterations.begin(), iterations.end(), 0.0) /
+            pop_cnt;
+    state.counters["unconverged"] = static_cast<double>(pop_cnt - std::count(outcome.begin(),
+            outcome.end(), static_cast<int>(GraduationOutcome::Converged)));
+}
+BENCHMARK_TEMPLATE(BM_GraduationAccelerated, double)->Apply(AcceleratedGrid);
+
+
+// The whole gradient of e0 should cost about two evaluations of it.
+template<typename REAL>
+void BM_FirstMomentPeriodLifeExpectancyAdjoint(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        FirstMomentPeriodLifeExpectancyAdjoint(&in.mx[0], &in.ax[0], &in.nx[0],
+                static_cast<REAL*>(nullptr), &in.out[0], &in.out2[0], in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 4);
+}
+BENCHMARK_TEMPLATE(BM_FirstMomentPeriodLifeExpectancyAdjoint, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_FirstMomentPeriodLifeExpectancyAdjoint, float)->Apply(UniformAndMixed);
+
+
+// The columns most pipelines want, lx and ex, from mx and ax.
+template<typename REAL>
+void BM_FullLifeTable(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    LifeTableColumns<REAL> columns;
+    columns.lx = &in.out[0];
+    columns.ex = &in.out2[0];
+    for (auto _: state) {
+        FullLifeTable(&in.mx[0], &in.ax[0], &in.nx[0], columns, in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 4);
+}
+BENCHMARK_TEMPLATE(BM_FullLifeTable, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_FullLifeTable, float)->Apply(UniformAndMixed);
+
+
+// Every population in a ragged batch alternates, ten at a time, between
+// the inputs' schema and a 20-age abridged one, to compare with
+// BM_FullLifeTableDispatch on the same number of values.
+template<typename REAL>
+void BM_FullLifeTableRagged(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    std::vector<REAL> nx(in.nx);
+    nx.resize(in.age_cnt + 20, 5);
+    const std::vector<size_t> nx_offsets{0, size_t(in.age_cnt), nx.size()};
+    std::vector<int> schema(in.pop_cnt);
+    std::vector<size_t> offsets{0};
+    for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+        schema[pop_idx] = (pop_idx / 10) % 2;
+        offsets.push_back(offsets.back() + (schema[pop_idx] ? 20 : in.age_cnt));
+    }
+    RaggedBatch<REAL> batch;
+    batch.offsets = &offsets[0];
+    batch.schema = &schema[0];
+    batch.nx = &nx[0];
+    batch.nx_offsets = &nx_offsets[0];
+    batch.N = in.pop_cnt;
+    batch.schema_cnt = 2;
+    LifeTableColumns<REAL> columns;
+    columns.lx = &in.out[0];
+    columns.ex = &in.out2[0];
+    for (auto _: state) {
+        FullLifeTableRagged(&in.mx[0], &in.ax[0], columns, batch);
+        benchmark::ClobberMemory();
+    }
+    state.counters["pops_per_second"] = benchmark::Counter(
+            static_cast<double>(in.pop_cnt), benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(
+            offsets.back() * sizeof(REAL) * 4));
+}
+BENCHMARK_TEMPLATE(BM_FullLifeTableRagged, double)->Apply(UniformOnly);
+
+
+// The same kernels, specialized for the age schema when it's known.
+template<typename REAL>
+void BM_FirstMomentPopulationDispatch(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        FirstMomentPopulationDispatch(&in.mx[0], &in.ax[0], &in.nx[0], &in.out[0], &in.out2[0],
+                in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 4);
+}
+BENCHMARK_TEMPLATE(BM_FirstMomentPopulationDispatch, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_FirstMomentPopulationDispatch, float)->Apply(UniformAndMixed);
+
+
+template<typename REAL>
+void BM_FullLifeTableDispatch(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    LifeTableColumns<REAL> columns;
+    columns.lx = &in.out[0];
+    columns.ex = &in.out2[0];
+    for (auto _: state) {
+        FullLifeTableDispatch(&in.mx[0], &in.ax[0], &in.nx[0], columns, in.age_cnt, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 4);
+}
+BENCHMARK_TEMPLATE(BM_FullLifeTableDispatch, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_FullLifeTableDispatch, float)->Apply(UniformAndMixed);
+
+
+template<typename REAL>
+void BM_SilerDefault(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    for (auto _: state) {
+        for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+            REAL x = 0;
+            for (int age_idx = 0; age_idx < in.age_cnt; age_idx++) {
+                in.out[pop_idx * in.age_cnt + age_idx] = siler_default<REAL>(
+                        x + in.nx[age_idx] / 2, REAL(pop_idx % 100));
+                x += in.nx[age_idx];
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 1);
+}
+BENCHMARK_TEMPLATE(BM_SilerDefault, double)->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE(BM_SilerDefault, float)->Apply(UniformAndMixed);
+
+
+// The same Siler curves as BM_SilerDefault, in batches, as midpoint
+// rates and as interval averages.
+template<typename REAL, HazardSample SAMPLE>
+void BM_SilerHazardRates(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    std::vector<REAL> parameters(in.pop_cnt * SilerHazard<REAL>::kParameterCount);
+    for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+        const REAL t = pop_idx % 100;
+        const REAL siler[] = {
+                REAL(0.2 * std::exp(-0.015 * t)), 1, REAL(0.0002 * std::exp(-0.01 * t)),
+                REAL(0.1), REAL(0.003 * std::exp(-0.01 * t))};
+        std::copy(siler, siler + 5, &parameters[pop_idx * 5]);
+    }
+    for (auto _: state) {
+        HazardRates<SilerHazard>(&parameters[0], &in.nx[0], &in.out[0], in.age_cnt, in.pop_cnt,
+                SAMPLE);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 1);
+}
+BENCHMARK_TEMPLATE2(BM_SilerHazardRates, double, HazardSample::Midpoint)
+        ->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE2(BM_SilerHazardRates, double, HazardSample::IntervalAverage)
+        ->Apply(UniformAndMixed);
+BENCHMARK_TEMPLATE2(BM_SilerHazardRates, float, HazardSample::IntervalAverage)
+        ->Apply(UniformAndMixed);
+
+
+// Fits Siler curves to the inputs' midpoint Siler rates from a rough
+// start, each population alone or warm-started in chains of a hundred.
+template<typename REAL, size_t CHAIN>
+void BM_FitSilerHazard(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    const REAL guess[] = {REAL(0.1), REAL(0.5), REAL(1e-4), REAL(0.12), REAL(1e-3)};
+    std::vector<REAL> start(in.pop_cnt * 5);
+    for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+        std::copy(guess, guess + 5, &start[pop_idx * 5]);
+    }
+    std::vector<REAL> parameters(start.size());
+    for (auto _: state) {
+        state.PauseTiming();
+        parameters = start;
+        state.ResumeTiming();
+        FitHazard<SilerHazard>(&in.mx[0], &in.nx[0], &parameters[0], HazardFitRecord(),
+                in.age_cnt, in.pop_cnt, CHAIN);
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, 1);
+}
+BENCHMARK_TEMPLATE2(BM_FitSilerHazard, double, 1)->Apply(UniformOnly);
+BENCHMARK_TEMPLATE2(BM_FitSilerHazard, double, 100)->Apply(UniformOnly);
+
+
+// Scenarios that scale the first population's mortality at the four
+// youngest ages, one scenario for each population. Each reads e0, or,
+// with WRITE, writes lx and ex, to compare with BM_FullLifeTable.
+template<typename REAL, bool WRITE>
+void BM_ScenarioLifeTable(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    ScenarioLifeTable<REAL> table(&in.mx[0], &in.ax[0], &in.nx[0], in.age_cnt);
+    const int ages[] = {0, 1, 2, 3};
+    std::vector<REAL> scenario_mx(in.pop_cnt * 4);
+    for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+        for (int change_idx = 0; change_idx < 4; change_idx++) {
+            scenario_mx[pop_idx * 4 + change_idx] = in.mx[change_idx] *
+                    (1 - REAL(pop_idx % 100) / 200);
+        }
+    }
+    LifeTableColumns<REAL> columns;
+    columns.lx = &in.out[0];
+    columns.ex = &in.out2[0];
+    for (auto _: state) {
+        for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+            table.Apply(ages, &scenario_mx[pop_idx * 4], nullptr, 4);
+            if (WRITE) {
+                table.Write(columns.Offset(pop_idx * in.age_cnt));
+            } else {
+                in.out[pop_idx] = table.LifeExpectancy(0);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    Report(state, in, WRITE ? 2 : 0);
+}
+BENCHMARK_TEMPLATE2(BM_ScenarioLifeTable, double, false)->Apply(UniformOnly);
+BENCHMARK_TEMPLATE2(BM_ScenarioLifeTable, double, true)->Apply(UniformOnly);
+
+
+// Five-year groups to single years, writing lx, dx, and ex for each,
+// with the operator built once. Bytes count the five-year mx and the
+// three single-year columns.
+template<typename REAL, typename ACCUM>
+void BM_ExpandLifeTable(benchmark::State& state)
+{
+    Inputs<REAL> in(state);
+    const int single_cnt = 5 * (in.age_cnt - 1) + 1;
+    const std::vector<REAL> single(single_cnt, 1);
+    ExpansionOperator<REAL> expand(&in.nx[0], in.age_cnt, &single[0], single_cnt);
+    std::vector<REAL> lx(in.pop_cnt * single_cnt), dx(lx.size()), ex(lx.size());
+    LifeTableColumns<REAL> columns;
+    columns.lx = &lx[0];
+    columns.dx = &dx[0];
+    columns.ex = &ex[0];
+    for (auto _: state) {
+        expand.template Apply<ACCUM>(&in.mx[0], &in.ax[0], columns, in.pop_cnt);
+        benchmark::ClobberMemory();
+    }
+    state.counters["pops_per_second"] = benchmark::Counter(
+            static_cast<double>(in.pop_cnt), benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(
+            in.pop_cnt * (in.age_cnt + 3 * single_cnt) * sizeof(REAL)));
+}
+BENCHMARK_TEMPLATE2(BM_ExpandLifeTable, double, double)->Apply(FiveYearOnly);
+BENCHMARK_TEMPLATE2(BM_ExpandLifeTable, float, double)->Apply(FiveYearOnly);
+
+
+// Arguments are (age_cnt, cause_cnt), for a hundred populations whose
+// causes split all-cause mortality in fixed shares.
+void CauseGrid(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgNames({"ages", "causes"});
+    for (int64_t age_cnt: {kAgeCounts[0], kAgeCounts[2]}) {
+        for (int64_t cause_cnt: {20, 300}) {
+            bench->Args({age_cnt, cause_cnt});
+        }
+    }
+}
+
+
+template<typename REAL>
+struct CauseInputs {
+    explicit CauseInputs(const benchmark::State& state)
+        : age_cnt(static_cast<int>(state.range(0))),
+          cause_cnt(static_cast<int>(state.range(1))),
+          nx(age_cnt, (age_cnt > 50) ? 1 : 5), mx(pop_cnt * age_cnt),
+          cause_mx(pop_cnt * cause_cnt * age_cnt), lx(cause_mx.size()), ex(cause_mx.size())
+    {
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                const REAL total = siler_default<REAL>(nx[0] * (age_idx + REAL(0.5)),
+                        REAL(pop_idx));
+                mx[pop_idx * age_cnt + age_idx] = total;
+                for (int cause_idx = 0; cause_idx < cause_cnt; cause_idx++) {
+                    cause_mx[(pop_idx * cause_cnt + cause_idx) * age_cnt + age_idx] =
+                            total / cause_cnt;
+                }
+            }
+        }
+    }
+
+    // Reports cause-deleted tables, each an age row of lx and of ex.
+    void Report(benchmark::State& state) const
+    {
+        state.counters["tables_per_second"] = benchmark::Counter(
+                static_cast<double>(pop_cnt * cause_cnt),
+                benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    static constexpr size_t pop_cnt = 100;
+    int age_cnt;
+    int cause_cnt;
+    std::vector<REAL> nx;
+    std::vector<REAL> mx;
+    std::vector<REAL> cause_mx;
+    std::vector<REAL> lx;
+    std::vector<REAL> ex;
+};
+
+
+// Every cause-deleted lx and ex, sharing the all-cause table.
+template<typename REAL>
+void BM_CauseDeletedLifeTable(benchmark::State& state)
+{
+    CauseInputs<REAL> in(state);
+    DecrementColumns<REAL> columns;
+    columns.deleted_lx = &in.lx[0];
+    columns.deleted_ex = &in.ex[0];
+    DecrementWorkspace<REAL> workspace;
+    for (auto _: state) {
+        CauseDeletedLifeTable(&in.mx[0], static_cast<const REAL*>(nullptr), &in.nx[0],
+                &in.cause_mx[0], columns, in.age_cnt, in.cause_cnt, in.pop_cnt, workspace);
+        benchmark::ClobberMemory();
+    }
+    in.Report(state);
+}
+BENCHMARK_TEMPLATE(BM_CauseDeletedLifeTable, double)->Apply(CauseGrid);
+
+
+// The same, one cause at a time, as constant-mortality ax, then
+// survivorship and life expectancy of mx minus the cause.
+template<typename REAL>
+void BM_CauseDeletedBaseline(benchmark::State& state)
+{
+    CauseInputs<REAL> in(state);
+    std::vector<REAL> deleted(in.age_cnt), deleted_ax(in.age_cnt), dx(in.age_cnt);
+    for (auto _: state) {
+        for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+            for (int cause_idx = 0; cause_idx < in.cause_cnt; cause_idx++) {
+                const size_t row = (pop_idx * in.cause_cnt + cause_idx) * in.age_cnt;
+                for (int age_idx = 0; age_idx < in.age_cnt; age_idx++) {
+                    deleted[age_idx] = in.mx[pop_idx * in.age_cnt + age_idx] -
+                            in.cause_mx[row + age_idx];
+                }
+                ConstantMortalityMeanAge(&deleted[0], &in.nx[0], &deleted_ax[0], in.age_cnt, 1);
+                FirstMomentPopulation(&deleted[0], &deleted_ax[0], &in.nx[0], &in.lx[row],
+                        &dx[0], in.age_cnt, 1);
+                FirstMomentPeriodLifeExpectancy(&deleted[0], &deleted_ax[0], &in.nx[0],
+                        &in.ex[row], in.age_cnt, 1);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    in.Report(state);
+}
+BENCHMARK_TEMPLATE(BM_CauseDeletedBaseline, double)->Apply(CauseGrid);
+
+
+// Arguments are (age_cnt, step_cnt), for a hundred populations in
+// five-year or single-year groups, with fertility and migration.
+void ProjectionGrid(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgNames({"ages", "steps"});
+    for (int64_t age_cnt: {kAgeCounts[0], kAgeCounts[2]}) {
+        for (int64_t step_cnt: {20, 100}) {
+            bench->Args({age_cnt, step_cnt});
+        }
+    }
+}
+
+
+// Projections with LANES populations at a time, so one lane is the
+// population-by-population loop with the same arithmetic.
+template<typename REAL, int LANES>
+void BM_ProjectPopulation(benchmark::State& state)
+{
+    const int age_cnt = static_cast<int>(state.range(0));
+    const int step_cnt = static_cast<int>(state.range(1));
+    const size_t pop_cnt = 100;
+    const size_t value_cnt = pop_cnt * step_cnt * age_cnt;
+    std::vector<REAL> nx(age_cnt, (age_cnt > 50) ? 1 : 5);
+    std::vector<REAL> population(pop_cnt * age_cnt, 1000);
+    std::vector<REAL> mx(value_cnt), fertility(value_cnt), migration(value_cnt);
+    std::vector<REAL> projected(value_cnt), births(pop_cnt * step_cnt);
+    for (size_t row_idx = 0; row_idx < pop_cnt * step_cnt; row_idx++) {
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const REAL age = nx[0] * (age_idx + REAL(0.5));
+            mx[row_idx * age_cnt + age_idx] = siler_default<REAL>(age, REAL(row_idx % 50));
+            fertility[row_idx * age_cnt + age_idx] = (age > 15 && age < 50) ? REAL(0.06) : 0;
+            migration[row_idx * age_cnt + age_idx] = REAL(age < 40 ? 2 : -1);
+        }
+    }
+    ProjectionRates<REAL> rates;
+    rates.mx = &mx[0];
+    rates.fertility = &fertility[0];
+    rates.migration = &migration[0];
+    ProjectionWorkspace<REAL, REAL> workspace;
+    for (auto _: state) {
+        ProjectPopulation<REAL, REAL, LANES>(&population[0], rates, &nx[0], REAL(0.49),
+                &projected[0], &births[0], age_cnt, step_cnt, pop_cnt, workspace);
+        benchmark::ClobberMemory();
+    }
+    state.counters["steps_per_second"] = benchmark::Counter(
+            static_cast<double>(pop_cnt * step_cnt), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE2(BM_ProjectPopulation, double, 1)->Apply(ProjectionGrid);
+BENCHMARK_TEMPLATE2(BM_ProjectPopulation, double, kDefaultLanes)->Apply(ProjectionGrid);
+BENCHMARK_TEMPLATE2(BM_ProjectPopulation, float, kDefaultLanes)->Apply(ProjectionGrid);
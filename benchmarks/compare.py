@@ -0,0 +1,81 @@
+"""Compares a run of fundem_bench against a baseline run.
+
+Both files are the JSON that Google Benchmark writes with
+``--benchmark_out=run.json --benchmark_out_format=json``. A benchmark
+regresses when its time grows by more than the threshold, and the script
+exits with status 1 if any benchmark regresses, so it can gate a build.
+Benchmarks that are in only one of the files are listed, not judged.
+
+    python benchmarks/compare.py baseline.json run.json --threshold 0.1
+"""
+import argparse
+import json
+import sys
+
+
+def load_times(path, measure):
+    """Time per iteration for each benchmark, in nanoseconds. When a run
+    has repetitions, this uses their median."""
+    with open(path) as json_file:
+        run = json.load(json_file)
+    scale = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+    times = dict()
+    medians = dict()
+    for benchmark in run["benchmarks"]:
+        if benchmark.get("error_occurred"):
+            continue
+        name = benchmark.get("run_name", benchmark["name"])
+        value = benchmark[measure] * scale[benchmark.get("time_unit", "ns")]
+        aggregate = benchmark.get("aggregate_name")
+        if aggregate == "median":
+            medians[name] = value
+        elif aggregate is None:
+            times.setdefault(name, value)
+    times.update(medians)
+    return times
+
+
+def compare(baseline, current, threshold):
+    """Returns rows of (name, baseline, current, ratio) and the names
+    that regressed."""
+    rows = list()
+    regressed = list()
+    for name in sorted(set(baseline) & set(current)):
+        ratio = current[name] / baseline[name]
+        rows.append((name, baseline[name], current[name], ratio))
+        if ratio > 1 + threshold:
+            regressed.append(name)
+    return rows, regressed
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="JSON from the baseline run")
+    parser.add_argument("current", help="JSON from the run to check")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="Fractional slowdown that counts as a regression")
+    parser.add_argument("--measure", choices=["real_time", "cpu_time"],
+                        default="cpu_time")
+    args = parser.parse_args(argv)
+
+    baseline = load_times(args.baseline, args.measure)
+    current = load_times(args.current, args.measure)
+    rows, regressed = compare(baseline, current, args.threshold)
+    width = max([len(row[0]) for row in rows] + [9])
+    print(f"{'benchmark':<{width}} {'baseline':>12} {'current':>12} {'ratio':>7}")
+    for name, before, after, ratio in rows:
+        flag = "  REGRESSED" if name in regressed else ""
+        print(f"{name:<{width}} {before:>12.0f} {after:>12.0f} {ratio:>7.3f}{flag}")
+    for name in sorted(set(baseline) - set(current)):
+        print(f"missing from current run: {name}")
+    for name in sorted(set(current) - set(baseline)):
+        print(f"new since baseline: {name}")
+    if regressed:
+        print(f"{len(regressed)} of {len(rows)} benchmarks are more than "
+              f"{args.threshold:.0%} slower than the baseline.")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
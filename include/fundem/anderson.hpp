@@ -0,0 +1,164 @@
+//
+// Anderson mixing for fixed-point iterations such as graduation.
+//
+
+#ifndef FUNDEM_ANDERSON_HPP
+#define FUNDEM_ANDERSON_HPP
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "fundem/cholesky.hpp"
+
+
+namespace fundem {
+
+/*! Anderson mixing for a fixed-point iteration x = G(x) on a vector
+ *  whose entries must stay strictly between zero and an upper bound.
+ *
+ *  Plain iteration takes G(x) as the next x. Anderson mixing keeps the
+ *  last `depth` changes in the residual f = G(x) - x and in G(x), finds
+ *  the combination gamma of residual changes that best cancels the
+ *  current residual, in least squares, and steps to
+ *  G(x) - sum_j gamma_j dG_j. With a depth of one this is a secant
+ *  method, and for a linear G it converges as GMRES does.
+ *
+ *  The least-squares problem is at most depth by depth, solved by a
+ *  Cholesky factorization of the normal equations. If that matrix is
+ *  close to singular, or the mixed step leaves the bounds, the mixer
+ *  forgets its history and takes the plain step, so every step is
+ *  either plain or stays inside the bounds. Vectors keep their
+ *  capacity, so a mixer that is reused allocates nothing after its
+ *  first population.
+ *
+ * @tparam REAL The type of floating point.
+ */
+template<typename REAL>
+class AndersonMixer {
+public:
+    /*! Most changes a mixer remembers. */
+    static constexpr int kMaxDepth = 4;
+
+    /*! Clears the history and sizes the mixer for vectors of `size`
+     *  entries, remembering up to `depth` changes.
+     */
+    void Reset(int size, int depth)
+    {
+        size_ = size;
+        depth_ = std::max(1, std::min(depth, int(kMaxDepth)));
+        residual_change_.resize(depth_ * size_);
+        image_change_.resize(depth_ * size_);
+        last_residual_.resize(size_);
+        last_image_.resize(size_);
+        history_cnt_ = 0;
+        newest_ = 0;
+        started_ = false;
+    }
+
+    /*! Given the input x and its image G(x), replaces the image with
+     *  the next input. Returns true if the step was mixed, and false if
+     *  it was the plain step.
+     *
+     * @param x The input of this iteration, Array[size].
+     * @param image G(x) on entry, and the next input on return.
+     * @param upper Array[size] of upper bounds. Lower bounds are zero.
+     */
+    bool Mix(const REAL *const x, REAL *const image, const REAL *const upper)
+    {
+        if (!started_) {
+            for (int idx = 0; idx < size_; idx++) {
+                last_residual_[idx] = image[idx] - x[idx];
+                last_image_[idx] = image[idx];
+            }
+            started_ = true;
+            return false;
+        }
+
+        // One pass finds the newest changes and their products with the
+        // remembered changes and with the new residual. Older products
+        // with the residual follow from f_k = f_{k-1} + df_newest.
+        const int newest = (newest_ + 1) % depth_;
+        const int column_cnt = std::min(history_cnt_ + 1, depth_);
+        int slot[kMaxDepth];
+        const REAL* older[kMaxDepth];
+        for (int back = 0; back < column_cnt; back++) {
+            slot[back] = (newest - back + depth_) % depth_;
+            older[back] = &residual_change_[slot[back] * size_];
+        }
+        REAL* residual_change = &residual_change_[newest * size_];
+        REAL* image_change = &image_change_[newest * size_];
+        REAL cross[kMaxDepth] = {0};
+        REAL toward = 0;
+        for (int idx = 0; idx < size_; idx++) {
+            const REAL residual = image[idx] - x[idx];
+            const REAL change = residual - last_residual_[idx];
+            residual_change[idx] = change;
+            image_change[idx] = image[idx] - last_image_[idx];
+            last_residual_[idx] = residual;
+            last_image_[idx] = image[idx];
+            toward += change * residual;
+            for (int back = 0; back < column_cnt; back++) {
+                cross[back] += older[back][idx] * change;
+            }
+        }
+        for (int back = 1; back < column_cnt; back++) {
+            gram_[newest][slot[back]] = cross[back];
+            gram_[slot[back]][newest] = cross[back];
+            residual_dot_[slot[back]] += cross[back];
+        }
+        gram_[newest][newest] = cross[0];
+        residual_dot_[newest] = toward;
+        newest_ = newest;
+        history_cnt_ = column_cnt;
+
+        // Normal equations for gamma, over columns from newest to oldest.
+        REAL normal[kMaxDepth][kMaxDepth];
+        REAL gamma[kMaxDepth];
+        for (int row_idx = 0; row_idx < column_cnt; row_idx++) {
+            for (int col_idx = 0; col_idx <= row_idx; col_idx++) {
+                normal[row_idx][col_idx] = gram_[slot[row_idx]][slot[col_idx]];
+            }
+            gamma[row_idx] = residual_dot_[slot[row_idx]];
+        }
+        const REAL tolerance = 1e3 * std::numeric_limits<REAL>::epsilon();
+        if (!CholeskySolve(&normal[0][0], kMaxDepth, gamma, column_cnt, tolerance)) {
+            history_cnt_ = 0;
+            return false;
+        }
+
+        // The mixed step, which must stay inside the bounds.
+        for (int col_idx = 0; col_idx < column_cnt; col_idx++) {
+            const REAL* change = &image_change_[slot[col_idx] * size_];
+            for (int idx = 0; idx < size_; idx++) {
+                image[idx] -= gamma[col_idx] * change[idx];
+            }
+        }
+        bool inside = true;
+        for (int idx = 0; idx < size_; idx++) {
+            inside &= (image[idx] > 0) & (image[idx] < upper[idx]);
+        }
+        if (!inside) {
+            history_cnt_ = 0;
+            std::copy(last_image_.begin(), last_image_.end(), image);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    int size_{0};
+    int depth_{1};
+    int history_cnt_{0};
+    int newest_{0};
+    bool started_{false};
+    std::vector<REAL> residual_change_;  //!< Array[depth,size], a ring.
+    std::vector<REAL> image_change_;     //!< Array[depth,size], a ring.
+    std::vector<REAL> last_residual_;
+    std::vector<REAL> last_image_;
+    REAL gram_[kMaxDepth][kMaxDepth];  //!< Products of residual changes, by slot.
+    REAL residual_dot_[kMaxDepth];     //!< Their products with the last residual.
+};
+
+}
+
+#endif //FUNDEM_ANDERSON_HPP
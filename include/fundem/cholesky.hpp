@@ -0,0 +1,63 @@
+//
+// A Cholesky solver for the small symmetric systems of fits and mixing.
+//
+
+#ifndef FUNDEM_CHOLESKY_HPP
+#define FUNDEM_CHOLESKY_HPP
+
+#include <cmath>
+
+
+namespace fundem {
+
+/*! Solves the symmetric positive-definite system A x = b, of size
+ *  `size`, by Cholesky decomposition, in place. Only the lower triangle
+ *  of A is read. It is overwritten with the factor, and b with x.
+ *
+ * @param A Row-major matrix whose rows are `stride` apart.
+ * @param stride Distance between rows of A, at least `size`.
+ * @param b The right-hand side on entry, and x on return.
+ * @param size Number of unknowns.
+ * @param tolerance Each pivot must exceed this fraction of its diagonal
+ *     entry. Zero only asks that pivots be positive.
+ * @return False if A isn't positive definite to within the tolerance.
+ */
+template<typename REAL>
+bool CholeskySolve(REAL *const A, int stride, REAL *const b, int size, REAL tolerance = 0)
+{
+    for (int col_idx = 0; col_idx < size; col_idx++) {
+        REAL pivot = A[col_idx * stride + col_idx];
+        for (int k_idx = 0; k_idx < col_idx; k_idx++) {
+            pivot -= A[col_idx * stride + k_idx] * A[col_idx * stride + k_idx];
+        }
+        if (!(pivot > tolerance * A[col_idx * stride + col_idx])) {
+            return false;
+        }
+        const REAL root = std::sqrt(pivot);
+        A[col_idx * stride + col_idx] = root;
+        for (int row_idx = col_idx + 1; row_idx < size; row_idx++) {
+            REAL entry = A[row_idx * stride + col_idx];
+            for (int k_idx = 0; k_idx < col_idx; k_idx++) {
+                entry -= A[row_idx * stride + k_idx] * A[col_idx * stride + k_idx];
+            }
+            A[row_idx * stride + col_idx] = entry / root;
+        }
+    }
+    for (int row_idx = 0; row_idx < size; row_idx++) {
+        for (int k_idx = 0; k_idx < row_idx; k_idx++) {
+            b[row_idx] -= A[row_idx * stride + k_idx] * b[k_idx];
+        }
+        b[row_idx] /= A[row_idx * stride + row_idx];
+    }
+    for (int row_idx = size - 1; row_idx >= 0; row_idx--) {
+        for (int k_idx = row_idx + 1; k_idx < size; k_idx++) {
+            b[row_idx] -= A[k_idx * stride + row_idx] * b[k_idx];
+        }
+        b[row_idx] /= A[row_idx * stride + row_idx];
+    }
+    return true;
+}
+
+}
+
+#endif //FUNDEM_CHOLESKY_HPP
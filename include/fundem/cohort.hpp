@@ -0,0 +1,166 @@
+//
+// Cohort lifetables from mortality that changes from year to year.
+//
+
+#ifndef FUNDEM_COHORT_HPP
+#define FUNDEM_COHORT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! Cohorts that step through ages together. Each step reads one age
+ *  group for all of them, from consecutive years, so the cache lines
+ *  one step loads hold the next age group for the following step.
+ */
+const int kCohortBlock = 8;
+
+
+/*! The year, counted from a cohort's birth year, that each age group
+ *  reads from the surface. That's the year that holds the middle of the
+ *  interval, or, for the open last interval, the year it starts.
+ *
+ * @param nx Array[age] of interval widths, in years.
+ * @param age_cnt Number of age groups.
+ * @return Array[age] of year offsets.
+ */
+template<typename REAL>
+std::vector<int> CohortYearOffsets(const REAL *const nx, int age_cnt)
+{
+    std::vector<int> offsets(age_cnt);
+    double x = 0;
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        const double middle = (age_idx < age_cnt - 1) ? x + 0.5 * nx[age_idx] : x;
+        offsets[age_idx] = static_cast<int>(std::floor(middle));
+        x += nx[age_idx];
+    }
+    return offsets;
+}
+
+
+/*! Cohort lifetables for blocks `[block_begin, block_end)`, where
+ *  block b is population `b / block_cnt` and cohorts starting at
+ *  `(b % block_cnt) * kCohortBlock`. This is the body of
+ *  `CohortLifeTable`, which covers every block, and `workspace` is the
+ *  calling thread's.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void CohortLifeTableBlocks(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, int year_cnt,
+        const std::vector<int>& year_offsets, size_t block_begin, size_t block_end,
+        LifeTableWorkspace<REAL>& workspace)
+{
+    const size_t block_cnt = (year_cnt + kCohortBlock - 1) / kCohortBlock;
+    const REAL missing = std::numeric_limits<REAL>::quiet_NaN();
+    auto& m_block = workspace.gathered_mx;
+    auto& a_block = workspace.gathered_ax;
+    m_block.resize(kCohortBlock * age_cnt);
+    a_block.resize((nullptr != ax) ? kCohortBlock * age_cnt : 0);
+
+    for (size_t block_idx = block_begin; block_idx < block_end; block_idx++) {
+        const size_t pop_idx = block_idx / block_cnt;
+        const int cohort_begin = static_cast<int>(block_idx % block_cnt) * kCohortBlock;
+        const int cohort_cnt = std::min(kCohortBlock, year_cnt - cohort_begin);
+        const size_t surface = pop_idx * year_cnt * age_cnt;
+
+        // Gather the diagonals. Years past the end of the surface are
+        // NaN, which the period kernel carries into every value that
+        // depends on them.
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            for (int cohort_idx = 0; cohort_idx < cohort_cnt; cohort_idx++) {
+                const int year_idx = cohort_begin + cohort_idx + year_offsets[age_idx];
+                const size_t source = surface + size_t(year_idx) * age_cnt + age_idx;
+                const bool observed = year_idx < year_cnt;
+                m_block[cohort_idx * age_cnt + age_idx] = observed ? mx[source] : missing;
+                if (nullptr != ax) {
+                    a_block[cohort_idx * age_cnt + age_idx] = observed ? ax[source] : missing;
+                }
+            }
+        }
+
+        // Output is [pop][cohort][age], so the block's cohorts are
+        // contiguous and the period kernel writes them in place.
+        FullLifeTable<REAL, ACCUM>(&m_block[0], (nullptr != ax) ? &a_block[0] : nullptr, nx,
+                columns.Offset(surface + size_t(cohort_begin) * age_cnt), age_cnt, cohort_cnt,
+                workspace);
+    }
+}
+
+
+/*! Lifetables for cohorts, following each birth year along the
+ *  diagonal of a surface of period mortality rates.
+ *
+ *  The surface is indexed by single calendar years, and the cohort
+ *  born at the start of year y is in age group x during year
+ *  y + floor(x + n_x / 2), so age groups narrower or wider than a year
+ *  step the cohort through the right number of years. Each cohort's
+ *  columns are those that `FullLifeTable` would compute from its
+ *  diagonal.
+ *
+ *  Cohorts born late in the surface outlive it. Their rates past its
+ *  last year are unknown, so every value that depends on them is NaN.
+ *  That's ax, qx, px, dx, and Lx for age groups past the edge, lx
+ *  after the first of those, and Tx and ex at every age, so a cohort's
+ *  ex is a number only if the surface covers its whole life.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type of px and of the running sums for lx and Tx.
+ * @param mx Array[pop,year,age] of mortality rates.
+ * @param ax Array[pop,year,age] of mean ages, or nullptr for
+ *     constant-mortality ax along each diagonal.
+ * @param nx Array[age] of interval widths, in years.
+ * @param columns Array[pop,cohort,age] for each wanted column, where
+ *     cohort c was born at the start of year c of the surface.
+ * @param age_cnt Number of age groups.
+ * @param year_cnt Number of years in the surface, and of cohorts.
+ * @param N Number of populations.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void CohortLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, int year_cnt, size_t N)
+{
+    if (year_cnt < 1) {
+        throw std::invalid_argument("There must be at least one year.");
+    }
+    const auto year_offsets = CohortYearOffsets(nx, age_cnt);
+    const size_t block_cnt = (year_cnt + kCohortBlock - 1) / kCohortBlock;
+    LifeTableWorkspace<REAL> workspace;
+    CohortLifeTableBlocks<REAL, ACCUM>(mx, ax, nx, columns, age_cnt, year_cnt,
+            year_offsets, 0, N * block_cnt, workspace);
+}
+
+
+/*! `CohortLifeTable` with blocks of cohorts split among threads, so
+ *  that even a single population uses the whole pool.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void CohortLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, int year_cnt, size_t N,
+        ThreadPool& pool)
+{
+    if (year_cnt < 1) {
+        throw std::invalid_argument("There must be at least one year.");
+    }
+    const auto year_offsets = CohortYearOffsets(nx, age_cnt);
+    const size_t block_cnt = (year_cnt + kCohortBlock - 1) / kCohortBlock;
+    std::vector<LifeTableWorkspace<REAL>> workspaces(pool.ThreadCount());
+    pool.ParallelForWorker(N * block_cnt, 0, [&](size_t begin, size_t end, int worker_idx) {
+        CohortLifeTableBlocks<REAL, ACCUM>(mx, ax, nx, columns, age_cnt, year_cnt,
+                year_offsets, begin, end, workspaces[worker_idx]);
+    });
+}
+
+}
+
+#endif //FUNDEM_COHORT_HPP
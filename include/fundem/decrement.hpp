@@ -0,0 +1,341 @@
+//
+// Cause-deleted and multiple-decrement lifetables for many causes at once.
+//
+
+#ifndef FUNDEM_DECREMENT_HPP
+#define FUNDEM_DECREMENT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "fundem/fast_math.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/simd.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+#if defined(__AVX512F__)
+/*! Causes computed together. With AVX-512, `Expm1` runs at vector width
+ *  and four doubles a group is fastest.
+ */
+constexpr int kDecrementLanes = 4;
+#else
+/*! Causes computed together. Without AVX-512, each lane's exponential
+ *  comes from libm, and eight lanes spread the work per group further.
+ */
+constexpr int kDecrementLanes = 8;
+#endif
+
+
+/*! exp(x) - 1 for every lane, from `Expm1` with AVX-512 and otherwise
+ *  from libm a lane at a time, which is faster on narrower vectors.
+ */
+template<typename ACCUM, int LANES>
+Lanes<ACCUM, LANES> DecrementExpm1(const Lanes<ACCUM, LANES>& x)
+{
+#if defined(__AVX512F__)
+    return Expm1(x);
+#else
+    ACCUM result[LANES];
+    for (int lane = 0; lane < LANES; lane++) {
+        result[lane] = std::expm1(x[lane]);
+    }
+    return Lanes<ACCUM, LANES>::Load(result);
+#endif
+}
+
+
+/*! Columns for each cause, each an Array[pop,cause,age], or null for
+ *  columns the caller doesn't want.
+ *
+ *  The deleted columns belong to the associated single-decrement table,
+ *  in which every cause acts except this one. The cause columns belong
+ *  to the multiple-decrement table, in which all causes act.
+ */
+template<typename REAL>
+struct DecrementColumns {
+    REAL* deleted_qx{nullptr};  //!< Probability of death without the cause.
+    REAL* deleted_lx{nullptr};  //!< Survivors without the cause.
+    REAL* deleted_ex{nullptr};  //!< Life expectancy without the cause.
+    REAL* cause_dx{nullptr};    //!< Deaths from the cause among all deaths.
+    REAL* cause_lx{nullptr};    //!< Survivors who will die of the cause.
+
+    /*! The same columns, starting `offset` values later. */
+    DecrementColumns Offset(size_t offset) const
+    {
+        auto shift = [offset](REAL* column) {
+            return (nullptr != column) ? column + offset : nullptr;
+        };
+        DecrementColumns shifted;
+        shifted.deleted_qx = shift(deleted_qx);
+        shifted.deleted_lx = shift(deleted_lx);
+        shifted.deleted_ex = shift(deleted_ex);
+        shifted.cause_dx = shift(cause_dx);
+        shifted.cause_lx = shift(cause_lx);
+        return shifted;
+    }
+};
+
+
+/*! Scratch space for `CauseDeletedLifeTable`. The all-cause rows are
+ *  Array[age], and the rows for a group of causes are Array[age,lane].
+ *  Like `LifeTableWorkspace`, a workspace keeps its capacity and goes to
+ *  one thread at a time.
+ */
+template<typename ACCUM>
+struct DecrementWorkspace {
+    std::vector<ACCUM> mx;
+    std::vector<ACCUM> nx;
+    std::vector<ACCUM> constant_ax;  //!< Constant-mortality mean age.
+    std::vector<ACCUM> hazard_scale; //!< log px / mx, to scale by a cause's rate.
+    std::vector<ACCUM> mean_shift;   //!< ax less its constant-mortality value.
+    std::vector<ACCUM> dx_per_mx;    //!< dx / mx, to scale by a cause's rate.
+    std::vector<ACCUM> cause_mx;     //!< A group of causes, interleaved.
+    std::vector<ACCUM> deleted_qx;
+    std::vector<ACCUM> deleted_lx;
+    std::vector<ACCUM> deleted_Lx;   //!< Person-years, then life expectancy.
+};
+
+
+/*! Cause-deleted and multiple-decrement lifetables for every cause of
+ *  every population, sharing the all-cause table among causes.
+ *
+ *  Deleting cause k leaves the fraction R = (mx - mx_k) / mx of the
+ *  hazard, and, as Chiang does, the deleted survival is px^R. Within a
+ *  closed interval, the deleted mean age differs from its
+ *  constant-mortality value by as much as ax does from its own, and in
+ *  the open interval it scales with the ratio of the two, which gives
+ *  ax / R when the last nx is infinite. With a null ax, every deleted
+ *  table is the constant-mortality lifetable of mx - mx_k, as
+ *  `FullLifeTable` computes it, up to rounding.
+ *
+ *  Each population computes log px, lx, and dx once. Causes then go
+ *  LANES at a time through `Lanes` arithmetic. For each cause and
+ *  closed interval, survival is a `DecrementExpm1` of the cause's rate times
+ *  log px / mx, and person-years are nx lx+1 + ax dx, as in
+ *  `FullLifeTable`, with the deleted mean age.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type of the arithmetic and of the sums over ages.
+ * @tparam LANES Causes computed together.
+ * @param mx Array[pop,age] of all-cause mortality rates.
+ * @param ax Array[pop,age] of all-cause mean ages, or nullptr for
+ *     constant-mortality ax.
+ * @param nx Array[age] of interval widths.
+ * @param cause_mx Array[pop,cause,age] of mortality rates for each
+ *     cause, which must be nonnegative and at most mx.
+ * @param columns Where to write the columns the caller wants.
+ * @param age_cnt Number of age groups.
+ * @param cause_cnt Number of causes.
+ * @param N Number of populations.
+ */
+template<typename REAL, typename ACCUM = REAL, int LANES = kDecrementLanes>
+void CauseDeletedLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const REAL *const cause_mx, const DecrementColumns<REAL>& columns,
+        int age_cnt, int cause_cnt, size_t N, DecrementWorkspace<ACCUM>& workspace)
+{
+    typedef Lanes<ACCUM, LANES> V;
+    if (age_cnt < 1) {
+        throw std::invalid_argument("There must be at least one age group.");
+    }
+    const bool backward = (nullptr != columns.deleted_ex);
+    const int last = age_cnt - 1;
+    workspace.mx.resize(age_cnt);
+    workspace.nx.resize(age_cnt);
+    workspace.constant_ax.resize(age_cnt);
+    workspace.hazard_scale.resize(age_cnt);
+    workspace.mean_shift.resize(age_cnt);
+    workspace.dx_per_mx.resize(age_cnt);
+    workspace.cause_mx.resize(age_cnt * LANES);
+    workspace.deleted_qx.resize(age_cnt * LANES);
+    workspace.deleted_lx.resize(age_cnt * LANES);
+    workspace.deleted_Lx.resize(age_cnt * LANES);
+    auto& all_mx = workspace.mx;
+    auto& n = workspace.nx;
+    auto& constant_mean = workspace.constant_ax;
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        n[age_idx] = nx[age_idx];
+    }
+    const V zero = V::Broadcast(0);
+    const V one = V::Broadcast(1);
+
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const REAL* m = mx + pop_idx * age_cnt;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            all_mx[age_idx] = m[age_idx];
+        }
+        ConstantMortalityMeanAge(&all_mx[0], &n[0], &constant_mean[0], age_cnt, 1);
+        ACCUM l = 1;
+        ACCUM open_ratio = 1;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const ACCUM m_age = all_mx[age_idx];
+            const ACCUM a = (nullptr != ax) ? ACCUM(ax[pop_idx * age_cnt + age_idx]) :
+                    constant_mean[age_idx];
+            if (age_idx == last) {
+                open_ratio = a / constant_mean[age_idx];
+                workspace.dx_per_mx[age_idx] = (m_age > 0) ? l / m_age : ACCUM(0);
+                break;
+            }
+            // Constant mortality has log px = -mx nx exactly. Otherwise,
+            // the logarithm of whichever of px and qx is smaller keeps
+            // its digits.
+            const ACCUM denominator = 1 + m_age * (n[age_idx] - a);
+            const ACCUM qx = m_age * n[age_idx] / denominator;
+            if (nullptr == ax) {
+                workspace.hazard_scale[age_idx] = -n[age_idx];
+            } else {
+                const ACCUM log_px = (qx < ACCUM(0.5)) ? std::log1p(-qx) :
+                        std::log((1 - m_age * a) / denominator);
+                workspace.hazard_scale[age_idx] = (m_age > 0) ? log_px / m_age : ACCUM(0);
+            }
+            workspace.mean_shift[age_idx] = a - constant_mean[age_idx];
+            workspace.dx_per_mx[age_idx] = (m_age > 0) ? l * qx / m_age : ACCUM(0);
+            l *= 1 - qx;
+        }
+
+        for (int cause_begin = 0; cause_begin < cause_cnt; cause_begin += LANES) {
+            const int lane_cnt = std::min(LANES, cause_cnt - cause_begin);
+            const size_t row = (pop_idx * cause_cnt + cause_begin) * age_cnt;
+            // Interleave the group's rates. Lanes past the last cause
+            // delete nothing.
+            for (int lane = 0; lane < LANES; lane++) {
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    const ACCUM m_cause = (lane < lane_cnt) ?
+                            ACCUM(cause_mx[row + lane * age_cnt + age_idx]) : ACCUM(0);
+                    if (!(m_cause >= 0 && m_cause <= all_mx[age_idx])) {
+                        throw std::invalid_argument("Each cause's mortality must be "
+                                "between zero and all-cause mortality.");
+                    }
+                    workspace.cause_mx[age_idx * LANES + lane] = m_cause;
+                }
+            }
+
+            V deleted_l = one;
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                const V m_cause = V::Load(&workspace.cause_mx[age_idx * LANES]);
+                const V m_deleted = V::Broadcast(all_mx[age_idx]) - m_cause;
+                deleted_l.Store(&workspace.deleted_lx[age_idx * LANES]);
+                if (age_idx == last) {
+                    if (backward) {
+                        const V deleted_a = V::Broadcast(open_ratio) *
+                                ConstantMortalityMeanAge(m_deleted, V::Broadcast(n[last]));
+                        (deleted_a * deleted_l).Store(&workspace.deleted_Lx[last * LANES]);
+                    }
+                    one.Store(&workspace.deleted_qx[last * LANES]);
+                    break;
+                }
+
+                const V deleted_q = zero - DecrementExpm1(
+                        m_deleted * V::Broadcast(workspace.hazard_scale[age_idx]));
+                const V deleted_d = deleted_l * deleted_q;
+                deleted_q.Store(&workspace.deleted_qx[age_idx * LANES]);
+                if (backward) {
+                    // Person-years as `FullLifeTable` counts them, from the
+                    // deleted mean age.
+                    const V n_age = V::Broadcast(n[age_idx]);
+                    const V deleted_a = ConstantMortalityMeanAge(m_deleted, n_age) +
+                            V::Broadcast(workspace.mean_shift[age_idx]);
+                    (n_age * (deleted_l - deleted_d) + deleted_a * deleted_d)
+                            .Store(&workspace.deleted_Lx[age_idx * LANES]);
+                }
+                deleted_l = deleted_l - deleted_d;
+            }
+
+            if (backward) {
+                // Backward, replacing person-years with life expectancy.
+                V deleted_T = zero;
+                for (int age_idx = last; age_idx >= 0; age_idx--) {
+                    deleted_T = deleted_T + V::Load(&workspace.deleted_Lx[age_idx * LANES]);
+                    (deleted_T / V::Load(&workspace.deleted_lx[age_idx * LANES]))
+                            .Store(&workspace.deleted_Lx[age_idx * LANES]);
+                }
+            }
+
+            // Each lane is a row of every column. Writing rows whole,
+            // rather than a value per row at each age, keeps the stores
+            // sequential.
+            for (int lane = 0; lane < lane_cnt; lane++) {
+                const size_t lane_row = row + lane * age_cnt;
+                auto write_row = [&](REAL* column, const std::vector<ACCUM>& interleaved) {
+                    if (nullptr != column) {
+                        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                            column[lane_row + age_idx] =
+                                    static_cast<REAL>(interleaved[age_idx * LANES + lane]);
+                        }
+                    }
+                };
+                write_row(columns.deleted_qx, workspace.deleted_qx);
+                write_row(columns.deleted_lx, workspace.deleted_lx);
+                write_row(columns.deleted_ex, workspace.deleted_Lx);
+                if (nullptr != columns.cause_dx || nullptr != columns.cause_lx) {
+                    // Survivors who will die of the cause are its deaths
+                    // yet to come.
+                    ACCUM cause_l = 0;
+                    for (int age_idx = last; age_idx >= 0; age_idx--) {
+                        const ACCUM cause_d = workspace.dx_per_mx[age_idx] *
+                                workspace.cause_mx[age_idx * LANES + lane];
+                        cause_l += cause_d;
+                        if (nullptr != columns.cause_dx) {
+                            columns.cause_dx[lane_row + age_idx] = static_cast<REAL>(cause_d);
+                        }
+                        if (nullptr != columns.cause_lx) {
+                            columns.cause_lx[lane_row + age_idx] = static_cast<REAL>(cause_l);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+template<typename REAL, typename ACCUM = REAL, int LANES = kDecrementLanes>
+void CauseDeletedLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const REAL *const cause_mx, const DecrementColumns<REAL>& columns,
+        int age_cnt, int cause_cnt, size_t N)
+{
+    DecrementWorkspace<ACCUM> workspace;
+    CauseDeletedLifeTable<REAL, ACCUM, LANES>(mx, ax, nx, cause_mx, columns, age_cnt,
+            cause_cnt, N, workspace);
+}
+
+
+template<typename REAL, typename ACCUM = REAL, int LANES = kDecrementLanes>
+void CauseDeletedLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const REAL *const cause_mx, const DecrementColumns<REAL>& columns,
+        int age_cnt, int cause_cnt, size_t N, ThreadPool& pool,
+        std::vector<DecrementWorkspace<ACCUM>>& workspaces)
+{
+    workspaces.resize(std::max(workspaces.size(), size_t(pool.ThreadCount())));
+    pool.ParallelForWorker(N, 0, [=, &columns, &workspaces](size_t begin, size_t end,
+            int worker_idx) {
+        const size_t offset = begin * age_cnt;
+        CauseDeletedLifeTable<REAL, ACCUM, LANES>(mx + offset,
+                (nullptr != ax) ? ax + offset : nullptr, nx, cause_mx + offset * cause_cnt,
+                columns.Offset(offset * cause_cnt), age_cnt, cause_cnt, end - begin,
+                workspaces[worker_idx]);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL, int LANES = kDecrementLanes>
+void CauseDeletedLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const REAL *const cause_mx, const DecrementColumns<REAL>& columns,
+        int age_cnt, int cause_cnt, size_t N, ThreadPool& pool)
+{
+    std::vector<DecrementWorkspace<ACCUM>> workspaces;
+    CauseDeletedLifeTable<REAL, ACCUM, LANES>(mx, ax, nx, cause_mx, columns, age_cnt,
+            cause_cnt, N, pool, workspaces);
+}
+
+}
+
+#endif //FUNDEM_DECREMENT_HPP
@@ -0,0 +1,245 @@
+//
+// Lifetables for draws of mortality, reduced over draws as they're made.
+//
+
+#ifndef FUNDEM_DRAWS_HPP
+#define FUNDEM_DRAWS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! The statistics over draws, in the order they're stored for each
+ *  population and age.
+ */
+enum DrawStatistic {
+    kDrawMean = 0,      //!< Mean over draws.
+    kDrawVariance = 1,  //!< Sample variance, with n - 1 in the denominator.
+    kDrawLower = 2,     //!< The lower quantile.
+    kDrawUpper = 3,     //!< The upper quantile.
+    kDrawStatisticCount = 4
+};
+
+
+/*! Lifetable values per column held at once, across all draws, for a
+ *  block of populations. A block holds at least one population, and
+ *  exact quantiles need all of its draws, so each column takes the
+ *  larger of this and `draw_cnt * age_cnt` values. Memory doesn't grow
+ *  with the count of populations.
+ */
+const size_t kDrawBlockValues = size_t{1} << 20;
+
+
+/*! Running mean and variance by Welford's update, which doesn't
+ *  lose precision to cancellation the way sums of squares do.
+ */
+template<typename ACCUM>
+struct RunningMoments {
+    size_t count{0};
+    ACCUM mean{0};
+    ACCUM sum_squares{0};  //!< Sum of squared deviations from the mean.
+
+    void Add(ACCUM value)
+    {
+        count++;
+        const ACCUM delta = value - mean;
+        mean += delta / static_cast<ACCUM>(count);
+        sum_squares += delta * (value - mean);
+    }
+
+    ACCUM Variance() const
+    {
+        return (count > 1) ? sum_squares / static_cast<ACCUM>(count - 1) : ACCUM(0);
+    }
+};
+
+
+/*! The quantile that linearly interpolates between order statistics,
+ *  which is R's type 7 and NumPy's default. Reorders `values`.
+ */
+template<typename REAL>
+REAL InterpolatedQuantile(REAL *const values, size_t count, double probability)
+{
+    const double position = probability * static_cast<double>(count - 1);
+    const size_t below = static_cast<size_t>(std::floor(position));
+    std::nth_element(values, values + below, values + count);
+    const REAL low = values[below];
+    if (below + 1 >= count) {
+        return low;
+    }
+    const REAL high = *std::min_element(values + below + 1, values + count);
+    return static_cast<REAL>(low + (position - below) * (high - low));
+}
+
+
+/*! Computes lifetables for a block of populations
+ *  `[pop_begin, pop_begin + block_cnt)` into `buffers`, which are
+ *  Array[draw,block,age], using the thread's `workspace`. Item i of
+ *  `[item_begin, item_end)` is draw `i / block_cnt` of the block's
+ *  population `i % block_cnt`, so it's row i of the buffers, and a
+ *  range of items can split draws, populations, or both.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void DrawBlockLifeTables(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& buffers, int age_cnt, size_t pop_cnt,
+        size_t pop_begin, size_t block_cnt, size_t item_begin, size_t item_end,
+        LifeTableWorkspace<REAL>& workspace)
+{
+    while (item_begin < item_end) {
+        // Items in one draw are neighbors in mx, too.
+        const size_t draw_idx = item_begin / block_cnt;
+        const size_t run_end = std::min(item_end, (draw_idx + 1) * block_cnt);
+        const size_t source = (draw_idx * pop_cnt + pop_begin + item_begin % block_cnt) *
+                age_cnt;
+        FullLifeTable<REAL, ACCUM>(mx + source, (nullptr != ax) ? ax + source : nullptr, nx,
+                buffers.Offset(item_begin * age_cnt), age_cnt, run_end - item_begin,
+                workspace);
+        item_begin = run_end;
+    }
+}
+
+
+/*! Reduces one column of `DrawBlockLifeTables` over draws, for the
+ *  cells `[cell_begin, cell_end)` of the block, where a cell is one
+ *  population and age. Draws are taken in order, so the result doesn't
+ *  depend on how cells are split among threads.
+ *
+ * @param buffer Array[draw,block,age] of one column.
+ * @param summary Array[pop,age,stat] of the same column, starting at
+ *     the block's first population.
+ * @param scratch Space for `draw_cnt` values.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void ReduceDrawBlock(
+        const REAL *const buffer, REAL *const summary, size_t cell_cnt, size_t draw_cnt,
+        size_t cell_begin, size_t cell_end, double lower, double upper, REAL *const scratch)
+{
+    for (size_t cell_idx = cell_begin; cell_idx < cell_end; cell_idx++) {
+        RunningMoments<ACCUM> moments;
+        for (size_t draw_idx = 0; draw_idx < draw_cnt; draw_idx++) {
+            scratch[draw_idx] = buffer[draw_idx * cell_cnt + cell_idx];
+            moments.Add(scratch[draw_idx]);
+        }
+        REAL* stats = summary + cell_idx * kDrawStatisticCount;
+        stats[kDrawMean] = static_cast<REAL>(moments.mean);
+        stats[kDrawVariance] = static_cast<REAL>(moments.Variance());
+        stats[kDrawLower] = InterpolatedQuantile(scratch, draw_cnt, lower);
+        stats[kDrawUpper] = InterpolatedQuantile(scratch, draw_cnt, upper);
+    }
+}
+
+
+/*! The columns of `LifeTableColumns`, in order, for looping over them. */
+template<typename REAL>
+std::vector<REAL* LifeTableColumns<REAL>::*> LifeTableColumnMembers()
+{
+    return {&LifeTableColumns<REAL>::ax, &LifeTableColumns<REAL>::qx,
+            &LifeTableColumns<REAL>::px, &LifeTableColumns<REAL>::lx,
+            &LifeTableColumns<REAL>::dx, &LifeTableColumns<REAL>::Lx,
+            &LifeTableColumns<REAL>::Tx, &LifeTableColumns<REAL>::ex};
+}
+
+
+/*! Summaries over draws of lifetable columns, without storing the
+ *  lifetable of every draw.
+ *
+ *  For a block of populations at a time, this computes the lifetables
+ *  of all draws into a buffer of `kDrawBlockValues` values per column,
+ *  or of one population's draws if those are more, then reduces each
+ *  population and age over draws to its mean, variance, and two
+ *  quantiles, exactly. Only the summaries are kept.
+ *  Columns follow `FullLifeTable`. Threads split the block's draws and
+ *  populations to make lifetables, so a few draws of many populations
+ *  still use every thread, and they split the cells to reduce them.
+ *  Each cell takes its draws in order, so results are identical for
+ *  any number of threads.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type of the lifetable's running sums and the moments.
+ * @param mx Array[draw,pop,age] of mortality rates.
+ * @param ax Array[draw,pop,age] of mean ages, or nullptr for
+ *     constant-mortality ax.
+ * @param nx Array[age] of interval widths.
+ * @param summaries Array[pop,age,stat] for each wanted column, with
+ *     statistics in the order of `DrawStatistic`.
+ * @param age_cnt Number of age groups.
+ * @param pop_cnt Number of populations.
+ * @param draw_cnt Number of draws.
+ * @param pool Threads that share the work.
+ * @param lower Probability of the lower quantile.
+ * @param upper Probability of the upper quantile.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void SummarizeDraws(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& summaries, int age_cnt, size_t pop_cnt,
+        size_t draw_cnt, ThreadPool& pool, double lower = 0.025, double upper = 0.975)
+{
+    if (draw_cnt < 1) {
+        throw std::invalid_argument("There must be at least one draw.");
+    }
+    if (!(0 <= lower && lower <= upper && upper <= 1)) {
+        throw std::invalid_argument("Quantiles must be ordered probabilities.");
+    }
+    const size_t pop_values = draw_cnt * age_cnt;
+    const size_t block_cnt = std::max(size_t{1},
+            std::min(pop_cnt, kDrawBlockValues / std::max(pop_values, size_t{1})));
+
+    const auto members = LifeTableColumnMembers<REAL>();
+    std::vector<std::vector<REAL>> storage;
+    storage.reserve(members.size());
+    LifeTableColumns<REAL> buffers;
+    for (auto member: members) {
+        if (nullptr != summaries.*member) {
+            storage.emplace_back(block_cnt * pop_values);
+            buffers.*member = &storage.back()[0];
+        }
+    }
+    std::vector<std::vector<REAL>> scratch(pool.ThreadCount(), std::vector<REAL>(draw_cnt));
+    std::vector<LifeTableWorkspace<REAL>> workspaces(pool.ThreadCount());
+
+    for (size_t pop_begin = 0; pop_begin < pop_cnt; pop_begin += block_cnt) {
+        const size_t pops = std::min(block_cnt, pop_cnt - pop_begin);
+        const size_t item_cnt = draw_cnt * pops;
+        pool.ParallelForWorker(item_cnt, 0, [&](size_t begin, size_t end, int worker_idx) {
+            DrawBlockLifeTables<REAL, ACCUM>(mx, ax, nx, buffers, age_cnt, pop_cnt,
+                    pop_begin, pops, begin, end, workspaces[worker_idx]);
+        });
+        const size_t cell_cnt = pops * age_cnt;
+        pool.ParallelForWorker(cell_cnt, 0, [&](size_t begin, size_t end, int worker_idx) {
+            for (auto member: members) {
+                if (nullptr != summaries.*member) {
+                    ReduceDrawBlock<REAL, ACCUM>(buffers.*member,
+                            summaries.*member + pop_begin * age_cnt * kDrawStatisticCount,
+                            cell_cnt, draw_cnt, begin, end, lower, upper,
+                            &scratch[worker_idx][0]);
+                }
+            }
+        });
+    }
+}
+
+
+/*! `SummarizeDraws` on the calling thread. */
+template<typename REAL, typename ACCUM = REAL>
+void SummarizeDraws(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& summaries, int age_cnt, size_t pop_cnt,
+        size_t draw_cnt, double lower = 0.025, double upper = 0.975)
+{
+    ThreadPool serial(1);
+    SummarizeDraws<REAL, ACCUM>(mx, ax, nx, summaries, age_cnt, pop_cnt, draw_cnt, serial,
+            lower, upper);
+}
+
+}
+
+#endif //FUNDEM_DRAWS_HPP
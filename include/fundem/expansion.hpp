@@ -0,0 +1,444 @@
+//
+// Conversion of lifetables between age schemas, such as abridged to single years.
+//
+
+#ifndef FUNDEM_EXPANSION_HPP
+#define FUNDEM_EXPANSION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! Interpolates a lifetable from one age schema onto another, for
+ *  every population of a batch.
+ *
+ *  The interpolant is a monotone cubic Hermite spline of the cumulative
+ *  hazard, -log lx, through the source's lx. Everything that depends
+ *  only on the two schemas is computed once, here: the Hermite basis at
+ *  each age of the union of the schemas, which makes a banded matrix
+ *  with four entries a row, and the weights that make each knot's slope
+ *  a width-weighted mean of the neighboring secants. Converting a
+ *  population finds its slopes, repairs them with the Fritsch-Carlson
+ *  limits so that the spline never falls between knots, and applies
+ *  the banded matrix. lx then never rises and stays between the
+ *  source's values at the ends of each source interval, and it is the
+ *  source's wherever the schemas share an age. Person-years between
+ *  ages of the union assume constant hazard, except that a source
+ *  interval the target doesn't split keeps the source's Lx, so that
+ *  converting to a coarser schema, or back, keeps the source's table.
+ *
+ *  Both schemas start at age zero and end in an open age group that
+ *  starts at the same age.
+ *
+ * @tparam REAL Type of nx.
+ */
+template<typename REAL>
+class ExpansionOperator {
+public:
+    /*!
+     * @param source_nx Array[source age] of the schema that data comes in.
+     * @param source_cnt Number of source age groups.
+     * @param target_nx Array[target age] of the schema to write.
+     * @param target_cnt Number of target age groups.
+     */
+    ExpansionOperator(const REAL *const source_nx, int source_cnt,
+            const REAL *const target_nx, int target_cnt)
+        : source_nx_(source_nx, source_nx + std::max(source_cnt, 0)),
+          target_nx_(target_nx, target_nx + std::max(target_cnt, 0))
+    {
+        if (source_cnt < 1 || target_cnt < 1) {
+            throw std::invalid_argument("Both schemas need at least one age group.");
+        }
+        const auto source_start = Starts(source_nx, source_cnt);
+        const auto target_start = Starts(target_nx, target_cnt);
+        const double last = source_start.back();
+        const double tolerance = 1e-9 * std::max(1.0, last);
+        if (std::abs(target_start.back() - last) > tolerance) {
+            throw std::invalid_argument(
+                    "The schemas' open age groups must start at the same age.");
+        }
+
+        // The union of ages, and where each schema's ages fall in it.
+        for (double start: source_start) {
+            union_start_.push_back(start);
+        }
+        for (double start: target_start) {
+            union_start_.push_back(start);
+        }
+        std::sort(union_start_.begin(), union_start_.end());
+        std::vector<double> merged;
+        for (double start: union_start_) {
+            if (merged.empty() || start - merged.back() > tolerance) {
+                merged.push_back(start);
+            }
+        }
+        union_start_.swap(merged);
+        source_union_ = UnionIndices(source_start, tolerance);
+        target_union_ = UnionIndices(target_start, tolerance);
+
+        // A knot's slope weighs the secant on each side by the width of
+        // the other side. End knots take the slope of the parabola through
+        // their two nearest intervals, which `Slopes` finds from widths.
+        slope_weight_.assign(2 * source_cnt, 0.0);
+        for (int knot_idx = 0; knot_idx < source_cnt - 1; knot_idx++) {
+            if (0 == knot_idx) {
+                slope_weight_[1] = 1;
+                continue;
+            }
+            const double h_left = source_start[knot_idx] - source_start[knot_idx - 1];
+            const double h_right = source_start[knot_idx + 1] - source_start[knot_idx];
+            slope_weight_[2 * knot_idx] = h_right / (h_left + h_right);
+            slope_weight_[2 * knot_idx + 1] = h_left / (h_left + h_right);
+        }
+        if (source_cnt > 1) {
+            slope_weight_[2 * (source_cnt - 1)] = 1;
+        }
+
+        // Each row of the banded matrix takes the cumulative hazard at
+        // the ends of a source interval and the slopes there.
+        const int union_cnt = UnionCount();
+        interval_.resize(union_cnt);
+        basis_.assign(kBand * union_cnt, 0.0);
+        int source_idx = 0;
+        for (int union_idx = 0; union_idx < union_cnt; union_idx++) {
+            while (source_idx + 1 < source_cnt &&
+                    source_union_[source_idx + 1] <= union_idx) {
+                source_idx++;
+            }
+            interval_[union_idx] = source_idx;
+            double* row = &basis_[kBand * union_idx];
+            if (source_idx == source_cnt - 1) {
+                row[0] = 1;
+                continue;
+            }
+            const double h = source_start[source_idx + 1] - source_start[source_idx];
+            const double t = (union_start_[union_idx] - source_start[source_idx]) / h;
+            row[0] = (2 * t - 3) * t * t + 1;
+            row[1] = (3 - 2 * t) * t * t;
+            row[2] = h * ((t - 2) * t + 1) * t;
+            row[3] = h * (t - 1) * t * t;
+        }
+        for (int knot_idx = 0; knot_idx + 1 < source_cnt; knot_idx++) {
+            width_.push_back(source_start[knot_idx + 1] - source_start[knot_idx]);
+        }
+    }
+
+    int SourceCount() const { return static_cast<int>(source_nx_.size()); }
+    int TargetCount() const { return static_cast<int>(target_nx_.size()); }
+    int UnionCount() const { return static_cast<int>(union_start_.size()); }
+    const std::vector<REAL>& SourceWidths() const { return source_nx_; }
+    const std::vector<REAL>& TargetWidths() const { return target_nx_; }
+
+    /*! Converts a lifetable for each population.
+     *
+     * @tparam ACCUM Type of the source lifetable and of sums over ages.
+     * @param mx Array[pop,source age] of mortality rates.
+     * @param ax Array[pop,source age] of mean ages, or nullptr for
+     *     constant-mortality ax.
+     * @param columns Array[pop,target age] for each column wanted. ax
+     *     and qx are those that give the target's lx and Lx.
+     * @param N Number of populations.
+     */
+    template<typename ACCUM = REAL>
+    void Apply(const REAL *const mx, const REAL *const ax, const LifeTableColumns<REAL>& columns,
+            size_t N) const
+    {
+        const int source_cnt = SourceCount();
+        const int target_cnt = TargetCount();
+        const int union_cnt = UnionCount();
+        std::vector<REAL> mean_age(nullptr == ax ? source_cnt : 0);
+        std::vector<ACCUM> hazard(source_cnt), person_years(source_cnt), slope(source_cnt);
+        std::vector<ACCUM> union_hazard(union_cnt), union_lx(union_cnt), union_Tx(union_cnt);
+
+        for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+            const REAL* m = mx + pop_idx * source_cnt;
+            const REAL* a = mean_age.data();
+            if (nullptr != ax) {
+                a = ax + pop_idx * source_cnt;
+            } else {
+                ConstantMortalityMeanAge(m, &source_nx_[0], &mean_age[0], source_cnt, 1);
+            }
+            SourceTable(m, a, &hazard[0], &person_years[0]);
+
+            Slopes(&hazard[0], &slope[0]);
+
+            // The banded product. Rounding aside, the limited slopes
+            // already keep the cumulative hazard from falling.
+            ACCUM previous = 0;
+            for (int union_idx = 0; union_idx < union_cnt; union_idx++) {
+                const double* row = &basis_[kBand * union_idx];
+                const int source_idx = interval_[union_idx];
+                const int next_idx = std::min(source_idx + 1, source_cnt - 1);
+                ACCUM value = ACCUM(row[0]) * hazard[source_idx] +
+                        ACCUM(row[1]) * hazard[next_idx] +
+                        ACCUM(row[2]) * slope[source_idx] + ACCUM(row[3]) * slope[next_idx];
+                value = std::min(std::max(value, std::max(previous, hazard[source_idx])),
+                        hazard[next_idx]);
+                union_hazard[union_idx] = value;
+                union_lx[union_idx] = std::exp(-value);
+                previous = value;
+            }
+
+            // Person-years under constant hazard between the union's
+            // ages, or the source's where a source interval isn't split.
+            union_Tx[union_cnt - 1] = person_years[source_cnt - 1];
+            int union_end = union_cnt - 1;
+            for (int source_idx = source_cnt - 2; source_idx >= 0; source_idx--) {
+                const int union_begin = source_union_[source_idx];
+                if (union_end - union_begin == 1) {
+                    union_Tx[union_begin] = union_Tx[union_end] + person_years[source_idx];
+                } else {
+                    for (int union_idx = union_end - 1; union_idx >= union_begin; union_idx--) {
+                        union_Tx[union_idx] = union_Tx[union_idx + 1] +
+                                UnionPersonYears(union_hazard, union_lx, union_idx);
+                    }
+                }
+                union_end = union_begin;
+            }
+
+            const size_t offset = pop_idx * target_cnt;
+            for (int target_idx = 0; target_idx < target_cnt; target_idx++) {
+                WriteTarget(union_lx, union_Tx, target_idx, columns, offset + target_idx);
+            }
+        }
+    }
+
+    template<typename ACCUM = REAL>
+    void Apply(const REAL *const mx, const REAL *const ax, const LifeTableColumns<REAL>& columns,
+            size_t N, ThreadPool& pool) const
+    {
+        const int source_cnt = SourceCount();
+        const int target_cnt = TargetCount();
+        pool.ParallelFor(N, [&](size_t begin, size_t end) {
+            Apply<ACCUM>(mx + begin * source_cnt,
+                    (nullptr != ax) ? ax + begin * source_cnt : nullptr,
+                    columns.Offset(begin * target_cnt), end - begin);
+        });
+    }
+
+private:
+    static constexpr int kBand = 4;
+
+    static std::vector<double> Starts(const REAL *const nx, int age_cnt)
+    {
+        std::vector<double> start(age_cnt);
+        double x = 0;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            start[age_idx] = x;
+            if (age_idx + 1 < age_cnt) {
+                if (!(nx[age_idx] > 0)) {
+                    throw std::invalid_argument("Age intervals must be positive.");
+                }
+                x += nx[age_idx];
+            }
+        }
+        return start;
+    }
+
+    std::vector<int> UnionIndices(const std::vector<double>& start, double tolerance) const
+    {
+        std::vector<int> indices(start.size());
+        for (size_t age_idx = 0; age_idx < start.size(); age_idx++) {
+            auto found = std::lower_bound(union_start_.begin(), union_start_.end(),
+                    start[age_idx] - tolerance);
+            indices[age_idx] = static_cast<int>(found - union_start_.begin());
+        }
+        return indices;
+    }
+
+    // Slopes of the cumulative hazard at the knots, limited as Fritsch
+    // and Carlson do, so that the spline is monotone in every interval.
+    template<typename ACCUM>
+    void Slopes(const ACCUM *const hazard, ACCUM *const slope) const
+    {
+        const int source_cnt = SourceCount();
+        if (source_cnt < 2) {
+            slope[0] = 0;
+            return;
+        }
+        ACCUM secant_left = 0;
+        for (int knot_idx = 0; knot_idx < source_cnt; knot_idx++) {
+            const ACCUM secant_right = (knot_idx + 1 < source_cnt) ?
+                    (hazard[knot_idx + 1] - hazard[knot_idx]) / ACCUM(width_[knot_idx]) :
+                    ACCUM(0);
+            slope[knot_idx] = ACCUM(slope_weight_[2 * knot_idx]) * secant_left +
+                    ACCUM(slope_weight_[2 * knot_idx + 1]) * secant_right;
+            secant_left = secant_right;
+        }
+        const int last_idx = source_cnt - 1;
+        if (last_idx > 1) {
+            slope[0] = EndSlope(hazard[0], hazard[1], hazard[2], width_[0], width_[1]);
+            slope[last_idx] = EndSlope(hazard[last_idx], hazard[last_idx - 1],
+                    hazard[last_idx - 2], -width_[last_idx - 1], -width_[last_idx - 2]);
+        }
+        for (int knot_idx = 0; knot_idx + 1 < source_cnt; knot_idx++) {
+            const ACCUM secant = (hazard[knot_idx + 1] - hazard[knot_idx]) /
+                    ACCUM(width_[knot_idx]);
+            if (!(secant > 0)) {
+                slope[knot_idx] = 0;
+                slope[knot_idx + 1] = 0;
+                continue;
+            }
+            const ACCUM alpha = std::max(slope[knot_idx], ACCUM(0)) / secant;
+            const ACCUM beta = std::max(slope[knot_idx + 1], ACCUM(0)) / secant;
+            const ACCUM radius = std::sqrt(alpha * alpha + beta * beta);
+            const ACCUM shrink = (radius > 3) ? 3 / radius : ACCUM(1);
+            slope[knot_idx] = shrink * alpha * secant;
+            slope[knot_idx + 1] = shrink * beta * secant;
+        }
+    }
+
+    // Slope at an end knot of the parabola through it and the next two
+    // knots, which are `near` and `far` widths away, signed toward them.
+    template<typename ACCUM>
+    static ACCUM EndSlope(ACCUM end, ACCUM next, ACCUM after, double near, double far)
+    {
+        const ACCUM secant_near = (next - end) / ACCUM(near);
+        const ACCUM secant_far = (after - next) / ACCUM(far);
+        return (ACCUM(2 * near + far) * secant_near - ACCUM(near) * secant_far) /
+                ACCUM(near + far);
+    }
+
+
+    // The source's cumulative hazard at each age and its person-years
+    // in each interval, as in `FullLifeTable`.
+    template<typename ACCUM>
+    void SourceTable(const REAL *const m, const REAL *const a, ACCUM *const hazard,
+            ACCUM *const person_years) const
+    {
+        const int source_cnt = SourceCount();
+        const ACCUM largest = std::numeric_limits<ACCUM>::max_exponent;
+        ACCUM l = 1;
+        for (int age_idx = 0; age_idx < source_cnt; age_idx++) {
+            const ACCUM m_age = m[age_idx];
+            const ACCUM px = (1 - m_age * a[age_idx]) /
+                    (1 + m_age * (source_nx_[age_idx] - a[age_idx]));
+            hazard[age_idx] = (l > 0) ? std::min(-std::log(l), largest) : largest;
+            if (age_idx == source_cnt - 1) {
+                person_years[age_idx] = ACCUM(a[age_idx]) * l;
+            } else {
+                person_years[age_idx] = ACCUM(source_nx_[age_idx]) * l * px +
+                        ACCUM(a[age_idx]) * l * (1 - px);
+            }
+            l *= px;
+        }
+    }
+
+    template<typename ACCUM>
+    ACCUM UnionPersonYears(const std::vector<ACCUM>& hazard, const std::vector<ACCUM>& lx,
+            int union_idx) const
+    {
+        // The survivors' difference is already at hand, and it loses
+        // little to cancellation unless the rise is small, where the
+        // series for (1 - exp(-rise)) / rise is as good as expm1 and cheaper.
+        const ACCUM width = union_start_[union_idx + 1] - union_start_[union_idx];
+        const ACCUM rise = hazard[union_idx + 1] - hazard[union_idx];
+        if (rise > ACCUM(1e-2)) {
+            return width * (lx[union_idx] - lx[union_idx + 1]) / rise;
+        }
+        return width * lx[union_idx] *
+                (1 - rise / 2 * (1 - rise / 3 * (1 - rise / 4 * (1 - rise / 5))));
+    }
+
+    template<typename ACCUM>
+    void WriteTarget(const std::vector<ACCUM>& lx, const std::vector<ACCUM>& Tx,
+            int target_idx, const LifeTableColumns<REAL>& columns, size_t value_idx) const
+    {
+        const int here = target_union_[target_idx];
+        const ACCUM l = lx[here];
+        const ACCUM T = Tx[here];
+        const bool open = (target_idx == TargetCount() - 1);
+        const ACCUM l_next = open ? ACCUM(0) : lx[target_union_[target_idx + 1]];
+        const ACCUM L = open ? T : T - Tx[target_union_[target_idx + 1]];
+        const ACCUM d = l - l_next;
+        if (nullptr != columns.ax) {
+            const ACCUM n = target_nx_[target_idx];
+            columns.ax[value_idx] = static_cast<REAL>(open ? T / l :
+                    ((d > 0) ? (L - n * l_next) / d : n / 2));
+        }
+        if (nullptr != columns.qx) {
+            columns.qx[value_idx] = static_cast<REAL>(d / l);
+        }
+        if (nullptr != columns.px) {
+            columns.px[value_idx] = static_cast<REAL>(l_next / l);
+        }
+        if (nullptr != columns.lx) {
+            columns.lx[value_idx] = static_cast<REAL>(l);
+        }
+        if (nullptr != columns.dx) {
+            columns.dx[value_idx] = static_cast<REAL>(d);
+        }
+        if (nullptr != columns.Lx) {
+            columns.Lx[value_idx] = static_cast<REAL>(L);
+        }
+        if (nullptr != columns.Tx) {
+            columns.Tx[value_idx] = static_cast<REAL>(T);
+        }
+        if (nullptr != columns.ex) {
+            columns.ex[value_idx] = static_cast<REAL>(T / l);
+        }
+    }
+
+    std::vector<REAL> source_nx_;
+    std::vector<REAL> target_nx_;
+    std::vector<double> union_start_;  //!< Ages of either schema.
+    std::vector<int> source_union_;    //!< Array[source age] into the union.
+    std::vector<int> target_union_;    //!< Array[target age] into the union.
+    std::vector<int> interval_;        //!< Array[union] of the source interval.
+    std::vector<double> basis_;        //!< Array[union,band] of the banded matrix.
+    std::vector<double> slope_weight_; //!< Array[source age,side] on each secant.
+    std::vector<double> width_;        //!< Array[source age] of finite widths.
+};
+
+
+//! Schema pairs whose operators `SharedExpansionOperator` keeps.
+constexpr size_t kSharedExpansionCacheSize = 16;
+
+
+/*! The operator for a pair of schemas, built on first use and kept
+ *  while it is among the `kSharedExpansionCacheSize` most recently used
+ *  pairs, so that callers that can't keep one between calls, such as
+ *  language bindings, build each about once. Callers that can should
+ *  own their `ExpansionOperator`.
+ */
+template<typename REAL>
+std::shared_ptr<const ExpansionOperator<REAL>> SharedExpansionOperator(
+        const REAL *const source_nx, int source_cnt, const REAL *const target_nx,
+        int target_cnt)
+{
+    using Key = std::pair<std::vector<REAL>, std::vector<REAL>>;
+    using Entry = std::pair<Key, std::shared_ptr<const ExpansionOperator<REAL>>>;
+    static std::mutex cache_mutex;
+    static std::vector<Entry> cache;  // Least recently used first.
+    Key key(std::vector<REAL>(source_nx, source_nx + std::max(source_cnt, 0)),
+            std::vector<REAL>(target_nx, target_nx + std::max(target_cnt, 0)));
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto found = std::find_if(cache.begin(), cache.end(),
+            [&key](const Entry& entry) { return entry.first == key; });
+    if (found != cache.end()) {
+        std::rotate(found, found + 1, cache.end());
+        return cache.back().second;
+    }
+    auto built = std::make_shared<const ExpansionOperator<REAL>>(
+            source_nx, source_cnt, target_nx, target_cnt);
+    if (cache.size() == kSharedExpansionCacheSize) {
+        cache.erase(cache.begin());
+    }
+    cache.emplace_back(std::move(key), built);
+    return built;
+}
+
+}
+
+#endif //FUNDEM_EXPANSION_HPP
@@ -0,0 +1,202 @@
+//
+// Branch-free elementary functions on Lanes.
+//
+
+#ifndef FUNDEM_FAST_MATH_HPP
+#define FUNDEM_FAST_MATH_HPP
+
+#include <cmath>
+#include <cstdint>
+#include "fundem/simd.hpp"
+
+
+namespace fundem {
+
+/*! Constants for exponentials and logarithms in each floating-point type.
+ *  The reduced argument r = x - k ln 2 has |r| <= ln(2)/2, where a
+ *  Taylor series of degree `kTerms` is accurate to rounding.
+ */
+template<typename REAL>
+struct ExpTraits;
+
+template<>
+struct ExpTraits<double> {
+    typedef std::int64_t integer;
+    static constexpr int kMantissaBits = 52;
+    static constexpr integer kBias = 1023;
+    static constexpr int kTerms = 13;
+    static constexpr int kLogTerms = 11;
+    // 1.5 * 2^52, which rounds to an integer when added.
+    static constexpr double kRoundingShift = 6755399441055744.0;
+    static constexpr double kInverseLn2 = 1.4426950408889634;
+    // ln 2 split so that k * kLn2High is exact for |k| < 2^11.
+    static constexpr double kLn2High = 0.693145751953125;
+    static constexpr double kLn2Low = 1.4286068203094173e-06;
+    static constexpr double kMaxArgument = 700.0;
+};
+
+template<>
+struct ExpTraits<float> {
+    typedef std::int32_t integer;
+    static constexpr int kMantissaBits = 23;
+    static constexpr integer kBias = 127;
+    static constexpr int kTerms = 8;
+    static constexpr int kLogTerms = 5;
+    // 1.5 * 2^23
+    static constexpr float kRoundingShift = 12582912.0f;
+    static constexpr float kInverseLn2 = 1.44269504f;
+    static constexpr float kLn2High = 0.693359375f;
+    static constexpr float kLn2Low = -2.12194440e-4f;
+    static constexpr float kMaxArgument = 85.0f;
+};
+
+
+/*! The Taylor series tail 1 + r/TERM (1 + r/(TERM+1) (... (1 + r/LAST))),
+ *  unrolled at compile time so that each coefficient is a constant
+ *  rather than a division in a loop the optimizer may keep.
+ */
+template<typename REAL, int LANES, int TERM, int LAST>
+struct ExpSeries {
+    static Lanes<REAL, LANES> Sum(const Lanes<REAL, LANES>& r)
+    {
+        typedef Lanes<REAL, LANES> V;
+        return V::Broadcast(1) + r * ExpSeries<REAL, LANES, TERM + 1, LAST>::Sum(r) *
+                V::Broadcast(REAL(1) / TERM);
+    }
+};
+
+template<typename REAL, int LANES, int LAST>
+struct ExpSeries<REAL, LANES, LAST, LAST> {
+    static Lanes<REAL, LANES> Sum(const Lanes<REAL, LANES>& r)
+    {
+        typedef Lanes<REAL, LANES> V;
+        return V::Broadcast(1) + r * V::Broadcast(1) * V::Broadcast(REAL(1) / LAST);
+    }
+};
+
+
+/*! Splits exp(x) = 2^k (1 + expm1(r)) for `Expm1` and `Exp`.
+ *
+ *  This reduces x = k ln 2 + r and sums a Taylor series for expm1(r).
+ *  2^k comes from integer arithmetic on the exponent bits, which
+ *  vectorizes. Arguments are clamped to `kMaxArgument` above, and to
+ *  -kMaxArgument below, so 2^k is always a normal number.
+ */
+template<typename REAL, int LANES>
+void ExpReduce(const Lanes<REAL, LANES>& x_in, Lanes<REAL, LANES>& two_k,
+        Lanes<REAL, LANES>& expm1_r)
+{
+    typedef Lanes<REAL, LANES> V;
+    typedef ExpTraits<REAL> T;
+    const V max_argument = V::Broadcast(T::kMaxArgument);
+    V x = Min(Max(x_in, V::Broadcast(-T::kMaxArgument)), max_argument);
+
+    const V shift = V::Broadcast(T::kRoundingShift);
+    const V shifted = x * V::Broadcast(T::kInverseLn2) + shift;
+    const V k = shifted - shift;
+    const V r = (x - k * V::Broadcast(T::kLn2High)) - k * V::Broadcast(T::kLn2Low);
+
+    // Horner's rule for r + r^2/2! + ... + r^kTerms/kTerms!.
+    expm1_r = r * ExpSeries<REAL, LANES, 2, T::kTerms>::Sum(r);
+
+#if defined(__GNUC__)
+    // Adding the shift left k in the low bits of the mantissa.
+    typedef typename T::integer integer;
+    typedef integer integer_vector __attribute__((vector_size(sizeof(REAL) * LANES)));
+    integer_vector shifted_bits, shift_bits;
+    std::memcpy(&shifted_bits, &shifted.v, sizeof(shifted_bits));
+    std::memcpy(&shift_bits, &shift.v, sizeof(shift_bits));
+    integer_vector exponent = ((shifted_bits - shift_bits) + T::kBias) << T::kMantissaBits;
+    std::memcpy(&two_k.v, &exponent, sizeof(two_k.v));
+#else
+    for (int lane = 0; lane < LANES; lane++) {
+        two_k.v[lane] = std::ldexp(REAL(1), static_cast<int>(k.v[lane]));
+    }
+#endif
+}
+
+
+/*! exp(x) - 1 for every lane, without branches.
+ *
+ *  This rebuilds 2^k (1 + expm1(r)) - 1 as 2^k expm1(r) + (2^k - 1),
+ *  so there is no cancellation when x is small. Below -kMaxArgument,
+ *  the result rounds to -1. The relative error is within about two
+ *  units in the last place.
+ */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> Expm1(const Lanes<REAL, LANES>& x)
+{
+    Lanes<REAL, LANES> two_k, expm1_r;
+    ExpReduce(x, two_k, expm1_r);
+    return two_k * expm1_r + (two_k - Lanes<REAL, LANES>::Broadcast(1));
+}
+
+
+/*! exp(x) for every lane, without branches. Arguments below
+ *  -kMaxArgument give exp(-kMaxArgument) rather than underflowing.
+ */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> Exp(const Lanes<REAL, LANES>& x)
+{
+    Lanes<REAL, LANES> two_k, expm1_r;
+    ExpReduce(x, two_k, expm1_r);
+    return two_k * expm1_r + two_k;
+}
+
+
+/*! The natural logarithm of every lane, without branches.
+ *
+ *  This splits x = 2^e m with m in [sqrt(1/2), sqrt(2)) and sums
+ *  log m = 2 atanh(s) = 2 (s + s^3/3 + s^5/5 + ...), where
+ *  s = (m - 1) / (m + 1), so |s| < 0.172 and `kLogTerms` terms reach
+ *  rounding. Lanes must hold positive, finite, normal numbers. The
+ *  relative error is within a few units in the last place.
+ */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> Log(const Lanes<REAL, LANES>& x)
+{
+    typedef Lanes<REAL, LANES> V;
+    typedef ExpTraits<REAL> T;
+    V mantissa, exponent;
+#if defined(__GNUC__)
+    typedef typename T::integer integer;
+    typedef integer integer_vector __attribute__((vector_size(sizeof(REAL) * LANES)));
+    const integer mantissa_mask = (integer(1) << T::kMantissaBits) - 1;
+    integer_vector bits;
+    std::memcpy(&bits, &x.v, sizeof(bits));
+    // A zero exponent puts the mantissa in [1, 2).
+    integer_vector mantissa_bits = (bits & mantissa_mask) | (T::kBias << T::kMantissaBits);
+    std::memcpy(&mantissa.v, &mantissa_bits, sizeof(mantissa.v));
+    // The biased exponent, in the low bits of 2^kMantissaBits, converts
+    // to floating point by subtraction.
+    const V low_bits = V::Broadcast(REAL(integer(1) << T::kMantissaBits));
+    integer_vector exponent_bits;
+    std::memcpy(&exponent_bits, &low_bits.v, sizeof(exponent_bits));
+    exponent_bits = exponent_bits | (bits >> T::kMantissaBits);
+    std::memcpy(&exponent.v, &exponent_bits, sizeof(exponent.v));
+    exponent = exponent - low_bits - V::Broadcast(REAL(T::kBias));
+#else
+    for (int lane = 0; lane < LANES; lane++) {
+        int lane_exponent;
+        mantissa.v[lane] = 2 * std::frexp(x.v[lane], &lane_exponent);
+        exponent.v[lane] = lane_exponent - 1;
+    }
+#endif
+    const V one = V::Broadcast(1);
+    const auto high = mantissa > V::Broadcast(REAL(1.4142135623730951));
+    mantissa = Select(high, mantissa * V::Broadcast(REAL(0.5)), mantissa);
+    exponent = Select(high, exponent + one, exponent);
+
+    const V s = (mantissa - one) / (mantissa + one);
+    const V s2 = s * s;
+    V series = V::Broadcast(REAL(1) / (2 * T::kLogTerms + 1));
+    for (int term = T::kLogTerms - 1; term >= 0; term--) {
+        series = V::Broadcast(REAL(1) / (2 * term + 1)) + s2 * series;
+    }
+    return exponent * V::Broadcast(T::kLn2High) +
+            (exponent * V::Broadcast(T::kLn2Low) + V::Broadcast(2) * s * series);
+}
+
+}
+
+#endif //FUNDEM_FAST_MATH_HPP
@@ -0,0 +1,308 @@
+//
+// Fits parametric hazards to observed mortality rates, one small
+// least-squares problem per population.
+//
+
+#ifndef FUNDEM_FIT_HPP
+#define FUNDEM_FIT_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "fundem/cholesky.hpp"
+#include "fundem/hazards.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! How a fit ended for one population. */
+enum class FitOutcome : int {
+    Converged = 0,      //!< The step, or the drop in the sum of squares, fell below tolerance.
+    MaxIterations = 1,  //!< Iteration hit its limit, and the parameters are the best found.
+    Failed = 2          //!< The start wasn't usable, so the parameters are unchanged.
+};
+
+
+/*! Records each population's fit into caller-owned arrays.
+ *
+ *  Each pointer is Array[pop], or nullptr for a record the caller
+ *  doesn't want. Populations write only their own entries, so one
+ *  record can go to a pool of threads.
+ */
+struct HazardFitRecord {
+    int* outcome{nullptr};      //!< A `FitOutcome`, as an int.
+    int* iterations{nullptr};   //!< Levenberg-Marquardt steps tried.
+    double* cost{nullptr};      //!< Half the sum of squared log residuals.
+
+    void Finish(size_t pop_idx, FitOutcome result, int iteration_cnt, double final_cost) const
+    {
+        if (nullptr != outcome) {
+            outcome[pop_idx] = static_cast<int>(result);
+        }
+        if (nullptr != iterations) {
+            iterations[pop_idx] = iteration_cnt;
+        }
+        if (nullptr != cost) {
+            cost[pop_idx] = final_cost;
+        }
+    }
+
+    HazardFitRecord Offset(size_t offset) const
+    {
+        HazardFitRecord shifted;
+        shifted.outcome = (nullptr != outcome) ? outcome + offset : nullptr;
+        shifted.iterations = (nullptr != iterations) ? iterations + offset : nullptr;
+        shifted.cost = (nullptr != cost) ? cost + offset : nullptr;
+        return shifted;
+    }
+};
+
+
+/*! Log residuals and their Jacobian for one population's fit.
+ *  Residuals of ages without a positive, finite observation are zero.
+ *
+ * @return Half the sum of squared residuals, or infinity if the model
+ *     isn't finite and positive at every observed age.
+ */
+template<template<typename> class HAZARD>
+double HazardResiduals(
+        const double *const log_parameters, const double *const ages,
+        const double *const log_mx, int age_cnt, double *const residual,
+        double *const jacobian)
+{
+    const int parameter_cnt = HAZARD<double>::kParameterCount;
+    double parameters[HAZARD<double>::kParameterCount];
+    for (int param_idx = 0; param_idx < parameter_cnt; param_idx++) {
+        parameters[param_idx] = std::exp(log_parameters[param_idx]);
+    }
+    const HAZARD<double> hazard(parameters);
+    double cost = 0;
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        double* row = jacobian + age_idx * parameter_cnt;
+        if (std::isnan(log_mx[age_idx])) {
+            residual[age_idx] = 0;
+            std::fill(row, row + parameter_cnt, 0.0);
+            continue;
+        }
+        const double rate = hazard.LogGradient(ages[age_idx], row);
+        if (!(rate > 0) || !std::isfinite(rate)) {
+            return std::numeric_limits<double>::infinity();
+        }
+        residual[age_idx] = std::log(rate) - log_mx[age_idx];
+        cost += residual[age_idx] * residual[age_idx];
+    }
+    return 0.5 * cost;
+}
+
+
+/*! Fits a parametric hazard to observed mortality rates for every
+ *  population, by Levenberg-Marquardt with analytic Jacobians.
+ *
+ *  The fit minimizes the squared difference between the logarithms of
+ *  the model and the observed rates, so that small rates at young ages
+ *  count as much as large ones at old ages. The model is sampled as
+ *  `HazardRates` does with `HazardSample::Midpoint`, at the middle of
+ *  each interval and at the start of an open interval, so those rates
+ *  reproduce the fit. Ages where the observed rate isn't positive and
+ *  finite don't count. Parameters are fit as logarithms, so they stay
+ *  positive, and every starting parameter must be positive. The fit
+ *  runs in double whatever REAL is, because the normal equations square
+ *  the conditioning of the problem.
+ *
+ *  Populations come in chains of `chain_cnt`, such as the draws of one
+ *  location and year. The first population of each chain starts from
+ *  its own parameters. Each later one starts from the fit before it,
+ *  if that converged, which usually takes a few steps from a close
+ *  neighbor. Chains, not populations, are shared among threads, so
+ *  results don't depend on the thread count.
+ *
+ * @tparam HAZARD `GompertzHazard`, `GompertzMakehamHazard`,
+ *     `SilerHazard`, `HeligmanPollardHazard`, or another class with
+ *     `LogGradient`.
+ * @tparam REAL Type of the arrays.
+ * @param mx Array[pop,age] of observed mortality rates.
+ * @param nx Array[age] of interval widths.
+ * @param parameters Array[pop,param], the starting parameters on
+ *     input and the fit parameters on output.
+ * @param record Outcome, iterations, and final cost for each population.
+ * @param age_cnt Number of age groups.
+ * @param N Number of populations.
+ * @param chain_cnt Populations in each warm-started chain.
+ * @param max_iterations Limit on steps for each population.
+ */
+template<template<typename> class HAZARD, typename REAL>
+void FitHazard(
+        const REAL *const mx, const REAL *const nx, REAL *const parameters,
+        const HazardFitRecord& record, int age_cnt, size_t N, size_t chain_cnt = 1,
+        int max_iterations = 100)
+{
+    const int parameter_cnt = HAZARD<double>::kParameterCount;
+    // The step is in log parameters, so this is a relative change.
+    const double step_tolerance = std::sqrt(std::numeric_limits<REAL>::epsilon());
+    const double cost_tolerance = std::numeric_limits<REAL>::epsilon();
+    const double max_damping = 1e16;
+    chain_cnt = std::max(chain_cnt, size_t(1));
+
+    std::vector<double> ages(age_cnt);
+    double x = 0;
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        ages[age_idx] = std::isinf(nx[age_idx]) ? x : x + 0.5 * nx[age_idx];
+        x += nx[age_idx];
+    }
+    std::vector<double> log_mx(age_cnt);
+    std::vector<double> residual(age_cnt), trial_residual(age_cnt);
+    std::vector<double> jacobian(age_cnt * parameter_cnt), trial_jacobian(age_cnt * parameter_cnt);
+    double theta[HAZARD<double>::kParameterCount];
+    double trial[HAZARD<double>::kParameterCount];
+    double gradient[HAZARD<double>::kParameterCount];
+    double step[HAZARD<double>::kParameterCount];
+    double normal[HAZARD<double>::kParameterCount * HAZARD<double>::kParameterCount];
+    double system[HAZARD<double>::kParameterCount * HAZARD<double>::kParameterCount];
+
+    bool previous_converged = false;
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        REAL* fit = parameters + pop_idx * parameter_cnt;
+        const REAL* observed = mx + pop_idx * age_cnt;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const double rate = observed[age_idx];
+            log_mx[age_idx] = (rate > 0 && std::isfinite(rate)) ? std::log(rate)
+                    : std::numeric_limits<double>::quiet_NaN();
+        }
+        const REAL* start = (pop_idx % chain_cnt != 0 && previous_converged)
+                ? fit - parameter_cnt : fit;
+        bool usable = true;
+        for (int param_idx = 0; param_idx < parameter_cnt; param_idx++) {
+            usable = usable && start[param_idx] > 0 && std::isfinite(start[param_idx]);
+            theta[param_idx] = std::log(static_cast<double>(start[param_idx]));
+        }
+        double cost = usable ? HazardResiduals<HAZARD>(
+                theta, &ages[0], &log_mx[0], age_cnt, &residual[0], &jacobian[0])
+                : std::numeric_limits<double>::infinity();
+        if (!std::isfinite(cost)) {
+            record.Finish(pop_idx, FitOutcome::Failed, 0, cost);
+            previous_converged = false;
+            continue;
+        }
+
+        FitOutcome outcome = FitOutcome::MaxIterations;
+        double damping = 1e-3;
+        bool refresh = true;
+        int iteration_cnt = 0;
+        while (iteration_cnt < max_iterations) {
+            if (refresh) {
+                // Normal equations J^T J and gradient J^T r.
+                for (int row_idx = 0; row_idx < parameter_cnt; row_idx++) {
+                    double g = 0;
+                    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                        g += jacobian[age_idx * parameter_cnt + row_idx] * residual[age_idx];
+                    }
+                    gradient[row_idx] = g;
+                    for (int col_idx = 0; col_idx <= row_idx; col_idx++) {
+                        double sum = 0;
+                        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                            sum += jacobian[age_idx * parameter_cnt + row_idx] *
+                                    jacobian[age_idx * parameter_cnt + col_idx];
+                        }
+                        normal[row_idx * parameter_cnt + col_idx] = sum;
+                        normal[col_idx * parameter_cnt + row_idx] = sum;
+                    }
+                }
+                refresh = false;
+            }
+            iteration_cnt++;
+
+            // Marquardt's scaling damps each parameter by its own curvature,
+            // with a floor for parameters the data barely constrain.
+            double largest_diagonal = 0;
+            for (int param_idx = 0; param_idx < parameter_cnt; param_idx++) {
+                largest_diagonal = std::max(
+                        largest_diagonal, normal[param_idx * (parameter_cnt + 1)]);
+            }
+            std::copy(normal, normal + parameter_cnt * parameter_cnt, system);
+            for (int param_idx = 0; param_idx < parameter_cnt; param_idx++) {
+                const double diagonal = std::max(normal[param_idx * (parameter_cnt + 1)],
+                        1e-12 * largest_diagonal);
+                system[param_idx * (parameter_cnt + 1)] += damping * diagonal;
+                step[param_idx] = -gradient[param_idx];
+            }
+            if (!CholeskySolve(system, parameter_cnt, step, parameter_cnt)) {
+                damping *= 10;
+                if (damping > max_damping) {
+                    break;
+                }
+                continue;
+            }
+
+            double step_size = 0;
+            for (int param_idx = 0; param_idx < parameter_cnt; param_idx++) {
+                step_size = std::max(step_size, std::abs(step[param_idx]));
+            }
+            // A parameter that barely matters, such as B of Heligman-Pollard
+            // far from its childhood hump, can take a step so long it
+            // flattens the model, so no step multiplies a parameter by more
+            // than e.
+            const double shrink = (step_size > 1) ? 1 / step_size : 1;
+            step_size *= shrink;
+            for (int param_idx = 0; param_idx < parameter_cnt; param_idx++) {
+                trial[param_idx] = theta[param_idx] + shrink * step[param_idx];
+            }
+            const double trial_cost = HazardResiduals<HAZARD>(
+                    trial, &ages[0], &log_mx[0], age_cnt, &trial_residual[0],
+                    &trial_jacobian[0]);
+            if (trial_cost < cost) {
+                const double drop = cost - trial_cost;
+                std::copy(trial, trial + parameter_cnt, theta);
+                residual.swap(trial_residual);
+                jacobian.swap(trial_jacobian);
+                cost = trial_cost;
+                refresh = true;
+                damping = std::max(damping / 3, 1e-12);
+                if (step_size <= step_tolerance || drop <= cost_tolerance * cost) {
+                    outcome = FitOutcome::Converged;
+                    break;
+                }
+            } else {
+                if (step_size <= step_tolerance) {
+                    // No smaller step can help, so this is a minimum.
+                    outcome = FitOutcome::Converged;
+                    break;
+                }
+                damping *= 2;
+                if (damping > max_damping) {
+                    break;
+                }
+            }
+        }
+
+        for (int param_idx = 0; param_idx < parameter_cnt; param_idx++) {
+            fit[param_idx] = static_cast<REAL>(std::exp(theta[param_idx]));
+        }
+        record.Finish(pop_idx, outcome, iteration_cnt, cost);
+        previous_converged = (FitOutcome::Converged == outcome);
+    }
+}
+
+
+template<template<typename> class HAZARD, typename REAL>
+void FitHazard(
+        const REAL *const mx, const REAL *const nx, REAL *const parameters,
+        const HazardFitRecord& record, int age_cnt, size_t N, ThreadPool& pool,
+        size_t chain_cnt = 1, int max_iterations = 100)
+{
+    const int parameter_cnt = HAZARD<REAL>::kParameterCount;
+    chain_cnt = std::max(chain_cnt, size_t(1));
+    const size_t chain_total = (N + chain_cnt - 1) / chain_cnt;
+    pool.ParallelFor(chain_total, [=](size_t begin, size_t end) {
+        const size_t first = begin * chain_cnt;
+        const size_t last = std::min(end * chain_cnt, N);
+        FitHazard<HAZARD>(mx + first * age_cnt, nx, parameters + first * parameter_cnt,
+                record.Offset(first), age_cnt, last - first, chain_cnt, max_iterations);
+    });
+}
+
+}
+
+#endif //FUNDEM_FIT_HPP
@@ -0,0 +1,157 @@
+//
+// What graduation did for each population, for tuning and diagnosis.
+//
+
+#ifndef FUNDEM_GRADUATION_MONITOR_HPP
+#define FUNDEM_GRADUATION_MONITOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+namespace fundem {
+
+/*! How graduation ended for one population. Only converged populations
+ *  keep the graduated ax. The others keep constant-mortality ax.
+ */
+enum class GraduationOutcome : int {
+    Converged = 0,  //!< The change in ax fell below the tolerance.
+    Diverged = 1,   //!< The change in ax grew, so iteration stopped.
+    Fallback = 2    //!< Iteration hit its limit without converging.
+};
+
+
+/*! The monitor that graduation uses unless it's given another.
+ *  Every call is empty and inline, so the compiler removes them and
+ *  uninstrumented graduation costs what it did before monitors existed.
+ *
+ *  A monitor is a small value that graduation copies. It's told when
+ *  each population starts and how it finished, with population indices
+ *  that count from the start of the arrays the kernel was given.
+ */
+struct NullGraduationMonitor {
+    int Start() const { return 0; }
+
+    void Finish(size_t, int, int, double, GraduationOutcome) const {}
+
+    /*! The same monitor for a kernel that starts `offset` populations later. */
+    NullGraduationMonitor Offset(size_t) const { return *this; }
+};
+
+
+/*! Records graduation for each population into caller-owned arrays.
+ *
+ *  Each pointer is Array[pop], or nullptr for a record the caller
+ *  doesn't want. Populations write only their own entries, so one
+ *  recorder can go to a pool of threads. The clock is read only if
+ *  `seconds` is wanted.
+ */
+struct GraduationRecorder {
+    using Clock = std::chrono::steady_clock;
+
+    int* iterations{nullptr};   //!< Fixed-point iterations taken.
+    double* difference{nullptr};  //!< Largest change in ax on the last iteration.
+    int* outcome{nullptr};      //!< A `GraduationOutcome`, as an int.
+    double* seconds{nullptr};   //!< Wall time for the population.
+
+    Clock::time_point Start() const
+    {
+        return (nullptr != seconds) ? Clock::now() : Clock::time_point();
+    }
+
+    void Finish(size_t pop_idx, Clock::time_point started, int iteration_cnt,
+            double last_difference, GraduationOutcome result) const
+    {
+        if (nullptr != seconds) {
+            seconds[pop_idx] = std::chrono::duration<double>(Clock::now() - started).count();
+        }
+        if (nullptr != iterations) {
+            iterations[pop_idx] = iteration_cnt;
+        }
+        if (nullptr != difference) {
+            difference[pop_idx] = last_difference;
+        }
+        if (nullptr != outcome) {
+            outcome[pop_idx] = static_cast<int>(result);
+        }
+    }
+
+    GraduationRecorder Offset(size_t offset) const
+    {
+        GraduationRecorder shifted;
+        shifted.iterations = (nullptr != iterations) ? iterations + offset : nullptr;
+        shifted.difference = (nullptr != difference) ? difference + offset : nullptr;
+        shifted.outcome = (nullptr != outcome) ? outcome + offset : nullptr;
+        shifted.seconds = (nullptr != seconds) ? seconds + offset : nullptr;
+        return shifted;
+    }
+};
+
+
+/*! Totals over the populations of a `GraduationRecorder`. Entries that
+ *  depend on a record the recorder didn't keep are left empty.
+ */
+struct GraduationSummary {
+    size_t converged_cnt{0};
+    size_t diverged_cnt{0};
+    size_t fallback_cnt{0};
+    //! Entry k counts populations that took k iterations.
+    std::vector<size_t> iteration_histogram;
+    //! Entry k counts populations that took [2^k, 2^(k+1)) nanoseconds,
+    //! with anything under two nanoseconds in entry 0.
+    std::vector<size_t> time_histogram;
+    double total_seconds{0};
+    double max_seconds{0};
+    size_t slowest_pop_idx{0};  //!< The population that took `max_seconds`.
+};
+
+
+/*! Bucket of `GraduationSummary::time_histogram` for a duration. */
+inline size_t GraduationTimeBucket(double seconds)
+{
+    const double nanoseconds = seconds * 1e9;
+    return (nanoseconds < 2) ? 0 : static_cast<size_t>(std::floor(std::log2(nanoseconds)));
+}
+
+
+inline GraduationSummary SummarizeGraduation(const GraduationRecorder& record, size_t pop_cnt)
+{
+    GraduationSummary summary;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        if (nullptr != record.outcome) {
+            switch (static_cast<GraduationOutcome>(record.outcome[pop_idx])) {
+                case GraduationOutcome::Converged: summary.converged_cnt++; break;
+                case GraduationOutcome::Diverged: summary.diverged_cnt++; break;
+                case GraduationOutcome::Fallback: summary.fallback_cnt++; break;
+            }
+        }
+        if (nullptr != record.iterations) {
+            const size_t iteration_cnt = static_cast<size_t>(record.iterations[pop_idx]);
+            if (iteration_cnt >= summary.iteration_histogram.size()) {
+                summary.iteration_histogram.resize(iteration_cnt + 1);
+            }
+            summary.iteration_histogram[iteration_cnt]++;
+        }
+        if (nullptr != record.seconds) {
+            const double seconds = record.seconds[pop_idx];
+            const size_t bucket = GraduationTimeBucket(seconds);
+            if (bucket >= summary.time_histogram.size()) {
+                summary.time_histogram.resize(bucket + 1);
+            }
+            summary.time_histogram[bucket]++;
+            summary.total_seconds += seconds;
+            if (seconds > summary.max_seconds) {
+                summary.max_seconds = seconds;
+                summary.slowest_pop_idx = pop_idx;
+            }
+        }
+    }
+    return summary;
+}
+
+}
+
+#endif //FUNDEM_GRADUATION_MONITOR_HPP
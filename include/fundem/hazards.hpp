@@ -5,7 +5,14 @@
 #ifndef FUNDEM_HAZARDS_HPP
 #define FUNDEM_HAZARDS_HPP
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "fundem/fast_math.hpp"
+#include "fundem/simd.hpp"
+#include "fundem/thread_pool.hpp"
 
 
 /*! Siler hazard rate with default values
@@ -38,4 +45,355 @@ REAL siler_default(REAL x, REAL t) {
 }
 
 
+namespace fundem {
+
+/*! How `HazardRates` turns a hazard into a rate for each interval. */
+enum class HazardSample : int {
+    IntervalAverage = 0,  //!< The mean hazard over a closed interval.
+    Midpoint = 1          //!< The hazard at the middle of the interval.
+};
+
+
+/*! The integral of exp(b t) over [x, x + n), which is n exp(b x) when
+ *  b is zero.
+ */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> ExpIntegral(REAL b, const Lanes<REAL, LANES>& x,
+        const Lanes<REAL, LANES>& n)
+{
+    typedef Lanes<REAL, LANES> V;
+    if (0 == b) {
+        return n * Exp(x * V::Broadcast(b));
+    }
+    return Exp(x * V::Broadcast(b)) * Expm1(n * V::Broadcast(b)) / V::Broadcast(b);
+}
+
+
+/*! Gompertz hazard, a exp(b x).
+ *  Parameters are a, b.
+ */
+template<typename REAL>
+struct GompertzHazard {
+    static constexpr int kParameterCount = 2;
+    REAL a;
+    REAL b;
+
+    explicit GompertzHazard(const REAL *const parameters)
+        : a(parameters[0]), b(parameters[1]) {}
+
+    template<int LANES>
+    Lanes<REAL, LANES> Rate(const Lanes<REAL, LANES>& x) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        return V::Broadcast(a) * Exp(x * V::Broadcast(b));
+    }
+
+    /*! The hazard integrated over [x, x + n). */
+    template<int LANES>
+    Lanes<REAL, LANES> Cumulative(const Lanes<REAL, LANES>& x, const Lanes<REAL, LANES>& n) const
+    {
+        return Lanes<REAL, LANES>::Broadcast(a) * ExpIntegral(b, x, n);
+    }
+
+    /*! The hazard at x, and in `gradient` the derivatives of its
+     *  logarithm with respect to the logarithm of each parameter.
+     */
+    REAL LogGradient(REAL x, REAL *const gradient) const
+    {
+        gradient[0] = 1;
+        gradient[1] = b * x;
+        return a * std::exp(b * x);
+    }
+};
+
+
+/*! Gompertz-Makeham hazard, c + a exp(b x).
+ *  Parameters are a, b, c.
+ */
+template<typename REAL>
+struct GompertzMakehamHazard {
+    static constexpr int kParameterCount = 3;
+    GompertzHazard<REAL> gompertz;
+    REAL c;
+
+    explicit GompertzMakehamHazard(const REAL *const parameters)
+        : gompertz(parameters), c(parameters[2]) {}
+
+    template<int LANES>
+    Lanes<REAL, LANES> Rate(const Lanes<REAL, LANES>& x) const
+    {
+        return Lanes<REAL, LANES>::Broadcast(c) + gompertz.Rate(x);
+    }
+
+    template<int LANES>
+    Lanes<REAL, LANES> Cumulative(const Lanes<REAL, LANES>& x, const Lanes<REAL, LANES>& n) const
+    {
+        return Lanes<REAL, LANES>::Broadcast(c) * n + gompertz.Cumulative(x, n);
+    }
+
+    REAL LogGradient(REAL x, REAL *const gradient) const
+    {
+        const REAL senescence = gompertz.a * std::exp(gompertz.b * x);
+        const REAL rate = c + senescence;
+        gradient[0] = senescence / rate;
+        gradient[1] = gompertz.b * x * senescence / rate;
+        gradient[2] = c / rate;
+        return rate;
+    }
+};
+
+
+/*! Siler hazard, a1 exp(-b1 x) + a2 exp(b2 x) + a3, for infant,
+ *  senescent, and background mortality. Parameters are a1, b1, a2, b2,
+ *  a3. `siler_default(x, t)` is this with a1 = 0.2 exp(-0.015 t),
+ *  b1 = 1, a2 = 0.0002 exp(-0.01 t), b2 = 0.1, and a3 = 0.003 exp(-0.01 t).
+ */
+template<typename REAL>
+struct SilerHazard {
+    static constexpr int kParameterCount = 5;
+    REAL a1;
+    REAL b1;
+    REAL a2;
+    REAL b2;
+    REAL a3;
+
+    explicit SilerHazard(const REAL *const parameters)
+        : a1(parameters[0]), b1(parameters[1]), a2(parameters[2]), b2(parameters[3]),
+          a3(parameters[4]) {}
+
+    template<int LANES>
+    Lanes<REAL, LANES> Rate(const Lanes<REAL, LANES>& x) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        return V::Broadcast(a1) * Exp(x * V::Broadcast(-b1)) +
+                V::Broadcast(a2) * Exp(x * V::Broadcast(b2)) + V::Broadcast(a3);
+    }
+
+    template<int LANES>
+    Lanes<REAL, LANES> Cumulative(const Lanes<REAL, LANES>& x, const Lanes<REAL, LANES>& n) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        return V::Broadcast(a1) * ExpIntegral(-b1, x, n) +
+                V::Broadcast(a2) * ExpIntegral(b2, x, n) + V::Broadcast(a3) * n;
+    }
+
+    REAL LogGradient(REAL x, REAL *const gradient) const
+    {
+        const REAL infant = a1 * std::exp(-b1 * x);
+        const REAL senescence = a2 * std::exp(b2 * x);
+        const REAL rate = infant + senescence + a3;
+        gradient[0] = infant / rate;
+        gradient[1] = -b1 * x * infant / rate;
+        gradient[2] = senescence / rate;
+        gradient[3] = b2 * x * senescence / rate;
+        gradient[4] = a3 / rate;
+        return rate;
+    }
+};
+
+
+/*! Heligman-Pollard mortality, which models the odds of death within
+ *  a year of age x as
+ *
+ *      q/p = A^((x + B)^C) + D exp(-E (ln x - ln F)^2) + G H^x,
+ *
+ *  for childhood, the accident hump, and senescence. The hazard is
+ *  log(1 + q/p), which gives those odds over each year. Parameters are
+ *  A through H, with A, B, F, and H positive. This hazard has no closed
+ *  integral, so `Cumulative` uses five-point Gauss-Legendre quadrature
+ *  in the logarithm of x + B.
+ */
+template<typename REAL>
+struct HeligmanPollardHazard {
+    static constexpr int kParameterCount = 8;
+    REAL B;
+    REAL C;
+    REAL D;
+    REAL E;
+    REAL log_A;
+    REAL log_F;
+    REAL G;
+    REAL log_H;
+
+    explicit HeligmanPollardHazard(const REAL *const parameters)
+        : B(parameters[1]), C(parameters[2]), D(parameters[3]), E(parameters[4]),
+          log_A(std::log(parameters[0])), log_F(std::log(parameters[5])), G(parameters[6]),
+          log_H(std::log(parameters[7])) {}
+
+    /*! The odds of death, q/p, at ages zero and above. */
+    template<int LANES>
+    Lanes<REAL, LANES> Odds(const Lanes<REAL, LANES>& x) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        const V child = Exp(Exp(V::Broadcast(C) * Log(x + V::Broadcast(B))) *
+                V::Broadcast(log_A));
+        const V distance = Log(x) - V::Broadcast(log_F);
+        // The hump vanishes at birth, where ln x isn't finite.
+        const V hump = Select(x > V::Broadcast(0),
+                V::Broadcast(D) * Exp(V::Broadcast(-E) * distance * distance), V::Broadcast(0));
+        const V senescence = V::Broadcast(G) * Exp(x * V::Broadcast(log_H));
+        return child + hump + senescence;
+    }
+
+    template<int LANES>
+    Lanes<REAL, LANES> Rate(const Lanes<REAL, LANES>& x) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        // log1p(odds) as log(u) odds / (u - 1), which corrects the
+        // rounding of u = 1 + odds.
+        const V odds = Odds(x);
+        const V u = V::Broadcast(1) + odds;
+        const V rounded = u - V::Broadcast(1);
+        return Select(rounded <= V::Broadcast(0), odds, Log(u) * odds / rounded);
+    }
+
+    /*! The hazard integrated over [x, x + n), in u = ln(x + B), where
+     *  the childhood term, which is steep near birth, is smooth.
+     */
+    template<int LANES>
+    Lanes<REAL, LANES> Cumulative(const Lanes<REAL, LANES>& x, const Lanes<REAL, LANES>& n) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        const REAL nodes[] = {0, REAL(0.5384693101056831), REAL(0.9061798459386640)};
+        const REAL weights[] = {
+                REAL(0.5688888888888889), REAL(0.4786286704993665), REAL(0.2369268850561891)};
+        const V shift = V::Broadcast(B);
+        const V low = Log(x + shift);
+        const V half_width = V::Broadcast(REAL(0.5)) * (Log(x + n + shift) - low);
+        const V middle = low + half_width;
+        // dx = exp(u) du.
+        auto integrand = [&](const V& u) {
+            const V age_shifted = Exp(u);
+            return Rate(age_shifted - shift) * age_shifted;
+        };
+        V sum = V::Broadcast(weights[0]) * integrand(middle);
+        for (int node_idx = 1; node_idx < 3; node_idx++) {
+            const V offset = V::Broadcast(nodes[node_idx]) * half_width;
+            sum = sum + V::Broadcast(weights[node_idx]) *
+                    (integrand(middle - offset) + integrand(middle + offset));
+        }
+        return half_width * sum;
+    }
+
+    /*! Ages must be positive, where the accident hump is defined. */
+    REAL LogGradient(REAL x, REAL *const gradient) const
+    {
+        const REAL shifted = x + B;
+        const REAL power = std::exp(C * std::log(shifted));
+        const REAL child = std::exp(log_A * power);
+        const REAL distance = std::log(x) - log_F;
+        const REAL hump = D * std::exp(-E * distance * distance);
+        const REAL senescence = G * std::exp(log_H * x);
+        const REAL odds = child + hump + senescence;
+        const REAL rate = std::log1p(odds);
+        // d log(rate) / d odds.
+        const REAL scale = 1 / ((1 + odds) * rate);
+        gradient[0] = scale * child * power;
+        gradient[1] = scale * child * log_A * C * power * B / shifted;
+        gradient[2] = scale * child * log_A * power * std::log(shifted) * C;
+        gradient[3] = scale * hump;
+        gradient[4] = -scale * E * distance * distance * hump;
+        gradient[5] = scale * 2 * E * distance * hump;
+        gradient[6] = scale * senescence;
+        gradient[7] = scale * x * senescence;
+        return rate;
+    }
+};
+
+
+/*! Mortality rates from a parametric hazard for every population.
+ *
+ *  Each population has its own parameters, and rates for LANES age
+ *  groups at a time come from vectorized exponentials and logarithms.
+ *  With `HazardSample::IntervalAverage`, an interval's rate is its
+ *  integrated hazard divided by its width, which is the constant rate
+ *  that gives the same survival through the interval, so lifetables
+ *  with constant-mortality ax reproduce the hazard's survival exactly.
+ *  `HazardSample::Midpoint` samples the hazard at the middle of each
+ *  interval instead. Under either, an open interval, with infinite
+ *  width, takes the hazard at its start, not an average over the rest
+ *  of life, so its rate isn't the inverse of the hazard's expectation
+ *  of life there. An open interval may start at age zero.
+ *
+ * @tparam HAZARD `GompertzHazard`, `GompertzMakehamHazard`,
+ *     `SilerHazard`, `HeligmanPollardHazard`, or another class with the
+ *     same members.
+ * @tparam REAL Type of the arrays.
+ * @tparam LANES Ages computed together.
+ * @param parameters Array[pop,param] of `HAZARD::kParameterCount`
+ *     parameters for each population.
+ * @param nx Array[age] of interval widths.
+ * @param mx Array[pop,age], output mortality rates.
+ * @param age_cnt Number of age groups.
+ * @param N Number of populations.
+ * @param sample Whether to average over the interval or sample its middle.
+ */
+template<template<typename> class HAZARD, typename REAL, int LANES = kDefaultLanes>
+void HazardRates(
+        const REAL *const parameters, const REAL *const nx, REAL *const mx,
+        int age_cnt, size_t N, HazardSample sample = HazardSample::IntervalAverage)
+{
+    typedef Lanes<REAL, LANES> V;
+    const int padded_cnt = (age_cnt + LANES - 1) / LANES * LANES;
+    // Padding past the last age, and open intervals, are a year wide
+    // at age one, where every hazard is finite. Open intervals are
+    // filled in afterwards, so that the vector loop computes one rate
+    // per age.
+    std::vector<REAL> start(padded_cnt, 1);
+    std::vector<REAL> width(padded_cnt, 1);
+    std::vector<int> open;
+    REAL x = 0;
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        start[age_idx] = x;
+        if (std::isinf(nx[age_idx])) {
+            open.push_back(age_idx);
+        } else {
+            width[age_idx] = nx[age_idx];
+        }
+        x += nx[age_idx];
+    }
+    const V half = V::Broadcast(REAL(0.5));
+
+    REAL tail[LANES];
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const HAZARD<REAL> hazard(parameters + pop_idx * HAZARD<REAL>::kParameterCount);
+        REAL* row = mx + pop_idx * age_cnt;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx += LANES) {
+            const V x0 = V::Load(&start[age_idx]);
+            const V n = V::Load(&width[age_idx]);
+            V rate;
+            if (HazardSample::Midpoint == sample) {
+                rate = hazard.Rate(x0 + half * n);
+            } else {
+                rate = hazard.Cumulative(x0, n) / n;
+            }
+            if (age_idx + LANES <= age_cnt) {
+                rate.Store(row + age_idx);
+            } else {
+                rate.Store(tail);
+                std::copy(tail, tail + (age_cnt - age_idx), row + age_idx);
+            }
+        }
+        for (int open_idx: open) {
+            hazard.Rate(V::Broadcast(start[open_idx])).Store(tail);
+            row[open_idx] = tail[0];
+        }
+    }
+}
+
+
+template<template<typename> class HAZARD, typename REAL, int LANES = kDefaultLanes>
+void HazardRates(
+        const REAL *const parameters, const REAL *const nx, REAL *const mx,
+        int age_cnt, size_t N, ThreadPool& pool,
+        HazardSample sample = HazardSample::IntervalAverage)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        HazardRates<HAZARD, REAL, LANES>(parameters + begin * HAZARD<REAL>::kParameterCount,
+                nx, mx + begin * age_cnt, age_cnt, end - begin, sample);
+    });
+}
+
+}
+
 #endif //FUNDEM_HAZARDS_HPP
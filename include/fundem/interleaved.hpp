@@ -0,0 +1,232 @@
+//
+// Kernels on a population-interleaved layout, so that vector lanes
+// advance several populations through the age recurrence at once.
+//
+
+#ifndef FUNDEM_INTERLEAVED_HPP
+#define FUNDEM_INTERLEAVED_HPP
+
+#include <cstddef>
+#include "fundem/simd.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! Populations per block that fill a 512-bit vector of doubles.
+ *  Eight lanes also run well as two 256-bit vectors.
+ */
+constexpr int kInterleaveLanes = 8;
+
+
+/*! Number of interleaved blocks needed to hold N populations.
+ *  The last block is padded when N isn't a multiple of LANES.
+ */
+template<int LANES>
+size_t InterleavedBlockCount(size_t N)
+{
+    return (N + LANES - 1) / LANES;
+}
+
+
+/*! Converts `[pop][age]` to blocks of `[age][lane]`.
+ *
+ *  Population `p` is lane `p % LANES` of block `p / LANES`. The
+ *  destination holds `InterleavedBlockCount<LANES>(N) * age_cnt * LANES`
+ *  values. Lanes past the last population are set to `pad`, which
+ *  should be a value that keeps the kernels finite, so zero for
+ *  `mx` and `ax`.
+ *
+ * @tparam LANES Populations per block.
+ * @param src Array[pop][age].
+ * @param dst Array[block][age][lane].
+ * @param age_cnt Number of age groups.
+ * @param N Number of populations.
+ * @param pad Value for unused lanes.
+ */
+template<int LANES, typename REAL>
+void Interleave(const REAL *const src, REAL *const dst, int age_cnt, size_t N,
+        REAL pad = 0)
+{
+    const size_t block_cnt = InterleavedBlockCount<LANES>(N);
+    for (size_t block_idx = 0; block_idx < block_cnt; block_idx++) {
+        REAL* block = dst + block_idx * age_cnt * LANES;
+        for (int lane = 0; lane < LANES; lane++) {
+            size_t pop_idx = block_idx * LANES + lane;
+            if (pop_idx < N) {
+                const REAL* row = src + pop_idx * age_cnt;
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    block[age_idx * LANES + lane] = row[age_idx];
+                }
+            } else {
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    block[age_idx * LANES + lane] = pad;
+                }
+            }
+        }
+    }
+}
+
+
+/*! Converts blocks of `[age][lane]` back to `[pop][age]`.
+ *  Padding lanes are dropped.
+ */
+template<int LANES, typename REAL>
+void Deinterleave(const REAL *const src, REAL *const dst, int age_cnt, size_t N)
+{
+    const size_t block_cnt = InterleavedBlockCount<LANES>(N);
+    for (size_t block_idx = 0; block_idx < block_cnt; block_idx++) {
+        const REAL* block = src + block_idx * age_cnt * LANES;
+        for (int lane = 0; lane < LANES; lane++) {
+            size_t pop_idx = block_idx * LANES + lane;
+            if (pop_idx >= N) {
+                break;
+            }
+            REAL* row = dst + pop_idx * age_cnt;
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                row[age_idx] = block[age_idx * LANES + lane];
+            }
+        }
+    }
+}
+
+
+/*! Survival, as `FirstMomentSurvival`, on interleaved blocks.
+ *
+ * @param mx Array[block][age][lane].
+ * @param ax Array[block][age][lane].
+ * @param nx Array[age], shared by all populations.
+ * @param survival Array[block][age][lane], output.
+ * @param age_cnt Number of age groups.
+ * @param block_cnt Number of blocks, from `InterleavedBlockCount`.
+ */
+template<int LANES, typename REAL>
+void FirstMomentSurvivalInterleaved(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const survival, int age_cnt, size_t block_cnt)
+{
+    typedef Lanes<REAL, LANES> V;
+    const V one = V::Broadcast(1);
+    for (size_t block_idx = 0; block_idx < block_cnt; block_idx++) {
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            size_t idx = (block_idx * age_cnt + age_idx) * LANES;
+            const V n = V::Broadcast(nx[age_idx]);
+            const V m = V::Load(mx + idx);
+            const V a = V::Load(ax + idx);
+            ((one - m * a) / (one + m * (n - a))).Store(survival + idx);
+        }
+    }
+}
+
+
+/*! Population, as `FirstMomentPopulation`, on interleaved blocks.
+ *  The `l *= px` recurrence runs along age with one lane per population,
+ *  so the lanes carry no dependency on each other and vectorize.
+ *
+ * @param mx Array[block][age][lane].
+ * @param ax Array[block][age][lane].
+ * @param nx Array[age], shared by all populations.
+ * @param lx Array[block][age][lane], output.
+ * @param dx Array[block][age][lane], output.
+ * @param age_cnt Number of age groups.
+ * @param block_cnt Number of blocks, from `InterleavedBlockCount`.
+ */
+template<int LANES, typename REAL>
+void FirstMomentPopulationInterleaved(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const lx, REAL *const dx, int age_cnt, size_t block_cnt)
+{
+    typedef Lanes<REAL, LANES> V;
+    const V one = V::Broadcast(1);
+    for (size_t block_idx = 0; block_idx < block_cnt; block_idx++) {
+        V l = one;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            size_t idx = (block_idx * age_cnt + age_idx) * LANES;
+            const V n = V::Broadcast(nx[age_idx]);
+            const V m = V::Load(mx + idx);
+            const V a = V::Load(ax + idx);
+            const V px = (one - m * a) / (one + m * (n - a));
+            l.Store(lx + idx);
+            (l * (one - px)).Store(dx + idx);
+            l = l * px;
+        }
+    }
+}
+
+
+/*! Period life expectancy, as `FirstMomentPeriodLifeExpectancy`,
+ *  on interleaved blocks.
+ *
+ * @param mx Array[block][age][lane].
+ * @param ax Array[block][age][lane].
+ * @param nx Array[age], shared by all populations.
+ * @param le Array[block][age][lane], output.
+ * @param age_cnt Number of age groups.
+ * @param block_cnt Number of blocks, from `InterleavedBlockCount`.
+ */
+template<int LANES, typename REAL>
+void FirstMomentPeriodLifeExpectancyInterleaved(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const le, int age_cnt, size_t block_cnt)
+{
+    typedef Lanes<REAL, LANES> V;
+    const V one = V::Broadcast(1);
+    for (size_t block_idx = 0; block_idx < block_cnt; block_idx++) {
+        size_t last_idx = (block_idx * age_cnt + age_cnt - 1) * LANES;
+        V e = V::Load(ax + last_idx);
+        e.Store(le + last_idx);
+        for (int age_idx = age_cnt - 2; age_idx >= 0; age_idx--) {
+            size_t now_idx = (block_idx * age_cnt + age_idx) * LANES;
+            const V n = V::Broadcast(nx[age_idx]);
+            const V m = V::Load(mx + now_idx);
+            const V a = V::Load(ax + now_idx);
+            e = (n + (one - m * a) * e) / (one + m * (n - a));
+            e.Store(le + now_idx);
+        }
+    }
+}
+
+
+// Block-parallel versions. Blocks are independent, just as populations are.
+
+template<int LANES, typename REAL>
+void FirstMomentSurvivalInterleaved(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const survival, int age_cnt, size_t block_cnt, ThreadPool& pool)
+{
+    pool.ParallelFor(block_cnt, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt * LANES;
+        FirstMomentSurvivalInterleaved<LANES>(mx + offset, ax + offset, nx,
+                survival + offset, age_cnt, end - begin);
+    });
+}
+
+
+template<int LANES, typename REAL>
+void FirstMomentPopulationInterleaved(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const lx, REAL *const dx, int age_cnt, size_t block_cnt,
+        ThreadPool& pool)
+{
+    pool.ParallelFor(block_cnt, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt * LANES;
+        FirstMomentPopulationInterleaved<LANES>(mx + offset, ax + offset, nx,
+                lx + offset, dx + offset, age_cnt, end - begin);
+    });
+}
+
+
+template<int LANES, typename REAL>
+void FirstMomentPeriodLifeExpectancyInterleaved(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const le, int age_cnt, size_t block_cnt, ThreadPool& pool)
+{
+    pool.ParallelFor(block_cnt, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt * LANES;
+        FirstMomentPeriodLifeExpectancyInterleaved<LANES>(mx + offset,
+                ax + offset, nx, le + offset, age_cnt, end - begin);
+    });
+}
+}
+
+#endif //FUNDEM_INTERLEAVED_HPP
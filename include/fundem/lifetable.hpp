@@ -3,10 +3,15 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <stdexcept>
 #include <vector>
-#include "gsl/gsl_math.h"
-#include "gsl/gsl_spline.h"
+#include "fundem/anderson.hpp"
+#include "fundem/fast_math.hpp"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/simd.hpp"
+#include "fundem/steffen.hpp"
+#include "fundem/thread_pool.hpp"
 
 
 namespace fundem {
@@ -31,7 +36,13 @@ void FirstMomentSurvival(
 }
 
 
-template<typename REAL>
+/*! Survivorship and deaths from mortality rates and mean ages.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type that carries lx from one age to the next. With float
+ *     arrays, a double ACCUM keeps rounding from growing along the ages.
+ */
+template<typename REAL, typename ACCUM = REAL>
 void FirstMomentPopulation(
         const REAL *const mx, const REAL *const ax, const REAL *const nx,
         REAL *const lx, REAL* dx, int age_cnt, size_t N)
@@ -44,44 +55,71 @@ void FirstMomentPopulation(
     {
         auto nxi = nx;
         auto mx_end = mxi + age_cnt;
-        REAL l = 1;
+        ACCUM l = 1;
         for (; mxi != mx_end; mxi++, axi++, nxi++, lxi++, dxi++)
         {
-            *lxi = l;
-            auto px = (1.0 - *mxi * *axi) / (1.0 + *mxi * (*nxi - *axi));
-            *dxi = l * (1 - px);
+            *lxi = static_cast<REAL>(l);
+            const ACCUM m = *mxi;
+            ACCUM px = (1 - m * *axi) / (1 + m * (*nxi - *axi));
+            *dxi = static_cast<REAL>(l * (1 - px));
             l *= px;
         }
     }
 }
 
 
-template<typename REAL>
+/*! Period life expectancy by the backward recursion.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type that carries life expectancy from one age to the next.
+ */
+template<typename REAL, typename ACCUM = REAL>
 void FirstMomentPeriodLifeExpectancy(
         const REAL *const mx, const REAL *const ax, const REAL *const nx,
         REAL *const le, int age_cnt, size_t N)
 {
     for (size_t pop_idx=0; pop_idx < N; pop_idx++)
     {
-        le[pop_idx * age_cnt + age_cnt - 1] = mx[pop_idx * age_cnt + age_cnt - 1];
+        // The last interval is open, so its life expectancy is its mean age.
+        ACCUM e = ax[pop_idx * age_cnt + age_cnt - 1];
+        le[pop_idx * age_cnt + age_cnt - 1] = ax[pop_idx * age_cnt + age_cnt - 1];
         for (int age_idx = age_cnt - 2; age_idx >= 0; age_idx--)
         {
             size_t now_idx = pop_idx * age_cnt + age_idx;
-            size_t prev_idx = pop_idx * age_cnt + age_idx + 1;
-            le[now_idx] = (nx[age_idx] + (1 - mx[now_idx] * ax[now_idx]) * le[prev_idx]) /
-                    (1 + mx[now_idx] * (nx[age_idx] - ax[now_idx]));
+            const ACCUM m = mx[now_idx];
+            e = (nx[age_idx] + (1 - m * ax[now_idx]) * e) /
+                    (1 + m * (nx[age_idx] - ax[now_idx]));
+            le[now_idx] = static_cast<REAL>(e);
         }
     }
 }
 
 
+/*! Mean age of death within each interval if mortality is constant.
+ *
+ *  For constant mortality, ax = 1/mx - nx / (exp(mx nx) - 1). When
+ *  x = mx nx is small, the two terms nearly cancel, losing about
+ *  log10(2/x) digits, so below `taylor_a` this uses the series
+ *  nx (1/2 - x/12 + x^3/720 - x^5/30240), and between `taylor_a` and
+ *  `taylor_b` it blends the two linearly. Both are accurate to about
+ *  1e-15 in the blend. An infinite nx marks the open interval, where
+ *  ax = 1/mx.
+ *
+ * @tparam REAL
+ * @param mxi Array[pop,age] of mortality rates.
+ * @param nxi Array[age] of interval widths.
+ * @param ax Array[pop,age], output.
+ * @param age_cnt Number of age groups.
+ * @param N Number of populations.
+ */
 template<typename REAL>
 void ConstantMortalityMeanAge(
         const REAL *const mxi,  const REAL *const nxi, REAL *const ax,
         int age_cnt, size_t N)
 {
-    const REAL taylor_a = 1e-4;
-    const REAL taylor_b = 1e-3;
+    // These bound x = mx * nx.
+    const REAL taylor_a = 1e-2;
+    const REAL taylor_b = 5e-2;
 
     for (size_t pop_idx=0; pop_idx < N; pop_idx++)
     {
@@ -90,32 +128,194 @@ void ConstantMortalityMeanAge(
             auto idx = pop_idx * age_cnt + age_idx;
             auto mx = mxi[idx];
             auto nx = nxi[age_idx];
-
-            if (mx <= taylor_a) {
-                ax[idx] = nx * (0.5 + nx * (mx/12 + std::pow(mx, 3) * std::pow(nx, 2) / 720));
-            } else if (mx >= taylor_b) {
-                auto expx = std::exp(-mx * nx);
-                ax[idx] = 1 / mx - nx * expx / (1 - expx);
+            auto x = mx * nx;
+
+            if (std::isinf(nx)) {
+                ax[idx] = 1 / mx;
+            } else if (x <= taylor_a) {
+                ax[idx] = nx * (REAL(0.5) - x * (REAL(1) / 12 -
+                        x * x * (REAL(1) / 720 - x * x / 30240)));
+            } else if (x >= taylor_b) {
+                ax[idx] = 1 / mx - nx / std::expm1(x);
             } else {
-                auto expx = std::exp(-mx * nx);
-                ax[idx] = (nx * (0.5 + nx * (mx / 12 + std::pow(mx, 3) * std::pow(nx, 2) / 720))) *
-                        (mx - taylor_a) / (taylor_b - taylor_a);
-                ax[idx] += ((1 / mx) - (nx * expx) / (1 - expx)) *
-                        (taylor_b - mx) / (taylor_b - taylor_a);
+                ax[idx] = nx * (REAL(0.5) - x * (REAL(1) / 12 -
+                        x * x * (REAL(1) / 720 - x * x / 30240))) *
+                        (taylor_b - x) / (taylor_b - taylor_a);
+                ax[idx] += (1 / mx - nx / std::expm1(x)) *
+                        (x - taylor_a) / (taylor_b - taylor_a);
             }
         }
     }
 }
 
+/*! `ConstantMortalityMeanAge` for every lane, without branches.
+ *
+ *  Both the series and the exact form are computed for every lane, using
+ *  the vectorized `Expm1`, and selects and a blend pick the answer. An
+ *  infinite n gives 1/m.
+ */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> ConstantMortalityMeanAge(const Lanes<REAL, LANES>& m,
+        const Lanes<REAL, LANES>& n)
+{
+    typedef Lanes<REAL, LANES> V;
+    const V taylor_a = V::Broadcast(1e-2);
+    const V taylor_b = V::Broadcast(5e-2);
+    const V band = taylor_b - taylor_a;
+    const V one = V::Broadcast(1);
+    const V half = V::Broadcast(0.5);
+    const V c1 = V::Broadcast(REAL(1) / 12);
+    const V c3 = V::Broadcast(REAL(1) / 720);
+    const V c5 = V::Broadcast(30240);
+    const V infinity = V::Broadcast(std::numeric_limits<REAL>::infinity());
+
+    const V x = m * n;
+    const V series = n * (half - x * (c1 - x * x * (c3 - x * x / c5)));
+    const V exact = one / m - n / Expm1(x);
+    const V blend = series * (taylor_b - x) / band + exact * (x - taylor_a) / band;
+    V result = Select(x <= taylor_a, series, Select(x >= taylor_b, exact, blend));
+    return Select(n >= infinity, one / m, result);
+}
 
+
+/*! `ConstantMortalityMeanAge` without branches, LANES ages at a time.
+ *
+ *  The only difference from `ConstantMortalityMeanAge` is the expm1
+ *  implementation, so for double the two agree within a relative 1e-14,
+ *  and for float within 1e-5, where 1/mx - nx/expm1(x) near
+ *  x = taylor_a amplifies last-place differences by 2/x.
+ *
+ * @tparam REAL
+ * @tparam LANES Ages computed together.
+ * @param mxi Array[pop,age] of mortality rates.
+ * @param nxi Array[age] of interval widths.
+ * @param ax Array[pop,age], output.
+ * @param age_cnt Number of age groups.
+ * @param N Number of populations.
+ */
+template<typename REAL, int LANES = kDefaultLanes>
+void ConstantMortalityMeanAgeVectorized(
+        const REAL *const mxi,  const REAL *const nxi, REAL *const ax,
+        int age_cnt, size_t N)
+{
+    typedef Lanes<REAL, LANES> V;
+    auto mean_age = [](const V& m, const V& n) {
+        return ConstantMortalityMeanAge(m, n);
+    };
+
+    // Padding for a partial group of ages keeps every lane finite.
+    REAL m_tail[LANES], n_tail[LANES], a_tail[LANES];
+    const int full_end = age_cnt - age_cnt % LANES;
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const REAL* m_row = mxi + pop_idx * age_cnt;
+        REAL* a_row = ax + pop_idx * age_cnt;
+        for (int age_idx = 0; age_idx < full_end; age_idx += LANES) {
+            mean_age(V::Load(m_row + age_idx), V::Load(nxi + age_idx)).Store(a_row + age_idx);
+        }
+        if (full_end < age_cnt) {
+            for (int lane = 0; lane < LANES; lane++) {
+                bool inside = full_end + lane < age_cnt;
+                m_tail[lane] = inside ? m_row[full_end + lane] : REAL(1);
+                n_tail[lane] = inside ? nxi[full_end + lane] : REAL(1);
+            }
+            mean_age(V::Load(m_tail), V::Load(n_tail)).Store(a_tail);
+            std::copy(a_tail, a_tail + (age_cnt - full_end), a_row + full_end);
+        }
+    }
+}
+
+
+/*! Scratch space for `GraduationMethod`, `GraduationMethodSteffen`,
+ *  and `FullLifeTable`, for callers that run them again and again on
+ *  small batches.
+ *
+ *  Vectors keep their capacity from one call to the next, so once a
+ *  workspace has seen an age count, or been reserved for it, calls with
+ *  that many ages or fewer make no heap allocations. Steffen graduation
+ *  also keeps its spline and rebuilds it only when nx changes. Kernels
+ *  size the members they use, so a workspace can go to any of them, but
+ *  to only one thread at a time.
+ */
 template<typename REAL>
+struct LifeTableWorkspace {
+    LifeTableWorkspace() = default;
+
+    explicit LifeTableWorkspace(int age_cnt) { Reserve(age_cnt); }
+
+    /*! Makes room for `age_cnt` ages in every kernel. */
+    void Reserve(int age_cnt)
+    {
+        working.reserve(2 * age_cnt);
+        ax.reserve(age_cnt);
+        lx.reserve(age_cnt + 1);
+        dx.reserve(age_cnt);
+        average_lx.reserve(age_cnt);
+        x.reserve(age_cnt + 1);
+        spline_nx.reserve(age_cnt);
+        spline.Reserve(age_cnt + 1);
+        mixer.Reset(age_cnt, AndersonMixer<REAL>::kMaxDepth);
+    }
+
+    std::vector<REAL> working;     //!< This and the last iteration's ax.
+    std::vector<REAL> ax;          //!< Mean age for columns nobody asked for.
+    std::vector<REAL> lx;
+    std::vector<REAL> dx;
+    std::vector<REAL> average_lx;  //!< Average of lx over each interval.
+    std::vector<REAL> x;           //!< Start of each interval.
+    std::vector<REAL> spline_nx;   //!< The intervals `spline` was built for.
+    SteffenSpline<REAL> spline;
+    AndersonMixer<REAL> mixer;     //!< History for Anderson graduation.
+    std::vector<REAL> gathered_mx; //!< A block of cohort diagonals of mx.
+    std::vector<REAL> gathered_ax; //!< The same diagonals of ax.
+};
+
+
+/*! How graduation steps from one ax to the next.
+ *
+ *  Plain iteration takes the graduated ax as the next guess. Anderson
+ *  iteration mixes it with the last few iterations, using
+ *  `AndersonMixer`, which takes fewer iterations where plain iteration
+ *  contracts slowly. A mixing step costs about as much as an iteration,
+ *  though, and it has been slower in wall time in every measurement, so
+ *  plain iteration is the default, and the bindings offer only plain
+ *  iteration. Anderson iteration doesn't rescue Preston's populations
+ *  that fail, where an old age jumps between its clamped value and a
+ *  computed one. Either way, the answer is an ax that graduation itself
+ *  computed, and populations that don't converge keep constant-mortality
+ *  ax.
+ */
+enum class GraduationIteration {
+    Plain,
+    Anderson
+};
+
+//! Changes that Anderson graduation remembers.
+constexpr int kGraduationAndersonDepth = 3;
+//! Plain iterations before Anderson graduation starts its history. The
+//! first iterations move ax the most, as the oldest ages settle, and
+//! their changes would mislead the mixing afterwards.
+constexpr int kGraduationAndersonStart = 2;
+
+
+/*! Preston's graduation method to determine n_a_x for equal intervals.
+ *  Populations that don't converge keep constant-mortality ax.
+ *
+ * @tparam REAL
+ * @tparam MONITOR `NullGraduationMonitor`, which costs nothing,
+ *     or `GraduationRecorder`, to see how each population went.
+ * @param monitor Told the outcome of each population.
+ * @param iteration Plain iteration, or Anderson mixing.
+ */
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
 void GraduationMethod(
         const REAL *const mxi, const REAL *const nx, REAL *const axi,
-        int age_cnt, size_t N)
+        int age_cnt, size_t N, LifeTableWorkspace<REAL>& workspace,
+        MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
 {
     const REAL max_difference = 1e-5;
-    const int look_back = 6;
-    const int max_iterations = 20;
+    constexpr int look_back = 6;
+    constexpr int max_iterations = 20;
 
     for (int check_n_idx=0; check_n_idx < age_cnt; check_n_idx++) {
         if (nx[check_n_idx] != nx[0]) {
@@ -130,9 +330,11 @@ void GraduationMethod(
     // is well-behaved in that the ax is >0 and <= n/2.
     ConstantMortalityMeanAge(mxi, nx, axi, age_cnt, N);
 
-    auto working = std::vector<REAL>(2 * age_cnt);
-    auto differences = std::vector<REAL>(max_iterations + look_back);
-    auto dx = std::vector<REAL>(age_cnt);
+    auto& working = workspace.working;
+    auto& dx = workspace.dx;
+    working.resize(2 * age_cnt);
+    dx.resize(age_cnt);
+    REAL differences[max_iterations + look_back];
 
     for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
         std::copy(axi + pop_idx * age_cnt, axi + (pop_idx + 1) * age_cnt,
@@ -143,9 +345,17 @@ void GraduationMethod(
         for (int look_init_idx = 0; look_init_idx < look_back; look_init_idx++) {
             differences[look_init_idx] = n;
         }
+        if (GraduationIteration::Anderson == iteration) {
+            workspace.mixer.Reset(age_cnt, kGraduationAndersonDepth);
+        }
 
+        auto started = monitor.Start();
+        GraduationOutcome outcome = GraduationOutcome::Fallback;
+        int iteration_cnt = 0;
+        REAL iter_difference = 0;
         REAL* answer = nullptr;
         for (int it_idx=0; it_idx < max_iterations; it_idx++) {
+            iteration_cnt = it_idx + 1;
             REAL * ax = &working[(it_idx % 2) * age_cnt];
             const REAL * last_ax = &working[((it_idx + 1) % 2) * age_cnt];
             // Compute dx, but look for dx<0 b/c it indicates not converging.
@@ -174,26 +384,43 @@ void GraduationMethod(
             }
 
             // Compute difference between this and last iteration.
-            REAL iter_difference = 0;
+            iter_difference = 0;
             for (int diff_idx=0; diff_idx < age_cnt; diff_idx++) {
                 iter_difference = std::max(iter_difference,
                         std::abs(ax[diff_idx] - last_ax[diff_idx]));
             }
             differences[it_idx + look_back] = iter_difference;
             if (iter_difference > differences[it_idx]) {
+                outcome = GraduationOutcome::Diverged;
                 break;
             } else if (iter_difference < max_difference) {
+                outcome = GraduationOutcome::Converged;
                 answer = ax;
                 break;
+            } else if (GraduationIteration::Anderson == iteration &&
+                    it_idx >= kGraduationAndersonStart) {
+                workspace.mixer.Mix(last_ax, ax, nx);
             } // else keep going.
         }
         if (nullptr != answer) {
             std::copy(answer, answer + age_cnt, axi + pop_idx * age_cnt);
         } // else it's already initialized with the constant-mortality answer.
+        monitor.Finish(pop_idx, started, iteration_cnt, iter_difference, outcome);
     }
 }
 
 
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethod(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t N, MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
+{
+    LifeTableWorkspace<REAL> workspace;
+    GraduationMethod(mxi, nx, axi, age_cnt, N, workspace, monitor, iteration);
+}
+
+
 /*! Graduation method to determine n_a_x using monotonic splines.
  *  This estimates nax using splines that guarantee decreasing lx.
  *  Unlike the traditional graduation method, this can estimate
@@ -209,20 +436,31 @@ void GraduationMethod(
  * @param axi
  * @param age_cnt
  * @param pop_cnt
+ * @param monitor Told the outcome of each population.
+ * @param iteration Plain iteration, or Anderson mixing.
  */
-template<typename REAL>
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
 void GraduationMethodSteffen(
         const REAL *const mxi, const REAL *const nx, REAL *const axi,
-        int age_cnt, size_t pop_cnt)
+        int age_cnt, size_t pop_cnt, LifeTableWorkspace<REAL>& workspace,
+        MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
 {
     const REAL max_difference = 1e-5;
-    const int look_back = 6;
-    const int max_iterations = 20;
-
-    std::vector<REAL> x(age_cnt + 1);
-    x[0] = 0;
-    for (int make_x_idx=1; make_x_idx < age_cnt + 1; make_x_idx++) {
-        x[make_x_idx] = x[make_x_idx - 1] + nx[make_x_idx - 1];
+    constexpr int look_back = 6;
+    constexpr int max_iterations = 20;
+
+    const auto& spline = workspace.spline;
+    if (workspace.spline_nx.size() != size_t(age_cnt) ||
+            !std::equal(nx, nx + age_cnt, workspace.spline_nx.begin())) {
+        auto& x = workspace.x;
+        x.resize(age_cnt + 1);
+        x[0] = 0;
+        for (int make_x_idx=1; make_x_idx < age_cnt + 1; make_x_idx++) {
+            x[make_x_idx] = x[make_x_idx - 1] + nx[make_x_idx - 1];
+        }
+        workspace.spline.Reset(&x[0], age_cnt + 1);
+        workspace.spline_nx.assign(nx, nx + age_cnt);
     }
     const REAL n_max = *std::max_element(nx, nx + age_cnt);
 
@@ -231,12 +469,13 @@ void GraduationMethodSteffen(
     // is well-behaved in that the ax is >0 and <= n/2.
     ConstantMortalityMeanAge(mxi, nx, axi, age_cnt, pop_cnt);
 
-    auto working = std::vector<REAL>(2 * age_cnt);
-    auto differences = std::vector<REAL>(max_iterations + look_back);
-    auto lx = std::vector<REAL>(age_cnt + 1);
-
-    gsl_interp_accel *acc = gsl_interp_accel_alloc();
-    gsl_spline *spline_steffen = gsl_spline_alloc(gsl_interp_steffen, age_cnt + 1);
+    auto& working = workspace.working;
+    auto& lx = workspace.lx;
+    auto& avg_lx = workspace.average_lx;
+    working.resize(2 * age_cnt);
+    lx.resize(age_cnt + 1);
+    avg_lx.resize(age_cnt);
+    REAL differences[max_iterations + look_back];
 
     for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
         std::copy(axi + pop_idx * age_cnt, axi + (pop_idx + 1) * age_cnt,
@@ -247,9 +486,17 @@ void GraduationMethodSteffen(
         for (int look_init_idx = 0; look_init_idx < look_back; look_init_idx++) {
             differences[look_init_idx] = n_max;
         }
+        if (GraduationIteration::Anderson == iteration) {
+            workspace.mixer.Reset(age_cnt, kGraduationAndersonDepth);
+        }
 
+        auto started = monitor.Start();
+        GraduationOutcome outcome = GraduationOutcome::Fallback;
+        int iteration_cnt = 0;
+        REAL iter_difference = 0;
         REAL* answer = nullptr;
         for (int it_idx=0; it_idx < max_iterations; it_idx++) {
+            iteration_cnt = it_idx + 1;
             REAL * ax = &working[(it_idx % 2) * age_cnt];
             const REAL * last_ax = &working[((it_idx + 1) % 2) * age_cnt];
             // Compute dx, but look for dx<0 b/c it indicates not converging.
@@ -260,12 +507,10 @@ void GraduationMethodSteffen(
                 lx[lx_idx + 1] = lx[lx_idx] * px;
             }
 
-            gsl_spline_init(spline_steffen, &x[0], &lx[0], age_cnt + 1);
+            spline.IntervalAverages(&lx[0], &avg_lx[0]);
             // Compute the new ax.
             for (int shift_idx=0; shift_idx < age_cnt; shift_idx++) {
-                auto avg_l = gsl_spline_eval_integ(
-                        spline_steffen, x[shift_idx], x[shift_idx + 1], acc) / nx[shift_idx];
-                auto numerator = avg_l - lx[shift_idx + 1];
+                auto numerator = avg_lx[shift_idx] - lx[shift_idx + 1];
                 auto dx = lx[shift_idx] - lx[shift_idx + 1];
                 if (dx > 1e-16) {
                     ax[shift_idx] = nx[shift_idx] * numerator / dx;
@@ -275,25 +520,371 @@ void GraduationMethodSteffen(
             }
 
             // Compute difference between this and last iteration.
-            REAL iter_difference = 0;
+            iter_difference = 0;
             for (int diff_idx=0; diff_idx < age_cnt; diff_idx++) {
                 iter_difference = std::max(iter_difference,
                                            std::abs(ax[diff_idx] - last_ax[diff_idx]));
             }
             differences[it_idx + look_back] = iter_difference;
             if (iter_difference > differences[it_idx]) {
+                outcome = GraduationOutcome::Diverged;
                 break;
             } else if (iter_difference < max_difference) {
+                outcome = GraduationOutcome::Converged;
                 answer = ax;
                 break;
+            } else if (GraduationIteration::Anderson == iteration &&
+                    it_idx >= kGraduationAndersonStart) {
+                workspace.mixer.Mix(last_ax, ax, nx);
             } // else keep going.
         }
         if (nullptr != answer) {
             std::copy(answer, answer + age_cnt, axi + pop_idx * age_cnt);
         } // else axi is already initialized with the constant-mortality answer.
+        monitor.Finish(pop_idx, started, iteration_cnt, iter_difference, outcome);
     }
-    gsl_spline_free(spline_steffen);
-    gsl_interp_accel_free(acc);
+}
+
+
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethodSteffen(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t pop_cnt, MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
+{
+    LifeTableWorkspace<REAL> workspace;
+    GraduationMethodSteffen(mxi, nx, axi, age_cnt, pop_cnt, workspace, monitor, iteration);
+}
+
+
+/*! Output columns for `FullLifeTable`.
+ *  Each is Array[pop,age], or nullptr for a column the caller
+ *  doesn't want. Columns left as nullptr are neither allocated nor written.
+ */
+template<typename REAL>
+struct LifeTableColumns {
+    REAL* ax{nullptr};  //!< Mean age of death within the interval.
+    REAL* qx{nullptr};  //!< Probability of death in the interval.
+    REAL* px{nullptr};  //!< Probability of survival through the interval.
+    REAL* lx{nullptr};  //!< Survivors to the start of the interval.
+    REAL* dx{nullptr};  //!< Deaths in the interval.
+    REAL* Lx{nullptr};  //!< Person-years lived in the interval.
+    REAL* Tx{nullptr};  //!< Person-years lived after the start of the interval.
+    REAL* ex{nullptr};  //!< Life expectancy at the start of the interval.
+
+    /*! The same columns, starting `offset` values later. */
+    LifeTableColumns Offset(size_t offset) const
+    {
+        auto shift = [offset](REAL* column) {
+            return (nullptr != column) ? column + offset : nullptr;
+        };
+        LifeTableColumns shifted;
+        shifted.ax = shift(ax);
+        shifted.qx = shift(qx);
+        shifted.px = shift(px);
+        shifted.lx = shift(lx);
+        shifted.dx = shift(dx);
+        shifted.Lx = shift(Lx);
+        shifted.Tx = shift(Tx);
+        shifted.ex = shift(ex);
+        return shifted;
+    }
+};
+
+
+/*! Ages whose count and widths are known only at run time. */
+template<typename REAL>
+struct AgeSchema {
+    const REAL* nx;
+    int age_cnt;
+
+    int Count() const { return age_cnt; }
+    REAL Width(int age_idx) const { return nx[age_idx]; }
+};
+
+
+/*! The body of `FullLifeTable`, for the ages that SCHEMA describes with
+ *  `nx`, `Count()`, and `Width(age_idx)`. The schemas in
+ *  `fundem/schema.hpp` make the count and widths compile-time constants.
+ *  Columns the caller didn't request go to `ax_row`, `lx_row`, and
+ *  `dx_row`, which each hold one population.
+ */
+template<typename REAL, typename ACCUM, typename SCHEMA>
+void FullLifeTableRows(
+        const REAL *const mx, const REAL *const ax, const SCHEMA& schema,
+        const LifeTableColumns<REAL>& columns, size_t N,
+        REAL *const ax_row, REAL *const lx_row, REAL *const dx_row)
+{
+    const int age_cnt = schema.Count();
+    const bool backward = columns.Lx || columns.Tx || columns.ex;
+
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const size_t offset = pop_idx * age_cnt;
+        const REAL* m = mx + offset;
+
+        const REAL* a;
+        if (nullptr != ax) {
+            a = ax + offset;
+            if (nullptr != columns.ax) {
+                std::copy(a, a + age_cnt, columns.ax + offset);
+            }
+        } else {
+            REAL* a_out = (nullptr != columns.ax) ? columns.ax + offset : ax_row;
+            ConstantMortalityMeanAge(m, schema.nx, a_out, age_cnt, 1);
+            a = a_out;
+        }
+
+        REAL* l_out = (nullptr != columns.lx) ? columns.lx + offset : lx_row;
+        REAL* d_out = (nullptr != columns.dx) ? columns.dx + offset : dx_row;
+
+        ACCUM l = 1;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const ACCUM m_age = m[age_idx];
+            ACCUM px = (1 - m_age * a[age_idx]) /
+                    (1 + m_age * (schema.Width(age_idx) - a[age_idx]));
+            if (nullptr != columns.px) {
+                columns.px[offset + age_idx] = static_cast<REAL>(px);
+            }
+            if (nullptr != columns.qx) {
+                columns.qx[offset + age_idx] = static_cast<REAL>(1 - px);
+            }
+            l_out[age_idx] = static_cast<REAL>(l);
+            d_out[age_idx] = static_cast<REAL>(l * (1 - px));
+            l *= px;
+        }
+
+        if (!backward) {
+            continue;
+        }
+        const int last = age_cnt - 1;
+        ACCUM T = ACCUM(a[last]) * l_out[last];
+        if (nullptr != columns.Lx) {
+            columns.Lx[offset + last] = static_cast<REAL>(T);
+        }
+        if (nullptr != columns.Tx) {
+            columns.Tx[offset + last] = static_cast<REAL>(T);
+        }
+        if (nullptr != columns.ex) {
+            columns.ex[offset + last] = a[last];
+        }
+        for (int age_idx = last - 1; age_idx >= 0; age_idx--) {
+            ACCUM L = ACCUM(schema.Width(age_idx)) * l_out[age_idx + 1] +
+                    ACCUM(a[age_idx]) * d_out[age_idx];
+            T += L;
+            if (nullptr != columns.Lx) {
+                columns.Lx[offset + age_idx] = static_cast<REAL>(L);
+            }
+            if (nullptr != columns.Tx) {
+                columns.Tx[offset + age_idx] = static_cast<REAL>(T);
+            }
+            if (nullptr != columns.ex) {
+                columns.ex[offset + age_idx] = static_cast<REAL>(T / l_out[age_idx]);
+            }
+        }
+    }
+}
+
+
+/*! Computes any subset of the lifetable columns in one pass per population.
+ *  Each population makes a forward sweep for px, lx, and dx and a
+ *  backward sweep for Lx, Tx, and ex while its row is in cache, instead
+ *  of streaming the whole array once per column. Values agree with
+ *  `FirstMomentSurvival`, `FirstMomentPopulation`, and
+ *  `FirstMomentPeriodLifeExpectancy`.
+ *
+ *  The last age group is open, so its person-years are Lx = ax * lx
+ *  and its life expectancy is ax.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type of px and of the running sums for lx and Tx. Each
+ *     lx and dx is rounded to REAL as it's stored, and Lx, Tx, and ex
+ *     come from those stored values, so with a wider ACCUM they carry
+ *     that rounding as well as their own.
+ * @param mx Array[pop,age] of mortality rates.
+ * @param ax Array[pop,age] of mean ages. If this is nullptr, ax comes
+ *     from `ConstantMortalityMeanAge`.
+ * @param nx Array[age] of interval widths.
+ * @param columns Where to write the columns the caller wants.
+ * @param age_cnt Number of age groups.
+ * @param N Number of populations.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, size_t N,
+        LifeTableWorkspace<REAL>& workspace)
+{
+    // Scratch rows stand in for columns the caller didn't request.
+    // They hold a single population, so they stay in cache.
+    workspace.ax.resize((nullptr == ax && nullptr == columns.ax) ? age_cnt : 0);
+    workspace.lx.resize((nullptr == columns.lx) ? age_cnt : 0);
+    workspace.dx.resize((nullptr == columns.dx) ? age_cnt : 0);
+    const AgeSchema<REAL> schema = {nx, age_cnt};
+    FullLifeTableRows<REAL, ACCUM>(mx, ax, schema, columns, N,
+            workspace.ax.data(), workspace.lx.data(), workspace.dx.data());
+}
+
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, size_t N)
+{
+    LifeTableWorkspace<REAL> workspace;
+    FullLifeTable<REAL, ACCUM>(mx, ax, nx, columns, age_cnt, N, workspace);
+}
+
+// Population-parallel versions of the kernels above. Each one hands
+// contiguous chunks of populations to the serial kernel, so its results
+// match the serial kernel exactly. Kernels that take workspaces use
+// one per thread, from a vector that grows to the pool's thread count.
+
+template<typename REAL>
+void FirstMomentSurvival(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const survival, int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        FirstMomentSurvival(mx + offset, ax + offset, nx, survival + offset,
+                age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPopulation(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const lx, REAL* dx, int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        FirstMomentPopulation<REAL, ACCUM>(mx + offset, ax + offset, nx, lx + offset,
+                dx + offset, age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPeriodLifeExpectancy(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const le, int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        FirstMomentPeriodLifeExpectancy<REAL, ACCUM>(mx + offset, ax + offset, nx,
+                le + offset, age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL>
+void ConstantMortalityMeanAge(
+        const REAL *const mxi,  const REAL *const nxi, REAL *const ax,
+        int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        ConstantMortalityMeanAge(mxi + offset, nxi, ax + offset,
+                age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL, int LANES = kDefaultLanes>
+void ConstantMortalityMeanAgeVectorized(
+        const REAL *const mxi,  const REAL *const nxi, REAL *const ax,
+        int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        ConstantMortalityMeanAgeVectorized<REAL, LANES>(mxi + offset, nxi,
+                ax + offset, age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethod(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t N, ThreadPool& pool,
+        std::vector<LifeTableWorkspace<REAL>>& workspaces, MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
+{
+    workspaces.resize(std::max(workspaces.size(), size_t(pool.ThreadCount())));
+    pool.ParallelForWorker(N, 0, [=, &workspaces](size_t begin, size_t end, int worker_idx) {
+        size_t offset = begin * age_cnt;
+        GraduationMethod(mxi + offset, nx, axi + offset, age_cnt, end - begin,
+                workspaces[worker_idx], monitor.Offset(begin), iteration);
+    });
+}
+
+
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethod(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t N, ThreadPool& pool, MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
+{
+    std::vector<LifeTableWorkspace<REAL>> workspaces;
+    GraduationMethod(mxi, nx, axi, age_cnt, N, pool, workspaces, monitor, iteration);
+}
+
+
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethodSteffen(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t pop_cnt, ThreadPool& pool,
+        std::vector<LifeTableWorkspace<REAL>>& workspaces, MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
+{
+    workspaces.resize(std::max(workspaces.size(), size_t(pool.ThreadCount())));
+    pool.ParallelForWorker(pop_cnt, 0, [=, &workspaces](size_t begin, size_t end,
+            int worker_idx) {
+        size_t offset = begin * age_cnt;
+        GraduationMethodSteffen(mxi + offset, nx, axi + offset, age_cnt, end - begin,
+                workspaces[worker_idx], monitor.Offset(begin), iteration);
+    });
+}
+
+
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethodSteffen(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t pop_cnt, ThreadPool& pool, MONITOR monitor = MONITOR(),
+        GraduationIteration iteration = GraduationIteration::Plain)
+{
+    std::vector<LifeTableWorkspace<REAL>> workspaces;
+    GraduationMethodSteffen(mxi, nx, axi, age_cnt, pop_cnt, pool, workspaces, monitor,
+            iteration);
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, size_t N,
+        ThreadPool& pool, std::vector<LifeTableWorkspace<REAL>>& workspaces)
+{
+    workspaces.resize(std::max(workspaces.size(), size_t(pool.ThreadCount())));
+    pool.ParallelForWorker(N, 0, [=, &columns, &workspaces](size_t begin, size_t end,
+            int worker_idx) {
+        size_t offset = begin * age_cnt;
+        FullLifeTable<REAL, ACCUM>(mx + offset, (nullptr != ax) ? ax + offset : nullptr, nx,
+                columns.Offset(offset), age_cnt, end - begin, workspaces[worker_idx]);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTable(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, size_t N,
+        ThreadPool& pool)
+{
+    std::vector<LifeTableWorkspace<REAL>> workspaces;
+    FullLifeTable<REAL, ACCUM>(mx, ax, nx, columns, age_cnt, N, pool, workspaces);
 }
 }
 
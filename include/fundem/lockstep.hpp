@@ -0,0 +1,264 @@
+//
+// Graduation that iterates a block of populations together.
+//
+
+#ifndef FUNDEM_LOCKSTEP_HPP
+#define FUNDEM_LOCKSTEP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "fundem/interleaved.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/simd.hpp"
+#include "fundem/steffen.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! Runs the graduation fixed-point iteration for one block of populations.
+ *
+ *  Every lane takes the same steps as `GraduationMethod` would take for
+ *  its population, but all lanes step together. After each step, a lane
+ *  whose largest change in ax grew compared with `look_back` steps
+ *  earlier has diverged and keeps its initial ax. A lane whose change
+ *  fell below the tolerance has converged and its ax is copied out.
+ *  Either way the lane is masked out and its later values are ignored.
+ *  The block stops when every lane has stopped.
+ *
+ * @param initial Array[age][lane], the constant-mortality ax. It is both
+ *     the starting point and the fallback.
+ * @param result Array[age][lane], which starts as a copy of `initial`.
+ * @param lane_cnt Lanes holding real populations. The rest are padding.
+ * @param start_difference Fills the look-back window before the first step.
+ * @param working Scratch of at least 2 * age_cnt lanes.
+ * @param update Callable as `update(last_ax, ax)` on Array[age] of lanes.
+ */
+template<int LANES, typename REAL, typename UPDATE>
+void GraduationLockstepBlock(
+        const Lanes<REAL, LANES> *const initial, Lanes<REAL, LANES> *const result,
+        int age_cnt, int lane_cnt, REAL start_difference,
+        Lanes<REAL, LANES> *const working, UPDATE&& update)
+{
+    typedef Lanes<REAL, LANES> V;
+    const REAL max_difference = 1e-5;
+    const int look_back = 6;
+    const int max_iterations = 20;
+
+    REAL differences[max_iterations + look_back][LANES];
+    bool active[LANES];
+    int active_cnt = lane_cnt;
+    for (int lane = 0; lane < LANES; lane++) {
+        active[lane] = lane < lane_cnt;
+        for (int look_init_idx = 0; look_init_idx < look_back; look_init_idx++) {
+            differences[look_init_idx][lane] = start_difference;
+        }
+    }
+    std::copy(initial, initial + age_cnt, working);
+    std::copy(initial, initial + age_cnt, working + age_cnt);
+
+    for (int it_idx = 0; it_idx < max_iterations && active_cnt > 0; it_idx++) {
+        V* ax = working + (it_idx % 2) * age_cnt;
+        const V* last_ax = working + ((it_idx + 1) % 2) * age_cnt;
+        update(last_ax, ax);
+
+        V iter_difference = V::Broadcast(0);
+        for (int diff_idx = 0; diff_idx < age_cnt; diff_idx++) {
+            iter_difference = Max(iter_difference, Abs(ax[diff_idx] - last_ax[diff_idx]));
+        }
+        for (int lane = 0; lane < LANES; lane++) {
+            if (!active[lane]) {
+                continue;
+            }
+            differences[it_idx + look_back][lane] = iter_difference[lane];
+            if (iter_difference[lane] > differences[it_idx][lane]) {
+                active[lane] = false;
+                active_cnt--;
+            } else if (iter_difference[lane] < max_difference) {
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    result[age_idx].v[lane] = ax[age_idx][lane];
+                }
+                active[lane] = false;
+                active_cnt--;
+            }
+        }
+    }
+}
+
+
+/*! `GraduationMethod` with LANES populations iterated in lockstep.
+ *
+ *  Populations are moved into interleaved blocks, one population per
+ *  vector lane, so that each step of the iteration is vector arithmetic
+ *  across populations. The dx < 1e-8 and out-of-range tests become lane
+ *  selects instead of branches. For double precision, each population
+ *  gets the same ax, bit for bit, as `GraduationMethod` returns with
+ *  `GraduationIteration::Plain`, as long as the compiler isn't allowed to
+ *  contract multiplies and adds.
+ *
+ *  This is plain iteration only. It takes no monitor, because a block
+ *  has no time per population, no Anderson mixing, which would need a
+ *  history per lane, and no workspace, because its scratch is in lanes.
+ *  For any of those, use `GraduationMethod`.
+ *
+ * @tparam REAL
+ * @tparam LANES Populations per block.
+ * @param mxi Array[pop,age] of mortality rates.
+ * @param nx Array[age] of widths, which must all be equal.
+ * @param axi Array[pop,age], output.
+ * @param age_cnt Number of age groups.
+ * @param N Number of populations.
+ */
+template<typename REAL, int LANES = kInterleaveLanes>
+void GraduationMethodLockstep(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t N)
+{
+    typedef Lanes<REAL, LANES> V;
+    for (int check_n_idx=0; check_n_idx < age_cnt; check_n_idx++) {
+        if (nx[check_n_idx] != nx[0]) {
+            throw std::runtime_error(
+                    "All age intervals must match for graduation.");
+        }
+    }
+    const REAL n_scalar = nx[0];
+    const V n = V::Broadcast(n_scalar);
+    const V one = V::Broadcast(1);
+    const V half = V::Broadcast(0.5);
+    const V twenty_four = V::Broadcast(24);
+    const V zero = V::Broadcast(0);
+    const V dx_min = V::Broadcast(1e-8);
+
+    ConstantMortalityMeanAge(mxi, nx, axi, age_cnt, N);
+
+    std::vector<V> mx(age_cnt), initial(age_cnt), result(age_cnt);
+    std::vector<V> working(2 * age_cnt), dx(age_cnt);
+
+    for (size_t block_start = 0; block_start < N; block_start += LANES) {
+        const int lane_cnt = static_cast<int>(std::min(size_t{LANES}, N - block_start));
+        const size_t offset = block_start * age_cnt;
+        Interleave<LANES>(mxi + offset, LaneData(mx), age_cnt, lane_cnt);
+        Interleave<LANES>(axi + offset, LaneData(initial), age_cnt, lane_cnt);
+        std::copy(initial.begin(), initial.end(), result.begin());
+
+        GraduationLockstepBlock<LANES>(&initial[0], &result[0], age_cnt, lane_cnt,
+                n_scalar, &working[0], [&](const V* last_ax, V* ax) {
+            V l = one;
+            for (int dx_idx = 0; dx_idx < age_cnt; dx_idx++) {
+                V px = (one - mx[dx_idx] * last_ax[dx_idx]) /
+                        (one + mx[dx_idx] * (n - last_ax[dx_idx]));
+                dx[dx_idx] = l * (one - px);
+                l = l * px;
+            }
+            for (int shift_idx = 1; shift_idx < age_cnt - 1; shift_idx++) {
+                V axx = n * (half + (dx[shift_idx + 1] - dx[shift_idx - 1])
+                        / (twenty_four * dx[shift_idx]));
+                axx = Select(dx[shift_idx] > dx_min, axx, zero - n);
+                ax[shift_idx] = Select((axx < zero) | (axx > n), initial[shift_idx], axx);
+            }
+        });
+        Deinterleave<LANES>(LaneData(result), axi + offset, age_cnt, lane_cnt);
+    }
+}
+
+
+/*! `GraduationMethodSteffen` with LANES populations iterated in lockstep.
+ *  The spline is evaluated for all lanes at once. For double precision,
+ *  each population gets the same ax as `GraduationMethodSteffen` with
+ *  `GraduationIteration::Plain`, under the same conditions as
+ *  `GraduationMethodLockstep`, and like it, this is plain iteration only.
+ *
+ * @tparam REAL
+ * @tparam LANES Populations per block.
+ * @param mxi Array[pop,age] of mortality rates.
+ * @param nx Array[age] of widths, which may differ.
+ * @param axi Array[pop,age], output.
+ * @param age_cnt Number of age groups.
+ * @param pop_cnt Number of populations.
+ */
+template<typename REAL, int LANES = kInterleaveLanes>
+void GraduationMethodSteffenLockstep(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t pop_cnt)
+{
+    typedef Lanes<REAL, LANES> V;
+    std::vector<REAL> x(age_cnt + 1);
+    x[0] = 0;
+    for (int make_x_idx=1; make_x_idx < age_cnt + 1; make_x_idx++) {
+        x[make_x_idx] = x[make_x_idx - 1] + nx[make_x_idx - 1];
+    }
+    const REAL n_max = *std::max_element(nx, nx + age_cnt);
+    const SteffenSpline<REAL> spline(&x[0], age_cnt + 1);
+    const V one = V::Broadcast(1);
+    const V half = V::Broadcast(0.5);
+    const V dx_min = V::Broadcast(1e-16);
+
+    ConstantMortalityMeanAge(mxi, nx, axi, age_cnt, pop_cnt);
+
+    std::vector<V> mx(age_cnt), initial(age_cnt), result(age_cnt);
+    std::vector<V> working(2 * age_cnt), lx(age_cnt + 1), avg_lx(age_cnt);
+
+    for (size_t block_start = 0; block_start < pop_cnt; block_start += LANES) {
+        const int lane_cnt = static_cast<int>(std::min(size_t{LANES}, pop_cnt - block_start));
+        const size_t offset = block_start * age_cnt;
+        Interleave<LANES>(mxi + offset, LaneData(mx), age_cnt, lane_cnt);
+        Interleave<LANES>(axi + offset, LaneData(initial), age_cnt, lane_cnt);
+        std::copy(initial.begin(), initial.end(), result.begin());
+
+        GraduationLockstepBlock<LANES>(&initial[0], &result[0], age_cnt, lane_cnt,
+                n_max, &working[0], [&](const V* last_ax, V* ax) {
+            lx[0] = one;
+            for (int lx_idx = 0; lx_idx < age_cnt; lx_idx++) {
+                const V n = V::Broadcast(nx[lx_idx]);
+                V px = (one - mx[lx_idx] * last_ax[lx_idx]) /
+                        (one + mx[lx_idx] * (n - last_ax[lx_idx]));
+                lx[lx_idx + 1] = lx[lx_idx] * px;
+            }
+            spline.IntervalAverages(&lx[0], &avg_lx[0]);
+            for (int shift_idx = 0; shift_idx < age_cnt; shift_idx++) {
+                const V n = V::Broadcast(nx[shift_idx]);
+                V numerator = avg_lx[shift_idx] - lx[shift_idx + 1];
+                V dx = lx[shift_idx] - lx[shift_idx + 1];
+                ax[shift_idx] = Select(dx > dx_min, n * numerator / dx, half * n);
+            }
+        });
+        Deinterleave<LANES>(LaneData(result), axi + offset, age_cnt, lane_cnt);
+    }
+}
+
+
+template<typename REAL, int LANES = kInterleaveLanes>
+void GraduationMethodLockstep(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t N, ThreadPool& pool)
+{
+    // Chunks are whole blocks, so no block straddles two threads.
+    const size_t block_cnt = InterleavedBlockCount<LANES>(N);
+    pool.ParallelFor(block_cnt, [=](size_t begin, size_t end) {
+        size_t pop_begin = begin * LANES;
+        size_t pop_end = std::min(N, end * LANES);
+        GraduationMethodLockstep<REAL, LANES>(mxi + pop_begin * age_cnt, nx,
+                axi + pop_begin * age_cnt, age_cnt, pop_end - pop_begin);
+    });
+}
+
+
+template<typename REAL, int LANES = kInterleaveLanes>
+void GraduationMethodSteffenLockstep(
+        const REAL *const mxi, const REAL *const nx, REAL *const axi,
+        int age_cnt, size_t pop_cnt, ThreadPool& pool)
+{
+    const size_t block_cnt = InterleavedBlockCount<LANES>(pop_cnt);
+    pool.ParallelFor(block_cnt, [=](size_t begin, size_t end) {
+        size_t pop_begin = begin * LANES;
+        size_t pop_end = std::min(pop_cnt, end * LANES);
+        GraduationMethodSteffenLockstep<REAL, LANES>(mxi + pop_begin * age_cnt, nx,
+                axi + pop_begin * age_cnt, age_cnt, pop_end - pop_begin);
+    });
+}
+
+}
+
+#endif //FUNDEM_LOCKSTEP_HPP
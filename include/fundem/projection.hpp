@@ -0,0 +1,367 @@
+//
+// Cohort-component projection of populations from lifetables, fertility,
+// and migration.
+//
+
+#ifndef FUNDEM_PROJECTION_HPP
+#define FUNDEM_PROJECTION_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include "fundem/lifetable.hpp"
+#include "fundem/simd.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! Steps whose survival ratios a projection computes at a time. The
+ *  ratios for a group of populations over this many steps stay in
+ *  cache while the populations advance through them.
+ */
+const int kProjectionStepBlock = 16;
+
+
+/*! Survival ratios, which are the entries of a Leslie matrix below its
+ *  first row, from the person-years of lifetables with a radix of one.
+ *
+ *  Entry 0 takes the births during a step into the first age group,
+ *  L_0 / n. Entry x, for 0 < x < last, takes age group x - 1 into age
+ *  group x, L_x / L_{x-1}. The last entry takes both the last closed
+ *  group and the open group into the open group,
+ *  L_last / (L_{last-1} + L_last). Groups that nobody reaches have a
+ *  ratio of zero.
+ *
+ * @param Lx Array[pop,age] of person-years lived, with a radix of one.
+ * @param n The width of every closed age group, which is also the
+ *     length of a step.
+ * @param ratios Array[pop,age] of survival ratios.
+ * @param age_cnt Number of age groups, at least two.
+ * @param N Number of populations.
+ */
+template<typename REAL>
+void SurvivalRatios(const REAL *const Lx, REAL n, REAL *const ratios, int age_cnt, size_t N)
+{
+    if (age_cnt < 2) {
+        throw std::invalid_argument("There must be at least two age groups.");
+    }
+    const int last = age_cnt - 1;
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const REAL* L = Lx + pop_idx * age_cnt;
+        REAL* ratio = ratios + pop_idx * age_cnt;
+        ratio[0] = L[0] / n;
+        for (int age_idx = 1; age_idx < last; age_idx++) {
+            ratio[age_idx] = (L[age_idx - 1] > 0) ? L[age_idx] / L[age_idx - 1] : REAL(0);
+        }
+        const REAL open = L[last - 1] + L[last];
+        ratio[last] = (open > 0) ? L[last] / open : REAL(0);
+    }
+}
+
+
+/*! Rates that drive a projection. Each array is Array[pop,step,age],
+ *  where step s covers the years from s n to (s + 1) n after the start,
+ *  except `births`, which is Array[pop,step]. Any but `mx` may be null,
+ *  and `mx` may be null when `Lx` is given.
+ */
+template<typename REAL>
+struct ProjectionRates {
+    const REAL* mx{nullptr};         //!< Mortality rates for each step's lifetable.
+    const REAL* ax{nullptr};         //!< Mean ages, or null for constant-mortality ax.
+    const REAL* Lx{nullptr};         //!< Person-years with a radix of one, instead of mx.
+    const REAL* fertility{nullptr};  //!< Births per person-year in each age group.
+    const REAL* migration{nullptr};  //!< Net migrants during the step.
+    const REAL* births{nullptr};     //!< Births during the step, when fertility is null.
+
+    /*! The same rates, starting at population `pop_idx`. */
+    ProjectionRates Offset(size_t pop_idx, int age_cnt, int step_cnt) const
+    {
+        const size_t offset = pop_idx * step_cnt * age_cnt;
+        auto shift = [](const REAL* rate, size_t by) {
+            return (nullptr != rate) ? rate + by : nullptr;
+        };
+        ProjectionRates shifted;
+        shifted.mx = shift(mx, offset);
+        shifted.ax = shift(ax, offset);
+        shifted.Lx = shift(Lx, offset);
+        shifted.fertility = shift(fertility, offset);
+        shifted.migration = shift(migration, offset);
+        shifted.births = shift(births, pop_idx * step_cnt);
+        return shifted;
+    }
+};
+
+
+/*! Scratch space for `ProjectPopulation`. Rows for a group of
+ *  populations are interleaved as Array[...,age,lane]. Like
+ *  `LifeTableWorkspace`, a workspace keeps its capacity and goes to one
+ *  thread at a time.
+ */
+template<typename REAL, typename ACCUM>
+struct ProjectionWorkspace {
+    LifeTableWorkspace<REAL> lifetable;
+    std::vector<REAL> Lx;          //!< Array[step,age] for one population.
+    std::vector<ACCUM> survival;   //!< Array[step,age,lane] of survival ratios.
+    std::vector<ACCUM> population; //!< Array[2,age,lane], before and after a step.
+    std::vector<ACCUM> migration;  //!< Array[age,lane] for one step.
+    std::vector<ACCUM> fertility;  //!< Array[age,lane] for one step.
+};
+
+
+/*! Projects populations forward by the cohort-component method.
+ *
+ *  Each step is as long as the closed age groups are wide, so every
+ *  cohort moves up one age group per step. Survivors of age group x - 1
+ *  enter age group x with the survival ratio from the step's lifetable,
+ *  L_x / L_{x-1}, as `SurvivalRatios` defines it, and the open group
+ *  keeps its own survivors with those of the group below it.
+ *  Births during the step are
+ *
+ *      B = (n / 2) sum_x F_x (N_x(t) + N_x(t + n)),
+ *
+ *  over every age group but the first, and `birth_fraction` of them
+ *  enter the first age group with survival L_0 / n. For a two-sex
+ *  projection, project women with their fertility and a birth fraction
+ *  for girls, then men with those births as `rates.births` and the
+ *  fraction for boys. Net migrants are counted by the age group they
+ *  are in at the end of the step. Half arrive at the start and survive
+ *  with their cohort, and half arrive at the end. Emigration can leave
+ *  an age group negative, which is left for the caller to judge.
+ *
+ *  The lifetables don't depend on the population, so, for a group of
+ *  LANES populations, the survival ratios of a block of steps are
+ *  computed first, from `rates.Lx` or with `FullLifeTable`. The
+ *  populations then advance through those steps together, one per
+ *  lane, which makes each step a few vector operations for each age.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type of the lifetables' sums and of the projected counts.
+ * @tparam LANES Populations projected together.
+ * @param population Array[pop,age] at the start.
+ * @param rates Mortality, fertility, and migration for every step.
+ * @param nx Array[age] of interval widths, all equal but the last.
+ * @param birth_fraction Share of births that join this population.
+ * @param projected Array[pop,step,age] at the end of each step.
+ * @param births Array[pop,step] of births during each step, or null.
+ * @param age_cnt Number of age groups, at least two.
+ * @param step_cnt Number of steps.
+ * @param N Number of populations.
+ */
+template<typename REAL, typename ACCUM = REAL, int LANES = kDefaultLanes>
+void ProjectPopulation(
+        const REAL *const population, const ProjectionRates<REAL>& rates,
+        const REAL *const nx, REAL birth_fraction, REAL *const projected,
+        REAL *const births, int age_cnt, int step_cnt, size_t N,
+        ProjectionWorkspace<REAL, ACCUM>& workspace)
+{
+    typedef Lanes<ACCUM, LANES> V;
+    if (age_cnt < 2) {
+        throw std::invalid_argument("There must be at least two age groups.");
+    }
+    if (step_cnt < 1) {
+        throw std::invalid_argument("There must be at least one step.");
+    }
+    if (nullptr == rates.mx && nullptr == rates.Lx) {
+        throw std::invalid_argument("Projection needs either mx or Lx.");
+    }
+    const int last = age_cnt - 1;
+    const REAL n = nx[0];
+    for (int age_idx = 1; age_idx < last; age_idx++) {
+        if (nx[age_idx] != n) {
+            throw std::invalid_argument(
+                    "Projection steps through age groups of equal width.");
+        }
+    }
+    const size_t row_cnt = size_t(step_cnt) * age_cnt;
+    const int block_step_cnt = std::min(kProjectionStepBlock, step_cnt);
+    workspace.Lx.resize((nullptr == rates.Lx) ? block_step_cnt * age_cnt : 0);
+    workspace.survival.resize(block_step_cnt * age_cnt * LANES);
+    workspace.population.resize(2 * age_cnt * LANES);
+    workspace.migration.resize((nullptr != rates.migration) ? age_cnt * LANES : 0);
+    workspace.fertility.resize((nullptr != rates.fertility) ? age_cnt * LANES : 0);
+    LifeTableColumns<REAL> lifetable;
+    if (nullptr == rates.Lx) {
+        lifetable.Lx = &workspace.Lx[0];
+    }
+    const V zero = V::Broadcast(0);
+    const V half = V::Broadcast(ACCUM(0.5));
+    const V step = V::Broadcast(n);
+    const V half_step = V::Broadcast(ACCUM(0.5) * n);
+    const V share = V::Broadcast(birth_fraction);
+
+    // Interleaves one step's rows of a rate for the group's populations.
+    // Lanes past the last population get zeros.
+    auto interleave = [&](const REAL* rate, size_t pop_begin, int lane_cnt, int step_idx,
+            std::vector<ACCUM>& into) {
+        for (int lane = 0; lane < LANES; lane++) {
+            const REAL* row = rate + ((pop_begin + lane) * step_cnt + step_idx) * age_cnt;
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                into[age_idx * LANES + lane] = (lane < lane_cnt) ? ACCUM(row[age_idx]) : 0;
+            }
+        }
+    };
+
+    for (size_t pop_begin = 0; pop_begin < N; pop_begin += LANES) {
+        const int lane_cnt = static_cast<int>(std::min(size_t(LANES), N - pop_begin));
+        ACCUM* now = &workspace.population[0];
+        ACCUM* next = &workspace.population[age_cnt * LANES];
+        for (int lane = 0; lane < LANES; lane++) {
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                now[age_idx * LANES + lane] = (lane < lane_cnt) ?
+                        ACCUM(population[(pop_begin + lane) * age_cnt + age_idx]) : 0;
+            }
+        }
+
+        for (int step_begin = 0; step_begin < step_cnt; step_begin += block_step_cnt) {
+            const int block_cnt = std::min(block_step_cnt, step_cnt - step_begin);
+
+            // Survival ratios for the block, which don't depend on the
+            // populations, so they're done ahead of the steps. Person-years
+            // are interleaved first, so the divisions are by lanes.
+            std::fill(workspace.survival.begin(), workspace.survival.end(), ACCUM(0));
+            for (int lane = 0; lane < lane_cnt; lane++) {
+                const size_t row = (pop_begin + lane) * row_cnt + size_t(step_begin) * age_cnt;
+                const REAL* L;
+                if (nullptr != rates.Lx) {
+                    L = rates.Lx + row;
+                } else {
+                    FullLifeTable<REAL, ACCUM>(rates.mx + row,
+                            (nullptr != rates.ax) ? rates.ax + row : nullptr, nx, lifetable,
+                            age_cnt, block_cnt, workspace.lifetable);
+                    L = &workspace.Lx[0];
+                }
+                for (int value_idx = 0; value_idx < block_cnt * age_cnt; value_idx++) {
+                    workspace.survival[value_idx * LANES + lane] = L[value_idx];
+                }
+            }
+            // In place, from the open group down, so each ratio reads
+            // person-years that are still there.
+            for (int block_idx = 0; block_idx < block_cnt; block_idx++) {
+                ACCUM* ratio = &workspace.survival[block_idx * age_cnt * LANES];
+                V above = V::Load(ratio + last * LANES);
+                V below = V::Load(ratio + (last - 1) * LANES);
+                V denominator = below + above;
+                Select(zero < denominator, above / denominator, zero)
+                        .Store(ratio + last * LANES);
+                for (int age_idx = last - 1; age_idx > 0; age_idx--) {
+                    above = below;
+                    below = V::Load(ratio + (age_idx - 1) * LANES);
+                    Select(zero < below, above / below, zero).Store(ratio + age_idx * LANES);
+                }
+                (below / step).Store(ratio);
+            }
+
+            for (int block_idx = 0; block_idx < block_cnt; block_idx++) {
+                const int step_idx = step_begin + block_idx;
+                const ACCUM* ratio = &workspace.survival[block_idx * age_cnt * LANES];
+                if (nullptr != rates.migration) {
+                    interleave(rates.migration, pop_begin, lane_cnt, step_idx,
+                            workspace.migration);
+                }
+                auto arriving = [&](int age_idx) {
+                    return (nullptr != rates.migration) ?
+                            half * V::Load(&workspace.migration[age_idx * LANES]) :
+                            zero;
+                };
+
+                // Every cohort moves up an age group.
+                for (int age_idx = 1; age_idx < last; age_idx++) {
+                    const V early = arriving(age_idx);
+                    (V::Load(ratio + age_idx * LANES) *
+                            (V::Load(now + (age_idx - 1) * LANES) + early) + early)
+                            .Store(next + age_idx * LANES);
+                }
+                const V early = arriving(last);
+                (V::Load(ratio + last * LANES) * (V::Load(now + (last - 1) * LANES) +
+                        V::Load(now + last * LANES) + early) + early)
+                        .Store(next + last * LANES);
+
+                V born = zero;
+                if (nullptr != rates.fertility) {
+                    interleave(rates.fertility, pop_begin, lane_cnt, step_idx,
+                            workspace.fertility);
+                    for (int age_idx = 1; age_idx < age_cnt; age_idx++) {
+                        born = born + V::Load(&workspace.fertility[age_idx * LANES]) *
+                                (V::Load(now + age_idx * LANES) +
+                                        V::Load(next + age_idx * LANES));
+                    }
+                    born = half_step * born;
+                } else if (nullptr != rates.births) {
+                    ACCUM given[LANES] = {0};
+                    for (int lane = 0; lane < lane_cnt; lane++) {
+                        given[lane] = rates.births[(pop_begin + lane) * step_cnt + step_idx];
+                    }
+                    born = V::Load(given);
+                }
+                const V early_born = arriving(0);
+                (V::Load(ratio) * (share * born + early_born) + early_born).Store(next);
+
+                // Each lane is a row of the output, written whole.
+                for (int lane = 0; lane < lane_cnt; lane++) {
+                    REAL* out = projected + ((pop_begin + lane) * step_cnt + step_idx) * age_cnt;
+                    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                        out[age_idx] = static_cast<REAL>(next[age_idx * LANES + lane]);
+                    }
+                    if (nullptr != births) {
+                        births[(pop_begin + lane) * step_cnt + step_idx] =
+                                static_cast<REAL>(born[lane]);
+                    }
+                }
+                std::swap(now, next);
+            }
+        }
+    }
+}
+
+
+template<typename REAL, typename ACCUM = REAL, int LANES = kDefaultLanes>
+void ProjectPopulation(
+        const REAL *const population, const ProjectionRates<REAL>& rates,
+        const REAL *const nx, REAL birth_fraction, REAL *const projected,
+        REAL *const births, int age_cnt, int step_cnt, size_t N)
+{
+    ProjectionWorkspace<REAL, ACCUM> workspace;
+    ProjectPopulation<REAL, ACCUM, LANES>(population, rates, nx, birth_fraction, projected,
+            births, age_cnt, step_cnt, N, workspace);
+}
+
+
+/*! `ProjectPopulation` with populations split among threads. Each
+ *  population's steps stay on one thread, in order, and every
+ *  population gets the same answer as it would from the serial kernel.
+ */
+template<typename REAL, typename ACCUM = REAL, int LANES = kDefaultLanes>
+void ProjectPopulation(
+        const REAL *const population, const ProjectionRates<REAL>& rates,
+        const REAL *const nx, REAL birth_fraction, REAL *const projected,
+        REAL *const births, int age_cnt, int step_cnt, size_t N, ThreadPool& pool,
+        std::vector<ProjectionWorkspace<REAL, ACCUM>>& workspaces)
+{
+    workspaces.resize(std::max(workspaces.size(), size_t(pool.ThreadCount())));
+    pool.ParallelForWorker(N, 0, [=, &rates, &workspaces](size_t begin, size_t end,
+            int worker_idx) {
+        const size_t rows = begin * step_cnt;
+        ProjectPopulation<REAL, ACCUM, LANES>(population + begin * age_cnt,
+                rates.Offset(begin, age_cnt, step_cnt), nx, birth_fraction,
+                projected + rows * age_cnt, (nullptr != births) ? births + rows : nullptr,
+                age_cnt, step_cnt, end - begin, workspaces[worker_idx]);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL, int LANES = kDefaultLanes>
+void ProjectPopulation(
+        const REAL *const population, const ProjectionRates<REAL>& rates,
+        const REAL *const nx, REAL birth_fraction, REAL *const projected,
+        REAL *const births, int age_cnt, int step_cnt, size_t N, ThreadPool& pool)
+{
+    std::vector<ProjectionWorkspace<REAL, ACCUM>> workspaces;
+    ProjectPopulation<REAL, ACCUM, LANES>(population, rates, nx, birth_fraction, projected,
+            births, age_cnt, step_cnt, N, pool, workspaces);
+}
+
+}
+
+#endif //FUNDEM_PROJECTION_HPP
@@ -0,0 +1,365 @@
+//
+// Lifetable kernels for batches whose populations have different age schemas.
+//
+
+#ifndef FUNDEM_RAGGED_HPP
+#define FUNDEM_RAGGED_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/schema.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! Populations packed end to end, each with its own age schema.
+ *
+ *  Population `pop_idx` has its values in a packed array, such as mx,
+ *  from `offsets[pop_idx]` to `offsets[pop_idx + 1]`. Its widths are
+ *  schema `schema[pop_idx]`, which is `nx` from `nx_offsets[schema]`
+ *  to `nx_offsets[schema + 1]`. Every packed array of a batch, inputs
+ *  and outputs alike, shares the offsets, so there is no padding.
+ *  Populations with the same schema next to each other run together
+ *  through the dense kernels, so sorting by schema helps, but isn't
+ *  required.
+ *
+ * @tparam REAL Type of nx.
+ */
+template<typename REAL>
+struct RaggedBatch {
+    const size_t* offsets{nullptr};     //!< Array[pop + 1] into packed arrays.
+    const int* schema{nullptr};         //!< Array[pop] of schema indices.
+    const REAL* nx{nullptr};            //!< Widths of every schema, packed.
+    const size_t* nx_offsets{nullptr};  //!< Array[schema + 1] into nx.
+    size_t N{0};                        //!< Number of populations.
+    int schema_cnt{0};                  //!< Number of schemas.
+
+    int AgeCount(size_t pop_idx) const
+    {
+        return static_cast<int>(offsets[pop_idx + 1] - offsets[pop_idx]);
+    }
+
+    const REAL* Widths(size_t pop_idx) const
+    {
+        return nx + nx_offsets[schema[pop_idx]];
+    }
+
+    /*! Total values in each packed array. */
+    size_t Size() const
+    {
+        return offsets[N];
+    }
+
+    /*! Throws std::invalid_argument unless each population's values
+     *  span exactly the ages of its schema.
+     */
+    void Check() const
+    {
+        if (0 != offsets[0] || 0 != nx_offsets[0]) {
+            throw std::invalid_argument("Ragged offsets must start at zero.");
+        }
+        for (int schema_idx = 0; schema_idx < schema_cnt; schema_idx++) {
+            if (nx_offsets[schema_idx + 1] <= nx_offsets[schema_idx]) {
+                throw std::invalid_argument(
+                        "Schema " + std::to_string(schema_idx) + " has no age groups.");
+            }
+        }
+        for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+            const int schema_idx = schema[pop_idx];
+            if (schema_idx < 0 || schema_idx >= schema_cnt) {
+                throw std::invalid_argument("Population " + std::to_string(pop_idx) +
+                        " has no schema " + std::to_string(schema_idx) + ".");
+            }
+            if (offsets[pop_idx + 1] < offsets[pop_idx] || offsets[pop_idx + 1] -
+                    offsets[pop_idx] != nx_offsets[schema_idx + 1] - nx_offsets[schema_idx]) {
+                throw std::invalid_argument("Population " + std::to_string(pop_idx) +
+                        " doesn't have the ages of schema " + std::to_string(schema_idx) + ".");
+            }
+        }
+    }
+};
+
+
+/*! Applies `body(begin, end, worker_idx)` to runs of populations in
+ *  [begin, end) that share a schema, so the body can hand each run to
+ *  a dense kernel with that schema's nx and age count.
+ */
+template<typename REAL, typename FUNC>
+void ForEachRaggedRun(const RaggedBatch<REAL>& batch, size_t begin, size_t end,
+        int worker_idx, FUNC& body)
+{
+    while (begin < end) {
+        size_t run_end = begin + 1;
+        while (run_end < end && batch.schema[run_end] == batch.schema[begin]) {
+            run_end++;
+        }
+        body(begin, run_end, worker_idx);
+        begin = run_end;
+    }
+}
+
+
+/*! Applies `body(begin, end, worker_idx)` to every run of populations
+ *  that share a schema, on one thread.
+ */
+template<typename REAL, typename FUNC>
+void RaggedFor(const RaggedBatch<REAL>& batch, FUNC&& body)
+{
+    batch.Check();
+    ForEachRaggedRun(batch, 0, batch.N, 0, body);
+}
+
+
+/*! Applies `body(begin, end, worker_idx)` to every run of populations
+ *  that share a schema, across the pool. Chunks hold about the same
+ *  number of ages, not of populations, so a thread that gets the long
+ *  schemas doesn't hold up the rest. As for `ParallelForWorker`, there
+ *  are several chunks for each thread.
+ */
+template<typename REAL, typename FUNC>
+void RaggedFor(const RaggedBatch<REAL>& batch, ThreadPool& pool, FUNC&& body)
+{
+    batch.Check();
+    const size_t chunks_per_thread = 8;
+    const size_t chunk_cnt = std::min(batch.N,
+            static_cast<size_t>(pool.ThreadCount()) * chunks_per_thread);
+    if (pool.ThreadCount() == 1 || chunk_cnt < 2) {
+        // One chunk still goes through the pool, which gives it the
+        // caller's worker index when this runs inside a pool body.
+        pool.ParallelForWorker(batch.N, batch.N, [&](size_t begin, size_t end, int worker_idx) {
+            ForEachRaggedRun(batch, begin, end, worker_idx, body);
+        });
+        return;
+    }
+    // Chunk chunk_idx starts at the first population at or after its
+    // share of the ages.
+    std::vector<size_t> starts(chunk_cnt + 1);
+    const size_t total = batch.Size();
+    for (size_t chunk_idx = 0; chunk_idx < chunk_cnt; chunk_idx++) {
+        const size_t target = total / chunk_cnt * chunk_idx +
+                total % chunk_cnt * chunk_idx / chunk_cnt;
+        starts[chunk_idx] = std::lower_bound(batch.offsets, batch.offsets + batch.N, target) -
+                batch.offsets;
+    }
+    starts[chunk_cnt] = batch.N;
+    pool.ParallelForWorker(chunk_cnt, 1, [&](size_t begin, size_t end, int worker_idx) {
+        ForEachRaggedRun(batch, starts[begin], starts[end], worker_idx, body);
+    });
+}
+
+
+// The kernels below take packed arrays in place of Array[pop,age] and a
+// batch in place of nx, age_cnt, and N. Each run of populations with one
+// schema goes to the dense kernel, specialized where `fundem/schema.hpp`
+// knows the schema, so results match calls that split the batch by
+// schema, for any thread count.
+
+/*! `FirstMomentSurvival` for a ragged batch. */
+template<typename REAL>
+void FirstMomentSurvivalRagged(
+        const REAL *const mx, const REAL *const ax, REAL *const survival,
+        const RaggedBatch<REAL>& batch)
+{
+    RaggedFor(batch, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FirstMomentSurvivalDispatch(mx + offset, ax + offset, batch.Widths(begin),
+                survival + offset, batch.AgeCount(begin), end - begin);
+    });
+}
+
+
+/*! `FirstMomentPopulation` for a ragged batch. */
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPopulationRagged(
+        const REAL *const mx, const REAL *const ax, REAL *const lx, REAL *const dx,
+        const RaggedBatch<REAL>& batch)
+{
+    RaggedFor(batch, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FirstMomentPopulationDispatch<REAL, ACCUM>(mx + offset, ax + offset,
+                batch.Widths(begin), lx + offset, dx + offset, batch.AgeCount(begin),
+                end - begin);
+    });
+}
+
+
+/*! `FirstMomentPeriodLifeExpectancy` for a ragged batch. */
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPeriodLifeExpectancyRagged(
+        const REAL *const mx, const REAL *const ax, REAL *const le,
+        const RaggedBatch<REAL>& batch)
+{
+    RaggedFor(batch, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FirstMomentPeriodLifeExpectancyDispatch<REAL, ACCUM>(mx + offset, ax + offset,
+                batch.Widths(begin), le + offset, batch.AgeCount(begin), end - begin);
+    });
+}
+
+
+/*! `ConstantMortalityMeanAge` for a ragged batch. */
+template<typename REAL>
+void ConstantMortalityMeanAgeRagged(
+        const REAL *const mx, REAL *const ax, const RaggedBatch<REAL>& batch)
+{
+    RaggedFor(batch, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        ConstantMortalityMeanAge(mx + offset, batch.Widths(begin), ax + offset,
+                batch.AgeCount(begin), end - begin);
+    });
+}
+
+
+/*! `GraduationMethod` for a ragged batch. Every schema must have
+ *  intervals of one width, though widths may differ between schemas.
+ */
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethodRagged(
+        const REAL *const mx, REAL *const ax, const RaggedBatch<REAL>& batch,
+        LifeTableWorkspace<REAL>& workspace, MONITOR monitor = MONITOR())
+{
+    RaggedFor(batch, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        GraduationMethod(mx + offset, batch.Widths(begin), ax + offset, batch.AgeCount(begin),
+                end - begin, workspace, monitor.Offset(begin));
+    });
+}
+
+
+/*! `GraduationMethodSteffen` for a ragged batch. */
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethodSteffenRagged(
+        const REAL *const mx, REAL *const ax, const RaggedBatch<REAL>& batch,
+        LifeTableWorkspace<REAL>& workspace, MONITOR monitor = MONITOR())
+{
+    RaggedFor(batch, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        GraduationMethodSteffen(mx + offset, batch.Widths(begin), ax + offset,
+                batch.AgeCount(begin), end - begin, workspace, monitor.Offset(begin));
+    });
+}
+
+
+/*! `FullLifeTable` for a ragged batch. Columns are packed arrays.
+ *  The last age group of each schema is open.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTableRagged(
+        const REAL *const mx, const REAL *const ax, const LifeTableColumns<REAL>& columns,
+        const RaggedBatch<REAL>& batch)
+{
+    RaggedFor(batch, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FullLifeTableDispatch<REAL, ACCUM>(mx + offset, (nullptr != ax) ? ax + offset : nullptr,
+                batch.Widths(begin), columns.Offset(offset), batch.AgeCount(begin),
+                end - begin);
+    });
+}
+
+
+template<typename REAL>
+void FirstMomentSurvivalRagged(
+        const REAL *const mx, const REAL *const ax, REAL *const survival,
+        const RaggedBatch<REAL>& batch, ThreadPool& pool)
+{
+    RaggedFor(batch, pool, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FirstMomentSurvivalDispatch(mx + offset, ax + offset, batch.Widths(begin),
+                survival + offset, batch.AgeCount(begin), end - begin);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPopulationRagged(
+        const REAL *const mx, const REAL *const ax, REAL *const lx, REAL *const dx,
+        const RaggedBatch<REAL>& batch, ThreadPool& pool)
+{
+    RaggedFor(batch, pool, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FirstMomentPopulationDispatch<REAL, ACCUM>(mx + offset, ax + offset,
+                batch.Widths(begin), lx + offset, dx + offset, batch.AgeCount(begin),
+                end - begin);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPeriodLifeExpectancyRagged(
+        const REAL *const mx, const REAL *const ax, REAL *const le,
+        const RaggedBatch<REAL>& batch, ThreadPool& pool)
+{
+    RaggedFor(batch, pool, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FirstMomentPeriodLifeExpectancyDispatch<REAL, ACCUM>(mx + offset, ax + offset,
+                batch.Widths(begin), le + offset, batch.AgeCount(begin), end - begin);
+    });
+}
+
+
+template<typename REAL>
+void ConstantMortalityMeanAgeRagged(
+        const REAL *const mx, REAL *const ax, const RaggedBatch<REAL>& batch,
+        ThreadPool& pool)
+{
+    RaggedFor(batch, pool, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        ConstantMortalityMeanAge(mx + offset, batch.Widths(begin), ax + offset,
+                batch.AgeCount(begin), end - begin);
+    });
+}
+
+
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethodRagged(
+        const REAL *const mx, REAL *const ax, const RaggedBatch<REAL>& batch,
+        ThreadPool& pool, std::vector<LifeTableWorkspace<REAL>>& workspaces,
+        MONITOR monitor = MONITOR())
+{
+    workspaces.resize(std::max(workspaces.size(), size_t(pool.ThreadCount())));
+    RaggedFor(batch, pool, [&](size_t begin, size_t end, int worker_idx) {
+        const size_t offset = batch.offsets[begin];
+        GraduationMethod(mx + offset, batch.Widths(begin), ax + offset, batch.AgeCount(begin),
+                end - begin, workspaces[worker_idx], monitor.Offset(begin));
+    });
+}
+
+
+template<typename REAL, typename MONITOR = NullGraduationMonitor>
+void GraduationMethodSteffenRagged(
+        const REAL *const mx, REAL *const ax, const RaggedBatch<REAL>& batch,
+        ThreadPool& pool, std::vector<LifeTableWorkspace<REAL>>& workspaces,
+        MONITOR monitor = MONITOR())
+{
+    workspaces.resize(std::max(workspaces.size(), size_t(pool.ThreadCount())));
+    RaggedFor(batch, pool, [&](size_t begin, size_t end, int worker_idx) {
+        const size_t offset = batch.offsets[begin];
+        GraduationMethodSteffen(mx + offset, batch.Widths(begin), ax + offset,
+                batch.AgeCount(begin), end - begin, workspaces[worker_idx],
+                monitor.Offset(begin));
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTableRagged(
+        const REAL *const mx, const REAL *const ax, const LifeTableColumns<REAL>& columns,
+        const RaggedBatch<REAL>& batch, ThreadPool& pool)
+{
+    RaggedFor(batch, pool, [&](size_t begin, size_t end, int) {
+        const size_t offset = batch.offsets[begin];
+        FullLifeTableDispatch<REAL, ACCUM>(mx + offset, (nullptr != ax) ? ax + offset : nullptr,
+                batch.Widths(begin), columns.Offset(offset), batch.AgeCount(begin),
+                end - begin);
+    });
+}
+
+}
+
+#endif //FUNDEM_RAGGED_HPP
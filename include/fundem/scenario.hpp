@@ -0,0 +1,389 @@
+//
+// Lifetables for what-if scenarios that change mortality at a few ages.
+//
+
+#ifndef FUNDEM_SCENARIO_HPP
+#define FUNDEM_SCENARIO_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! A lifetable for one population that answers for scenarios, each of
+ *  which changes mx, and optionally ax, at a few ages of a base table.
+ *
+ *  The base columns are computed once. A scenario that changes ages
+ *  from `first` to `last` leaves every column above `last` a multiple of
+ *  its base value, except ex, which is unchanged, because survival
+ *  beyond `last` depends only on mortality there. It leaves lx, dx, and
+ *  Lx below `first` as they were and shifts Tx there by a constant.
+ *  So `Apply` recomputes only the ages from `first` to `last`, keeps
+ *  the multiple and the shift for the rest, and allocates nothing.
+ *  Where the base has no survivors above `last`, to the precision of
+ *  ACCUM, there is no multiple, and `Apply` recomputes to the last age.
+ *  Reading a value at one age costs a multiply or a divide, and
+ *  `Write` fills whole columns. Values agree with `FullLifeTable` on
+ *  the changed mx, to rounding, with the last interval open.
+ *
+ *  Scenarios are relative to the base, not to each other. To build one
+ *  scenario on another, `Rebase` makes the current scenario the base.
+ *
+ * @tparam REAL Type of the arrays.
+ * @tparam ACCUM Type of the stored columns and of the recurrences.
+ */
+template<typename REAL, typename ACCUM = REAL>
+class ScenarioLifeTable {
+public:
+    /*! Computes the base table.
+     *
+     * @param mx Array[age] of mortality rates.
+     * @param ax Array[age] of mean ages, or nullptr for
+     *     constant-mortality ax.
+     * @param nx Array[age] of interval widths.
+     * @param age_cnt Number of age groups, at least one.
+     */
+    ScenarioLifeTable(const REAL *const mx, const REAL *const ax, const REAL *const nx,
+            int age_cnt)
+        : age_cnt_(age_cnt), nx_(nx, nx + age_cnt), mx_(mx, mx + age_cnt), ax_(age_cnt),
+          px_(age_cnt), lx_(age_cnt + 1), dx_(age_cnt), Lx_(age_cnt), Tx_(age_cnt + 1),
+          window_mx_(age_cnt), window_ax_(age_cnt), window_px_(age_cnt),
+          window_lx_(age_cnt + 1), window_dx_(age_cnt), window_Lx_(age_cnt),
+          window_Tx_(age_cnt + 1)
+    {
+        if (age_cnt < 1) {
+            throw std::invalid_argument("There must be at least one age group.");
+        }
+        if (nullptr != ax) {
+            std::copy(ax, ax + age_cnt, ax_.begin());
+        } else {
+            ConstantMortalityMeanAge(mx, nx, &ax_[0], age_cnt, 1);
+        }
+        Rebuild();
+    }
+
+    int AgeCount() const { return age_cnt_; }
+
+    /*! Sets the scenario to the base with mx, and ax, changed at `ages`.
+     *  Ages may come in any order. If one appears twice, the later
+     *  value wins. This costs time proportional to the span from the
+     *  youngest to the oldest changed age.
+     *
+     * @param ages Array[change_cnt] of age indices.
+     * @param mx Array[change_cnt] of mortality rates at those ages.
+     * @param ax Array[change_cnt] of mean ages, or nullptr for
+     *     constant-mortality ax at the changed ages.
+     * @param change_cnt Number of changes. Zero gives the base.
+     */
+    void Apply(const int *const ages, const REAL *const mx, const REAL *const ax,
+            int change_cnt)
+    {
+        int first = age_cnt_;
+        int last = -1;
+        for (int change_idx = 0; change_idx < change_cnt; change_idx++) {
+            if (ages[change_idx] < 0 || ages[change_idx] >= age_cnt_) {
+                throw std::out_of_range("A scenario changes an age outside the table.");
+            }
+            first = std::min(first, ages[change_idx]);
+            last = std::max(last, ages[change_idx]);
+        }
+        first_ = first;
+        last_ = last;
+        scale_ = 1;
+        shift_ = 0;
+        if (last_ < first_) {
+            return;
+        }
+
+        std::copy(&mx_[first_], &mx_[last_] + 1, &window_mx_[first_]);
+        std::copy(&ax_[first_], &ax_[last_] + 1, &window_ax_[first_]);
+        for (int change_idx = 0; change_idx < change_cnt; change_idx++) {
+            const int age_idx = ages[change_idx];
+            window_mx_[age_idx] = mx[change_idx];
+            if (nullptr != ax) {
+                window_ax_[age_idx] = ax[change_idx];
+            } else {
+                REAL mean_age;
+                ConstantMortalityMeanAge(&mx[change_idx], &nx_[age_idx], &mean_age, 1, 1);
+                window_ax_[age_idx] = mean_age;
+            }
+        }
+
+        // lx forward from the first change, which doesn't alter lx there.
+        ACCUM l = WindowSurvivors(first_, last_, lx_[first_]);
+        if (last_ + 1 < age_cnt_) {
+            if (lx_[last_ + 1] >= std::numeric_limits<ACCUM>::min()) {
+                // Above the changes, survivors are the base times this.
+                scale_ = l / lx_[last_ + 1];
+            } else {
+                // The base has no survivors, to precision, above the
+                // changes, so no multiple of it gives the scenario's.
+                std::copy(&mx_[last_ + 1], &mx_[age_cnt_ - 1] + 1, &window_mx_[last_ + 1]);
+                std::copy(&ax_[last_ + 1], &ax_[age_cnt_ - 1] + 1, &window_ax_[last_ + 1]);
+                l = WindowSurvivors(last_ + 1, age_cnt_ - 1, l);
+                last_ = age_cnt_ - 1;
+            }
+        }
+        window_lx_[last_ + 1] = l;
+
+        // Tx backward to the first change, which shifts every Tx below it.
+        ACCUM T = scale_ * Tx_[last_ + 1];
+        for (int age_idx = last_; age_idx >= first_; age_idx--) {
+            const ACCUM L = PersonYears(age_idx, window_ax_[age_idx], window_lx_[age_idx],
+                    window_lx_[age_idx + 1], window_dx_[age_idx]);
+            window_Lx_[age_idx] = L;
+            T += L;
+            window_Tx_[age_idx] = T;
+        }
+        shift_ = T - Tx_[first_];
+    }
+
+    /*! Returns the scenario to the base. */
+    void Reset()
+    {
+        Apply(nullptr, nullptr, nullptr, 0);
+    }
+
+    /*! Makes the current scenario the base, in time proportional to the
+     *  number of ages.
+     */
+    void Rebase()
+    {
+        for (int age_idx = first_; age_idx <= last_; age_idx++) {
+            mx_[age_idx] = window_mx_[age_idx];
+            ax_[age_idx] = window_ax_[age_idx];
+        }
+        Rebuild();
+    }
+
+    REAL MortalityRate(int age_idx) const
+    {
+        return InWindow(age_idx) ? window_mx_[age_idx] : mx_[age_idx];
+    }
+
+    REAL MeanAge(int age_idx) const
+    {
+        return InWindow(age_idx) ? window_ax_[age_idx] : ax_[age_idx];
+    }
+
+    REAL Survival(int age_idx) const
+    {
+        return static_cast<REAL>(InWindow(age_idx) ? window_px_[age_idx] : px_[age_idx]);
+    }
+
+    /*! lx, survivors to the start of the interval. */
+    REAL Survivors(int age_idx) const
+    {
+        return static_cast<REAL>(Column(lx_, window_lx_, age_idx));
+    }
+
+    /*! dx, deaths in the interval. */
+    REAL Deaths(int age_idx) const
+    {
+        return static_cast<REAL>(Column(dx_, window_dx_, age_idx));
+    }
+
+    /*! Lx, person-years lived in the interval. */
+    REAL PersonYearsIn(int age_idx) const
+    {
+        return static_cast<REAL>(Column(Lx_, window_Lx_, age_idx));
+    }
+
+    /*! Tx, person-years lived after the start of the interval. */
+    REAL PersonYearsAfter(int age_idx) const
+    {
+        return static_cast<REAL>(TotalPersonYears(age_idx));
+    }
+
+    /*! ex, life expectancy at the start of the interval. */
+    REAL LifeExpectancy(int age_idx) const
+    {
+        if (age_idx > last_) {
+            return static_cast<REAL>(ex_[age_idx]);
+        }
+        return static_cast<REAL>(TotalPersonYears(age_idx) / Column(lx_, window_lx_, age_idx));
+    }
+
+    /*! Writes the scenario's columns, each Array[age], for every column
+     *  that isn't nullptr.
+     */
+    void Write(const LifeTableColumns<REAL>& columns) const
+    {
+        for (int age_idx = 0; age_idx < age_cnt_; age_idx++) {
+            if (nullptr != columns.ax) {
+                columns.ax[age_idx] = MeanAge(age_idx);
+            }
+            if (nullptr != columns.px) {
+                columns.px[age_idx] = Survival(age_idx);
+            }
+            if (nullptr != columns.qx) {
+                columns.qx[age_idx] = static_cast<REAL>(1 - ACCUM(Survival(age_idx)));
+            }
+            if (nullptr != columns.lx) {
+                columns.lx[age_idx] = Survivors(age_idx);
+            }
+            if (nullptr != columns.dx) {
+                columns.dx[age_idx] = Deaths(age_idx);
+            }
+            if (nullptr != columns.Lx) {
+                columns.Lx[age_idx] = PersonYearsIn(age_idx);
+            }
+            if (nullptr != columns.Tx) {
+                columns.Tx[age_idx] = PersonYearsAfter(age_idx);
+            }
+            if (nullptr != columns.ex) {
+                columns.ex[age_idx] = LifeExpectancy(age_idx);
+            }
+        }
+    }
+
+private:
+    // Fills px, lx, and dx of the window from `begin` to `end`, starting
+    // from survivors `l`, and returns the survivors after `end`.
+    ACCUM WindowSurvivors(int begin, int end, ACCUM l)
+    {
+        for (int age_idx = begin; age_idx <= end; age_idx++) {
+            const ACCUM m = window_mx_[age_idx];
+            const ACCUM a = window_ax_[age_idx];
+            const ACCUM px = (1 - m * a) / (1 + m * (nx_[age_idx] - a));
+            window_px_[age_idx] = px;
+            window_lx_[age_idx] = l;
+            window_dx_[age_idx] = l * (1 - px);
+            l *= px;
+        }
+        return l;
+    }
+
+    // The last interval is open, so its person-years are ax lx.
+    ACCUM PersonYears(int age_idx, ACCUM a, ACCUM l, ACCUM l_next, ACCUM d) const
+    {
+        if (age_idx == age_cnt_ - 1) {
+            return a * l;
+        }
+        return ACCUM(nx_[age_idx]) * l_next + a * d;
+    }
+
+    bool InWindow(int age_idx) const
+    {
+        return age_idx >= first_ && age_idx <= last_;
+    }
+
+    // lx, dx, or Lx, which are the base below the changes and a multiple
+    // of it above them.
+    ACCUM Column(const std::vector<ACCUM>& base, const std::vector<ACCUM>& window,
+            int age_idx) const
+    {
+        if (age_idx < first_) {
+            return base[age_idx];
+        } else if (age_idx <= last_) {
+            return window[age_idx];
+        }
+        return scale_ * base[age_idx];
+    }
+
+    ACCUM TotalPersonYears(int age_idx) const
+    {
+        if (age_idx < first_) {
+            return Tx_[age_idx] + shift_;
+        } else if (age_idx <= last_) {
+            return window_Tx_[age_idx];
+        }
+        return scale_ * Tx_[age_idx];
+    }
+
+    void Rebuild()
+    {
+        ACCUM l = 1;
+        for (int age_idx = 0; age_idx < age_cnt_; age_idx++) {
+            const ACCUM m = mx_[age_idx];
+            const ACCUM a = ax_[age_idx];
+            px_[age_idx] = (1 - m * a) / (1 + m * (nx_[age_idx] - a));
+            lx_[age_idx] = l;
+            dx_[age_idx] = l * (1 - px_[age_idx]);
+            l *= px_[age_idx];
+        }
+        lx_[age_cnt_] = l;
+        ex_.resize(age_cnt_);
+        ACCUM T = 0;
+        Tx_[age_cnt_] = 0;
+        for (int age_idx = age_cnt_ - 1; age_idx >= 0; age_idx--) {
+            Lx_[age_idx] = PersonYears(age_idx, ax_[age_idx], lx_[age_idx], lx_[age_idx + 1],
+                    dx_[age_idx]);
+            T += Lx_[age_idx];
+            Tx_[age_idx] = T;
+            ex_[age_idx] = T / lx_[age_idx];
+        }
+        first_ = age_cnt_;
+        last_ = -1;
+        scale_ = 1;
+        shift_ = 0;
+    }
+
+    int age_cnt_;
+    std::vector<REAL> nx_;
+    // The base table.
+    std::vector<REAL> mx_;
+    std::vector<REAL> ax_;
+    std::vector<ACCUM> px_;
+    std::vector<ACCUM> lx_;
+    std::vector<ACCUM> dx_;
+    std::vector<ACCUM> Lx_;
+    std::vector<ACCUM> Tx_;
+    std::vector<ACCUM> ex_;
+    // The scenario, recomputed for ages [first_, last_].
+    int first_{0};
+    int last_{-1};
+    ACCUM scale_{1};  //!< Above last_, lx, dx, Lx, and Tx are this times the base.
+    ACCUM shift_{0};  //!< Below first_, Tx is the base plus this.
+    std::vector<REAL> window_mx_;
+    std::vector<REAL> window_ax_;
+    std::vector<ACCUM> window_px_;
+    std::vector<ACCUM> window_lx_;
+    std::vector<ACCUM> window_dx_;
+    std::vector<ACCUM> window_Lx_;
+    std::vector<ACCUM> window_Tx_;
+};
+
+
+/*! Lifetables for many scenarios of one base population, each of which
+ *  changes mx at the same ages.
+ *
+ * @param mx Array[age] of base mortality rates.
+ * @param ax Array[age] of base mean ages, or nullptr for constant mortality.
+ * @param nx Array[age] of interval widths.
+ * @param ages Array[change_cnt] of the ages that scenarios change.
+ * @param scenario_mx Array[scenario,change] of mortality rates at those
+ *     ages. Mean ages at those ages are constant-mortality.
+ * @param columns Array[scenario,age] for each column wanted.
+ * @param age_cnt Number of age groups.
+ * @param change_cnt Number of changed ages.
+ * @param scenario_cnt Number of scenarios.
+ * @param pool Threads that share the scenarios, each with its own table.
+ */
+template<typename REAL, typename ACCUM = REAL>
+void ScenarioLifeTables(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const int *const ages, const REAL *const scenario_mx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, int change_cnt,
+        size_t scenario_cnt, ThreadPool& pool)
+{
+    const ScenarioLifeTable<REAL, ACCUM> base(mx, ax, nx, age_cnt);
+    std::vector<ScenarioLifeTable<REAL, ACCUM>> tables(pool.ThreadCount(), base);
+    pool.ParallelForWorker(scenario_cnt, 0, [&](size_t begin, size_t end, int worker_idx) {
+        auto& table = tables[worker_idx];
+        for (size_t scenario_idx = begin; scenario_idx < end; scenario_idx++) {
+            table.Apply(ages, scenario_mx + scenario_idx * change_cnt, nullptr, change_cnt);
+            table.Write(columns.Offset(scenario_idx * age_cnt));
+        }
+    });
+}
+
+}
+
+#endif //FUNDEM_SCENARIO_HPP
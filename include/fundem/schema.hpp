@@ -0,0 +1,335 @@
+//
+// Lifetable kernels specialized at compile time for the usual age schemas.
+//
+
+#ifndef FUNDEM_SCHEMA_HPP
+#define FUNDEM_SCHEMA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+// The kernels here take the number of age groups, AGE_CNT, as a template
+// argument, so every loop over ages has a constant trip count that the
+// compiler can unroll, and scratch rows live on the stack. If WIDTH is
+// positive, every interval is that many years wide and nx isn't read
+// at all. If WIDTH is zero, widths come from nx, as in the generic
+// kernels. Either way, each value is computed by the same operations in
+// the same order as the generic kernel, so results are identical.
+
+/*! The width of an interval, folded to a constant when WIDTH is known. */
+template<int WIDTH, typename REAL>
+inline REAL SchemaWidth(const REAL *const nx, int age_idx)
+{
+    return (WIDTH > 0) ? REAL(WIDTH) : nx[age_idx];
+}
+
+
+/*! Whether every interval is `width` years wide. */
+template<typename REAL>
+bool UniformWidth(const REAL *const nx, int age_cnt, REAL width)
+{
+    return std::all_of(nx, nx + age_cnt, [width](REAL n) { return n == width; });
+}
+
+
+/*! `FirstMomentSurvival` for AGE_CNT age groups. */
+template<int AGE_CNT, int WIDTH, typename REAL>
+void FirstMomentSurvivalFixed(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const survival, size_t N)
+{
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const REAL* m = mx + pop_idx * AGE_CNT;
+        const REAL* a = ax + pop_idx * AGE_CNT;
+        REAL* s = survival + pop_idx * AGE_CNT;
+        for (int age_idx = 0; age_idx < AGE_CNT; age_idx++) {
+            s[age_idx] = (1.0 - m[age_idx] * a[age_idx]) /
+                    (1.0 + m[age_idx] * (SchemaWidth<WIDTH>(nx, age_idx) - a[age_idx]));
+        }
+    }
+}
+
+
+/*! `FirstMomentPopulation` for AGE_CNT age groups. */
+template<int AGE_CNT, int WIDTH, typename REAL, typename ACCUM = REAL>
+void FirstMomentPopulationFixed(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const lx, REAL *const dx, size_t N)
+{
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const size_t offset = pop_idx * AGE_CNT;
+        ACCUM l = 1;
+        for (int age_idx = 0; age_idx < AGE_CNT; age_idx++) {
+            lx[offset + age_idx] = static_cast<REAL>(l);
+            const ACCUM m = mx[offset + age_idx];
+            const REAL a = ax[offset + age_idx];
+            ACCUM px = (1 - m * a) / (1 + m * (SchemaWidth<WIDTH>(nx, age_idx) - a));
+            dx[offset + age_idx] = static_cast<REAL>(l * (1 - px));
+            l *= px;
+        }
+    }
+}
+
+
+/*! `FirstMomentPeriodLifeExpectancy` for AGE_CNT age groups. */
+template<int AGE_CNT, int WIDTH, typename REAL, typename ACCUM = REAL>
+void FirstMomentPeriodLifeExpectancyFixed(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const le, size_t N)
+{
+    for (size_t pop_idx = 0; pop_idx < N; pop_idx++) {
+        const size_t offset = pop_idx * AGE_CNT;
+        ACCUM e = ax[offset + AGE_CNT - 1];
+        le[offset + AGE_CNT - 1] = ax[offset + AGE_CNT - 1];
+        for (int age_idx = AGE_CNT - 2; age_idx >= 0; age_idx--) {
+            const ACCUM m = mx[offset + age_idx];
+            const REAL n = SchemaWidth<WIDTH>(nx, age_idx);
+            e = (n + (1 - m * ax[offset + age_idx]) * e) /
+                    (1 + m * (n - ax[offset + age_idx]));
+            le[offset + age_idx] = static_cast<REAL>(e);
+        }
+    }
+}
+
+
+/*! An `AgeSchema` with AGE_CNT age groups, as wide as `SchemaWidth` says. */
+template<int AGE_CNT, int WIDTH, typename REAL>
+struct FixedAgeSchema {
+    const REAL* nx;
+
+    static constexpr int Count() { return AGE_CNT; }
+    REAL Width(int age_idx) const { return SchemaWidth<WIDTH>(nx, age_idx); }
+};
+
+
+/*! `FullLifeTable` for AGE_CNT age groups. Columns the caller didn't
+ *  request are computed into rows on the stack.
+ */
+template<int AGE_CNT, int WIDTH, typename REAL, typename ACCUM = REAL>
+void FullLifeTableFixed(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, size_t N)
+{
+    REAL ax_row[AGE_CNT];
+    REAL lx_row[AGE_CNT];
+    REAL dx_row[AGE_CNT];
+    const FixedAgeSchema<AGE_CNT, WIDTH, REAL> schema = {nx};
+    FullLifeTableRows<REAL, ACCUM>(mx, ax, schema, columns, N, ax_row, lx_row, dx_row);
+}
+
+
+/*! Calls `kernel.template Run<AGE_CNT, WIDTH>()` for the schema that
+ *  matches `nx`, if there is one. The known schemas are 20 five-year
+ *  groups, the 23 GBD groups, which split the first years into neonatal
+ *  and post-neonatal intervals, and 111 single years. Twenty or 111
+ *  groups of other widths still get a fixed age count.
+ *
+ * @return Whether a specialization ran. If not, the caller should run
+ *     the generic kernel.
+ */
+template<typename REAL, typename KERNEL>
+bool DispatchAgeSchema(const REAL *const nx, int age_cnt, const KERNEL& kernel)
+{
+    switch (age_cnt) {
+        case 20:
+            if (UniformWidth(nx, age_cnt, REAL(5))) {
+                kernel.template Run<20, 5>();
+            } else {
+                kernel.template Run<20, 0>();
+            }
+            return true;
+        case 23:
+            kernel.template Run<23, 0>();
+            return true;
+        case 111:
+            if (UniformWidth(nx, age_cnt, REAL(1))) {
+                kernel.template Run<111, 1>();
+            } else {
+                kernel.template Run<111, 0>();
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+// Arguments of each kernel, held until the dispatcher knows the schema.
+
+template<typename REAL>
+struct SurvivalSchemaKernel {
+    const REAL* mx;
+    const REAL* ax;
+    const REAL* nx;
+    REAL* survival;
+    size_t N;
+
+    template<int AGE_CNT, int WIDTH>
+    void Run() const
+    {
+        FirstMomentSurvivalFixed<AGE_CNT, WIDTH>(mx, ax, nx, survival, N);
+    }
+};
+
+
+template<typename REAL, typename ACCUM>
+struct PopulationSchemaKernel {
+    const REAL* mx;
+    const REAL* ax;
+    const REAL* nx;
+    REAL* lx;
+    REAL* dx;
+    size_t N;
+
+    template<int AGE_CNT, int WIDTH>
+    void Run() const
+    {
+        FirstMomentPopulationFixed<AGE_CNT, WIDTH, REAL, ACCUM>(mx, ax, nx, lx, dx, N);
+    }
+};
+
+
+template<typename REAL, typename ACCUM>
+struct LifeExpectancySchemaKernel {
+    const REAL* mx;
+    const REAL* ax;
+    const REAL* nx;
+    REAL* le;
+    size_t N;
+
+    template<int AGE_CNT, int WIDTH>
+    void Run() const
+    {
+        FirstMomentPeriodLifeExpectancyFixed<AGE_CNT, WIDTH, REAL, ACCUM>(mx, ax, nx, le, N);
+    }
+};
+
+
+template<typename REAL, typename ACCUM>
+struct FullLifeTableSchemaKernel {
+    const REAL* mx;
+    const REAL* ax;
+    const REAL* nx;
+    const LifeTableColumns<REAL>& columns;
+    size_t N;
+
+    template<int AGE_CNT, int WIDTH>
+    void Run() const
+    {
+        FullLifeTableFixed<AGE_CNT, WIDTH, REAL, ACCUM>(mx, ax, nx, columns, N);
+    }
+};
+
+
+/*! `FirstMomentSurvival`, specialized if the age schema is known. */
+template<typename REAL>
+void FirstMomentSurvivalDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const survival, int age_cnt, size_t N)
+{
+    const SurvivalSchemaKernel<REAL> kernel{mx, ax, nx, survival, N};
+    if (!DispatchAgeSchema(nx, age_cnt, kernel)) {
+        FirstMomentSurvival(mx, ax, nx, survival, age_cnt, N);
+    }
+}
+
+
+/*! `FirstMomentPopulation`, specialized if the age schema is known. */
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPopulationDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const lx, REAL *const dx, int age_cnt, size_t N)
+{
+    const PopulationSchemaKernel<REAL, ACCUM> kernel{mx, ax, nx, lx, dx, N};
+    if (!DispatchAgeSchema(nx, age_cnt, kernel)) {
+        FirstMomentPopulation<REAL, ACCUM>(mx, ax, nx, lx, dx, age_cnt, N);
+    }
+}
+
+
+/*! `FirstMomentPeriodLifeExpectancy`, specialized if the age schema is known. */
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPeriodLifeExpectancyDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const le, int age_cnt, size_t N)
+{
+    const LifeExpectancySchemaKernel<REAL, ACCUM> kernel{mx, ax, nx, le, N};
+    if (!DispatchAgeSchema(nx, age_cnt, kernel)) {
+        FirstMomentPeriodLifeExpectancy<REAL, ACCUM>(mx, ax, nx, le, age_cnt, N);
+    }
+}
+
+
+/*! `FullLifeTable`, specialized if the age schema is known. */
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTableDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, size_t N)
+{
+    const FullLifeTableSchemaKernel<REAL, ACCUM> kernel{mx, ax, nx, columns, N};
+    if (!DispatchAgeSchema(nx, age_cnt, kernel)) {
+        FullLifeTable<REAL, ACCUM>(mx, ax, nx, columns, age_cnt, N);
+    }
+}
+
+
+template<typename REAL>
+void FirstMomentSurvivalDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const survival, int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        FirstMomentSurvivalDispatch(mx + offset, ax + offset, nx, survival + offset,
+                age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPopulationDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const lx, REAL *const dx, int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        FirstMomentPopulationDispatch<REAL, ACCUM>(mx + offset, ax + offset, nx,
+                lx + offset, dx + offset, age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FirstMomentPeriodLifeExpectancyDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        REAL *const le, int age_cnt, size_t N, ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        FirstMomentPeriodLifeExpectancyDispatch<REAL, ACCUM>(mx + offset, ax + offset, nx,
+                le + offset, age_cnt, end - begin);
+    });
+}
+
+
+template<typename REAL, typename ACCUM = REAL>
+void FullLifeTableDispatch(
+        const REAL *const mx, const REAL *const ax, const REAL *const nx,
+        const LifeTableColumns<REAL>& columns, int age_cnt, size_t N,
+        ThreadPool& pool)
+{
+    pool.ParallelFor(N, [=, &columns](size_t begin, size_t end) {
+        size_t offset = begin * age_cnt;
+        FullLifeTableDispatch<REAL, ACCUM>(mx + offset, (nullptr != ax) ? ax + offset : nullptr,
+                nx, columns.Offset(offset), age_cnt, end - begin);
+    });
+}
+
+}
+
+#endif //FUNDEM_SCHEMA_HPP
@@ -0,0 +1,232 @@
+//
+// A fixed-width group of lanes for kernels that run one population per lane.
+//
+
+#ifndef FUNDEM_SIMD_HPP
+#define FUNDEM_SIMD_HPP
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+namespace fundem {
+
+/*! Lanes for kernels that vectorize along ages within a population.
+ *  Four doubles fill a 256-bit vector, and short age schemas waste
+ *  less on a partial group.
+ */
+constexpr int kDefaultLanes = 4;
+
+
+/*! LANES values of type REAL that are operated on together.
+ *
+ *  With GCC and Clang this wraps a compiler vector type, so arithmetic
+ *  compiles to vector instructions at whatever width the target supports,
+ *  independent of how the optimizer chose to unroll loops. Other compilers
+ *  get an array and an elementwise loop. Arithmetic is IEEE arithmetic
+ *  lane by lane, so a lane computes what the scalar expression computes.
+ */
+template<typename REAL, int LANES>
+struct Lanes {
+#if defined(__GNUC__)
+    // Aligned only as REAL, so that Lanes can live in a std::vector,
+    // which doesn't promise more than that.
+    typedef REAL vector_type
+        __attribute__((vector_size(sizeof(REAL) * LANES), aligned(sizeof(REAL))));
+    vector_type v;
+#else
+    REAL v[LANES];
+#endif
+
+    static Lanes Load(const REAL *const source)
+    {
+        Lanes loaded;
+        std::memcpy(&loaded.v, source, sizeof(loaded.v));
+        return loaded;
+    }
+
+    static Lanes Broadcast(REAL value)
+    {
+        Lanes broadcast;
+        for (int lane = 0; lane < LANES; lane++) {
+            broadcast.v[lane] = value;
+        }
+        return broadcast;
+    }
+
+    void Store(REAL *const destination) const
+    {
+        std::memcpy(destination, &v, sizeof(v));
+    }
+
+    REAL operator[](int lane) const { return v[lane]; }
+};
+
+
+/*! The values of an Array[age] of lanes as an interleaved Array[age][lane].
+ */
+template<typename REAL, int LANES>
+REAL* LaneData(std::vector<Lanes<REAL, LANES>>& lanes)
+{
+    static_assert(sizeof(Lanes<REAL, LANES>) == LANES * sizeof(REAL),
+            "Lanes must be packed to be read as an array.");
+    return reinterpret_cast<REAL*>(lanes.data());
+}
+
+
+/*! The result of comparing two `Lanes`, one truth value per lane. */
+template<typename REAL, int LANES>
+struct LaneMask {
+#if defined(__GNUC__)
+    typedef typename Lanes<REAL, LANES>::vector_type vector_type;
+    typedef decltype(vector_type{} < vector_type{}) mask_type;
+    mask_type m;
+#else
+    bool m[LANES];
+#endif
+
+    bool operator[](int lane) const { return m[lane] != 0; }
+};
+
+
+#if defined(__GNUC__)
+#define FUNDEM_LANES_OPERATOR(OP) \
+    template<typename REAL, int LANES> \
+    Lanes<REAL, LANES> operator OP(const Lanes<REAL, LANES>& a, const Lanes<REAL, LANES>& b) \
+    { \
+        Lanes<REAL, LANES> result; \
+        result.v = a.v OP b.v; \
+        return result; \
+    }
+#else
+#define FUNDEM_LANES_OPERATOR(OP) \
+    template<typename REAL, int LANES> \
+    Lanes<REAL, LANES> operator OP(const Lanes<REAL, LANES>& a, const Lanes<REAL, LANES>& b) \
+    { \
+        Lanes<REAL, LANES> result; \
+        for (int lane = 0; lane < LANES; lane++) { \
+            result.v[lane] = a.v[lane] OP b.v[lane]; \
+        } \
+        return result; \
+    }
+#endif
+
+FUNDEM_LANES_OPERATOR(+)
+FUNDEM_LANES_OPERATOR(-)
+FUNDEM_LANES_OPERATOR(*)
+FUNDEM_LANES_OPERATOR(/)
+
+#undef FUNDEM_LANES_OPERATOR
+
+
+#if defined(__GNUC__)
+#define FUNDEM_LANES_COMPARISON(OP) \
+    template<typename REAL, int LANES> \
+    LaneMask<REAL, LANES> operator OP(const Lanes<REAL, LANES>& a, const Lanes<REAL, LANES>& b) \
+    { \
+        LaneMask<REAL, LANES> result; \
+        result.m = a.v OP b.v; \
+        return result; \
+    }
+#else
+#define FUNDEM_LANES_COMPARISON(OP) \
+    template<typename REAL, int LANES> \
+    LaneMask<REAL, LANES> operator OP(const Lanes<REAL, LANES>& a, const Lanes<REAL, LANES>& b) \
+    { \
+        LaneMask<REAL, LANES> result; \
+        for (int lane = 0; lane < LANES; lane++) { \
+            result.m[lane] = a.v[lane] OP b.v[lane]; \
+        } \
+        return result; \
+    }
+#endif
+
+FUNDEM_LANES_COMPARISON(<)
+FUNDEM_LANES_COMPARISON(>)
+FUNDEM_LANES_COMPARISON(<=)
+FUNDEM_LANES_COMPARISON(>=)
+
+#undef FUNDEM_LANES_COMPARISON
+
+
+template<typename REAL, int LANES>
+LaneMask<REAL, LANES> operator|(const LaneMask<REAL, LANES>& a, const LaneMask<REAL, LANES>& b)
+{
+    LaneMask<REAL, LANES> result;
+#if defined(__GNUC__)
+    result.m = a.m | b.m;
+#else
+    for (int lane = 0; lane < LANES; lane++) {
+        result.m[lane] = a.m[lane] || b.m[lane];
+    }
+#endif
+    return result;
+}
+
+
+/*! Lane-wise `std::signbit`, so -0 counts as negative. Compares each lane's
+ *  bits, read as a signed integer, with zero.
+ */
+template<typename REAL, int LANES>
+LaneMask<REAL, LANES> SignBit(const Lanes<REAL, LANES>& a)
+{
+    LaneMask<REAL, LANES> result;
+#if defined(__GNUC__)
+    typename LaneMask<REAL, LANES>::mask_type bits;
+    static_assert(sizeof(bits) == sizeof(a.v), "Masks must have the width of their lanes.");
+    std::memcpy(&bits, &a.v, sizeof(bits));
+    result.m = bits < decltype(bits){};
+#else
+    for (int lane = 0; lane < LANES; lane++) {
+        result.m[lane] = std::signbit(a.v[lane]);
+    }
+#endif
+    return result;
+}
+
+
+/*! Takes `if_true` in lanes where `mask` is set, otherwise `if_false`. */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> Select(const LaneMask<REAL, LANES>& mask,
+        const Lanes<REAL, LANES>& if_true, const Lanes<REAL, LANES>& if_false)
+{
+    Lanes<REAL, LANES> result;
+#if defined(__GNUC__)
+    result.v = mask.m ? if_true.v : if_false.v;
+#else
+    for (int lane = 0; lane < LANES; lane++) {
+        result.v[lane] = mask.m[lane] ? if_true.v[lane] : if_false.v[lane];
+    }
+#endif
+    return result;
+}
+
+
+/*! Lane-wise `std::min`, which returns `a` unless `b < a`. */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> Min(const Lanes<REAL, LANES>& a, const Lanes<REAL, LANES>& b)
+{
+    return Select(b < a, b, a);
+}
+
+
+/*! Lane-wise `std::max`, which returns `a` unless `a < b`. */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> Max(const Lanes<REAL, LANES>& a, const Lanes<REAL, LANES>& b)
+{
+    return Select(a < b, b, a);
+}
+
+
+/*! Lane-wise `std::abs`, which makes -0 into +0. */
+template<typename REAL, int LANES>
+Lanes<REAL, LANES> Abs(const Lanes<REAL, LANES>& a)
+{
+    const auto zero = Lanes<REAL, LANES>::Broadcast(0);
+    return Select(a <= zero, zero - a, a);
+}
+
+}
+
+#endif //FUNDEM_SIMD_HPP
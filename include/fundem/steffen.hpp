@@ -0,0 +1,193 @@
+//
+// Steffen's monotone cubic interpolation, specialized to interval averages.
+//
+
+#ifndef FUNDEM_STEFFEN_HPP
+#define FUNDEM_STEFFEN_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "fundem/simd.hpp"
+
+
+namespace fundem {
+
+/*! Steffen monotone interpolant on a fixed grid.
+ *
+ *  This is the interpolation of M. Steffen, "A simple method for monotonic
+ *  interpolation in one dimension," Astron. Astrophys. 239, 443-450 (1990),
+ *  with the same boundary slopes as GSL's `gsl_interp_steffen`. The
+ *  interpolant through monotone data is monotone, so it never makes
+ *  lx increase.
+ *
+ *  Graduation asks for the same thing on every iteration, the average
+ *  of the interpolant over each interval of an unchanging grid. This
+ *  computes everything that depends only on the grid when it's
+ *  constructed. After that, evaluation reads the y values once,
+ *  allocates nothing, and integrates each cubic in closed form,
+ *
+ *      integral_i = h_i (y_i + y_{i+1}) / 2 + h_i^2 (y'_i - y'_{i+1}) / 12.
+ *
+ * @tparam REAL The type of floating point.
+ */
+template<typename REAL>
+class SteffenSpline {
+public:
+    /*! A spline with no grid, for `Reset` to fill. */
+    SteffenSpline() : point_cnt_(0) {}
+
+    /*! Precomputes the grid.
+     *
+     * @param x Array[point_cnt], strictly increasing.
+     * @param point_cnt Number of points, at least two.
+     */
+    SteffenSpline(const REAL *const x, int point_cnt)
+        : point_cnt_(0)
+    {
+        Reset(x, point_cnt);
+    }
+
+    /*! Makes room for grids of up to `point_cnt` points, so that
+     *  `Reset` on them doesn't allocate.
+     */
+    void Reserve(int point_cnt)
+    {
+        inverse_h_.reserve(point_cnt);
+        h_twelfth_.reserve(point_cnt);
+        left_weight_.reserve(point_cnt);
+        right_weight_.reserve(point_cnt);
+    }
+
+    /*! Precomputes a new grid, reusing memory from the last one. */
+    void Reset(const REAL *const x, int point_cnt)
+    {
+        point_cnt_ = point_cnt;
+        inverse_h_.resize(point_cnt - 1);
+        h_twelfth_.resize(point_cnt - 1);
+        left_weight_.resize(point_cnt);
+        right_weight_.resize(point_cnt);
+        for (int interval_idx = 0; interval_idx < point_cnt - 1; interval_idx++) {
+            REAL h = x[interval_idx + 1] - x[interval_idx];
+            inverse_h_[interval_idx] = 1 / h;
+            h_twelfth_[interval_idx] = h / 12;
+        }
+        // The parabola through three points has slope
+        // p_i = (s_{i-1} h_i + s_i h_{i-1}) / (h_{i-1} + h_i) at the middle one.
+        left_weight_[0] = right_weight_[0] = 0;
+        left_weight_[point_cnt - 1] = right_weight_[point_cnt - 1] = 0;
+        for (int point_idx = 1; point_idx < point_cnt - 1; point_idx++) {
+            REAL h_left = x[point_idx] - x[point_idx - 1];
+            REAL h_right = x[point_idx + 1] - x[point_idx];
+            left_weight_[point_idx] = h_right / (h_left + h_right);
+            right_weight_[point_idx] = h_left / (h_left + h_right);
+        }
+    }
+
+    int PointCount() const { return point_cnt_; }
+
+    /*! Average of the interpolant over each interval.
+     *
+     * @param y Array[point_cnt] of values at the grid points.
+     * @param average Array[point_cnt - 1], output.
+     */
+    void IntervalAverages(const REAL *const y, REAL *const average) const
+    {
+        const int interval_cnt = point_cnt_ - 1;
+        REAL slope_right = (y[1] - y[0]) * inverse_h_[0];
+        // The first point takes the slope of its interval.
+        REAL derivative_left = slope_right;
+        for (int interval_idx = 0; interval_idx < interval_cnt; interval_idx++) {
+            const REAL slope_left = slope_right;
+            REAL derivative_right;
+            if (interval_idx + 1 < interval_cnt) {
+                slope_right = (y[interval_idx + 2] - y[interval_idx + 1]) *
+                        inverse_h_[interval_idx + 1];
+                derivative_right = Derivative(slope_left, slope_right, interval_idx + 1);
+            } else {
+                // So does the last point.
+                derivative_right = slope_left;
+            }
+            average[interval_idx] = REAL(0.5) * (y[interval_idx] + y[interval_idx + 1]) +
+                    h_twelfth_[interval_idx] * (derivative_left - derivative_right);
+            derivative_left = derivative_right;
+        }
+    }
+
+    /*! Interval averages for LANES interpolants at once.
+     *  Each lane computes exactly what `IntervalAverages` computes for it.
+     *
+     * @param y Array[point_cnt] of lanes, one curve per lane.
+     * @param average Array[point_cnt - 1] of lanes, output.
+     */
+    template<int LANES>
+    void IntervalAverages(const Lanes<REAL, LANES> *const y,
+            Lanes<REAL, LANES> *const average) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        const V half = V::Broadcast(0.5);
+        const int interval_cnt = point_cnt_ - 1;
+        V slope_right = (y[1] - y[0]) * V::Broadcast(inverse_h_[0]);
+        V derivative_left = slope_right;
+        for (int interval_idx = 0; interval_idx < interval_cnt; interval_idx++) {
+            const V slope_left = slope_right;
+            V derivative_right;
+            if (interval_idx + 1 < interval_cnt) {
+                slope_right = (y[interval_idx + 2] - y[interval_idx + 1]) *
+                        V::Broadcast(inverse_h_[interval_idx + 1]);
+                derivative_right = Derivative(slope_left, slope_right, interval_idx + 1);
+            } else {
+                derivative_right = slope_left;
+            }
+            average[interval_idx] = half * (y[interval_idx] + y[interval_idx + 1]) +
+                    V::Broadcast(h_twelfth_[interval_idx]) * (derivative_left - derivative_right);
+            derivative_left = derivative_right;
+        }
+    }
+
+private:
+    template<int LANES>
+    Lanes<REAL, LANES> Derivative(const Lanes<REAL, LANES>& slope_left,
+            const Lanes<REAL, LANES>& slope_right, int point_idx) const
+    {
+        typedef Lanes<REAL, LANES> V;
+        V parabola = slope_left * V::Broadcast(left_weight_[point_idx]) +
+                slope_right * V::Broadcast(right_weight_[point_idx]);
+        V sign_sum = Sign(slope_left) + Sign(slope_right);
+        return sign_sum * Min(Min(Abs(slope_left), Abs(slope_right)),
+                V::Broadcast(0.5) * Abs(parabola));
+    }
+
+    template<int LANES>
+    static Lanes<REAL, LANES> Sign(const Lanes<REAL, LANES>& value)
+    {
+        typedef Lanes<REAL, LANES> V;
+        return Select(SignBit(value), V::Broadcast(-1), V::Broadcast(1));
+    }
+
+    // Steffen's limited slope, eq. 11, with the sign convention of GSL,
+    // which takes the sign bit with copysign, so -0 counts as negative.
+    REAL Derivative(REAL slope_left, REAL slope_right, int point_idx) const
+    {
+        REAL parabola = slope_left * left_weight_[point_idx] +
+                slope_right * right_weight_[point_idx];
+        REAL sign_sum = Sign(slope_left) + Sign(slope_right);
+        return sign_sum * std::min(std::min(std::abs(slope_left), std::abs(slope_right)),
+                REAL(0.5) * std::abs(parabola));
+    }
+
+    static REAL Sign(REAL value)
+    {
+        return std::copysign(REAL(1), value);
+    }
+
+    int point_cnt_;
+    std::vector<REAL> inverse_h_;
+    std::vector<REAL> h_twelfth_;
+    std::vector<REAL> left_weight_;
+    std::vector<REAL> right_weight_;
+};
+
+}
+
+#endif //FUNDEM_STEFFEN_HPP
@@ -0,0 +1,481 @@
+//
+// Lifetables over memory-mapped files that needn't fit in memory.
+//
+
+#ifndef FUNDEM_STREAMING_HPP
+#define FUNDEM_STREAMING_HPP
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+namespace fundem {
+
+/*! The NumPy type string for each floating-point type. */
+template<typename REAL>
+struct NpyType;
+
+template<>
+struct NpyType<double> {
+    static const char* Descr() { return "<f8"; }
+};
+
+template<>
+struct NpyType<float> {
+    static const char* Descr() { return "<f4"; }
+};
+
+
+/*! A file mapped into memory as an array of REAL.
+ *
+ *  The file is either raw values, with no header, or a `.npy` file,
+ *  which is recognized by its magic string. A `.npy` file must be
+ *  little-endian, in C order, and of the type REAL. A raw file is
+ *  one-dimensional, with as many values as fit in it. This uses POSIX
+ *  `mmap`, so the operating system pages the file in and out, and
+ *  `WillNeed` and `DontNeed` tell it which pages to fetch and drop.
+ *  Both are advice, which the operating system may act on or ignore.
+ */
+template<typename REAL>
+class MappedArray {
+public:
+    /*! Maps an existing file.
+     *
+     * @param path The file.
+     * @param writable Whether to map it for writing.
+     */
+    static MappedArray Open(const std::string& path, bool writable = false)
+    {
+        MappedArray mapped;
+        mapped.descriptor_ = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+        if (mapped.descriptor_ < 0) {
+            ThrowSystemError("Could not open", path);
+        }
+        struct stat status;
+        if (::fstat(mapped.descriptor_, &status) != 0) {
+            ThrowSystemError("Could not read the size of", path);
+        }
+        mapped.Map(static_cast<size_t>(status.st_size), writable, path);
+
+        const char* bytes = static_cast<const char*>(mapped.map_);
+        if (mapped.map_size_ >= 6 && std::memcmp(bytes, "\x93NUMPY", 6) == 0) {
+            mapped.ReadNpyHeader(path);
+        } else {
+            mapped.shape_ = {mapped.map_size_ / sizeof(REAL)};
+        }
+        return mapped;
+    }
+
+    /*! Creates a file of the given shape, replacing any that's there,
+     *  and maps it for writing. Its values start as zero.
+     *
+     * @param path The file.
+     * @param shape Dimensions, the last of which varies fastest.
+     * @param npy Whether to write a `.npy` header, otherwise raw values.
+     */
+    static MappedArray Create(const std::string& path, const std::vector<size_t>& shape,
+            bool npy)
+    {
+        MappedArray mapped;
+        mapped.shape_ = shape;
+        std::string header = npy ? NpyHeader(shape) : std::string();
+        mapped.descriptor_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (mapped.descriptor_ < 0) {
+            ThrowSystemError("Could not create", path);
+        }
+        const size_t size = header.size() + mapped.Size() * sizeof(REAL);
+        if (::ftruncate(mapped.descriptor_, static_cast<off_t>(size)) != 0) {
+            ThrowSystemError("Could not set the size of", path);
+        }
+        mapped.Map(size, true, path);
+        std::memcpy(mapped.map_, header.data(), header.size());
+        mapped.data_offset_ = header.size();
+        return mapped;
+    }
+
+    MappedArray(MappedArray&& other) noexcept
+        : descriptor_(other.descriptor_), map_(other.map_), map_size_(other.map_size_),
+          data_offset_(other.data_offset_), shape_(std::move(other.shape_))
+    {
+        other.descriptor_ = -1;
+        other.map_ = nullptr;
+    }
+
+    MappedArray& operator=(MappedArray&& other) noexcept
+    {
+        if (this != &other) {
+            Close();
+            descriptor_ = other.descriptor_;
+            map_ = other.map_;
+            map_size_ = other.map_size_;
+            data_offset_ = other.data_offset_;
+            shape_ = std::move(other.shape_);
+            other.descriptor_ = -1;
+            other.map_ = nullptr;
+        }
+        return *this;
+    }
+
+    MappedArray(const MappedArray&) = delete;
+    MappedArray& operator=(const MappedArray&) = delete;
+
+    ~MappedArray() { Close(); }
+
+    REAL* Data() { return reinterpret_cast<REAL*>(static_cast<char*>(map_) + data_offset_); }
+    const REAL* Data() const
+    {
+        return reinterpret_cast<const REAL*>(static_cast<const char*>(map_) + data_offset_);
+    }
+
+    const std::vector<size_t>& Shape() const { return shape_; }
+
+    /*! Whether the file has a `.npy` header. */
+    bool IsNpy() const { return data_offset_ > 0; }
+
+    /*! Number of values. */
+    size_t Size() const
+    {
+        size_t size = 1;
+        for (auto dimension: shape_) {
+            size *= dimension;
+        }
+        return size;
+    }
+
+    /*! Asks the operating system to start reading values [begin, end).
+     *  This is `madvise` and returns at once. Nothing reads the pages,
+     *  so a value not yet read when it's used faults in as usual.
+     */
+    void WillNeed(size_t begin, size_t end) const { Advise(begin, end, MADV_WILLNEED); }
+
+    /*! Lets the operating system drop values [begin, end) from memory.
+     *  Written values are already in the page cache, so they aren't lost,
+     *  and they are scheduled to be written to the file. Ranges must be
+     *  released in increasing order, with nothing before `begin` in use.
+     */
+    void DontNeed(size_t begin, size_t end) const
+    {
+        size_t page_begin, page_end;
+        if (PageRange(begin, end, &page_begin, &page_end)) {
+            char* base = static_cast<char*>(map_);
+            ::msync(base + page_begin, page_end - page_begin, MS_ASYNC);
+            ::madvise(base + page_begin, page_end - page_begin, MADV_DONTNEED);
+        }
+    }
+
+private:
+    MappedArray() = default;
+
+    void Map(size_t size, bool writable, const std::string& path)
+    {
+        map_size_ = size;
+        if (0 == size) {
+            return;
+        }
+        int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* mapped = ::mmap(nullptr, size, protection, MAP_SHARED, descriptor_, 0);
+        if (MAP_FAILED == mapped) {
+            ThrowSystemError("Could not map", path);
+        }
+        map_ = mapped;
+    }
+
+    void Close()
+    {
+        if (nullptr != map_) {
+            ::munmap(map_, map_size_);
+            map_ = nullptr;
+        }
+        if (descriptor_ >= 0) {
+            ::close(descriptor_);
+            descriptor_ = -1;
+        }
+    }
+
+    // Pages from the one holding `begin` to the one before `end` are
+    // dropped. The page holding `end` may still be in use by the next
+    // chunk, and the previous chunk left the page holding `begin`, so
+    // releasing chunks in order eventually drops every page.
+    bool PageRange(size_t begin, size_t end, size_t* page_begin, size_t* page_end) const
+    {
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t byte_begin = data_offset_ + begin * sizeof(REAL);
+        size_t byte_end = std::min(map_size_, data_offset_ + end * sizeof(REAL));
+        *page_begin = byte_begin / page * page;
+        *page_end = byte_end / page * page;
+        if (byte_end == map_size_) {
+            *page_end = map_size_;
+        }
+        return nullptr != map_ && *page_begin < *page_end;
+    }
+
+    void Advise(size_t begin, size_t end, int advice) const
+    {
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        if (nullptr == map_ || begin >= end) {
+            return;
+        }
+        size_t byte_begin = (data_offset_ + begin * sizeof(REAL)) / page * page;
+        size_t byte_end = std::min(map_size_, data_offset_ + end * sizeof(REAL));
+        ::madvise(static_cast<char*>(map_) + byte_begin, byte_end - byte_begin, advice);
+    }
+
+    // Format 1.0 has a two-byte header length and 2.0 a four-byte one.
+    void ReadNpyHeader(const std::string& path)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(map_);
+        if (map_size_ < 10) {
+            throw std::runtime_error(path + " is too short to be a .npy file.");
+        }
+        size_t header_length;
+        size_t header_start;
+        if (1 == bytes[6]) {
+            header_length = bytes[8] | (bytes[9] << 8);
+            header_start = 10;
+        } else {
+            if (map_size_ < 12) {
+                throw std::runtime_error(path + " is too short to be a .npy file.");
+            }
+            header_length = bytes[8] | (bytes[9] << 8) | (bytes[10] << 16) |
+                    (static_cast<size_t>(bytes[11]) << 24);
+            header_start = 12;
+        }
+        if (header_start + header_length > map_size_) {
+            throw std::runtime_error(path + " has a .npy header longer than the file.");
+        }
+        const std::string header(reinterpret_cast<const char*>(bytes) + header_start,
+                header_length);
+        data_offset_ = header_start + header_length;
+
+        if (NpyValue(header, "descr", path) != std::string("'") + NpyType<REAL>::Descr() + "'") {
+            throw std::runtime_error(path + " doesn't hold " + NpyType<REAL>::Descr() +
+                    " values.");
+        }
+        if (NpyValue(header, "fortran_order", path) != "False") {
+            throw std::runtime_error(path + " is in Fortran order.");
+        }
+        const std::string shape = NpyValue(header, "shape", path);
+        shape_.clear();
+        size_t position = 0;
+        while (position < shape.size()) {
+            if (std::isdigit(static_cast<unsigned char>(shape[position]))) {
+                size_t digit_end = position;
+                while (digit_end < shape.size() &&
+                        std::isdigit(static_cast<unsigned char>(shape[digit_end]))) {
+                    digit_end++;
+                }
+                shape_.push_back(std::stoull(shape.substr(position, digit_end - position)));
+                position = digit_end;
+            } else {
+                position++;
+            }
+        }
+        if (data_offset_ + Size() * sizeof(REAL) > map_size_) {
+            throw std::runtime_error(path + " is shorter than its .npy shape.");
+        }
+    }
+
+    // The text of one value in the header's dictionary literal.
+    static std::string NpyValue(const std::string& header, const std::string& key,
+            const std::string& path)
+    {
+        size_t key_at = header.find("'" + key + "'");
+        if (std::string::npos == key_at) {
+            throw std::runtime_error(path + " has no " + key + " in its .npy header.");
+        }
+        size_t value_at = header.find(':', key_at) + 1;
+        while (value_at < header.size() && ' ' == header[value_at]) {
+            value_at++;
+        }
+        size_t value_end = ('(' == header[value_at]) ? header.find(')', value_at) + 1
+                : header.find_first_of(",}", value_at);
+        return header.substr(value_at, value_end - value_at);
+    }
+
+    static std::string NpyHeader(const std::vector<size_t>& shape)
+    {
+        std::string dictionary = std::string("{'descr': '") + NpyType<REAL>::Descr() +
+                "', 'fortran_order': False, 'shape': (";
+        for (auto dimension: shape) {
+            dictionary += std::to_string(dimension) + ", ";
+        }
+        if (1 != shape.size() && !shape.empty()) {
+            dictionary.resize(dictionary.size() - 2);
+        } else if (1 == shape.size()) {
+            dictionary.resize(dictionary.size() - 1);
+        }
+        dictionary += "), }";
+        // The data starts on a multiple of 64 bytes, and the header ends
+        // with a newline.
+        const size_t preamble = 10;
+        size_t padded = (preamble + dictionary.size() + 1 + 63) / 64 * 64;
+        dictionary.append(padded - preamble - dictionary.size() - 1, ' ');
+        dictionary += '\n';
+        std::string header("\x93NUMPY\x01\x00", 8);
+        header += static_cast<char>(dictionary.size() & 0xff);
+        header += static_cast<char>((dictionary.size() >> 8) & 0xff);
+        return header + dictionary;
+    }
+
+    static void ThrowSystemError(const char* what, const std::string& path)
+    {
+        throw std::runtime_error(std::string(what) + " " + path + ": " + std::strerror(errno));
+    }
+
+    int descriptor_{-1};
+    void* map_{nullptr};
+    size_t map_size_{0};
+    size_t data_offset_{0};
+    std::vector<size_t> shape_;
+};
+
+
+/*! How `StreamLifeTable` finds the mean age of death. */
+enum class MeanAgeMethod {
+    ConstantMortality,  //!< `ConstantMortalityMeanAge`
+    Graduation,         //!< `GraduationMethod`, for equal intervals
+    GraduationSteffen   //!< `GraduationMethodSteffen`
+};
+
+
+/*! Files for `StreamLifeTable`. Outputs with an empty path aren't written.
+ *  Outputs have the same shape and format as the input.
+ */
+struct LifeTableFiles {
+    std::string mx;  //!< Input, Array[..., age] of mortality rates.
+    std::string ax;  //!< Mean age of death.
+    std::string lx;  //!< Survivors to the start of the interval.
+    std::string dx;  //!< Deaths in the interval.
+    std::string ex;  //!< Period life expectancy.
+};
+
+
+/*! Computes lifetable columns for an mx file of any size.
+ *
+ *  Every axis of the input but the last is a population, so a cube of
+ *  [draw, location, year, sex, age] is draw * location * year * sex
+ *  populations. The driver works through the populations in chunks.
+ *  Before it computes a chunk, it advises the operating system that
+ *  the next chunk is needed, which may start reading it ahead, but no
+ *  thread of this driver reads it, so how much reading overlaps the
+ *  computation is up to the operating system. After it computes a
+ *  chunk, it releases that chunk's pages of input and output, which
+ *  start writing to disk.
+ *  The pages mapped at any moment are the current and next chunks, so
+ *  memory use stays under `memory_limit` however large the files are.
+ *  Within a chunk, the kernels run on the pool, and their results are
+ *  exactly those of the in-memory kernels.
+ *
+ * @tparam REAL The type in the files.
+ * @param files The input and the outputs wanted.
+ * @param nx Array[age] of interval widths.
+ * @param age_cnt Number of age groups, which must be the input's last axis.
+ * @param method How to compute ax.
+ * @param memory_limit Bytes of input, output, and scratch to hold at once.
+ * @param pool Threads for each chunk.
+ */
+template<typename REAL>
+void StreamLifeTable(
+        const LifeTableFiles& files, const REAL *const nx, int age_cnt,
+        MeanAgeMethod method, size_t memory_limit, ThreadPool& pool)
+{
+    const MappedArray<REAL> mx = MappedArray<REAL>::Open(files.mx);
+    const std::vector<size_t>& shape = mx.Shape();
+    const bool npy = mx.IsNpy();
+    if (age_cnt < 1 || mx.Size() % age_cnt != 0 ||
+            (shape.size() > 1 && shape.back() != static_cast<size_t>(age_cnt))) {
+        throw std::runtime_error(files.mx + " doesn't end in " +
+                std::to_string(age_cnt) + " age groups.");
+    }
+    const size_t pop_cnt = mx.Size() / age_cnt;
+    // A raw input is written back as raw, with its one dimension.
+    const std::vector<size_t> out_shape = npy ? shape : std::vector<size_t>{mx.Size()};
+
+    std::vector<MappedArray<REAL>> outputs;
+    auto create = [&](const std::string& path) -> REAL* {
+        if (path.empty()) {
+            return nullptr;
+        }
+        outputs.push_back(MappedArray<REAL>::Create(path, out_shape, npy));
+        return outputs.back().Data();
+    };
+    REAL* ax_out = create(files.ax);
+    REAL* lx_out = create(files.lx);
+    REAL* dx_out = create(files.dx);
+    REAL* ex_out = create(files.ex);
+    const bool need_ax = nullptr != ex_out || nullptr != lx_out || nullptr != dx_out;
+    const bool ax_scratch = nullptr == ax_out && need_ax;
+    // lx and dx come together, so one that isn't wanted goes to scratch.
+    const bool population = nullptr != lx_out || nullptr != dx_out;
+    const int population_scratch = population ?
+            ((nullptr == lx_out) + (nullptr == dx_out)) : 0;
+
+    // Each population holds rows of mx and every output and scratch row,
+    // twice over, for the chunk in hand and the one being read.
+    const size_t row_cnt = 1 + outputs.size() + ax_scratch + population_scratch;
+    const size_t bytes_per_population = 2 * row_cnt * age_cnt * sizeof(REAL);
+    const size_t chunk_cnt_max = memory_limit / bytes_per_population;
+    if (0 == chunk_cnt_max) {
+        throw std::runtime_error("The memory limit of " + std::to_string(memory_limit) +
+                " bytes holds less than one population.");
+    }
+    const size_t chunk_size = std::min(chunk_cnt_max, std::max<size_t>(pop_cnt, 1));
+    std::vector<REAL> ax_row(ax_scratch ? chunk_size * age_cnt : 0);
+    std::vector<REAL> lx_row((population && nullptr == lx_out) ? chunk_size * age_cnt : 0);
+    std::vector<REAL> dx_row((population && nullptr == dx_out) ? chunk_size * age_cnt : 0);
+
+    mx.WillNeed(0, chunk_size * age_cnt);
+    for (size_t chunk_begin = 0; chunk_begin < pop_cnt; chunk_begin += chunk_size) {
+        const size_t chunk_cnt = std::min(chunk_size, pop_cnt - chunk_begin);
+        const size_t begin = chunk_begin * age_cnt;
+        const size_t end = begin + chunk_cnt * age_cnt;
+        mx.WillNeed(end, std::min(mx.Size(), end + chunk_size * age_cnt));
+
+        const REAL* m = mx.Data() + begin;
+        REAL* a = ax_scratch ? &ax_row[0] : (ax_out ? ax_out + begin : nullptr);
+        if (nullptr != a) {
+            switch (method) {
+            case MeanAgeMethod::ConstantMortality:
+                ConstantMortalityMeanAge(m, nx, a, age_cnt, chunk_cnt, pool);
+                break;
+            case MeanAgeMethod::Graduation:
+                GraduationMethod(m, nx, a, age_cnt, chunk_cnt, pool);
+                break;
+            case MeanAgeMethod::GraduationSteffen:
+                GraduationMethodSteffen(m, nx, a, age_cnt, chunk_cnt, pool);
+                break;
+            }
+        }
+        if (population) {
+            FirstMomentPopulation(m, a, nx,
+                    lx_out ? lx_out + begin : &lx_row[0],
+                    dx_out ? dx_out + begin : &dx_row[0],
+                    age_cnt, chunk_cnt, pool);
+        }
+        if (nullptr != ex_out) {
+            FirstMomentPeriodLifeExpectancy(m, a, nx, ex_out + begin, age_cnt, chunk_cnt, pool);
+        }
+
+        mx.DontNeed(begin, end);
+        for (auto& output: outputs) {
+            output.DontNeed(begin, end);
+        }
+    }
+}
+
+}
+
+#endif //FUNDEM_STREAMING_HPP
@@ -0,0 +1,270 @@
+//
+// A small pool of worker threads that splits populations across cores.
+//
+
+#ifndef FUNDEM_THREAD_POOL_HPP
+#define FUNDEM_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace fundem {
+
+/*! A fixed set of worker threads for population-parallel kernels.
+ *
+ *  Work is a range of populations, [0, N), which is cut into chunks
+ *  of `grain` populations. Every thread, including the one that calls
+ *  `ParallelFor`, claims the next unclaimed chunk from a shared atomic
+ *  counter, so threads that finish early take over the remaining work
+ *  of slower threads. Each population is computed by exactly the same
+ *  serial code as it would be without the pool, so results are
+ *  identical, bit for bit, no matter how many threads run.
+ *
+ *  Only one `ParallelFor` runs on a pool at a time. Concurrent callers
+ *  wait their turn. A body may call `ParallelFor` on the same pool, as
+ *  kernels with pool overloads do when they call one another. That
+ *  inner call runs serially on the thread that made it, with the same
+ *  worker index, because the other threads are busy with the outer one.
+ */
+class ThreadPool {
+public:
+    /*! Start the pool.
+     *
+     * @param thread_cnt Total threads, including the calling thread.
+     *     Zero or negative means use every hardware thread.
+     */
+    explicit ThreadPool(int thread_cnt = 0)
+    {
+        if (thread_cnt <= 0) {
+            thread_cnt = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        }
+        thread_cnt_ = thread_cnt;
+        for (int worker_idx = 1; worker_idx < thread_cnt_; worker_idx++) {
+            workers_.emplace_back([this, worker_idx]() { this->WorkerLoop(worker_idx); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (auto& worker: workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int ThreadCount() const { return thread_cnt_; }
+
+    /*! Apply `body(begin, end, worker_idx)` to chunks of [0, N).
+     *
+     *  The worker index is in [0, ThreadCount()) and is unique among
+     *  threads running at the same time, so it can select per-thread
+     *  scratch space. If any chunk throws, the remaining chunks are
+     *  skipped and the first exception is rethrown here.
+     *
+     * @param N Number of populations.
+     * @param grain Populations per chunk. Zero picks a size that gives
+     *     each thread several chunks.
+     * @param body Callable as `body(size_t, size_t, int)`.
+     */
+    template<typename FUNC>
+    void ParallelForWorker(size_t N, size_t grain, FUNC&& body)
+    {
+        if (N == 0) {
+            return;
+        }
+        if (grain == 0) {
+            grain = DefaultGrain(N);
+        }
+        if (Running().pool == this) {
+            body(size_t{0}, N, Running().worker_idx);
+            return;
+        }
+        if (thread_cnt_ == 1 || N <= grain) {
+            body(size_t{0}, N, 0);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit_lock(submit_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            job_ = [&body](size_t begin, size_t end, int worker_idx) {
+                body(begin, end, worker_idx);
+            };
+            job_size_ = N;
+            job_grain_ = grain;
+            next_chunk_.store(0);
+            failed_.store(false);
+            error_ = nullptr;
+            busy_workers_ = static_cast<int>(workers_.size());
+            generation_++;
+        }
+        start_.notify_all();
+
+        RunChunks(0);
+
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        done_.wait(lock, [this]() { return busy_workers_ == 0; });
+        job_ = nullptr;
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    /*! Apply `body(begin, end)` to chunks of [0, N).
+     *  This is `ParallelForWorker` for bodies that need no scratch space.
+     */
+    template<typename FUNC>
+    void ParallelFor(size_t N, size_t grain, FUNC&& body)
+    {
+        ParallelForWorker(N, grain, [&body](size_t begin, size_t end, int) {
+            body(begin, end);
+        });
+    }
+
+    /*! Apply `body(begin, end)` with an automatically-chosen grain. */
+    template<typename FUNC>
+    void ParallelFor(size_t N, FUNC&& body)
+    {
+        ParallelFor(N, 0, std::forward<FUNC>(body));
+    }
+
+private:
+    size_t DefaultGrain(size_t N) const
+    {
+        // Several chunks per thread lets fast threads take up the slack
+        // of slow ones without paying for many tiny chunks.
+        const size_t chunks_per_thread = 8;
+        size_t chunk_cnt = static_cast<size_t>(thread_cnt_) * chunks_per_thread;
+        return std::max(size_t{1}, (N + chunk_cnt - 1) / chunk_cnt);
+    }
+
+    // The pool whose chunks this thread is running, if any, so that a
+    // body that calls back into the pool runs inline instead of waiting
+    // for a job that can't finish until it returns.
+    struct RunningChunks {
+        const ThreadPool* pool{nullptr};
+        int worker_idx{0};
+    };
+
+    static RunningChunks& Running()
+    {
+        thread_local RunningChunks running;
+        return running;
+    }
+
+    void RunChunks(int worker_idx)
+    {
+        const RunningChunks outer = Running();
+        Running().pool = this;
+        Running().worker_idx = worker_idx;
+        RunChunkLoop(worker_idx);
+        Running() = outer;
+    }
+
+    void RunChunkLoop(int worker_idx)
+    {
+        while (!failed_.load(std::memory_order_relaxed)) {
+            size_t begin = next_chunk_.fetch_add(job_grain_);
+            if (begin >= job_size_) {
+                break;
+            }
+            size_t end = std::min(job_size_, begin + job_grain_);
+            try {
+                job_(begin, end, worker_idx);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+                failed_.store(true);
+            }
+        }
+    }
+
+    void WorkerLoop(int worker_idx)
+    {
+        size_t seen_generation = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(state_mutex_);
+                start_.wait(lock, [this, seen_generation]() {
+                    return stop_ || generation_ != seen_generation;
+                });
+                if (stop_) {
+                    return;
+                }
+                seen_generation = generation_;
+            }
+            RunChunks(worker_idx);
+            {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                busy_workers_--;
+            }
+            done_.notify_one();
+        }
+    }
+
+    int thread_cnt_;
+    std::vector<std::thread> workers_;
+
+    std::mutex submit_mutex_;
+    std::mutex state_mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    bool stop_{false};
+    size_t generation_{0};
+    int busy_workers_{0};
+
+    std::function<void(size_t, size_t, int)> job_;
+    size_t job_size_{0};
+    size_t job_grain_{1};
+    std::atomic<size_t> next_chunk_{0};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;
+};
+
+
+/*! A pool shared by every caller in the process, for language bindings,
+ *  which can't hand a pool from one call to the next. There is one pool
+ *  for each number of threads asked for, kept for the life of the
+ *  process, so callers that alternate thread counts, such as one thread
+ *  for small batches and many for large ones, start threads only the
+ *  first time they ask for each count.
+ *
+ * @param thread_cnt Total threads. Zero or negative means every core.
+ */
+inline std::shared_ptr<ThreadPool> SharedThreadPool(int thread_cnt)
+{
+    static std::mutex shared_mutex;
+    static std::map<int, std::shared_ptr<ThreadPool>> shared_pools;
+    if (thread_cnt <= 0) {
+        thread_cnt = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    std::lock_guard<std::mutex> lock(shared_mutex);
+    auto& shared_pool = shared_pools[thread_cnt];
+    if (!shared_pool) {
+        shared_pool = std::make_shared<ThreadPool>(thread_cnt);
+    }
+    return shared_pool;
+}
+
+}
+
+#endif //FUNDEM_THREAD_POOL_HPP
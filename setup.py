@@ -30,7 +30,7 @@ lifetable = Extension(
     "fundem._lifetable",
     sources=["src/lifetable.cpp"],
     include_dirs=["include"],
-    libraries=["gsl"],
+    libraries=["pthread"],
     language="c++",
     extra_compile_args=extra_compile_args,
 )
@@ -16,22 +16,322 @@ BEGIN_RCPP
 END_RCPP
 }
 // first_moment_survival
-NumericVector first_moment_survival(NumericVector mx, NumericVector ax, NumericVector nx);
-RcppExport SEXP _fundem_first_moment_survival(SEXP mxSEXP, SEXP axSEXP, SEXP nxSEXP) {
+NumericVector first_moment_survival(NumericVector mx, NumericVector ax, NumericVector nx, int thread_cnt);
+RcppExport SEXP _fundem_first_moment_survival(SEXP mxSEXP, SEXP axSEXP, SEXP nxSEXP, SEXP thread_cntSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type ax(axSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
-    rcpp_result_gen = Rcpp::wrap(first_moment_survival(mx, ax, nx));
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(first_moment_survival(mx, ax, nx, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// first_moment_population
+List first_moment_population(NumericVector mx, NumericVector ax, NumericVector nx, int thread_cnt);
+RcppExport SEXP _fundem_first_moment_population(SEXP mxSEXP, SEXP axSEXP, SEXP nxSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(first_moment_population(mx, ax, nx, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// first_moment_period_life_expectancy
+NumericVector first_moment_period_life_expectancy(NumericVector mx, NumericVector ax, NumericVector nx, int thread_cnt);
+RcppExport SEXP _fundem_first_moment_period_life_expectancy(SEXP mxSEXP, SEXP axSEXP, SEXP nxSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(first_moment_period_life_expectancy(mx, ax, nx, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// first_moment_period_life_expectancy_adjoint
+List first_moment_period_life_expectancy_adjoint(NumericVector mx, NumericVector ax, NumericVector nx, Nullable<NumericVector> weights, int thread_cnt);
+RcppExport SEXP _fundem_first_moment_period_life_expectancy_adjoint(SEXP mxSEXP, SEXP axSEXP, SEXP nxSEXP, SEXP weightsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type weights(weightsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(first_moment_period_life_expectancy_adjoint(mx, ax, nx, weights, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// first_moment_population_adjoint
+List first_moment_population_adjoint(NumericVector mx, NumericVector ax, NumericVector nx, Nullable<NumericVector> lx_weights, Nullable<NumericVector> dx_weights, int thread_cnt);
+RcppExport SEXP _fundem_first_moment_population_adjoint(SEXP mxSEXP, SEXP axSEXP, SEXP nxSEXP, SEXP lx_weightsSEXP, SEXP dx_weightsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type lx_weights(lx_weightsSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type dx_weights(dx_weightsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(first_moment_population_adjoint(mx, ax, nx, lx_weights, dx_weights, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// constant_mortality_mean_age
+NumericVector constant_mortality_mean_age(NumericVector mx, NumericVector nx, int thread_cnt);
+RcppExport SEXP _fundem_constant_mortality_mean_age(SEXP mxSEXP, SEXP nxSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(constant_mortality_mean_age(mx, nx, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// graduation_method
+NumericVector graduation_method(NumericVector mx, NumericVector nx, int thread_cnt, bool monitor);
+RcppExport SEXP _fundem_graduation_method(SEXP mxSEXP, SEXP nxSEXP, SEXP thread_cntSEXP, SEXP monitorSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    Rcpp::traits::input_parameter< bool >::type monitor(monitorSEXP);
+    rcpp_result_gen = Rcpp::wrap(graduation_method(mx, nx, thread_cnt, monitor));
+    return rcpp_result_gen;
+END_RCPP
+}
+// graduation_method_steffen
+NumericVector graduation_method_steffen(NumericVector mx, NumericVector nx, int thread_cnt, bool monitor);
+RcppExport SEXP _fundem_graduation_method_steffen(SEXP mxSEXP, SEXP nxSEXP, SEXP thread_cntSEXP, SEXP monitorSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    Rcpp::traits::input_parameter< bool >::type monitor(monitorSEXP);
+    rcpp_result_gen = Rcpp::wrap(graduation_method_steffen(mx, nx, thread_cnt, monitor));
+    return rcpp_result_gen;
+END_RCPP
+}
+// full_lifetable
+List full_lifetable(NumericVector mx, NumericVector nx, Nullable<NumericVector> ax, CharacterVector columns, int thread_cnt);
+RcppExport SEXP _fundem_full_lifetable(SEXP mxSEXP, SEXP nxSEXP, SEXP axSEXP, SEXP columnsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(full_lifetable(mx, nx, ax, columns, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// cohort_lifetable
+List cohort_lifetable(NumericVector mx, NumericVector nx, Nullable<NumericVector> ax, CharacterVector columns, int thread_cnt);
+RcppExport SEXP _fundem_cohort_lifetable(SEXP mxSEXP, SEXP nxSEXP, SEXP axSEXP, SEXP columnsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(cohort_lifetable(mx, nx, ax, columns, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// summarize_draws
+List summarize_draws(NumericVector mx, NumericVector nx, Nullable<NumericVector> ax, CharacterVector columns, NumericVector quantiles, int thread_cnt);
+RcppExport SEXP _fundem_summarize_draws(SEXP mxSEXP, SEXP nxSEXP, SEXP axSEXP, SEXP columnsSEXP, SEXP quantilesSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type quantiles(quantilesSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(summarize_draws(mx, nx, ax, columns, quantiles, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// ragged_lifetable
+List ragged_lifetable(NumericVector mx, IntegerVector schema, List schemas, Nullable<NumericVector> ax, CharacterVector columns, int thread_cnt);
+RcppExport SEXP _fundem_ragged_lifetable(SEXP mxSEXP, SEXP schemaSEXP, SEXP schemasSEXP, SEXP axSEXP, SEXP columnsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type schema(schemaSEXP);
+    Rcpp::traits::input_parameter< List >::type schemas(schemasSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(ragged_lifetable(mx, schema, schemas, ax, columns, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ragged_graduation
+NumericVector ragged_graduation(NumericVector mx, IntegerVector schema, List schemas, bool steffen, int thread_cnt);
+RcppExport SEXP _fundem_ragged_graduation(SEXP mxSEXP, SEXP schemaSEXP, SEXP schemasSEXP, SEXP steffenSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type schema(schemaSEXP);
+    Rcpp::traits::input_parameter< List >::type schemas(schemasSEXP);
+    Rcpp::traits::input_parameter< bool >::type steffen(steffenSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(ragged_graduation(mx, schema, schemas, steffen, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// scenario_lifetable
+List scenario_lifetable(NumericVector mx, NumericVector nx, IntegerVector ages, NumericVector scenario_mx, Nullable<NumericVector> ax, CharacterVector columns, int thread_cnt);
+RcppExport SEXP _fundem_scenario_lifetable(SEXP mxSEXP, SEXP nxSEXP, SEXP agesSEXP, SEXP scenario_mxSEXP, SEXP axSEXP, SEXP columnsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type ages(agesSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type scenario_mx(scenario_mxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(scenario_lifetable(mx, nx, ages, scenario_mx, ax, columns, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// expand_lifetable
+List expand_lifetable(NumericVector mx, NumericVector nx, NumericVector target_nx, Nullable<NumericVector> ax, CharacterVector columns, int thread_cnt);
+RcppExport SEXP _fundem_expand_lifetable(SEXP mxSEXP, SEXP nxSEXP, SEXP target_nxSEXP, SEXP axSEXP, SEXP columnsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type target_nx(target_nxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(expand_lifetable(mx, nx, target_nx, ax, columns, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// cause_deleted_lifetable
+List cause_deleted_lifetable(NumericVector mx, NumericVector nx, NumericVector cause_mx, Nullable<NumericVector> ax, CharacterVector columns, int thread_cnt);
+RcppExport SEXP _fundem_cause_deleted_lifetable(SEXP mxSEXP, SEXP nxSEXP, SEXP cause_mxSEXP, SEXP axSEXP, SEXP columnsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type cause_mx(cause_mxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(cause_deleted_lifetable(mx, nx, cause_mx, ax, columns, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// project_population
+List project_population(NumericVector population, NumericVector nx, Nullable<NumericVector> mx, Nullable<NumericVector> fertility, Nullable<NumericVector> migration, Nullable<NumericVector> births, Nullable<NumericVector> ax, Nullable<NumericVector> Lx, double birth_fraction, int thread_cnt);
+RcppExport SEXP _fundem_project_population(SEXP populationSEXP, SEXP nxSEXP, SEXP mxSEXP, SEXP fertilitySEXP, SEXP migrationSEXP, SEXP birthsSEXP, SEXP axSEXP, SEXP LxSEXP, SEXP birth_fractionSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type population(populationSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type fertility(fertilitySEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type migration(migrationSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type births(birthsSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type ax(axSEXP);
+    Rcpp::traits::input_parameter< Nullable<NumericVector> >::type Lx(LxSEXP);
+    Rcpp::traits::input_parameter< double >::type birth_fraction(birth_fractionSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(project_population(population, nx, mx, fertility, migration, births, ax, Lx, birth_fraction, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+// hazard_rates
+NumericVector hazard_rates(std::string model, NumericVector parameters, NumericVector nx, bool midpoint, int thread_cnt);
+RcppExport SEXP _fundem_hazard_rates(SEXP modelSEXP, SEXP parametersSEXP, SEXP nxSEXP, SEXP midpointSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type parameters(parametersSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< bool >::type midpoint(midpointSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(hazard_rates(model, parameters, nx, midpoint, thread_cnt));
+    return rcpp_result_gen;
+END_RCPP
+}
+
+// fit_hazard
+List fit_hazard(std::string model, NumericVector mx, NumericVector nx, NumericVector parameters, int chain_cnt, int max_iterations, int thread_cnt);
+RcppExport SEXP _fundem_fit_hazard(SEXP modelSEXP, SEXP mxSEXP, SEXP nxSEXP, SEXP parametersSEXP, SEXP chain_cntSEXP, SEXP max_iterationsSEXP, SEXP thread_cntSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type mx(mxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type parameters(parametersSEXP);
+    Rcpp::traits::input_parameter< int >::type chain_cnt(chain_cntSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iterations(max_iterationsSEXP);
+    Rcpp::traits::input_parameter< int >::type thread_cnt(thread_cntSEXP);
+    rcpp_result_gen = Rcpp::wrap(fit_hazard(model, mx, nx, parameters, chain_cnt, max_iterations, thread_cnt));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
     {"_fundem_rcpp_hello_world", (DL_FUNC) &_fundem_rcpp_hello_world, 0},
-    {"_fundem_first_moment_survival", (DL_FUNC) &_fundem_first_moment_survival, 3},
+    {"_fundem_first_moment_survival", (DL_FUNC) &_fundem_first_moment_survival, 4},
+    {"_fundem_first_moment_population", (DL_FUNC) &_fundem_first_moment_population, 4},
+    {"_fundem_first_moment_period_life_expectancy", (DL_FUNC) &_fundem_first_moment_period_life_expectancy, 4},
+    {"_fundem_first_moment_period_life_expectancy_adjoint", (DL_FUNC) &_fundem_first_moment_period_life_expectancy_adjoint, 5},
+    {"_fundem_first_moment_population_adjoint", (DL_FUNC) &_fundem_first_moment_population_adjoint, 6},
+    {"_fundem_constant_mortality_mean_age", (DL_FUNC) &_fundem_constant_mortality_mean_age, 3},
+    {"_fundem_graduation_method", (DL_FUNC) &_fundem_graduation_method, 4},
+    {"_fundem_graduation_method_steffen", (DL_FUNC) &_fundem_graduation_method_steffen, 4},
+    {"_fundem_full_lifetable", (DL_FUNC) &_fundem_full_lifetable, 5},
+    {"_fundem_cohort_lifetable", (DL_FUNC) &_fundem_cohort_lifetable, 5},
+    {"_fundem_summarize_draws", (DL_FUNC) &_fundem_summarize_draws, 6},
+    {"_fundem_ragged_lifetable", (DL_FUNC) &_fundem_ragged_lifetable, 6},
+    {"_fundem_ragged_graduation", (DL_FUNC) &_fundem_ragged_graduation, 5},
+    {"_fundem_scenario_lifetable", (DL_FUNC) &_fundem_scenario_lifetable, 7},
+    {"_fundem_expand_lifetable", (DL_FUNC) &_fundem_expand_lifetable, 6},
+    {"_fundem_cause_deleted_lifetable", (DL_FUNC) &_fundem_cause_deleted_lifetable, 6},
+    {"_fundem_project_population", (DL_FUNC) &_fundem_project_population, 10},
+    {"_fundem_hazard_rates", (DL_FUNC) &_fundem_hazard_rates, 5},
+    {"_fundem_fit_hazard", (DL_FUNC) &_fundem_fit_hazard, 7},
     {NULL, NULL, 0}
 };
 
@@ -15,71 +15,681 @@ _lifetable = np.ctypeslib.load_library(
     compiled_libraries["_lifetable"].name,
     compiled_libraries["_lifetable"].parent)
 
-_lifetable.first_moment_survival.restype = None
-_lifetable.first_moment_survival.argtypes = [
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.c_int,
-    ctypes.c_size_t
-]
-
-
-def first_moment_survival(mx, ax, nx):
-    assert mx.shape == ax.shape
-    assert mx.shape[-1] == nx.shape[-1], \
-        f"Populations {mx.shape} must end in age groups {nx.shape}."
-    population_cnt = 1 if len(mx.shape) is 1 else np.prod(mx.shape[:-1])
-
-    survival = np.require(np.zeros_like(mx), dtype=np.float64,
-                          requirements=["A", "C", "W", "O"])
-    _lifetable.first_moment_survival(
-        np.ascontiguousarray(mx).ctypes.data_as(
-            ctypes.POINTER(ctypes.c_double)),
-        np.ascontiguousarray(ax).ctypes.data_as(
-            ctypes.POINTER(ctypes.c_double)),
-        np.ascontiguousarray(nx).ctypes.data_as(
-            ctypes.POINTER(ctypes.c_double)),
-        survival.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
-        nx.size,
-        population_cnt
-    )
-    return survival
-
-
-_lifetable.first_moment_population.restype = None
-_lifetable.first_moment_population.argtypes = [
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.POINTER(ctypes.c_double),
-    ctypes.c_int,
-    ctypes.c_size_t
-]
-
-
-def first_moment_population(mx, ax, nx):
-    assert mx.shape == ax.shape
-    assert mx.shape[-1] == nx.shape[-1], \
-        f"Populations {mx.shape} must end in age groups {nx.shape}."
-    population_cnt = 1 if len(mx.shape) is 1 else np.prod(mx.shape[:-1])
-
-    lx = np.require(np.zeros_like(mx), dtype=np.float64,
-                    requirements=["A", "C", "W", "O"])
-    dx = np.require(np.zeros_like(mx), dtype=np.float64,
-                    requirements=["A", "C", "W", "O"])
-    _lifetable.first_moment_population(
-        np.ascontiguousarray(mx).ctypes.data_as(
-            ctypes.POINTER(ctypes.c_double)),
-        np.ascontiguousarray(ax).ctypes.data_as(
-            ctypes.POINTER(ctypes.c_double)),
-        np.ascontiguousarray(nx).ctypes.data_as(
-            ctypes.POINTER(ctypes.c_double)),
-        lx.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
-        dx.ctypes.data_as(ctypes.POINTER(ctypes.c_double)),
-        nx.size,
-        population_cnt
-    )
+_lifetable.fundem_last_error.restype = ctypes.c_char_p
+_lifetable.fundem_last_error.argtypes = []
+
+
+class _Array(ctypes.Structure):
+    """An array[pop,age] as the library sees it, with strides in elements.
+    """
+    _fields_ = [
+        ("data", ctypes.c_void_p),
+        ("pop_stride", ctypes.c_int64),
+        ("age_stride", ctypes.c_int64),
+    ]
+
+
+# Each kernel has a double and a float version. Arrays of float32 go to
+# the float version, and everything else is converted to float64.
+_FLOAT = np.dtype(np.float32)
+_DOUBLE = np.dtype(np.float64)
+
+
+# Most kernels end with the counts of ages and populations, then threads.
+_COUNTS = [ctypes.c_int, ctypes.c_size_t, ctypes.c_int]
+
+
+def _declare(name, array_cnt, pointer_cnt=0, scalars=_COUNTS):
+    """Declares every precision of a kernel, keyed by (dtype, mixed).
+    Pointers to contiguous records or indices follow the arrays, and
+    `scalars` follow those."""
+    kernels = dict()
+    for suffix, key in [("", (_DOUBLE, False)), ("_float", (_FLOAT, False)),
+                        ("_mixed", (_FLOAT, True))]:
+        try:
+            function = getattr(_lifetable, name + suffix)
+        except AttributeError:
+            continue
+        function.restype = ctypes.c_int
+        function.argtypes = [_Array] * array_cnt + \
+            [ctypes.c_void_p] * pointer_cnt + list(scalars)
+        kernels[key] = function
+    return kernels
+
+
+def _kernel(kernels, dtype, mixed):
+    # Double arrays already accumulate in double.
+    return kernels[(dtype, bool(mixed) and dtype == _FLOAT)]
+
+
+def _storage_dtype(mx):
+    if mx.dtype == _FLOAT:
+        return _FLOAT
+    return _DOUBLE
+
+
+def _population_stride(array):
+    """Bytes between populations if the leading axes of the array
+    collapse into one axis without a copy, otherwise None."""
+    axes = [(size, stride) for (size, stride)
+            in zip(array.shape[:-1], array.strides[:-1]) if size != 1]
+    if not axes:
+        return 0
+    for (outer_size, outer_stride), (inner_size, inner_stride) \
+            in zip(axes[:-1], axes[1:]):
+        if outer_stride != inner_stride * inner_size:
+            return None
+    return axes[-1][1]
+
+
+def _strides(array):
+    """Strides of an array[pop,age] in elements, or None if it isn't one."""
+    itemsize = array.dtype.itemsize
+    if array.ndim == 0:
+        return None
+    pop_stride = _population_stride(array)
+    age_stride = array.strides[-1]
+    if pop_stride is None or pop_stride % itemsize or age_stride % itemsize:
+        return None
+    return pop_stride // itemsize, age_stride // itemsize
+
+
+def _input(array, dtype):
+    """Describes an input without copying it, unless it has the wrong
+    dtype or a layout that strides can't describe. Returns the array that
+    was described, which must outlive the call."""
+    array = np.asarray(array)
+    if array.dtype != dtype:
+        array = array.astype(dtype)
+    strides = _strides(array)
+    if strides is None:
+        array = np.ascontiguousarray(array)
+        strides = _strides(array)
+    return _Array(array.ctypes.data, *strides), array
+
+
+def _output(out, shape, dtype, name):
+    """Describes an output, either `out` or a new array."""
+    if out is None:
+        out = np.empty(shape, dtype=dtype)
+    elif not isinstance(out, np.ndarray):
+        raise TypeError(f"The {name} output must be an ndarray.")
+    elif out.shape != shape or out.dtype != dtype:
+        raise ValueError(
+            f"The {name} output is {out.dtype}{out.shape} "
+            f"but should be {dtype}{shape}.")
+    elif not out.flags.writeable:
+        raise ValueError(f"The {name} output isn't writeable.")
+    strides = _strides(out)
+    if strides is None:
+        raise ValueError(
+            f"The {name} output's populations can't be described "
+            f"with a single stride.")
+    return _Array(out.ctypes.data, *strides), out
+
+
+_NONE = _Array(None, 0, 0)
+
+
+def _describe(dtype, inputs, outputs):
+    """Describes the arrays of a kernel, inputs first.
+
+    Args:
+        inputs (list): Triples of (array or None, name, shape), where
+            None is an absent array and a shape of None takes any shape.
+        outputs (list): Triples of (out array or None, name, shape), or
+            None for an output that isn't wanted.
+    Returns:
+        tuple: The described arrays, the input arrays that must outlive
+        the call, and the output arrays, with None for those that
+        weren't wanted.
+    """
+    described = list()
+    kept = list()
+    for array, name, shape in inputs:
+        if array is None:
+            described.append(_NONE)
+            continue
+        if shape is not None and np.shape(array) != shape:
+            raise ValueError(f"{name} {np.shape(array)} must be {shape}.")
+        argument, array = _input(array, dtype)
+        described.append(argument)
+        kept.append(array)
+    results = list()
+    for output in outputs:
+        if output is None:
+            described.append(_NONE)
+            results.append(None)
+            continue
+        argument, array = _output(output[0], output[2], dtype, output[1])
+        described.append(argument)
+        results.append(array)
+    return described, kept, results
+
+
+def _run(kernel, *arguments):
+    if kernel(*arguments) != 0:
+        raise RuntimeError(_lifetable.fundem_last_error().decode())
+
+
+def _call(kernels, mx, nx, inputs, outputs, thread_cnt, mixed, records=()):
+    """Calls a kernel as kernel(mx, *inputs, nx, *outputs, *records)
+    on arrays that all have the shape of mx.
+
+    Args:
+        kernels: From `_declare`.
+        inputs (list): Pairs of (input array or None, name) after mx.
+        outputs (list): Pairs of (out array or None, name), or None for
+            an output that isn't wanted.
+        records (list): Addresses of per-population records.
+    Returns:
+        list: The output arrays, with None for those that weren't wanted.
+    """
+    mx = np.asarray(mx)
+    nx = np.asarray(nx)
+    if mx.shape[-1:] != nx.shape[-1:]:
+        raise ValueError(f"Populations {mx.shape} must end in age groups {nx.shape}.")
+    age_cnt = nx.shape[-1]
+    population_cnt = int(np.prod(mx.shape[:-1], dtype=np.int64))
+    dtype = _storage_dtype(mx)
+    described, kept, results = _describe(
+        dtype,
+        [(mx, "mx", None)] + [(array, name, mx.shape) for (array, name) in inputs] +
+        [(nx, "nx", None)],
+        [None if output is None else output + (mx.shape,) for output in outputs])
+    _run(_kernel(kernels, dtype, mixed), *described, *records, age_cnt, population_cnt,
+         thread_cnt)
+    return results
+
+
+_first_moment_survival = _declare("first_moment_survival", 4)
+
+
+def first_moment_survival(mx, ax, nx, thread_cnt=1, out=None):
+    return _call(_first_moment_survival, mx, nx, [(ax, "ax")],
+                 [(out, "survival")], thread_cnt, False)[0]
+
+
+_first_moment_population = _declare("first_moment_population", 5)
+
+
+def first_moment_population(mx, ax, nx, thread_cnt=1, mixed=False, out=None):
+    lx_out, dx_out = (None, None) if out is None else out
+    lx, dx = _call(_first_moment_population, mx, nx, [(ax, "ax")],
+                   [(lx_out, "lx"), (dx_out, "dx")], thread_cnt, mixed)
     return lx, dx
+
+
+_first_moment_period_life_expectancy = _declare(
+    "first_moment_period_life_expectancy", 4)
+
+
+def first_moment_period_life_expectancy(mx, ax, nx, thread_cnt=1, mixed=False,
+                                        out=None):
+    return _call(_first_moment_period_life_expectancy, mx, nx, [(ax, "ax")],
+                 [(out, "le")], thread_cnt, mixed)[0]
+
+
+_first_moment_period_life_expectancy_adjoint = _declare(
+    "first_moment_period_life_expectancy_adjoint", 6)
+
+
+def first_moment_period_life_expectancy_adjoint(mx, ax, nx, weights=None,
+                                                thread_cnt=1, out=None):
+    mx_out, ax_out = (None, None) if out is None else out
+    mx_grad, ax_grad = _call(
+        _first_moment_period_life_expectancy_adjoint, mx, nx,
+        [(ax, "ax"), (weights, "weights")],
+        [(mx_out, "mx gradient"), (ax_out, "ax gradient")], thread_cnt, False)
+    return mx_grad, ax_grad
+
+
+_first_moment_population_adjoint = _declare("first_moment_population_adjoint", 7)
+
+
+def first_moment_population_adjoint(mx, ax, nx, lx_weights=None, dx_weights=None,
+                                    thread_cnt=1, out=None):
+    mx_out, ax_out = (None, None) if out is None else out
+    mx_grad, ax_grad = _call(
+        _first_moment_population_adjoint, mx, nx,
+        [(ax, "ax"), (lx_weights, "lx_weights"), (dx_weights, "dx_weights")],
+        [(mx_out, "mx gradient"), (ax_out, "ax gradient")], thread_cnt, False)
+    return mx_grad, ax_grad
+
+
+_constant_mortality_mean_age = _declare("constant_mortality_mean_age", 3)
+
+
+def constant_mortality_mean_age(mx, nx, thread_cnt=1, out=None):
+    return _call(_constant_mortality_mean_age, mx, nx, [],
+                 [(out, "ax")], thread_cnt, False)[0]
+
+
+class GraduationMonitor:
+    """Records what graduation did for each population.
+
+    Pass one as ``monitor=`` to `graduation_method` or
+    `graduation_method_steffen`. After the call, each record has the
+    shape of mx without its age axis.
+
+    Attributes:
+        iterations (np.ndarray): Fixed-point iterations taken.
+        difference (np.ndarray): Largest change in ax on the last iteration.
+        outcome (np.ndarray): Index into `OUTCOMES`. Only converged
+            populations keep graduated ax. The rest keep
+            constant-mortality ax.
+        seconds (np.ndarray): Wall time for each population.
+    """
+    OUTCOMES = ("converged", "diverged", "fallback")
+
+    def __init__(self):
+        self.iterations = None
+        self.difference = None
+        self.outcome = None
+        self.seconds = None
+
+    def _records(self, shape):
+        self.iterations = np.full(shape, -1, dtype=np.intc)
+        self.difference = np.full(shape, np.nan)
+        self.outcome = np.full(shape, -1, dtype=np.intc)
+        self.seconds = np.full(shape, np.nan)
+        return [record.ctypes.data for record in
+                (self.iterations, self.difference, self.outcome, self.seconds)]
+
+    def summary(self):
+        """Totals over populations, as a dict. Entry k of
+        ``iteration_histogram`` counts populations that took k iterations,
+        and entry k of ``time_histogram`` counts those that took
+        [2^k, 2^(k+1)) nanoseconds, with anything faster in entry 0."""
+        nanoseconds = self.seconds.ravel() * 1e9
+        time_bucket = np.where(
+            nanoseconds < 2, 0,
+            np.floor(np.log2(np.maximum(nanoseconds, 1)))).astype(int)
+        outcome_cnt = np.bincount(self.outcome.ravel(), minlength=len(self.OUTCOMES))
+        summary = {name: int(count) for (name, count)
+                   in zip(self.OUTCOMES, outcome_cnt)}
+        summary.update(
+            iteration_histogram=np.bincount(self.iterations.ravel()),
+            time_histogram=np.bincount(time_bucket),
+            total_seconds=float(self.seconds.sum()),
+            max_seconds=float(self.seconds.max(initial=0)),
+            slowest=np.unravel_index(int(np.argmax(self.seconds)), self.seconds.shape)
+            if self.seconds.size else None,
+        )
+        return summary
+
+
+def _graduate(kernels, monitored, mx, nx, thread_cnt, out, monitor):
+    if monitor is None:
+        return _call(kernels, mx, nx, [], [(out, "ax")], thread_cnt, False)[0]
+    records = monitor._records(np.shape(mx)[:-1])
+    return _call(monitored, mx, nx, [], [(out, "ax")], thread_cnt, False,
+                 records)[0]
+
+
+_graduation_method = _declare("graduation_method", 3)
+_graduation_method_monitored = _declare("graduation_method_monitored", 3, 4)
+
+
+def graduation_method(mx, nx, thread_cnt=1, out=None, monitor=None):
+    return _graduate(_graduation_method, _graduation_method_monitored,
+                     mx, nx, thread_cnt, out, monitor)
+
+
+_graduation_method_steffen = _declare("graduation_method_steffen", 3)
+_graduation_method_steffen_monitored = _declare(
+    "graduation_method_steffen_monitored", 3, 4)
+
+
+def graduation_method_steffen(mx, nx, thread_cnt=1, out=None, monitor=None):
+    return _graduate(_graduation_method_steffen,
+                     _graduation_method_steffen_monitored,
+                     mx, nx, thread_cnt, out, monitor)
+
+
+_full_lifetable = _declare("full_lifetable", 11)
+
+LIFETABLE_COLUMNS = ("ax", "qx", "px", "lx", "dx", "Lx", "Tx", "ex")
+
+
+def _columns(names, columns, out, kind):
+    """Outputs for a kernel that fills any of `names`, in that order,
+    as pairs of (out array or None, name), or None where a column isn't
+    wanted. Columns in the dict `out` are wanted and go there."""
+    out = dict() if out is None else out
+    unknown = (set(columns) | set(out)) - set(names)
+    if unknown:
+        raise ValueError(f"Unknown {kind} columns {sorted(unknown)}.")
+    wanted = set(columns) | set(out)
+    return [(out.get(name), name) if name in wanted else None for name in names]
+
+
+def _shaped(outputs, shape):
+    return [None if output is None else output + (shape,) for output in outputs]
+
+
+def _named(names, results):
+    return {name: result for (name, result) in zip(names, results)
+            if result is not None}
+
+
+def full_lifetable(mx, nx, ax=None, columns=LIFETABLE_COLUMNS, thread_cnt=1,
+                   mixed=False, out=None):
+    outputs = _columns(LIFETABLE_COLUMNS, columns, out, "lifetable")
+    results = _call(_full_lifetable, mx, nx, [(ax, "ax")], outputs, thread_cnt, mixed)
+    return _named(LIFETABLE_COLUMNS, results)
+
+
+_cohort_lifetable = _declare(
+    "cohort_lifetable", 11, 0, [ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_int])
+
+
+def cohort_lifetable(mx, nx, ax=None, columns=("lx", "dx", "ex"), thread_cnt=1,
+                     mixed=False, out=None):
+    mx = np.asarray(mx)
+    nx = np.asarray(nx)
+    outputs = _columns(LIFETABLE_COLUMNS, columns, out, "lifetable")
+    if mx.ndim < 2 or mx.shape[-1:] != nx.shape[-1:]:
+        raise ValueError(
+            f"mx {mx.shape} must be [..., year, age] with ages {nx.shape}.")
+    dtype = _storage_dtype(mx)
+    described, kept, results = _describe(
+        dtype, [(mx, "mx", None), (ax, "ax", mx.shape), (nx, "nx", None)],
+        _shaped(outputs, mx.shape))
+    age_cnt, year_cnt = mx.shape[-1], mx.shape[-2]
+    population_cnt = int(np.prod(mx.shape[:-2], dtype=np.int64))
+    _run(_kernel(_cohort_lifetable, dtype, mixed), *described, age_cnt, year_cnt,
+         population_cnt, thread_cnt)
+    return _named(LIFETABLE_COLUMNS, results)
+
+
+_summarize_draws = _declare(
+    "summarize_draws", 11, 0,
+    [ctypes.c_int, ctypes.c_size_t, ctypes.c_size_t, ctypes.c_double,
+     ctypes.c_double, ctypes.c_int])
+
+DRAW_STATISTICS = ("mean", "variance", "lower", "upper")
+
+
+def summarize_draws(mx, nx, ax=None, columns=("ex",), quantiles=(0.025, 0.975),
+                    thread_cnt=1, mixed=False, out=None):
+    mx = np.asarray(mx)
+    nx = np.asarray(nx)
+    outputs = _columns(LIFETABLE_COLUMNS, columns, out, "lifetable")
+    if mx.ndim < 2 or mx.shape[-1:] != nx.shape[-1:]:
+        raise ValueError(
+            f"mx {mx.shape} must be [draw, ..., age] with ages {nx.shape}.")
+    dtype = _storage_dtype(mx)
+    described, kept, results = _describe(
+        dtype, [(mx, "mx", None), (ax, "ax", mx.shape), (nx, "nx", None)],
+        _shaped(outputs, mx.shape[1:] + (len(DRAW_STATISTICS),)))
+    draw_cnt, age_cnt = mx.shape[0], mx.shape[-1]
+    population_cnt = int(np.prod(mx.shape[1:-1], dtype=np.int64))
+    _run(_kernel(_summarize_draws, dtype, mixed), *described, age_cnt, population_cnt,
+         draw_cnt, quantiles[0], quantiles[1], thread_cnt)
+    return _named(LIFETABLE_COLUMNS, results)
+
+
+_scenario_lifetable = _declare(
+    "scenario_lifetable", 12, 1,
+    [ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_int])
+
+
+def scenario_lifetable(mx, nx, ages, scenario_mx, ax=None, columns=("ex",),
+                       thread_cnt=1, mixed=False, out=None):
+    mx = np.asarray(mx)
+    nx = np.asarray(nx)
+    outputs = _columns(LIFETABLE_COLUMNS, columns, out, "lifetable")
+    if mx.ndim != 1 or mx.shape != nx.shape:
+        raise ValueError(f"mx {mx.shape} must be one population with ages {nx.shape}.")
+    ages = np.ascontiguousarray(ages, dtype=np.intc)
+    scenario_mx = np.asarray(scenario_mx)
+    if ages.ndim != 1 or scenario_mx.ndim != 2 or scenario_mx.shape[1] != ages.shape[0]:
+        raise ValueError(
+            f"scenario_mx {scenario_mx.shape} must be [scenario, change] "
+            f"for ages {ages.shape}.")
+    dtype = _storage_dtype(mx)
+    age_cnt = mx.shape[0]
+    change_cnt, scenario_cnt = scenario_mx.shape[1], scenario_mx.shape[0]
+    described, kept, results = _describe(
+        dtype,
+        [(mx, "mx", None), (ax, "ax", mx.shape), (nx, "nx", None),
+         (scenario_mx, "scenario_mx", None)],
+        _shaped(outputs, (scenario_cnt, age_cnt)))
+    _run(_kernel(_scenario_lifetable, dtype, mixed), *described, ages.ctypes.data,
+         age_cnt, change_cnt, scenario_cnt, thread_cnt)
+    return _named(LIFETABLE_COLUMNS, results)
+
+
+_expand_lifetable = _declare(
+    "expand_lifetable", 12, 0, [ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_int])
+
+
+def expand_lifetable(mx, nx, target_nx, ax=None, columns=("lx", "dx", "ex"),
+                     thread_cnt=1, mixed=False, out=None):
+    mx = np.asarray(mx)
+    nx = np.asarray(nx)
+    target_nx = np.asarray(target_nx)
+    outputs = _columns(LIFETABLE_COLUMNS, columns, out, "lifetable")
+    if mx.ndim < 1 or mx.shape[-1:] != nx.shape or nx.ndim != 1:
+        raise ValueError(f"mx {mx.shape} must be [..., age] with ages {nx.shape}.")
+    if target_nx.ndim != 1:
+        raise ValueError(f"target_nx {target_nx.shape} must be one schema.")
+    dtype = _storage_dtype(mx)
+    source_cnt, target_cnt = nx.shape[0], target_nx.shape[0]
+    described, kept, results = _describe(
+        dtype,
+        [(mx, "mx", None), (ax, "ax", mx.shape), (nx, "nx", None),
+         (target_nx, "target_nx", None)],
+        _shaped(outputs, mx.shape[:-1] + (target_cnt,)))
+    population_cnt = int(np.prod(mx.shape[:-1], dtype=np.int64))
+    _run(_kernel(_expand_lifetable, dtype, mixed), *described, source_cnt, target_cnt,
+         population_cnt, thread_cnt)
+    return _named(LIFETABLE_COLUMNS, results)
+
+
+_cause_deleted_lifetable = _declare(
+    "cause_deleted_lifetable", 9, 0,
+    [ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_int])
+
+# Columns of the cause-deleted and multiple-decrement tables, in the
+# order the library takes them.
+DECREMENT_COLUMNS = ("deleted_qx", "deleted_lx", "deleted_ex", "cause_dx", "cause_lx")
+
+
+def cause_deleted_lifetable(mx, nx, cause_mx, ax=None, columns=("deleted_ex",),
+                            thread_cnt=1, mixed=False, out=None):
+    mx = np.asarray(mx)
+    nx = np.asarray(nx)
+    cause_mx = np.asarray(cause_mx)
+    outputs = _columns(DECREMENT_COLUMNS, columns, out, "decrement")
+    if mx.ndim < 1 or mx.shape[-1:] != nx.shape or nx.ndim != 1:
+        raise ValueError(f"mx {mx.shape} must be [..., age] with ages {nx.shape}.")
+    if cause_mx.ndim != mx.ndim + 1 or cause_mx.shape[:-2] != mx.shape[:-1] or \
+            cause_mx.shape[-1] != mx.shape[-1]:
+        raise ValueError(
+            f"cause_mx {cause_mx.shape} must be [..., cause, age] for mx {mx.shape}.")
+    dtype = _storage_dtype(mx)
+    described, kept, results = _describe(
+        dtype,
+        [(mx, "mx", None), (ax, "ax", mx.shape), (nx, "nx", None),
+         (cause_mx, "cause_mx", None)],
+        _shaped(outputs, cause_mx.shape))
+    age_cnt, cause_cnt = mx.shape[-1], cause_mx.shape[-2]
+    population_cnt = int(np.prod(mx.shape[:-1], dtype=np.int64))
+    _run(_kernel(_cause_deleted_lifetable, dtype, mixed), *described, age_cnt, cause_cnt,
+         population_cnt, thread_cnt)
+    return _named(DECREMENT_COLUMNS, results)
+
+
+_project_population = _declare(
+    "project_population", 10, 0,
+    [ctypes.c_double, ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_int])
+
+# What a projection returns.
+PROJECTION_COLUMNS = ("population", "births")
+
+
+def project_population(population, nx, mx=None, fertility=None, migration=None,
+                       births=None, ax=None, Lx=None, birth_fraction=1.0, thread_cnt=1,
+                       mixed=False, out=None):
+    """Projects populations [..., age] by the cohort-component method
+    through rates that are [..., step, age], with births [..., step]
+    when there is no fertility. Returns the population at the end of
+    each step, [..., step, age], and the births during each step."""
+    population = np.asarray(population)
+    nx = np.asarray(nx)
+    projected, born = _columns(PROJECTION_COLUMNS, PROJECTION_COLUMNS, out, "projection")
+    if (mx is None) == (Lx is None):
+        raise ValueError("Give either mx or Lx for the projection's survival.")
+    shape = np.shape(mx if mx is not None else Lx)
+    if population.ndim < 1 or nx.ndim != 1 or population.shape[-1] != nx.shape[-1]:
+        raise ValueError(
+            f"population {population.shape} must be [..., age] with ages {nx.shape}.")
+    if len(shape) != population.ndim + 1 or shape[:-2] != population.shape[:-1] or \
+            shape[-1] != nx.shape[-1]:
+        raise ValueError(
+            f"Rates {shape} must be [..., step, age] for population {population.shape}.")
+    dtype = _storage_dtype(population)
+    described, kept, (projected, born) = _describe(
+        dtype,
+        [(population, "population", None), (mx, "mx", shape), (ax, "ax", shape),
+         (Lx, "Lx", shape), (fertility, "fertility", shape),
+         (migration, "migration", shape), (births, "births", shape[:-1]),
+         (nx, "nx", None)],
+        [projected + (shape,), born + (shape[:-1],)])
+    age_cnt, step_cnt = shape[-1], shape[-2]
+    population_cnt = int(np.prod(population.shape[:-1], dtype=np.int64))
+    _run(_kernel(_project_population, dtype, mixed), *described, birth_fraction, age_cnt,
+         step_cnt, population_cnt, thread_cnt)
+    return dict(population=projected, births=born)
+
+
+def _ragged_layout(mx, schema, schemas, dtype):
+    """Packs the schemas' widths and finds where each population starts
+    in packed arrays, as `fundem/ragged.hpp` wants them."""
+    schema = np.ascontiguousarray(schema, dtype=np.intc)
+    widths = [np.asarray(nx, dtype=dtype).ravel() for nx in schemas]
+    if schema.ndim != 1 or not widths:
+        raise ValueError("schema must be one index per population into schemas.")
+    nx_offsets = np.zeros(len(widths) + 1, dtype=np.uintp)
+    nx_offsets[1:] = np.cumsum([nx.size for nx in widths])
+    if np.any((schema < 0) | (schema >= len(widths))):
+        raise ValueError(f"schema refers to a schema outside the {len(widths)} given.")
+    offsets = np.zeros(schema.size + 1, dtype=np.uintp)
+    offsets[1:] = np.cumsum(np.diff(nx_offsets)[schema])
+    if mx.shape != (int(offsets[-1]),):
+        raise ValueError(
+            f"mx {mx.shape} must hold the {int(offsets[-1])} values of "
+            f"its populations' schemas, end to end.")
+    nx = np.concatenate(widths)
+    return schema, nx, nx_offsets, offsets
+
+
+_ragged_lifetable = _declare(
+    "ragged_lifetable", 11, 3, [ctypes.c_size_t, ctypes.c_int, ctypes.c_int])
+
+
+def ragged_lifetable(mx, schema, schemas, ax=None, columns=LIFETABLE_COLUMNS,
+                     thread_cnt=1, mixed=False, out=None):
+    mx = np.asarray(mx)
+    outputs = _columns(LIFETABLE_COLUMNS, columns, out, "lifetable")
+    dtype = _storage_dtype(mx)
+    schema, nx, nx_offsets, offsets = _ragged_layout(mx, schema, schemas, dtype)
+    described, kept, results = _describe(
+        dtype, [(mx, "mx", None), (ax, "ax", mx.shape), (nx, "nx", None)],
+        _shaped(outputs, mx.shape))
+    _run(_kernel(_ragged_lifetable, dtype, mixed), *described, offsets.ctypes.data,
+         schema.ctypes.data, nx_offsets.ctypes.data, schema.size, nx_offsets.size - 1,
+         thread_cnt)
+    return _named(LIFETABLE_COLUMNS, results)
+
+
+_ragged_graduation = _declare(
+    "ragged_graduation", 3, 3, [ctypes.c_size_t, ctypes.c_int, ctypes.c_int, ctypes.c_int])
+
+
+def ragged_graduation(mx, schema, schemas, steffen=True, thread_cnt=1, out=None):
+    mx = np.asarray(mx)
+    dtype = _storage_dtype(mx)
+    schema, nx, nx_offsets, offsets = _ragged_layout(mx, schema, schemas, dtype)
+    described, kept, (ax,) = _describe(
+        dtype, [(mx, "mx", None), (nx, "nx", None)], [(out, "ax", mx.shape)])
+    _run(_kernel(_ragged_graduation, dtype, False), *described, offsets.ctypes.data,
+         schema.ctypes.data, nx_offsets.ctypes.data, schema.size, nx_offsets.size - 1,
+         int(bool(steffen)), thread_cnt)
+    return ax
+
+
+# Hazard models in the order the library numbers them, with the count
+# of parameters each takes.
+HAZARD_MODELS = {"gompertz": 2, "makeham": 3, "siler": 5, "heligman_pollard": 8}
+
+_hazard_rates = _declare(
+    "hazard_rates", 3, 0,
+    [ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_int, ctypes.c_int])
+
+
+def _parameter_count(model):
+    if model not in HAZARD_MODELS:
+        raise ValueError(
+            f"Unknown hazard model {model}, not one of {list(HAZARD_MODELS)}.")
+    return HAZARD_MODELS[model]
+
+
+def hazard_rates(model, parameters, nx, midpoint=False, thread_cnt=1, out=None):
+    parameter_cnt = _parameter_count(model)
+    parameters = np.asarray(parameters)
+    nx = np.asarray(nx)
+    if parameters.ndim < 1 or parameters.shape[-1] != parameter_cnt:
+        raise ValueError(
+            f"The {model} model takes {parameter_cnt} parameters, "
+            f"but parameters are {parameters.shape}.")
+    if nx.ndim != 1:
+        raise ValueError(f"nx {nx.shape} must be one schema.")
+    dtype = _storage_dtype(parameters)
+    described, kept, (mx,) = _describe(
+        dtype, [(parameters, "parameters", None), (nx, "nx", None)],
+        [(out, "mx", parameters.shape[:-1] + nx.shape)])
+    population_cnt = int(np.prod(parameters.shape[:-1], dtype=np.int64))
+    _run(_kernel(_hazard_rates, dtype, False), *described,
+         list(HAZARD_MODELS).index(model), nx.shape[0], population_cnt,
+         int(bool(midpoint)), thread_cnt)
+    return mx
+
+
+_fit_hazard = _declare(
+    "fit_hazard", 3, 3,
+    [ctypes.c_int, ctypes.c_int, ctypes.c_size_t, ctypes.c_size_t, ctypes.c_int,
+     ctypes.c_int])
+
+# How a fit ended, in the order the library numbers outcomes.
+FIT_OUTCOMES = ("converged", "max_iterations", "failed")
+
+
+def fit_hazard(model, mx, nx, parameters, chain_cnt=1, max_iterations=100,
+               thread_cnt=1, out=None):
+    """Fits a hazard model to each population of mx, starting from
+    `parameters`, which are left alone unless they are also `out`."""
+    parameter_cnt = _parameter_count(model)
+    mx = np.asarray(mx)
+    nx = np.asarray(nx)
+    if mx.ndim < 1 or mx.shape[-1:] != nx.shape[-1:]:
+        raise ValueError(f"mx {mx.shape} must be [..., age] with ages {nx.shape}.")
+    shape = mx.shape[:-1] + (parameter_cnt,)
+    if np.shape(parameters) != shape:
+        raise ValueError(
+            f"The {model} model takes {parameter_cnt} parameters, so starting "
+            f"parameters {np.shape(parameters)} should be {shape}.")
+    dtype = _storage_dtype(mx)
+    described, kept, (fit,) = _describe(
+        dtype, [(mx, "mx", None), (nx, "nx", None)], [(out, "parameters", shape)])
+    fit[...] = parameters
+    outcome = np.empty(mx.shape[:-1], dtype=np.intc)
+    iterations = np.empty(mx.shape[:-1], dtype=np.intc)
+    cost = np.empty(mx.shape[:-1], dtype=np.float64)
+    population_cnt = int(np.prod(mx.shape[:-1], dtype=np.int64))
+    _run(_kernel(_fit_hazard, dtype, False), *described, outcome.ctypes.data,
+         iterations.ctypes.data, cost.ctypes.data, list(HAZARD_MODELS).index(model),
+         nx.shape[-1], population_cnt, chain_cnt, max_iterations, thread_cnt)
+    return dict(parameters=fit, outcome=outcome, iterations=iterations, cost=cost)
@@ -1,6 +1,25 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
-#include "Python.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "fundem/adjoint.hpp"
+#include "fundem/cohort.hpp"
+#include "fundem/decrement.hpp"
+#include "fundem/draws.hpp"
+#include "fundem/expansion.hpp"
+#include "fundem/fit.hpp"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/hazards.hpp"
 #include "fundem/lifetable.hpp"
+#include "fundem/projection.hpp"
+#include "fundem/ragged.hpp"
+#include "fundem/scenario.hpp"
+#include "fundem/schema.hpp"
+#include "fundem/thread_pool.hpp"
 
 using namespace fundem;
 
@@ -18,28 +37,1360 @@ using namespace fundem;
 extern "C" {
 #endif
 
-FUNDEM_API void first_moment_survival(
-        double* mx, double* ax, double* nx, double* s, int age_cnt, size_t N)
+/*! One argument of a kernel, an Array[pop,age] at any strides.
+ *  Strides count elements, not bytes, and may be negative. For nx,
+ *  only the age stride matters. A null `data` marks an optional
+ *  array that the caller doesn't want.
+ */
+typedef struct {
+    void* data;
+    int64_t pop_stride;
+    int64_t age_stride;
+} fundem_array;
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace {
+
+// Entry points return nonzero on failure and leave the message here,
+// for the thread that made the call.
+thread_local std::string last_error;
+
+
+// Populations gathered at a time from an array that isn't laid out
+// [pop][age] contiguously. Gathering is per thread, into buffers
+// that keep their capacity from call to call.
+const size_t kGatherPopulations = 64;
+
+
+bool IsContiguous(const fundem_array& array, int64_t age_cnt, size_t N)
+{
+    return array.age_stride == 1 && (array.pop_stride == age_cnt || N == 1);
+}
+
+
+/*! Runs a kernel on strided arrays.
+ *  Arrays before `output_begin` are read and the rest are written.
+ *  The kernel is called as `kernel(rows, nx, age_cnt, pop_cnt, first_pop)`,
+ *  where `rows` holds a contiguous Array[pop,age] for each array, or
+ *  nullptr, for populations that are split among the threads of the
+ *  shared pool, starting at population `first_pop`.
+ *  Python calls through ctypes, which releases the GIL for the length
+ *  of the call, so other Python threads continue while kernels run.
+ */
+template<typename REAL, int ARRAY_CNT, typename KERNEL>
+int RunKernel(
+        const fundem_array (&arrays)[ARRAY_CNT], int output_begin,
+        const fundem_array& nx, int age_cnt, size_t N, int thread_cnt,
+        KERNEL kernel)
+{
+    try {
+        if (age_cnt < 1) {
+            throw std::invalid_argument("There must be at least one age group.");
+        }
+        std::vector<REAL> nx_gathered;
+        const REAL* nx_data = static_cast<const REAL*>(nx.data);
+        if (nx.age_stride != 1) {
+            nx_gathered.resize(age_cnt);
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                nx_gathered[age_idx] = nx_data[age_idx * nx.age_stride];
+            }
+            nx_data = &nx_gathered[0];
+        }
+        bool contiguous = true;
+        for (int array_idx = 0; array_idx < ARRAY_CNT; array_idx++) {
+            contiguous = contiguous && (nullptr == arrays[array_idx].data ||
+                    IsContiguous(arrays[array_idx], age_cnt, N));
+        }
+
+        auto pool = SharedThreadPool(thread_cnt);
+        pool->ParallelFor(N, [&](size_t begin, size_t end) {
+            REAL* rows[ARRAY_CNT];
+            if (contiguous) {
+                for (int array_idx = 0; array_idx < ARRAY_CNT; array_idx++) {
+                    REAL* data = static_cast<REAL*>(arrays[array_idx].data);
+                    rows[array_idx] = (nullptr != data) ? data + begin * age_cnt : nullptr;
+                }
+                kernel(rows, nx_data, age_cnt, end - begin, begin);
+                return;
+            }
+
+            thread_local std::vector<REAL> buffers[ARRAY_CNT];
+            for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += kGatherPopulations) {
+                const size_t chunk_cnt = std::min(kGatherPopulations, end - chunk_begin);
+                for (int array_idx = 0; array_idx < ARRAY_CNT; array_idx++) {
+                    const fundem_array& array = arrays[array_idx];
+                    REAL* data = static_cast<REAL*>(array.data);
+                    if (nullptr == data) {
+                        rows[array_idx] = nullptr;
+                    } else if (IsContiguous(array, age_cnt, N)) {
+                        rows[array_idx] = data + chunk_begin * age_cnt;
+                    } else {
+                        buffers[array_idx].resize(kGatherPopulations * age_cnt);
+                        rows[array_idx] = &buffers[array_idx][0];
+                        if (array_idx < output_begin) {
+                            for (size_t pop_idx = 0; pop_idx < chunk_cnt; pop_idx++) {
+                                const REAL* source = data +
+                                        std::ptrdiff_t(chunk_begin + pop_idx) * array.pop_stride;
+                                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                                    rows[array_idx][pop_idx * age_cnt + age_idx] =
+                                            source[age_idx * array.age_stride];
+                                }
+                            }
+                        }
+                    }
+                }
+                kernel(rows, nx_data, age_cnt, chunk_cnt, chunk_begin);
+                for (int array_idx = output_begin; array_idx < ARRAY_CNT; array_idx++) {
+                    const fundem_array& array = arrays[array_idx];
+                    REAL* data = static_cast<REAL*>(array.data);
+                    if (nullptr == data || IsContiguous(array, age_cnt, N)) {
+                        continue;
+                    }
+                    for (size_t pop_idx = 0; pop_idx < chunk_cnt; pop_idx++) {
+                        REAL* destination = data +
+                                std::ptrdiff_t(chunk_begin + pop_idx) * array.pop_stride;
+                        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                            destination[age_idx * array.age_stride] =
+                                    rows[array_idx][pop_idx * age_cnt + age_idx];
+                        }
+                    }
+                }
+            }
+        });
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// Each kernel comes in double, float, and, where something accumulates
+// along ages, mixed versions that store float and accumulate in double.
+
+template<typename REAL>
+int SurvivalEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array survival, int age_cnt, size_t N, int thread_cnt)
+{
+    const fundem_array arrays[] = {mx, ax, survival};
+    return RunKernel<REAL>(arrays, 2, nx, age_cnt, N, thread_cnt,
+            [](REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t) {
+        FirstMomentSurvivalDispatch(rows[0], rows[1], n, rows[2], age_cnt, pop_cnt);
+    });
+}
+
+
+template<typename REAL, typename ACCUM>
+int PopulationEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array lx, fundem_array dx, int age_cnt, size_t N, int thread_cnt)
+{
+    const fundem_array arrays[] = {mx, ax, lx, dx};
+    return RunKernel<REAL>(arrays, 2, nx, age_cnt, N, thread_cnt,
+            [](REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t) {
+        FirstMomentPopulationDispatch<REAL, ACCUM>(rows[0], rows[1], n, rows[2], rows[3],
+                age_cnt, pop_cnt);
+    });
+}
+
+
+template<typename REAL, typename ACCUM>
+int LifeExpectancyEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array le, int age_cnt, size_t N, int thread_cnt)
+{
+    const fundem_array arrays[] = {mx, ax, le};
+    return RunKernel<REAL>(arrays, 2, nx, age_cnt, N, thread_cnt,
+            [](REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t) {
+        FirstMomentPeriodLifeExpectancyDispatch<REAL, ACCUM>(rows[0], rows[1], n, rows[2],
+                age_cnt, pop_cnt);
+    });
+}
+
+
+// Gradients take weights, which may be null, after ax.
+template<typename REAL>
+int LifeExpectancyAdjointEntry(fundem_array mx, fundem_array ax, fundem_array weights,
+        fundem_array nx, fundem_array mx_grad, fundem_array ax_grad,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    const fundem_array arrays[] = {mx, ax, weights, mx_grad, ax_grad};
+    return RunKernel<REAL>(arrays, 3, nx, age_cnt, N, thread_cnt,
+            [](REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t) {
+        FirstMomentPeriodLifeExpectancyAdjoint(rows[0], rows[1], n, rows[2], rows[3], rows[4],
+                age_cnt, pop_cnt);
+    });
+}
+
+
+template<typename REAL>
+int PopulationAdjointEntry(fundem_array mx, fundem_array ax, fundem_array lx_weights,
+        fundem_array dx_weights, fundem_array nx, fundem_array mx_grad, fundem_array ax_grad,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    const fundem_array arrays[] = {mx, ax, lx_weights, dx_weights, mx_grad, ax_grad};
+    return RunKernel<REAL>(arrays, 4, nx, age_cnt, N, thread_cnt,
+            [](REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t) {
+        FirstMomentPopulationAdjoint(rows[0], rows[1], n, rows[2], rows[3], rows[4], rows[5],
+                age_cnt, pop_cnt);
+    });
+}
+
+
+// Graduation scratch for each thread, kept from call to call, so that
+// repeated calls on small batches don't allocate.
+template<typename REAL>
+LifeTableWorkspace<REAL>& ThreadWorkspace()
+{
+    thread_local LifeTableWorkspace<REAL> workspace;
+    return workspace;
+}
+
+
+// The mean-age kernels share a signature, mx and nx in, ax out.
+template<typename REAL>
+struct MeanAgeKernels {
+    static void ConstantMortality(
+            REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t)
+    {
+        ConstantMortalityMeanAgeVectorized(rows[0], n, rows[1], age_cnt, pop_cnt);
+    }
+
+    static void Graduation(
+            REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t)
+    {
+        GraduationMethod(rows[0], n, rows[1], age_cnt, pop_cnt, ThreadWorkspace<REAL>());
+    }
+
+    static void Steffen(
+            REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t)
+    {
+        GraduationMethodSteffen(rows[0], n, rows[1], age_cnt, pop_cnt,
+                ThreadWorkspace<REAL>());
+    }
+};
+
+
+template<typename REAL>
+int MeanAgeEntry(fundem_array mx, fundem_array nx, fundem_array ax,
+        int age_cnt, size_t N, int thread_cnt,
+        void (*kernel)(REAL* const*, const REAL*, int, size_t, size_t))
+{
+    const fundem_array arrays[] = {mx, ax};
+    return RunKernel<REAL>(arrays, 1, nx, age_cnt, N, thread_cnt, kernel);
+}
+
+
+// Graduation that also fills per-population records, any of which
+// may be null.
+template<typename REAL>
+int MonitoredEntry(fundem_array mx, fundem_array nx, fundem_array ax,
+        int* iterations, double* difference, int* outcome, double* seconds,
+        int age_cnt, size_t N, int thread_cnt, bool steffen)
+{
+    GraduationRecorder recorder;
+    recorder.iterations = iterations;
+    recorder.difference = difference;
+    recorder.outcome = outcome;
+    recorder.seconds = seconds;
+    const fundem_array arrays[] = {mx, ax};
+    return RunKernel<REAL>(arrays, 1, nx, age_cnt, N, thread_cnt,
+            [recorder, steffen](REAL* const* rows, const REAL* n, int age_cnt,
+                    size_t pop_cnt, size_t first_pop) {
+        if (steffen) {
+            GraduationMethodSteffen(rows[0], n, rows[1], age_cnt, pop_cnt,
+                    ThreadWorkspace<REAL>(), recorder.Offset(first_pop));
+        } else {
+            GraduationMethod(rows[0], n, rows[1], age_cnt, pop_cnt,
+                    ThreadWorkspace<REAL>(), recorder.Offset(first_pop));
+        }
+    });
+}
+
+
+template<typename REAL, typename ACCUM>
+int FullLifeTableEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    const fundem_array arrays[] = {mx, ax, ax_out, qx, px, lx, dx, Lx, Tx, ex};
+    return RunKernel<REAL>(arrays, 2, nx, age_cnt, N, thread_cnt,
+            [](REAL* const* rows, const REAL* n, int age_cnt, size_t pop_cnt, size_t) {
+        LifeTableColumns<REAL> columns;
+        columns.ax = rows[2];
+        columns.qx = rows[3];
+        columns.px = rows[4];
+        columns.lx = rows[5];
+        columns.dx = rows[6];
+        columns.Lx = rows[7];
+        columns.Tx = rows[8];
+        columns.ex = rows[9];
+        FullLifeTableDispatch<REAL, ACCUM>(rows[0], rows[1], n, columns, age_cnt, pop_cnt);
+    });
+}
+
+
+/*! An array as the contiguous Array[row,col] that a kernel taking
+ *  whole arrays wants. That is the caller's memory when its strides
+ *  allow, and otherwise a copy that starts with the caller's values
+ *  and that `Store` writes back, so an array may be read, written, or
+ *  both. Null data stays null.
+ */
+template<typename REAL>
+class ContiguousArray {
+public:
+    ContiguousArray(const fundem_array& array, size_t row_cnt, std::ptrdiff_t col_cnt)
+        : array_(array), row_cnt_(row_cnt), col_cnt_(col_cnt),
+          data_(static_cast<REAL*>(array.data))
+    {
+        if (nullptr == data_ || row_cnt < 1 || col_cnt < 1 ||
+                IsContiguous(array, col_cnt, row_cnt)) {
+            return;
+        }
+        copy_.resize(row_cnt * col_cnt);
+        for (size_t row_idx = 0; row_idx < row_cnt; row_idx++) {
+            const REAL* source = data_ + std::ptrdiff_t(row_idx) * array.pop_stride;
+            for (std::ptrdiff_t col_idx = 0; col_idx < col_cnt; col_idx++) {
+                copy_[row_idx * col_cnt + col_idx] = source[col_idx * array.age_stride];
+            }
+        }
+        data_ = &copy_[0];
+    }
+
+    REAL* Data() const
+    {
+        return data_;
+    }
+
+    /*! Writes a copy back to the caller's memory. */
+    void Store() const
+    {
+        if (copy_.empty()) {
+            return;
+        }
+        REAL* const data = static_cast<REAL*>(array_.data);
+        for (size_t row_idx = 0; row_idx < row_cnt_; row_idx++) {
+            REAL* destination = data + std::ptrdiff_t(row_idx) * array_.pop_stride;
+            for (std::ptrdiff_t col_idx = 0; col_idx < col_cnt_; col_idx++) {
+                destination[col_idx * array_.age_stride] = copy_[row_idx * col_cnt_ + col_idx];
+            }
+        }
+    }
+
+private:
+    fundem_array array_;
+    size_t row_cnt_;
+    std::ptrdiff_t col_cnt_;
+    REAL* data_;
+    std::vector<REAL> copy_;
+};
+
+
+/*! Lifetable columns, in the order of `LifeTableColumnMembers`, as
+ *  contiguous arrays that all have the same shape.
+ */
+template<typename REAL>
+class ContiguousColumns {
+public:
+    ContiguousColumns(const fundem_array (&columns)[8], size_t row_cnt,
+            std::ptrdiff_t col_cnt)
+    {
+        const auto members = LifeTableColumnMembers<REAL>();
+        arrays_.reserve(members.size());
+        for (size_t column_idx = 0; column_idx < members.size(); column_idx++) {
+            arrays_.emplace_back(columns[column_idx], row_cnt, col_cnt);
+            columns_.*members[column_idx] = arrays_.back().Data();
+        }
+    }
+
+    const LifeTableColumns<REAL>& Columns() const
+    {
+        return columns_;
+    }
+
+    void Store() const
+    {
+        for (const auto& array: arrays_) {
+            array.Store();
+        }
+    }
+
+private:
+    std::vector<ContiguousArray<REAL>> arrays_;
+    LifeTableColumns<REAL> columns_;
+};
+
+
+// Ragged batches pack every population's values end to end, with
+// schemas' widths packed in nx. Packed arrays are one row each, and
+// columns may be null.
+template<typename REAL>
+RaggedBatch<REAL> MakeRaggedBatch(const size_t* offsets, const int* schema, const REAL* nx,
+        const size_t* nx_offsets, size_t N, int schema_cnt)
+{
+    RaggedBatch<REAL> batch;
+    batch.offsets = offsets;
+    batch.schema = schema;
+    batch.nx = nx;
+    batch.nx_offsets = nx_offsets;
+    batch.N = N;
+    batch.schema_cnt = schema_cnt;
+    return batch;
+}
+
+
+// The length of a packed array, which must be an offset that strides can reach.
+std::ptrdiff_t PackedCount(size_t value_cnt)
+{
+    if (value_cnt > size_t(PTRDIFF_MAX)) {
+        throw std::invalid_argument("A ragged batch has more values than can be addressed.");
+    }
+    return static_cast<std::ptrdiff_t>(value_cnt);
+}
+
+
+template<typename REAL, typename ACCUM>
+int RaggedLifeTableEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const size_t* offsets, const int* schema, const size_t* nx_offsets, size_t N,
+        int schema_cnt, int thread_cnt)
 {
     try {
-        FirstMomentSurvival(mx, ax, nx, s, age_cnt, N);
+        auto batch = MakeRaggedBatch<REAL>(offsets, schema, nullptr, nx_offsets, N,
+                schema_cnt);
+        batch.Check();
+        const std::ptrdiff_t value_cnt = PackedCount(batch.Size());
+        const ContiguousArray<REAL> mx_values(mx, 1, value_cnt);
+        const ContiguousArray<REAL> ax_values(ax, 1, value_cnt);
+        const ContiguousArray<REAL> widths(nx, 1, PackedCount(nx_offsets[schema_cnt]));
+        const fundem_array outputs[] = {ax_out, qx, px, lx, dx, Lx, Tx, ex};
+        const ContiguousColumns<REAL> columns(outputs, 1, value_cnt);
+        batch.nx = widths.Data();
+        auto pool = SharedThreadPool(thread_cnt);
+        FullLifeTableRagged<REAL, ACCUM>(mx_values.Data(), ax_values.Data(),
+                columns.Columns(), batch, *pool);
+        columns.Store();
+        return 0;
     } catch (std::exception& e) {
-        PyErr_SetString(PyExc_RuntimeError, e.what());
+        last_error = e.what();
+        return 1;
     }
 }
 
 
-FUNDEM_API void first_moment_population(
-        double* mx, double* ax, double* nx, double* lx, double* dx, int age_cnt, size_t N)
+template<typename REAL>
+int RaggedGraduationEntry(fundem_array mx, fundem_array nx, fundem_array ax,
+        const size_t* offsets, const int* schema, const size_t* nx_offsets, size_t N,
+        int schema_cnt, int steffen, int thread_cnt)
 {
     try {
-        FirstMomentPopulation(mx, ax, nx, lx, dx, age_cnt, N);
+        auto batch = MakeRaggedBatch<REAL>(offsets, schema, nullptr, nx_offsets, N,
+                schema_cnt);
+        batch.Check();
+        const std::ptrdiff_t value_cnt = PackedCount(batch.Size());
+        const ContiguousArray<REAL> mx_values(mx, 1, value_cnt);
+        const ContiguousArray<REAL> ax_values(ax, 1, value_cnt);
+        const ContiguousArray<REAL> widths(nx, 1, PackedCount(nx_offsets[schema_cnt]));
+        batch.nx = widths.Data();
+        const REAL* const rates = mx_values.Data();
+        REAL* const mean_ages = ax_values.Data();
+        auto pool = SharedThreadPool(thread_cnt);
+        RaggedFor(batch, *pool, [&](size_t begin, size_t end, int) {
+            const size_t offset = batch.offsets[begin];
+            if (steffen) {
+                GraduationMethodSteffen(rates + offset, batch.Widths(begin),
+                        mean_ages + offset, batch.AgeCount(begin), end - begin,
+                        ThreadWorkspace<REAL>());
+            } else {
+                GraduationMethod(rates + offset, batch.Widths(begin), mean_ages + offset,
+                        batch.AgeCount(begin), end - begin, ThreadWorkspace<REAL>());
+            }
+        });
+        ax_values.Store();
+        return 0;
     } catch (std::exception& e) {
-        PyErr_SetString(PyExc_RuntimeError, e.what());
+        last_error = e.what();
+        return 1;
     }
 }
 
 
+// Cohort surfaces are Array[pop,year,age], given as Array[pop*year,age]
+// with each population's years together, because cohorts cut across
+// populations' rows. Columns may be null.
+template<typename REAL, typename ACCUM>
+int CohortEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, int year_cnt, size_t N, int thread_cnt)
+{
+    try {
+        if (age_cnt < 1) {
+            throw std::invalid_argument("There must be at least one age group.");
+        }
+        if (year_cnt < 1) {
+            throw std::invalid_argument("There must be at least one year.");
+        }
+        const size_t row_cnt = N * year_cnt;
+        const ContiguousArray<REAL> mx_rows(mx, row_cnt, age_cnt);
+        const ContiguousArray<REAL> ax_rows(ax, row_cnt, age_cnt);
+        const ContiguousArray<REAL> widths(nx, 1, age_cnt);
+        const fundem_array outputs[] = {ax_out, qx, px, lx, dx, Lx, Tx, ex};
+        const ContiguousColumns<REAL> columns(outputs, row_cnt, age_cnt);
+        auto pool = SharedThreadPool(thread_cnt);
+        CohortLifeTable<REAL, ACCUM>(mx_rows.Data(), ax_rows.Data(), widths.Data(),
+                columns.Columns(), age_cnt, year_cnt, N, *pool);
+        columns.Store();
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// Draws are Array[draw,pop,age], given as Array[draw*pop,age], and each
+// summary is Array[pop,age,stat], given as Array[pop*age,stat], or null.
+template<typename REAL, typename ACCUM>
+int DrawsEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t pop_cnt, size_t draw_cnt, double lower, double upper,
+        int thread_cnt)
+{
+    try {
+        if (age_cnt < 1) {
+            throw std::invalid_argument("There must be at least one age group.");
+        }
+        const ContiguousArray<REAL> mx_rows(mx, draw_cnt * pop_cnt, age_cnt);
+        const ContiguousArray<REAL> ax_rows(ax, draw_cnt * pop_cnt, age_cnt);
+        const ContiguousArray<REAL> widths(nx, 1, age_cnt);
+        const fundem_array outputs[] = {ax_out, qx, px, lx, dx, Lx, Tx, ex};
+        const ContiguousColumns<REAL> summaries(outputs, pop_cnt * age_cnt,
+                kDrawStatisticCount);
+        auto pool = SharedThreadPool(thread_cnt);
+        SummarizeDraws<REAL, ACCUM>(mx_rows.Data(), ax_rows.Data(), widths.Data(),
+                summaries.Columns(), age_cnt, pop_cnt, draw_cnt, *pool, lower, upper);
+        summaries.Store();
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// One base population, Array[age], with scenarios that change mx at
+// the same ages, Array[scenario,change]. Columns are Array[scenario,age],
+// or null.
+template<typename REAL, typename ACCUM>
+int ScenarioEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array scenario_mx, fundem_array ax_out, fundem_array qx, fundem_array px,
+        fundem_array lx, fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const int* ages, int age_cnt, int change_cnt, size_t scenario_cnt, int thread_cnt)
+{
+    try {
+        if (age_cnt < 1) {
+            throw std::invalid_argument("There must be at least one age group.");
+        }
+        const ContiguousArray<REAL> base_mx(mx, 1, age_cnt);
+        const ContiguousArray<REAL> base_ax(ax, 1, age_cnt);
+        const ContiguousArray<REAL> widths(nx, 1, age_cnt);
+        const ContiguousArray<REAL> changes(scenario_mx, scenario_cnt, change_cnt);
+        const fundem_array outputs[] = {ax_out, qx, px, lx, dx, Lx, Tx, ex};
+        const ContiguousColumns<REAL> columns(outputs, scenario_cnt, age_cnt);
+        auto pool = SharedThreadPool(thread_cnt);
+        ScenarioLifeTables<REAL, ACCUM>(base_mx.Data(), base_ax.Data(), widths.Data(), ages,
+                changes.Data(), columns.Columns(), age_cnt, change_cnt, scenario_cnt,
+                *pool);
+        columns.Store();
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// Populations' mx and ax in the source schema, Array[pop,source age],
+// become columns in the target schema, Array[pop,target age], or null.
+// Operators are cached by schema pair.
+template<typename REAL, typename ACCUM>
+int ExpansionEntry(fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array target_nx, fundem_array ax_out, fundem_array qx, fundem_array px,
+        fundem_array lx, fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int source_cnt, int target_cnt, size_t N, int thread_cnt)
+{
+    try {
+        const ContiguousArray<REAL> mx_rows(mx, N, source_cnt);
+        const ContiguousArray<REAL> ax_rows(ax, N, source_cnt);
+        const ContiguousArray<REAL> source_widths(nx, 1, source_cnt);
+        const ContiguousArray<REAL> target_widths(target_nx, 1, target_cnt);
+        const fundem_array outputs[] = {ax_out, qx, px, lx, dx, Lx, Tx, ex};
+        const ContiguousColumns<REAL> columns(outputs, N, target_cnt);
+        auto expand = SharedExpansionOperator(source_widths.Data(), source_cnt,
+                target_widths.Data(), target_cnt);
+        auto pool = SharedThreadPool(thread_cnt);
+        expand->template Apply<ACCUM>(mx_rows.Data(), ax_rows.Data(), columns.Columns(), N,
+                *pool);
+        columns.Store();
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// Array[pop,age] all-cause mx and ax, with Array[pop,cause,age] cause_mx,
+// given as Array[pop*cause,age], become cause-deleted and
+// multiple-decrement columns of the same shape as cause_mx, or null.
+template<typename REAL, typename ACCUM>
+int DecrementEntry(fundem_array mx, fundem_array ax, fundem_array nx, fundem_array cause_mx,
+        fundem_array deleted_qx, fundem_array deleted_lx, fundem_array deleted_ex,
+        fundem_array cause_dx, fundem_array cause_lx, int age_cnt, int cause_cnt, size_t N,
+        int thread_cnt)
+{
+    try {
+        if (cause_cnt < 1) {
+            throw std::invalid_argument("There must be at least one cause.");
+        }
+        const size_t row_cnt = N * cause_cnt;
+        const ContiguousArray<REAL> mx_rows(mx, N, age_cnt);
+        const ContiguousArray<REAL> ax_rows(ax, N, age_cnt);
+        const ContiguousArray<REAL> widths(nx, 1, age_cnt);
+        const ContiguousArray<REAL> cause_rows(cause_mx, row_cnt, age_cnt);
+        const ContiguousArray<REAL> outputs[] = {
+            {deleted_qx, row_cnt, age_cnt}, {deleted_lx, row_cnt, age_cnt},
+            {deleted_ex, row_cnt, age_cnt}, {cause_dx, row_cnt, age_cnt},
+            {cause_lx, row_cnt, age_cnt}};
+        DecrementColumns<REAL> columns;
+        columns.deleted_qx = outputs[0].Data();
+        columns.deleted_lx = outputs[1].Data();
+        columns.deleted_ex = outputs[2].Data();
+        columns.cause_dx = outputs[3].Data();
+        columns.cause_lx = outputs[4].Data();
+        auto pool = SharedThreadPool(thread_cnt);
+        CauseDeletedLifeTable<REAL, ACCUM>(mx_rows.Data(), ax_rows.Data(), widths.Data(),
+                cause_rows.Data(), columns, age_cnt, cause_cnt, N, *pool);
+        for (const auto& output: outputs) {
+            output.Store();
+        }
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// An Array[pop,age] population projects through rates that are each
+// Array[pop,step,age], given as Array[pop*step,age], or null, except
+// births, which are Array[pop,step]. Either mx or Lx must be given.
+template<typename REAL, typename ACCUM>
+int ProjectionEntry(fundem_array population, fundem_array mx, fundem_array ax,
+        fundem_array Lx, fundem_array fertility, fundem_array migration,
+        fundem_array births_in, fundem_array nx, fundem_array projected, fundem_array births,
+        double birth_fraction, int age_cnt, int step_cnt, size_t N, int thread_cnt)
+{
+    try {
+        if (step_cnt < 1) {
+            throw std::invalid_argument("There must be at least one step.");
+        }
+        const size_t row_cnt = N * step_cnt;
+        const ContiguousArray<REAL> start(population, N, age_cnt);
+        const ContiguousArray<REAL> inputs[] = {
+            {mx, row_cnt, age_cnt}, {ax, row_cnt, age_cnt}, {Lx, row_cnt, age_cnt},
+            {fertility, row_cnt, age_cnt}, {migration, row_cnt, age_cnt},
+            {births_in, N, step_cnt}};
+        const ContiguousArray<REAL> widths(nx, 1, age_cnt);
+        const ContiguousArray<REAL> projected_rows(projected, row_cnt, age_cnt);
+        const ContiguousArray<REAL> birth_rows(births, N, step_cnt);
+        ProjectionRates<REAL> rates;
+        rates.mx = inputs[0].Data();
+        rates.ax = inputs[1].Data();
+        rates.Lx = inputs[2].Data();
+        rates.fertility = inputs[3].Data();
+        rates.migration = inputs[4].Data();
+        rates.births = inputs[5].Data();
+        auto pool = SharedThreadPool(thread_cnt);
+        ProjectPopulation<REAL, ACCUM>(start.Data(), rates, widths.Data(),
+                static_cast<REAL>(birth_fraction), projected_rows.Data(), birth_rows.Data(),
+                age_cnt, step_cnt, N, *pool);
+        projected_rows.Store();
+        birth_rows.Store();
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// Hazard rates for one model, whose parameters are Array[pop,param].
+template<template<typename> class HAZARD, typename REAL>
+void ModelHazardRates(fundem_array parameters, fundem_array nx, fundem_array mx,
+        int age_cnt, size_t N, ThreadPool& pool, HazardSample sample)
+{
+    const ContiguousArray<REAL> given(parameters, N, HAZARD<REAL>::kParameterCount);
+    const ContiguousArray<REAL> widths(nx, 1, age_cnt);
+    const ContiguousArray<REAL> rates(mx, N, age_cnt);
+    HazardRates<HAZARD>(given.Data(), widths.Data(), rates.Data(), age_cnt, N, pool, sample);
+    rates.Store();
+}
+
+
+// Parameters are Array[pop,param] for the model, which is 0 for
+// Gompertz, 1 for Gompertz-Makeham, 2 for Siler, and 3 for
+// Heligman-Pollard. Rates are Array[pop,age].
+template<typename REAL>
+int HazardEntry(fundem_array parameters, fundem_array nx, fundem_array mx, int model,
+        int age_cnt, size_t N, int midpoint, int thread_cnt)
+{
+    try {
+        if (age_cnt < 1) {
+            throw std::invalid_argument("There must be at least one age group.");
+        }
+        const HazardSample sample = midpoint ? HazardSample::Midpoint
+                : HazardSample::IntervalAverage;
+        auto pool = SharedThreadPool(thread_cnt);
+        switch (model) {
+            case 0:
+                ModelHazardRates<GompertzHazard, REAL>(parameters, nx, mx, age_cnt, N, *pool,
+                        sample);
+                break;
+            case 1:
+                ModelHazardRates<GompertzMakehamHazard, REAL>(parameters, nx, mx, age_cnt, N,
+                        *pool, sample);
+                break;
+            case 2:
+                ModelHazardRates<SilerHazard, REAL>(parameters, nx, mx, age_cnt, N, *pool,
+                        sample);
+                break;
+            case 3:
+                ModelHazardRates<HeligmanPollardHazard, REAL>(parameters, nx, mx, age_cnt, N,
+                        *pool, sample);
+                break;
+            default:
+                throw std::invalid_argument(
+                        "There is no hazard model " + std::to_string(model) + ".");
+        }
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+
+// A fit of one model, as for `ModelHazardRates`.
+template<template<typename> class HAZARD, typename REAL>
+void ModelFit(fundem_array mx, fundem_array nx, fundem_array parameters,
+        const HazardFitRecord& record, int age_cnt, size_t N, ThreadPool& pool,
+        size_t chain_cnt, int max_iterations)
+{
+    const ContiguousArray<REAL> rates(mx, N, age_cnt);
+    const ContiguousArray<REAL> widths(nx, 1, age_cnt);
+    const ContiguousArray<REAL> fit(parameters, N, HAZARD<REAL>::kParameterCount);
+    FitHazard<HAZARD>(rates.Data(), widths.Data(), fit.Data(), record, age_cnt, N, pool,
+            chain_cnt, max_iterations);
+    fit.Store();
+}
+
+
+// Fits a hazard model, numbered as for `HazardEntry`, to Array[pop,age]
+// mx, starting from and replacing Array[pop,param] parameters. Records
+// are contiguous Array[pop], or null.
+template<typename REAL>
+int FitEntry(fundem_array mx, fundem_array nx, fundem_array parameters, int* outcome,
+        int* iterations, double* cost, int model, int age_cnt, size_t N, size_t chain_cnt,
+        int max_iterations, int thread_cnt)
+{
+    try {
+        if (age_cnt < 1) {
+            throw std::invalid_argument("There must be at least one age group.");
+        }
+        HazardFitRecord record;
+        record.outcome = outcome;
+        record.iterations = iterations;
+        record.cost = cost;
+        auto pool = SharedThreadPool(thread_cnt);
+        switch (model) {
+            case 0:
+                ModelFit<GompertzHazard, REAL>(mx, nx, parameters, record, age_cnt, N, *pool,
+                        chain_cnt, max_iterations);
+                break;
+            case 1:
+                ModelFit<GompertzMakehamHazard, REAL>(mx, nx, parameters, record, age_cnt, N,
+                        *pool, chain_cnt, max_iterations);
+                break;
+            case 2:
+                ModelFit<SilerHazard, REAL>(mx, nx, parameters, record, age_cnt, N, *pool,
+                        chain_cnt, max_iterations);
+                break;
+            case 3:
+                ModelFit<HeligmanPollardHazard, REAL>(mx, nx, parameters, record, age_cnt, N,
+                        *pool, chain_cnt, max_iterations);
+                break;
+            default:
+                throw std::invalid_argument(
+                        "There is no hazard model " + std::to_string(model) + ".");
+        }
+        return 0;
+    } catch (std::exception& e) {
+        last_error = e.what();
+        return 1;
+    }
+}
+
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+FUNDEM_API const char* fundem_last_error()
+{
+    return last_error.c_str();
+}
+
+
+FUNDEM_API int first_moment_survival(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array s,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return SurvivalEntry<double>(mx, ax, nx, s, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_survival_float(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array s,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return SurvivalEntry<float>(mx, ax, nx, s, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_population(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array lx, fundem_array dx,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return PopulationEntry<double, double>(mx, ax, nx, lx, dx, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_population_float(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array lx, fundem_array dx,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return PopulationEntry<float, float>(mx, ax, nx, lx, dx, age_cnt, N, thread_cnt);
+}
+
+
+// Float arrays with lx carried in double.
+FUNDEM_API int first_moment_population_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array lx, fundem_array dx,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return PopulationEntry<float, double>(mx, ax, nx, lx, dx, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_period_life_expectancy(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array le,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return LifeExpectancyEntry<double, double>(mx, ax, nx, le, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_period_life_expectancy_float(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array le,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return LifeExpectancyEntry<float, float>(mx, ax, nx, le, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_period_life_expectancy_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array le,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return LifeExpectancyEntry<float, double>(mx, ax, nx, le, age_cnt, N, thread_cnt);
+}
+
+
+// Null weights mean the gradient of e0.
+FUNDEM_API int first_moment_period_life_expectancy_adjoint(
+        fundem_array mx, fundem_array ax, fundem_array weights, fundem_array nx,
+        fundem_array mx_grad, fundem_array ax_grad, int age_cnt, size_t N, int thread_cnt)
+{
+    return LifeExpectancyAdjointEntry<double>(mx, ax, weights, nx, mx_grad, ax_grad,
+            age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_period_life_expectancy_adjoint_float(
+        fundem_array mx, fundem_array ax, fundem_array weights, fundem_array nx,
+        fundem_array mx_grad, fundem_array ax_grad, int age_cnt, size_t N, int thread_cnt)
+{
+    return LifeExpectancyAdjointEntry<float>(mx, ax, weights, nx, mx_grad, ax_grad,
+            age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_population_adjoint(
+        fundem_array mx, fundem_array ax, fundem_array lx_weights, fundem_array dx_weights,
+        fundem_array nx, fundem_array mx_grad, fundem_array ax_grad,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return PopulationAdjointEntry<double>(mx, ax, lx_weights, dx_weights, nx,
+            mx_grad, ax_grad, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int first_moment_population_adjoint_float(
+        fundem_array mx, fundem_array ax, fundem_array lx_weights, fundem_array dx_weights,
+        fundem_array nx, fundem_array mx_grad, fundem_array ax_grad,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return PopulationAdjointEntry<float>(mx, ax, lx_weights, dx_weights, nx,
+            mx_grad, ax_grad, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int constant_mortality_mean_age(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MeanAgeEntry<double>(mx, nx, ax, age_cnt, N, thread_cnt,
+            &MeanAgeKernels<double>::ConstantMortality);
+}
+
+
+FUNDEM_API int constant_mortality_mean_age_float(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MeanAgeEntry<float>(mx, nx, ax, age_cnt, N, thread_cnt,
+            &MeanAgeKernels<float>::ConstantMortality);
+}
+
+
+FUNDEM_API int graduation_method(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MeanAgeEntry<double>(mx, nx, ax, age_cnt, N, thread_cnt,
+            &MeanAgeKernels<double>::Graduation);
+}
+
+
+FUNDEM_API int graduation_method_float(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MeanAgeEntry<float>(mx, nx, ax, age_cnt, N, thread_cnt,
+            &MeanAgeKernels<float>::Graduation);
+}
+
+
+FUNDEM_API int graduation_method_steffen(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MeanAgeEntry<double>(mx, nx, ax, age_cnt, N, thread_cnt,
+            &MeanAgeKernels<double>::Steffen);
+}
+
+
+FUNDEM_API int graduation_method_steffen_float(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MeanAgeEntry<float>(mx, nx, ax, age_cnt, N, thread_cnt,
+            &MeanAgeKernels<float>::Steffen);
+}
+
+
+// Records are Array[pop] in the order of the populations of mx.
+FUNDEM_API int graduation_method_monitored(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int* iterations, double* difference, int* outcome, double* seconds,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MonitoredEntry<double>(mx, nx, ax, iterations, difference, outcome, seconds,
+            age_cnt, N, thread_cnt, false);
+}
+
+
+FUNDEM_API int graduation_method_monitored_float(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int* iterations, double* difference, int* outcome, double* seconds,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MonitoredEntry<float>(mx, nx, ax, iterations, difference, outcome, seconds,
+            age_cnt, N, thread_cnt, false);
+}
+
+
+FUNDEM_API int graduation_method_steffen_monitored(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int* iterations, double* difference, int* outcome, double* seconds,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MonitoredEntry<double>(mx, nx, ax, iterations, difference, outcome, seconds,
+            age_cnt, N, thread_cnt, true);
+}
+
+
+FUNDEM_API int graduation_method_steffen_monitored_float(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        int* iterations, double* difference, int* outcome, double* seconds,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return MonitoredEntry<float>(mx, nx, ax, iterations, difference, outcome, seconds,
+            age_cnt, N, thread_cnt, true);
+}
+
+
+// The ax argument may have null data, for constant-mortality ax,
+// and so may any of the columns after nx.
+FUNDEM_API int full_lifetable(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return FullLifeTableEntry<double, double>(mx, ax, nx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int full_lifetable_float(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return FullLifeTableEntry<float, float>(mx, ax, nx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, age_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int full_lifetable_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t N, int thread_cnt)
+{
+    return FullLifeTableEntry<float, double>(mx, ax, nx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, age_cnt, N, thread_cnt);
+}
+
+
+// Packed arrays are Array[value], and offsets, schema, and nx_offsets
+// are contiguous.
+FUNDEM_API int ragged_lifetable(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const size_t* offsets, const int* schema, const size_t* nx_offsets, size_t N,
+        int schema_cnt, int thread_cnt)
+{
+    return RaggedLifeTableEntry<double, double>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx,
+            ex, offsets, schema, nx_offsets, N, schema_cnt, thread_cnt);
+}
+
+
+FUNDEM_API int ragged_lifetable_float(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const size_t* offsets, const int* schema, const size_t* nx_offsets, size_t N,
+        int schema_cnt, int thread_cnt)
+{
+    return RaggedLifeTableEntry<float, float>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx,
+            ex, offsets, schema, nx_offsets, N, schema_cnt, thread_cnt);
+}
+
+
+FUNDEM_API int ragged_lifetable_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const size_t* offsets, const int* schema, const size_t* nx_offsets, size_t N,
+        int schema_cnt, int thread_cnt)
+{
+    return RaggedLifeTableEntry<float, double>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx,
+            ex, offsets, schema, nx_offsets, N, schema_cnt, thread_cnt);
+}
+
+
+FUNDEM_API int ragged_graduation(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        const size_t* offsets, const int* schema, const size_t* nx_offsets, size_t N,
+        int schema_cnt, int steffen, int thread_cnt)
+{
+    return RaggedGraduationEntry<double>(mx, nx, ax, offsets, schema, nx_offsets, N,
+            schema_cnt, steffen, thread_cnt);
+}
+
+
+FUNDEM_API int ragged_graduation_float(
+        fundem_array mx, fundem_array nx, fundem_array ax,
+        const size_t* offsets, const int* schema, const size_t* nx_offsets, size_t N,
+        int schema_cnt, int steffen, int thread_cnt)
+{
+    return RaggedGraduationEntry<float>(mx, nx, ax, offsets, schema, nx_offsets, N,
+            schema_cnt, steffen, thread_cnt);
+}
+
+
+FUNDEM_API int cohort_lifetable(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, int year_cnt, size_t N, int thread_cnt)
+{
+    return CohortEntry<double, double>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx, ex,
+            age_cnt, year_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int cohort_lifetable_float(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, int year_cnt, size_t N, int thread_cnt)
+{
+    return CohortEntry<float, float>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx, ex,
+            age_cnt, year_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int cohort_lifetable_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, int year_cnt, size_t N, int thread_cnt)
+{
+    return CohortEntry<float, double>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx, ex,
+            age_cnt, year_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int summarize_draws(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t pop_cnt, size_t draw_cnt, double lower, double upper,
+        int thread_cnt)
+{
+    return DrawsEntry<double, double>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx, ex,
+            age_cnt, pop_cnt, draw_cnt, lower, upper, thread_cnt);
+}
+
+
+FUNDEM_API int summarize_draws_float(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t pop_cnt, size_t draw_cnt, double lower, double upper,
+        int thread_cnt)
+{
+    return DrawsEntry<float, float>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx, ex,
+            age_cnt, pop_cnt, draw_cnt, lower, upper, thread_cnt);
+}
+
+
+FUNDEM_API int summarize_draws_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int age_cnt, size_t pop_cnt, size_t draw_cnt, double lower, double upper,
+        int thread_cnt)
+{
+    return DrawsEntry<float, double>(mx, ax, nx, ax_out, qx, px, lx, dx, Lx, Tx, ex,
+            age_cnt, pop_cnt, draw_cnt, lower, upper, thread_cnt);
+}
+
+
+// Ages are a contiguous Array[change].
+FUNDEM_API int scenario_lifetable(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array scenario_mx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const int* ages, int age_cnt, int change_cnt, size_t scenario_cnt, int thread_cnt)
+{
+    return ScenarioEntry<double, double>(mx, ax, nx, scenario_mx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, ages, age_cnt, change_cnt, scenario_cnt, thread_cnt);
+}
+
+
+FUNDEM_API int scenario_lifetable_float(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array scenario_mx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const int* ages, int age_cnt, int change_cnt, size_t scenario_cnt, int thread_cnt)
+{
+    return ScenarioEntry<float, float>(mx, ax, nx, scenario_mx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, ages, age_cnt, change_cnt, scenario_cnt, thread_cnt);
+}
+
+
+FUNDEM_API int scenario_lifetable_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array scenario_mx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        const int* ages, int age_cnt, int change_cnt, size_t scenario_cnt, int thread_cnt)
+{
+    return ScenarioEntry<float, double>(mx, ax, nx, scenario_mx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, ages, age_cnt, change_cnt, scenario_cnt, thread_cnt);
+}
+
+
+FUNDEM_API int expand_lifetable(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array target_nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int source_cnt, int target_cnt, size_t N, int thread_cnt)
+{
+    return ExpansionEntry<double, double>(mx, ax, nx, target_nx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, source_cnt, target_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int expand_lifetable_float(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array target_nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int source_cnt, int target_cnt, size_t N, int thread_cnt)
+{
+    return ExpansionEntry<float, float>(mx, ax, nx, target_nx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, source_cnt, target_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int expand_lifetable_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array target_nx,
+        fundem_array ax_out, fundem_array qx, fundem_array px, fundem_array lx,
+        fundem_array dx, fundem_array Lx, fundem_array Tx, fundem_array ex,
+        int source_cnt, int target_cnt, size_t N, int thread_cnt)
+{
+    return ExpansionEntry<float, double>(mx, ax, nx, target_nx, ax_out, qx, px, lx, dx,
+            Lx, Tx, ex, source_cnt, target_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int cause_deleted_lifetable(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array cause_mx,
+        fundem_array deleted_qx, fundem_array deleted_lx, fundem_array deleted_ex,
+        fundem_array cause_dx, fundem_array cause_lx, int age_cnt, int cause_cnt, size_t N,
+        int thread_cnt)
+{
+    return DecrementEntry<double, double>(mx, ax, nx, cause_mx, deleted_qx, deleted_lx,
+            deleted_ex, cause_dx, cause_lx, age_cnt, cause_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int cause_deleted_lifetable_float(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array cause_mx,
+        fundem_array deleted_qx, fundem_array deleted_lx, fundem_array deleted_ex,
+        fundem_array cause_dx, fundem_array cause_lx, int age_cnt, int cause_cnt, size_t N,
+        int thread_cnt)
+{
+    return DecrementEntry<float, float>(mx, ax, nx, cause_mx, deleted_qx, deleted_lx,
+            deleted_ex, cause_dx, cause_lx, age_cnt, cause_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int cause_deleted_lifetable_mixed(
+        fundem_array mx, fundem_array ax, fundem_array nx, fundem_array cause_mx,
+        fundem_array deleted_qx, fundem_array deleted_lx, fundem_array deleted_ex,
+        fundem_array cause_dx, fundem_array cause_lx, int age_cnt, int cause_cnt, size_t N,
+        int thread_cnt)
+{
+    return DecrementEntry<float, double>(mx, ax, nx, cause_mx, deleted_qx, deleted_lx,
+            deleted_ex, cause_dx, cause_lx, age_cnt, cause_cnt, N, thread_cnt);
+}
+
+
+FUNDEM_API int project_population(
+        fundem_array population, fundem_array mx, fundem_array ax, fundem_array Lx,
+        fundem_array fertility, fundem_array migration, fundem_array births_in,
+        fundem_array nx, fundem_array projected, fundem_array births, double birth_fraction,
+        int age_cnt, int step_cnt, size_t N, int thread_cnt)
+{
+    return ProjectionEntry<double, double>(population, mx, ax, Lx, fertility, migration,
+            births_in, nx, projected, births, birth_fraction, age_cnt, step_cnt, N,
+            thread_cnt);
+}
+
+
+FUNDEM_API int project_population_float(
+        fundem_array population, fundem_array mx, fundem_array ax, fundem_array Lx,
+        fundem_array fertility, fundem_array migration, fundem_array births_in,
+        fundem_array nx, fundem_array projected, fundem_array births, double birth_fraction,
+        int age_cnt, int step_cnt, size_t N, int thread_cnt)
+{
+    return ProjectionEntry<float, float>(population, mx, ax, Lx, fertility, migration,
+            births_in, nx, projected, births, birth_fraction, age_cnt, step_cnt, N,
+            thread_cnt);
+}
+
+
+FUNDEM_API int project_population_mixed(
+        fundem_array population, fundem_array mx, fundem_array ax, fundem_array Lx,
+        fundem_array fertility, fundem_array migration, fundem_array births_in,
+        fundem_array nx, fundem_array projected, fundem_array births, double birth_fraction,
+        int age_cnt, int step_cnt, size_t N, int thread_cnt)
+{
+    return ProjectionEntry<float, double>(population, mx, ax, Lx, fertility, migration,
+            births_in, nx, projected, births, birth_fraction, age_cnt, step_cnt, N,
+            thread_cnt);
+}
+
+
+FUNDEM_API int hazard_rates(
+        fundem_array parameters, fundem_array nx, fundem_array mx, int model,
+        int age_cnt, size_t N, int midpoint, int thread_cnt)
+{
+    return HazardEntry<double>(parameters, nx, mx, model, age_cnt, N, midpoint, thread_cnt);
+}
+
+
+FUNDEM_API int hazard_rates_float(
+        fundem_array parameters, fundem_array nx, fundem_array mx, int model,
+        int age_cnt, size_t N, int midpoint, int thread_cnt)
+{
+    return HazardEntry<float>(parameters, nx, mx, model, age_cnt, N, midpoint, thread_cnt);
+}
+
+
+FUNDEM_API int fit_hazard(
+        fundem_array mx, fundem_array nx, fundem_array parameters, int* outcome,
+        int* iterations, double* cost, int model, int age_cnt, size_t N, size_t chain_cnt,
+        int max_iterations, int thread_cnt)
+{
+    return FitEntry<double>(mx, nx, parameters, outcome, iterations, cost, model, age_cnt, N,
+            chain_cnt, max_iterations, thread_cnt);
+}
+
+
+FUNDEM_API int fit_hazard_float(
+        fundem_array mx, fundem_array nx, fundem_array parameters, int* outcome,
+        int* iterations, double* cost, int model, int age_cnt, size_t N, size_t chain_cnt,
+        int max_iterations, int thread_cnt)
+{
+    return FitEntry<float>(mx, nx, parameters, outcome, iterations, cost, model, age_cnt, N,
+            chain_cnt, max_iterations, thread_cnt);
+}
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,19 +1,754 @@
+#include <algorithm>
+#include <string>
+#include <vector>
 #include <Rcpp.h>
+#include "fundem/adjoint.hpp"
+#include "fundem/cohort.hpp"
+#include "fundem/decrement.hpp"
+#include "fundem/draws.hpp"
+#include "fundem/expansion.hpp"
+#include "fundem/fit.hpp"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/hazards.hpp"
 #include "fundem/lifetable.hpp"
+#include "fundem/projection.hpp"
+#include "fundem/ragged.hpp"
+#include "fundem/scenario.hpp"
+#include "fundem/schema.hpp"
+#include "fundem/thread_pool.hpp"
 
 using namespace Rcpp;
 
+// R stores a matrix by columns, so a matrix of dimensions [age, pop], or
+// an array of dimensions [age, ...], is already the Array[pop,age] that
+// the kernels read. These functions hand R's memory to the kernels
+// directly. The only allocations are the results, which keep the
+// dimensions of mx. Kernels run on the shared pool, whose threads touch
+// only these arrays and never call into R.
+
+namespace {
+
+size_t PopulationCount(const NumericVector& mx, const NumericVector& nx)
+{
+    if (nx.size() == 0 || mx.size() % nx.size() != 0) {
+        stop("mx has %d values, which isn't a multiple of the %d age groups in nx.",
+                mx.size(), nx.size());
+    }
+    return mx.size() / nx.size();
+}
+
+
+void CheckSameSize(const NumericVector& mx, const NumericVector& other, const char* name)
+{
+    if (other.size() != mx.size()) {
+        stop("%s has %d values, but mx has %d.", name, other.size(), mx.size());
+    }
+}
+
+
+// The data of an optional argument that must match mx, or nullptr.
+// The vector keeps the data alive.
+const double* OptionalLike(const NumericVector& mx, const Nullable<NumericVector>& argument,
+        NumericVector& vector, const char* name)
+{
+    if (argument.isNull()) {
+        return nullptr;
+    }
+    vector = NumericVector(argument);
+    CheckSameSize(mx, vector, name);
+    return vector.begin();
+}
+
+
+// A result with the dimensions and names of mx, left uninitialized
+// because the kernel writes every value.
+NumericVector ResultLike(const NumericVector& mx)
+{
+    NumericVector result = no_init(mx.size());
+    if (mx.hasAttribute("dim")) {
+        result.attr("dim") = mx.attr("dim");
+    }
+    if (mx.hasAttribute("dimnames")) {
+        result.attr("dimnames") = mx.attr("dimnames");
+    }
+    return result;
+}
+
+
+// Allocates each named column with the dimensions of mx, in the order
+// given, and points the kernel's columns at them.
+List LifeTableResult(const NumericVector& mx, const CharacterVector& columns,
+        fundem::LifeTableColumns<double>& pointers)
+{
+    List result;
+    for (R_xlen_t column_idx = 0; column_idx < columns.size(); column_idx++) {
+        const std::string name = as<std::string>(columns[column_idx]);
+        if (result.containsElementNamed(name.c_str())) {
+            continue;
+        }
+        NumericVector column = ResultLike(mx);
+        if ("ax" == name) {
+            pointers.ax = column.begin();
+        } else if ("qx" == name) {
+            pointers.qx = column.begin();
+        } else if ("px" == name) {
+            pointers.px = column.begin();
+        } else if ("lx" == name) {
+            pointers.lx = column.begin();
+        } else if ("dx" == name) {
+            pointers.dx = column.begin();
+        } else if ("Lx" == name) {
+            pointers.Lx = column.begin();
+        } else if ("Tx" == name) {
+            pointers.Tx = column.begin();
+        } else if ("ex" == name) {
+            pointers.ex = column.begin();
+        } else {
+            stop("There is no lifetable column called %s.", name);
+        }
+        result.push_back(column, name);
+    }
+    return result;
+}
+
+
+
+// A ragged batch for packed mx, where schema holds, for each population,
+// an index from one into the list of nx vectors in schemas.
+struct RaggedLayout {
+    RaggedLayout(const NumericVector& mx, const IntegerVector& schema_in, const List& schemas)
+        : schema(schema_in.begin(), schema_in.end()), nx_offsets(1, 0), offsets(1, 0)
+    {
+        for (R_xlen_t schema_idx = 0; schema_idx < schemas.size(); schema_idx++) {
+            NumericVector widths = schemas[schema_idx];
+            nx.insert(nx.end(), widths.begin(), widths.end());
+            nx_offsets.push_back(nx.size());
+        }
+        for (int& pop_schema: schema) {
+            if (pop_schema < 1 || pop_schema > schemas.size()) {
+                stop("schema refers to schema %d, but there are %d.", pop_schema,
+                        schemas.size());
+            }
+            pop_schema -= 1;
+            offsets.push_back(offsets.back() + nx_offsets[pop_schema + 1] -
+                    nx_offsets[pop_schema]);
+        }
+        if (offsets.back() != static_cast<size_t>(mx.size())) {
+            stop("mx has %d values, but its populations' schemas have %d.", mx.size(),
+                    offsets.back());
+        }
+        batch.offsets = offsets.data();
+        batch.schema = schema.data();
+        batch.nx = nx.data();
+        batch.nx_offsets = nx_offsets.data();
+        batch.N = schema.size();
+        batch.schema_cnt = schemas.size();
+    }
+
+    std::vector<int> schema;
+    std::vector<double> nx;
+    std::vector<size_t> nx_offsets;
+    std::vector<size_t> offsets;
+    fundem::RaggedBatch<double> batch;
+};
+
+
+// What graduation did for each population, allocated before the kernel
+// runs so that worker threads only fill in values.
+struct GraduationRecords {
+    explicit GraduationRecords(size_t pop_cnt)
+        : iterations(no_init(pop_cnt)), difference(no_init(pop_cnt)),
+          outcome(no_init(pop_cnt)), seconds(no_init(pop_cnt)) {}
+
+    fundem::GraduationRecorder Recorder()
+    {
+        fundem::GraduationRecorder recorder;
+        recorder.iterations = iterations.begin();
+        recorder.difference = difference.begin();
+        recorder.outcome = outcome.begin();
+        recorder.seconds = seconds.begin();
+        return recorder;
+    }
+
+    // The records, with outcome as a factor, and their totals.
+    List AsList()
+    {
+        auto summary = fundem::SummarizeGraduation(Recorder(), iterations.size());
+        IntegerVector outcome_factor = outcome + 1;
+        outcome_factor.attr("levels") = CharacterVector::create(
+                "converged", "diverged", "fallback");
+        outcome_factor.attr("class") = "factor";
+        return List::create(
+                Named("iterations") = iterations,
+                Named("difference") = difference,
+                Named("outcome") = outcome_factor,
+                Named("seconds") = seconds,
+                Named("summary") = List::create(
+                        Named("converged") = static_cast<double>(summary.converged_cnt),
+                        Named("diverged") = static_cast<double>(summary.diverged_cnt),
+                        Named("fallback") = static_cast<double>(summary.fallback_cnt),
+                        Named("iteration_histogram") = wrap(summary.iteration_histogram),
+                        Named("time_histogram") = wrap(summary.time_histogram),
+                        Named("total_seconds") = summary.total_seconds,
+                        Named("max_seconds") = summary.max_seconds,
+                        Named("slowest") = static_cast<double>(summary.slowest_pop_idx + 1)));
+    }
+
+    IntegerVector iterations;
+    NumericVector difference;
+    IntegerVector outcome;
+    NumericVector seconds;
+};
+
+
+int HazardParameterCount(const std::string& model)
+{
+    if ("gompertz" == model) {
+        return fundem::GompertzHazard<double>::kParameterCount;
+    } else if ("makeham" == model) {
+        return fundem::GompertzMakehamHazard<double>::kParameterCount;
+    } else if ("siler" == model) {
+        return fundem::SilerHazard<double>::kParameterCount;
+    } else if ("heligman_pollard" == model) {
+        return fundem::HeligmanPollardHazard<double>::kParameterCount;
+    }
+    stop("There is no hazard model called %s.", model);
+}
+
+}
+
+
 // [[Rcpp::export]]
 NumericVector first_moment_survival(
-        NumericVector mx, NumericVector ax, NumericVector nx)
+        NumericVector mx, NumericVector ax, NumericVector nx, int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    CheckSameSize(mx, ax, "ax");
+    NumericVector survival = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::FirstMomentSurvivalDispatch(
+            mx.begin(), ax.begin(), nx.begin(), survival.begin(), nx.size(), pop_cnt, *pool);
+    return survival;
+}
+
+
+// [[Rcpp::export]]
+List first_moment_population(
+        NumericVector mx, NumericVector ax, NumericVector nx, int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    CheckSameSize(mx, ax, "ax");
+    NumericVector lx = ResultLike(mx);
+    NumericVector dx = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::FirstMomentPopulationDispatch(
+            mx.begin(), ax.begin(), nx.begin(), lx.begin(), dx.begin(),
+            nx.size(), pop_cnt, *pool);
+    return List::create(Named("lx") = lx, Named("dx") = dx);
+}
+
+
+// [[Rcpp::export]]
+NumericVector first_moment_period_life_expectancy(
+        NumericVector mx, NumericVector ax, NumericVector nx, int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    CheckSameSize(mx, ax, "ax");
+    NumericVector le = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::FirstMomentPeriodLifeExpectancyDispatch(
+            mx.begin(), ax.begin(), nx.begin(), le.begin(), nx.size(), pop_cnt, *pool);
+    return le;
+}
+
+
+// Gradient of sum(weights * ex) with respect to mx and ax. Without
+// weights, it's the gradient of e0.
+// [[Rcpp::export]]
+List first_moment_period_life_expectancy_adjoint(
+        NumericVector mx, NumericVector ax, NumericVector nx,
+        Nullable<NumericVector> weights = R_NilValue, int thread_cnt = 1)
 {
-    std::vector<double> mxv(mx.begin(), mx.end());
-    std::vector<double> axv(ax.begin(), ax.end());
-    std::vector<double> nxv(nx.begin(), nx.end());
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    CheckSameSize(mx, ax, "ax");
+    NumericVector weights_in;
+    const double* weights_data = OptionalLike(mx, weights, weights_in, "weights");
+    NumericVector mx_grad = ResultLike(mx);
+    NumericVector ax_grad = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::FirstMomentPeriodLifeExpectancyAdjoint(
+            mx.begin(), ax.begin(), nx.begin(), weights_data, mx_grad.begin(), ax_grad.begin(),
+            nx.size(), pop_cnt, *pool);
+    return List::create(Named("mx") = mx_grad, Named("ax") = ax_grad);
+}
+
+
+// Gradient of sum(lx_weights * lx + dx_weights * dx).
+// [[Rcpp::export]]
+List first_moment_population_adjoint(
+        NumericVector mx, NumericVector ax, NumericVector nx,
+        Nullable<NumericVector> lx_weights = R_NilValue,
+        Nullable<NumericVector> dx_weights = R_NilValue, int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    CheckSameSize(mx, ax, "ax");
+    NumericVector lx_in, dx_in;
+    const double* lx_data = OptionalLike(mx, lx_weights, lx_in, "lx_weights");
+    const double* dx_data = OptionalLike(mx, dx_weights, dx_in, "dx_weights");
+    NumericVector mx_grad = ResultLike(mx);
+    NumericVector ax_grad = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::FirstMomentPopulationAdjoint(
+            mx.begin(), ax.begin(), nx.begin(), lx_data, dx_data,
+            mx_grad.begin(), ax_grad.begin(), nx.size(), pop_cnt, *pool);
+    return List::create(Named("mx") = mx_grad, Named("ax") = ax_grad);
+}
+
+
+// [[Rcpp::export]]
+NumericVector constant_mortality_mean_age(
+        NumericVector mx, NumericVector nx, int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    NumericVector ax = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::ConstantMortalityMeanAgeVectorized(
+            mx.begin(), nx.begin(), ax.begin(), nx.size(), pop_cnt, *pool);
+    return ax;
+}
+
+
+// With monitor = TRUE, the result has a "graduation" attribute that
+// says what happened to each population.
+// [[Rcpp::export]]
+NumericVector graduation_method(
+        NumericVector mx, NumericVector nx, int thread_cnt = 1, bool monitor = false)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    NumericVector ax = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    if (monitor) {
+        GraduationRecords records(pop_cnt);
+        fundem::GraduationMethod(
+                mx.begin(), nx.begin(), ax.begin(), nx.size(), pop_cnt, *pool,
+                records.Recorder());
+        ax.attr("graduation") = records.AsList();
+    } else {
+        fundem::GraduationMethod(
+                mx.begin(), nx.begin(), ax.begin(), nx.size(), pop_cnt, *pool);
+    }
+    return ax;
+}
 
-    std::vector<double> survival(mx.size());
-    fundem::FirstMomentSurvival(
-            &mxv[0], &axv[0], &nxv[0], &survival[0], mx.size());
 
-    return NumericVector(survival.begin(), survival.end());
+// [[Rcpp::export]]
+NumericVector graduation_method_steffen(
+        NumericVector mx, NumericVector nx, int thread_cnt = 1, bool monitor = false)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    NumericVector ax = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    if (monitor) {
+        GraduationRecords records(pop_cnt);
+        fundem::GraduationMethodSteffen(
+                mx.begin(), nx.begin(), ax.begin(), nx.size(), pop_cnt, *pool,
+                records.Recorder());
+        ax.attr("graduation") = records.AsList();
+    } else {
+        fundem::GraduationMethodSteffen(
+                mx.begin(), nx.begin(), ax.begin(), nx.size(), pop_cnt, *pool);
+    }
+    return ax;
+}
+
+
+// [[Rcpp::export]]
+List full_lifetable(
+        NumericVector mx, NumericVector nx, Nullable<NumericVector> ax = R_NilValue,
+        CharacterVector columns = CharacterVector::create(
+                "ax", "qx", "px", "lx", "dx", "Lx", "Tx", "ex"),
+        int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    NumericVector ax_in;
+    const double* ax_data = OptionalLike(mx, ax, ax_in, "ax");
+
+    fundem::LifeTableColumns<double> pointers;
+    List result = LifeTableResult(mx, columns, pointers);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::FullLifeTableDispatch(mx.begin(), ax_data, nx.begin(), pointers, nx.size(), pop_cnt,
+            *pool);
+    return result;
+}
+
+
+// A surface of mx is an array of dimensions [age, year, ...], and the
+// result has the same dimensions with cohorts in place of years. Values
+// that depend on years past the end of the surface are NaN.
+// [[Rcpp::export]]
+List cohort_lifetable(
+        NumericVector mx, NumericVector nx, Nullable<NumericVector> ax = R_NilValue,
+        CharacterVector columns = CharacterVector::create("lx", "dx", "ex"),
+        int thread_cnt = 1)
+{
+    if (!mx.hasAttribute("dim")) {
+        stop("mx must be an array of dimensions [age, year, ...].");
+    }
+    IntegerVector dims = mx.attr("dim");
+    if (dims.size() < 2 || dims[0] != nx.size()) {
+        stop("mx must be an array of dimensions [age, year, ...] with %d ages.", nx.size());
+    }
+    const int year_cnt = dims[1];
+    const size_t pop_cnt = PopulationCount(mx, nx) / std::max(year_cnt, 1);
+    NumericVector ax_in;
+    const double* ax_data = OptionalLike(mx, ax, ax_in, "ax");
+
+    fundem::LifeTableColumns<double> pointers;
+    List result = LifeTableResult(mx, columns, pointers);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::CohortLifeTable(mx.begin(), ax_data, nx.begin(), pointers, nx.size(), year_cnt,
+            pop_cnt, *pool);
+    return result;
+}
+
+
+// Draws of mx are an array of dimensions [age, ..., draw]. Each summary
+// has dimensions [stat, age, ...], with statistics named in the order
+// of fundem::DrawStatistic.
+// [[Rcpp::export]]
+List summarize_draws(
+        NumericVector mx, NumericVector nx, Nullable<NumericVector> ax = R_NilValue,
+        CharacterVector columns = CharacterVector::create("ex"),
+        NumericVector quantiles = NumericVector::create(0.025, 0.975),
+        int thread_cnt = 1)
+{
+    if (!mx.hasAttribute("dim")) {
+        stop("mx must be an array of dimensions [age, ..., draw].");
+    }
+    IntegerVector dims = mx.attr("dim");
+    if (dims.size() < 2 || dims[0] != nx.size()) {
+        stop("mx must be an array of dimensions [age, ..., draw] with %d ages.", nx.size());
+    }
+    if (quantiles.size() != 2) {
+        stop("quantiles must hold a lower and an upper probability.");
+    }
+    const int draw_cnt = dims[dims.size() - 1];
+    const size_t pop_cnt = PopulationCount(mx, nx) / std::max(draw_cnt, 1);
+    NumericVector ax_in;
+    const double* ax_data = OptionalLike(mx, ax, ax_in, "ax");
+
+    // The summaries take their dimensions from this.
+    NumericVector shape = no_init(fundem::kDrawStatisticCount * pop_cnt * nx.size());
+    IntegerVector shape_dims(dims.size());
+    shape_dims[0] = fundem::kDrawStatisticCount;
+    for (int dim_idx = 0; dim_idx < dims.size() - 1; dim_idx++) {
+        shape_dims[dim_idx + 1] = dims[dim_idx];
+    }
+    shape.attr("dim") = shape_dims;
+    List dimnames(dims.size());
+    dimnames[0] = CharacterVector::create("mean", "variance", "lower", "upper");
+    shape.attr("dimnames") = dimnames;
+
+    fundem::LifeTableColumns<double> pointers;
+    List result = LifeTableResult(shape, columns, pointers);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::SummarizeDraws(mx.begin(), ax_data, nx.begin(), pointers, nx.size(), pop_cnt,
+            draw_cnt, *pool, quantiles[0], quantiles[1]);
+    return result;
+}
+
+
+// Populations with different age schemas, packed end to end in mx.
+// schemas is a list of nx vectors, and schema gives each population's
+// index into it, from one. Each column is packed as mx is.
+// [[Rcpp::export]]
+List ragged_lifetable(
+        NumericVector mx, IntegerVector schema, List schemas,
+        Nullable<NumericVector> ax = R_NilValue,
+        CharacterVector columns = CharacterVector::create(
+                "ax", "qx", "px", "lx", "dx", "Lx", "Tx", "ex"),
+        int thread_cnt = 1)
+{
+    const RaggedLayout layout(mx, schema, schemas);
+    NumericVector ax_in;
+    const double* ax_data = OptionalLike(mx, ax, ax_in, "ax");
+    fundem::LifeTableColumns<double> pointers;
+    List result = LifeTableResult(mx, columns, pointers);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::FullLifeTableRagged(mx.begin(), ax_data, pointers, layout.batch, *pool);
+    return result;
+}
+
+
+// [[Rcpp::export]]
+NumericVector ragged_graduation(
+        NumericVector mx, IntegerVector schema, List schemas, bool steffen = true,
+        int thread_cnt = 1)
+{
+    const RaggedLayout layout(mx, schema, schemas);
+    NumericVector ax = ResultLike(mx);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    std::vector<fundem::LifeTableWorkspace<double>> workspaces;
+    if (steffen) {
+        fundem::GraduationMethodSteffenRagged(mx.begin(), ax.begin(), layout.batch, *pool,
+                workspaces);
+    } else {
+        fundem::GraduationMethodRagged(mx.begin(), ax.begin(), layout.batch, *pool,
+                workspaces);
+    }
+    return ax;
+}
+
+
+// Scenarios change a base population's mx at the same ages, which
+// count from one. scenario_mx is a matrix of dimensions [change,
+// scenario], and each column of the result has dimensions [age, scenario].
+// [[Rcpp::export]]
+List scenario_lifetable(
+        NumericVector mx, NumericVector nx, IntegerVector ages, NumericVector scenario_mx,
+        Nullable<NumericVector> ax = R_NilValue,
+        CharacterVector columns = CharacterVector::create("ex"), int thread_cnt = 1)
+{
+    if (mx.size() != nx.size()) {
+        stop("mx has %d values, but a base population has the %d ages in nx.",
+                mx.size(), nx.size());
+    }
+    if (ages.size() == 0 || scenario_mx.size() % ages.size() != 0) {
+        stop("scenario_mx has %d values, which isn't a multiple of the %d changed ages.",
+                scenario_mx.size(), ages.size());
+    }
+    const size_t scenario_cnt = scenario_mx.size() / ages.size();
+    std::vector<int> age_idx(ages.begin(), ages.end());
+    for (int& age: age_idx) {
+        age -= 1;
+    }
+    NumericVector ax_in;
+    const double* ax_data = OptionalLike(mx, ax, ax_in, "ax");
+
+    NumericVector shape = no_init(scenario_cnt * nx.size());
+    shape.attr("dim") = IntegerVector::create(nx.size(), scenario_cnt);
+    fundem::LifeTableColumns<double> pointers;
+    List result = LifeTableResult(shape, columns, pointers);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::ScenarioLifeTables(mx.begin(), ax_data, nx.begin(), &age_idx[0],
+            scenario_mx.begin(), pointers, nx.size(), ages.size(), scenario_cnt, *pool);
+    return result;
+}
+
+
+// mx and ax are in the ages of nx, a matrix or array of dimensions
+// [age, ...], and the columns have the same dimensions but with the ages
+// of target_nx.
+// [[Rcpp::export]]
+List expand_lifetable(
+        NumericVector mx, NumericVector nx, NumericVector target_nx,
+        Nullable<NumericVector> ax = R_NilValue,
+        CharacterVector columns = CharacterVector::create("lx", "dx", "ex"),
+        int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    NumericVector ax_in;
+    const double* ax_data = OptionalLike(mx, ax, ax_in, "ax");
+    auto expand = fundem::SharedExpansionOperator(nx.begin(), nx.size(), target_nx.begin(),
+            target_nx.size());
+
+    NumericVector shape = no_init(pop_cnt * target_nx.size());
+    if (mx.hasAttribute("dim")) {
+        IntegerVector dims = clone(as<IntegerVector>(mx.attr("dim")));
+        dims[0] = target_nx.size();
+        shape.attr("dim") = dims;
+    }
+    fundem::LifeTableColumns<double> pointers;
+    List result = LifeTableResult(shape, columns, pointers);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    expand->Apply(mx.begin(), ax_data, pointers, pop_cnt, *pool);
+    return result;
+}
+
+
+// Cause rates have dimensions [age, cause, ...] for mx of dimensions
+// [age, ...], and the columns have the dimensions of cause_mx.
+// [[Rcpp::export]]
+List cause_deleted_lifetable(
+        NumericVector mx, NumericVector nx, NumericVector cause_mx,
+        Nullable<NumericVector> ax = R_NilValue,
+        CharacterVector columns = CharacterVector::create("deleted_ex"),
+        int thread_cnt = 1)
+{
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    if (cause_mx.size() == 0 || cause_mx.size() % mx.size() != 0) {
+        stop("cause_mx has %d values, which isn't a multiple of the %d in mx.",
+                cause_mx.size(), mx.size());
+    }
+    const int cause_cnt = static_cast<int>(cause_mx.size() / mx.size());
+    NumericVector ax_in;
+    const double* ax_data = OptionalLike(mx, ax, ax_in, "ax");
+
+    List result;
+    fundem::DecrementColumns<double> pointers;
+    for (R_xlen_t column_idx = 0; column_idx < columns.size(); column_idx++) {
+        const std::string name = as<std::string>(columns[column_idx]);
+        if (result.containsElementNamed(name.c_str())) {
+            continue;
+        }
+        NumericVector column = ResultLike(cause_mx);
+        if ("deleted_qx" == name) {
+            pointers.deleted_qx = column.begin();
+        } else if ("deleted_lx" == name) {
+            pointers.deleted_lx = column.begin();
+        } else if ("deleted_ex" == name) {
+            pointers.deleted_ex = column.begin();
+        } else if ("cause_dx" == name) {
+            pointers.cause_dx = column.begin();
+        } else if ("cause_lx" == name) {
+            pointers.cause_lx = column.begin();
+        } else {
+            stop("There is no decrement column called %s.", name);
+        }
+        result.push_back(column, name);
+    }
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::CauseDeletedLifeTable(mx.begin(), ax_data, nx.begin(), cause_mx.begin(), pointers,
+            nx.size(), cause_cnt, pop_cnt, *pool);
+    return result;
+}
+
+
+// The population has dimensions [age, ...], and every rate, either mx or
+// Lx among them, has dimensions [age, step, ...], except births, which
+// are [step, ...]. The projected population has the dimensions of the
+// rates, and the births during each step those of births.
+// [[Rcpp::export]]
+List project_population(
+        NumericVector population, NumericVector nx,
+        Nullable<NumericVector> mx = R_NilValue, Nullable<NumericVector> fertility = R_NilValue,
+        Nullable<NumericVector> migration = R_NilValue,
+        Nullable<NumericVector> births = R_NilValue, Nullable<NumericVector> ax = R_NilValue,
+        Nullable<NumericVector> Lx = R_NilValue, double birth_fraction = 1.0,
+        int thread_cnt = 1)
+{
+    if (mx.isNull() == Lx.isNull()) {
+        stop("Give either mx or Lx for the projection's survival.");
+    }
+    NumericVector shape(mx.isNull() ? Lx : mx);
+    if (!shape.hasAttribute("dim")) {
+        stop("Rates must be arrays of dimensions [age, step, ...].");
+    }
+    IntegerVector dims = shape.attr("dim");
+    if (dims.size() < 2 || dims[0] != nx.size()) {
+        stop("Rates must be arrays of dimensions [age, step, ...] with %d ages.", nx.size());
+    }
+    const int step_cnt = dims[1];
+    const size_t pop_cnt = PopulationCount(population, nx);
+    if (static_cast<size_t>(shape.size()) != pop_cnt * step_cnt * nx.size()) {
+        stop("Rates have %d values, but %d steps for %d populations need %d.", shape.size(),
+                step_cnt, pop_cnt, pop_cnt * step_cnt * nx.size());
+    }
+    fundem::ProjectionRates<double> rates;
+    NumericVector mx_in, ax_in, Lx_in, fertility_in, migration_in, births_in;
+    rates.mx = OptionalLike(shape, mx, mx_in, "mx");
+    rates.ax = OptionalLike(shape, ax, ax_in, "ax");
+    rates.Lx = OptionalLike(shape, Lx, Lx_in, "Lx");
+    rates.fertility = OptionalLike(shape, fertility, fertility_in, "fertility");
+    rates.migration = OptionalLike(shape, migration, migration_in, "migration");
+
+    NumericVector born = no_init(pop_cnt * step_cnt);
+    IntegerVector born_dims(dims.begin() + 1, dims.end());
+    born.attr("dim") = born_dims;
+    rates.births = OptionalLike(born, births, births_in, "births");
+    NumericVector projected = ResultLike(shape);
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    fundem::ProjectPopulation<double>(population.begin(), rates, nx.begin(), birth_fraction,
+            projected.begin(), born.begin(), nx.size(), step_cnt, pop_cnt, *pool);
+    return List::create(Named("population") = projected, Named("births") = born);
+}
+
+
+// Parameters are a matrix, or array, of dimensions [param, ...], and
+// the rates have dimensions [age, ...].
+// [[Rcpp::export]]
+NumericVector hazard_rates(
+        std::string model, NumericVector parameters, NumericVector nx,
+        bool midpoint = false, int thread_cnt = 1)
+{
+    const int parameter_cnt = HazardParameterCount(model);
+    if (parameters.size() % parameter_cnt != 0) {
+        stop("The %s model takes %d parameters, which don't divide the %d given.",
+                model, parameter_cnt, parameters.size());
+    }
+    const size_t pop_cnt = parameters.size() / parameter_cnt;
+    NumericVector mx = no_init(pop_cnt * nx.size());
+    if (parameters.hasAttribute("dim")) {
+        IntegerVector dims = clone(as<IntegerVector>(parameters.attr("dim")));
+        dims[0] = nx.size();
+        mx.attr("dim") = dims;
+    } else {
+        mx.attr("dim") = IntegerVector::create(nx.size(), pop_cnt);
+    }
+
+    const auto sample = midpoint ? fundem::HazardSample::Midpoint
+            : fundem::HazardSample::IntervalAverage;
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    const double* p = parameters.begin();
+    if ("gompertz" == model) {
+        fundem::HazardRates<fundem::GompertzHazard>(p, nx.begin(), mx.begin(), nx.size(),
+                pop_cnt, *pool, sample);
+    } else if ("makeham" == model) {
+        fundem::HazardRates<fundem::GompertzMakehamHazard>(p, nx.begin(), mx.begin(), nx.size(),
+                pop_cnt, *pool, sample);
+    } else if ("siler" == model) {
+        fundem::HazardRates<fundem::SilerHazard>(p, nx.begin(), mx.begin(), nx.size(),
+                pop_cnt, *pool, sample);
+    } else {
+        fundem::HazardRates<fundem::HeligmanPollardHazard>(p, nx.begin(), mx.begin(), nx.size(),
+                pop_cnt, *pool, sample);
+    }
+    return mx;
+}
+
+
+// Starting parameters are [param, ...] for mx of [age, ...]. The fit
+// parameters have the same shape, and the records, with outcome as a
+// factor, are one per population.
+// [[Rcpp::export]]
+List fit_hazard(
+        std::string model, NumericVector mx, NumericVector nx, NumericVector parameters,
+        int chain_cnt = 1, int max_iterations = 100, int thread_cnt = 1)
+{
+    const int parameter_cnt = HazardParameterCount(model);
+    const size_t pop_cnt = PopulationCount(mx, nx);
+    if (static_cast<size_t>(parameters.size()) != pop_cnt * parameter_cnt) {
+        stop("The %s model takes %d parameters for each of %d populations, not %d.",
+                model, parameter_cnt, pop_cnt, parameters.size());
+    }
+    NumericVector fit = clone(parameters);
+    IntegerVector outcome = no_init(pop_cnt);
+    IntegerVector iterations = no_init(pop_cnt);
+    NumericVector cost = no_init(pop_cnt);
+    fundem::HazardFitRecord record;
+    record.outcome = outcome.begin();
+    record.iterations = iterations.begin();
+    record.cost = cost.begin();
+
+    auto pool = fundem::SharedThreadPool(thread_cnt);
+    const size_t chains = std::max(chain_cnt, 1);
+    if ("gompertz" == model) {
+        fundem::FitHazard<fundem::GompertzHazard>(mx.begin(), nx.begin(), fit.begin(), record,
+                nx.size(), pop_cnt, *pool, chains, max_iterations);
+    } else if ("makeham" == model) {
+        fundem::FitHazard<fundem::GompertzMakehamHazard>(mx.begin(), nx.begin(), fit.begin(),
+                record, nx.size(), pop_cnt, *pool, chains, max_iterations);
+    } else if ("siler" == model) {
+        fundem::FitHazard<fundem::SilerHazard>(mx.begin(), nx.begin(), fit.begin(), record,
+                nx.size(), pop_cnt, *pool, chains, max_iterations);
+    } else {
+        fundem::FitHazard<fundem::HeligmanPollardHazard>(mx.begin(), nx.begin(), fit.begin(),
+                record, nx.size(), pop_cnt, *pool, chains, max_iterations);
+    }
+    IntegerVector outcome_factor = outcome + 1;
+    outcome_factor.attr("levels") = CharacterVector::create(
+            "converged", "max_iterations", "failed");
+    outcome_factor.attr("class") = "factor";
+    return List::create(Named("parameters") = fit, Named("outcome") = outcome_factor,
+            Named("iterations") = iterations, Named("cost") = cost);
 }
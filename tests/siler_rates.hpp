@@ -0,0 +1,47 @@
+//
+// Siler mortality rates, and the age grid they go on, that the tests share.
+//
+
+#ifndef FUNDEM_SILER_RATES_HPP
+#define FUNDEM_SILER_RATES_HPP
+
+#include <cstddef>
+#include <vector>
+#include "fundem/hazards.hpp"
+
+
+/*! GBD's 23 age groups, of 7, 21, and 337 days, 4 years, and then five
+ *  years each, with the last interval `last_nx` wide.
+ */
+template<typename REAL>
+std::vector<REAL> GbdWidths(REAL last_nx = 5)
+{
+    std::vector<REAL> nx{REAL(7) / 365, REAL(21) / 365, REAL(365 - 28) / 365, 4};
+    nx.resize(23, 5);
+    nx.back() = last_nx;
+    return nx;
+}
+
+
+/*! Array[pop,age] of `siler_default` at the middle of each interval of
+ *  `nx`, where population `pop_idx` is at time
+ *  `t_first + t_scale * pop_idx`.
+ */
+template<typename REAL>
+std::vector<REAL> SilerRates(const std::vector<REAL>& nx, size_t pop_cnt, double t_scale,
+        double t_first = 0)
+{
+    const size_t age_cnt = nx.size();
+    std::vector<REAL> mx(pop_cnt * age_cnt);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        double x = 0;
+        for (size_t age_idx = 0; age_idx < age_cnt; age_idx++) {
+            mx[pop_idx * age_cnt + age_idx] = siler_default(x + 0.5 * nx[age_idx],
+                    t_first + t_scale * pop_idx);
+            x += nx[age_idx];
+        }
+    }
+    return mx;
+}
+
+#endif //FUNDEM_SILER_RATES_HPP
@@ -0,0 +1,184 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/adjoint.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+struct Populations {
+    Populations(int age_cnt, size_t pop_cnt)
+        : nx(age_cnt, 5.0), ax(age_cnt * pop_cnt)
+    {
+        nx[0] = 1;
+        nx[1] = 4;
+        mx = SilerRates(nx, pop_cnt, 7.0);
+        ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt);
+    }
+
+    std::vector<double> nx;
+    std::vector<double> mx;
+    std::vector<double> ax;
+};
+
+
+// Weighted sums of lifetable values for one population.
+double LifeExpectancySum(const std::vector<double>& mx, const std::vector<double>& ax,
+        const std::vector<double>& nx, const std::vector<double>& weights)
+{
+    std::vector<double> le(nx.size());
+    FirstMomentPeriodLifeExpectancy(&mx[0], &ax[0], &nx[0], &le[0], nx.size(), 1);
+    double sum = 0;
+    for (size_t age_idx = 0; age_idx < nx.size(); age_idx++) {
+        sum += weights[age_idx] * le[age_idx];
+    }
+    return sum;
+}
+
+
+double PopulationSum(const std::vector<double>& mx, const std::vector<double>& ax,
+        const std::vector<double>& nx, const std::vector<double>& lx_weights,
+        const std::vector<double>& dx_weights)
+{
+    std::vector<double> lx(nx.size()), dx(nx.size());
+    FirstMomentPopulation(&mx[0], &ax[0], &nx[0], &lx[0], &dx[0], nx.size(), 1);
+    double sum = 0;
+    for (size_t age_idx = 0; age_idx < nx.size(); age_idx++) {
+        sum += lx_weights[age_idx] * lx[age_idx] + dx_weights[age_idx] * dx[age_idx];
+    }
+    return sum;
+}
+
+
+// Central difference of f with respect to one entry of x.
+template<typename FUNC>
+double Difference(FUNC f, std::vector<double>& x, size_t idx)
+{
+    const double saved = x[idx];
+    const double h = 1e-6 * std::abs(saved);
+    x[idx] = saved + h;
+    const double above = f();
+    x[idx] = saved - h;
+    const double below = f();
+    x[idx] = saved;
+    return (above - below) / (2 * h);
+}
+
+}
+
+
+TEST(ADJOINT, e0_gradient_matches_differences)
+{
+    const int age_cnt = 20;
+    Populations pop(age_cnt, 1);
+    std::vector<double> mx_grad(age_cnt), ax_grad(age_cnt);
+    FirstMomentPeriodLifeExpectancyAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0],
+            static_cast<double*>(nullptr), &mx_grad[0], &ax_grad[0], age_cnt, 1);
+
+    std::vector<double> weights(age_cnt, 0.0);
+    weights[0] = 1;
+    auto e0 = [&]() { return LifeExpectancySum(pop.mx, pop.ax, pop.nx, weights); };
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        double by_mx = Difference(e0, pop.mx, age_idx);
+        double by_ax = Difference(e0, pop.ax, age_idx);
+        EXPECT_NEAR(mx_grad[age_idx], by_mx, 1e-6 * (1 + std::abs(by_mx))) << age_idx;
+        EXPECT_NEAR(ax_grad[age_idx], by_ax, 1e-6 * (1 + std::abs(by_ax))) << age_idx;
+    }
+    // Raising mortality anywhere shortens life.
+    for (int age_idx = 0; age_idx < age_cnt - 1; age_idx++) {
+        EXPECT_LT(mx_grad[age_idx], 0);
+    }
+}
+
+
+TEST(ADJOINT, weighted_life_expectancy)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 3;
+    Populations pop(age_cnt, pop_cnt);
+    std::vector<double> weights(age_cnt * pop_cnt);
+    for (size_t weight_idx = 0; weight_idx < weights.size(); weight_idx++) {
+        weights[weight_idx] = std::cos(0.7 * weight_idx);
+    }
+    std::vector<double> mx_grad(pop.mx.size()), ax_grad(pop.mx.size());
+    FirstMomentPeriodLifeExpectancyAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0],
+            &weights[0], &mx_grad[0], &ax_grad[0], age_cnt, pop_cnt);
+
+    const size_t pop_idx = 2;
+    auto row = [&](const std::vector<double>& all) {
+        return std::vector<double>(all.begin() + pop_idx * age_cnt,
+                all.begin() + (pop_idx + 1) * age_cnt);
+    };
+    auto mx = row(pop.mx);
+    auto ax = row(pop.ax);
+    auto w = row(weights);
+    auto sum = [&]() { return LifeExpectancySum(mx, ax, pop.nx, w); };
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        double by_mx = Difference(sum, mx, age_idx);
+        double by_ax = Difference(sum, ax, age_idx);
+        EXPECT_NEAR(mx_grad[pop_idx * age_cnt + age_idx], by_mx, 1e-6 * (1 + std::abs(by_mx)));
+        EXPECT_NEAR(ax_grad[pop_idx * age_cnt + age_idx], by_ax, 1e-6 * (1 + std::abs(by_ax)));
+    }
+}
+
+
+TEST(ADJOINT, population_gradient_matches_differences)
+{
+    const int age_cnt = 20;
+    Populations pop(age_cnt, 1);
+    std::vector<double> lx_weights(age_cnt), dx_weights(age_cnt);
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        lx_weights[age_idx] = std::sin(1.3 * age_idx);
+        dx_weights[age_idx] = 0.5 * age_idx;
+    }
+    std::vector<double> mx_grad(age_cnt), ax_grad(age_cnt);
+    FirstMomentPopulationAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0],
+            &lx_weights[0], &dx_weights[0], &mx_grad[0], &ax_grad[0], age_cnt, 1);
+
+    auto sum = [&]() { return PopulationSum(pop.mx, pop.ax, pop.nx, lx_weights, dx_weights); };
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        double by_mx = Difference(sum, pop.mx, age_idx);
+        double by_ax = Difference(sum, pop.ax, age_idx);
+        EXPECT_NEAR(mx_grad[age_idx], by_mx, 1e-6 * (1 + std::abs(by_mx))) << age_idx;
+        EXPECT_NEAR(ax_grad[age_idx], by_ax, 1e-6 * (1 + std::abs(by_ax))) << age_idx;
+    }
+
+    // Survival to the start of the last age group depends on
+    // every age group before it, and none after.
+    std::vector<double> survival(age_cnt, 0.0);
+    survival[age_cnt - 1] = 1;
+    FirstMomentPopulationAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0],
+            &survival[0], static_cast<double*>(nullptr), &mx_grad[0], &ax_grad[0], age_cnt, 1);
+    EXPECT_LT(mx_grad[0], 0);
+    EXPECT_EQ(mx_grad[age_cnt - 1], 0);
+}
+
+
+TEST(ADJOINT, parallel_matches_serial)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 101;
+    Populations pop(age_cnt, pop_cnt);
+    ThreadPool pool(3);
+    std::vector<double> serial_m(pop.mx.size()), serial_a(pop.mx.size());
+    std::vector<double> parallel_m(pop.mx.size()), parallel_a(pop.mx.size());
+    FirstMomentPeriodLifeExpectancyAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0],
+            static_cast<double*>(nullptr), &serial_m[0], &serial_a[0], age_cnt, pop_cnt);
+    FirstMomentPeriodLifeExpectancyAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0],
+            static_cast<double*>(nullptr), &parallel_m[0], &parallel_a[0], age_cnt, pop_cnt, pool);
+    EXPECT_EQ(serial_m, parallel_m);
+    EXPECT_EQ(serial_a, parallel_a);
+
+    FirstMomentPopulationAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0], &pop.ax[0],
+            &pop.mx[0], &serial_m[0], &serial_a[0], age_cnt, pop_cnt);
+    FirstMomentPopulationAdjoint(&pop.mx[0], &pop.ax[0], &pop.nx[0], &pop.ax[0],
+            &pop.mx[0], &parallel_m[0], &parallel_a[0], age_cnt, pop_cnt, pool);
+    EXPECT_EQ(serial_m, parallel_m);
+    EXPECT_EQ(serial_a, parallel_a);
+}
@@ -0,0 +1,176 @@
+#include <cmath>
+#include <numeric>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/anderson.hpp"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Siler mortality in five-year groups, with the Poisson noise of deaths
+// in a population of a few thousand when noisy.
+void SilerPopulations(std::vector<double>& mx, std::vector<double>& nx, int age_cnt,
+        size_t pop_cnt, bool noisy)
+{
+    nx.assign(age_cnt, 5.0);
+    mx = SilerRates(nx, pop_cnt, 1.0);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const double rate = mx[pop_idx * age_cnt + age_idx];
+            const double exposure = 2000 * std::exp(-0.02 * age_idx);
+            // A deterministic stand-in for sampling deaths.
+            const double wobble = std::sin(7.0 * pop_idx + 3.0 * age_idx);
+            const double deaths = noisy ?
+                    std::max(1.0, std::round(rate * exposure +
+                            2 * wobble * std::sqrt(rate * exposure))) :
+                    rate * exposure;
+            mx[pop_idx * age_cnt + age_idx] = deaths / exposure;
+        }
+    }
+}
+
+
+int TotalIterations(const std::vector<int>& iterations)
+{
+    return std::accumulate(iterations.begin(), iterations.end(), 0);
+}
+
+}
+
+
+TEST(ANDERSON, solves_linear_fixed_point)
+{
+    // G(x) = A x + b with A a slow contraction, so plain iteration needs
+    // hundreds of steps and a secant history needs a few.
+    const int size = 6;
+    auto image_of = [size](const std::vector<double>& x) {
+        std::vector<double> image(size);
+        for (int row_idx = 0; row_idx < size; row_idx++) {
+            image[row_idx] = 5.0 + row_idx;
+            for (int col_idx = 0; col_idx < size; col_idx++) {
+                image[row_idx] += (row_idx == col_idx ? 0.9 : 0.01) * (x[col_idx] - 5);
+            }
+        }
+        return image;
+    };
+    std::vector<double> upper(size, 100.0);
+    for (int depth = 1; depth <= AndersonMixer<double>::kMaxDepth; depth++) {
+        AndersonMixer<double> mixer;
+        mixer.Reset(size, depth);
+        std::vector<double> x(size, 50.0);
+        int step_cnt = 0;
+        for (; step_cnt < 100; step_cnt++) {
+            std::vector<double> image = image_of(x);
+            double difference = 0;
+            for (int idx = 0; idx < size; idx++) {
+                difference = std::max(difference, std::abs(image[idx] - x[idx]));
+            }
+            if (difference < 1e-10) {
+                break;
+            }
+            mixer.Mix(&x[0], &image[0], &upper[0]);
+            x = image;
+        }
+        // One change can't cancel both rates of contraction at once.
+        EXPECT_LT(step_cnt, 1 == depth ? 40 : 10) << "depth " << depth;
+        std::vector<double> image = image_of(x);
+        for (int idx = 0; idx < size; idx++) {
+            EXPECT_NEAR(x[idx], image[idx], 1e-9);
+        }
+    }
+}
+
+
+TEST(ANDERSON, falls_back_to_plain_step_inside_bounds)
+{
+    AndersonMixer<double> mixer;
+    mixer.Reset(2, 2);
+    std::vector<double> upper{1.0, 1.0};
+    std::vector<double> x{0.5, 0.5};
+    std::vector<double> image{0.7, 0.3};
+    EXPECT_FALSE(mixer.Mix(&x[0], &image[0], &upper[0]));
+    // The residual shrinks slowly, so the secant step extrapolates to 1.3.
+    x = image;
+    image = {0.85, 0.15};
+    EXPECT_FALSE(mixer.Mix(&x[0], &image[0], &upper[0]));
+    EXPECT_EQ(image, (std::vector<double>{0.85, 0.15}));
+}
+
+
+TEST(ANDERSON, graduation_matches_plain_in_fewer_iterations)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 100;
+    for (bool noisy: {false, true}) {
+        std::vector<double> mx, nx;
+        SilerPopulations(mx, nx, age_cnt, pop_cnt, noisy);
+        std::vector<double> ax_plain(mx.size()), ax_anderson(mx.size());
+        std::vector<int> plain_iterations(pop_cnt), anderson_iterations(pop_cnt);
+        std::vector<int> outcome(pop_cnt);
+        GraduationRecorder recorder;
+        recorder.outcome = &outcome[0];
+
+        recorder.iterations = &plain_iterations[0];
+        GraduationMethodSteffen(&mx[0], &nx[0], &ax_plain[0], age_cnt, pop_cnt, recorder);
+        recorder.iterations = &anderson_iterations[0];
+        GraduationMethodSteffen(&mx[0], &nx[0], &ax_anderson[0], age_cnt, pop_cnt, recorder,
+                GraduationIteration::Anderson);
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            EXPECT_EQ(outcome[pop_idx], int(GraduationOutcome::Converged));
+        }
+        EXPECT_LT(TotalIterations(anderson_iterations), TotalIterations(plain_iterations));
+        for (size_t value_idx = 0; value_idx < mx.size(); value_idx++) {
+            EXPECT_NEAR(ax_anderson[value_idx], ax_plain[value_idx], 1e-4);
+            EXPECT_GT(ax_anderson[value_idx], 0);
+            EXPECT_LT(ax_anderson[value_idx], nx[value_idx % age_cnt]);
+        }
+    }
+}
+
+
+TEST(ANDERSON, keeps_fallback_guarantees)
+{
+    // Preston's graduation cycles for many of these populations, which
+    // mixing can't cure, so they must still fall back the same way.
+    const int age_cnt = 20;
+    const size_t pop_cnt = 100;
+    std::vector<double> mx, nx;
+    SilerPopulations(mx, nx, age_cnt, pop_cnt, true);
+    std::vector<double> ax(mx.size());
+    std::vector<int> outcome(pop_cnt, -1);
+    GraduationRecorder recorder;
+    recorder.outcome = &outcome[0];
+    GraduationMethod(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt, recorder,
+            GraduationIteration::Anderson);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        EXPECT_GE(outcome[pop_idx], 0);
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const double value = ax[pop_idx * age_cnt + age_idx];
+            EXPECT_GT(value, 0);
+            EXPECT_LT(value, nx[age_idx]);
+        }
+    }
+}
+
+
+TEST(ANDERSON, parallel_matches_serial)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 257;
+    std::vector<double> mx, nx;
+    SilerPopulations(mx, nx, age_cnt, pop_cnt, true);
+    std::vector<double> ax_serial(mx.size()), ax_parallel(mx.size());
+    ThreadPool pool(4);
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax_serial[0], age_cnt, pop_cnt,
+            NullGraduationMonitor(), GraduationIteration::Anderson);
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax_parallel[0], age_cnt, pop_cnt, pool,
+            NullGraduationMonitor(), GraduationIteration::Anderson);
+    EXPECT_EQ(ax_serial, ax_parallel);
+}
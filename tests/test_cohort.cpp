@@ -0,0 +1,190 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/cohort.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Siler mortality that falls over the years of the surface.
+std::vector<double> SilerSurface(const std::vector<double>& nx, int year_cnt, size_t pop_cnt)
+{
+    std::vector<double> mx;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        // Each year is a population of the surface.
+        const auto years = SilerRates(nx, year_cnt, 1.0, 10.0 * pop_idx);
+        mx.insert(mx.end(), years.begin(), years.end());
+    }
+    return mx;
+}
+
+
+// Walks one cohort's diagonal the slow way, with NaN past the surface.
+std::vector<double> Diagonal(const std::vector<double>& surface, const std::vector<double>& nx,
+        int year_cnt, size_t pop_idx, int cohort_idx)
+{
+    const int age_cnt = nx.size();
+    std::vector<double> diagonal(age_cnt, std::numeric_limits<double>::quiet_NaN());
+    double x = 0;
+    for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+        double middle = (age_idx < age_cnt - 1) ? x + nx[age_idx] / 2 : x;
+        int year_idx = cohort_idx + int(std::floor(middle));
+        if (year_idx < year_cnt) {
+            diagonal[age_idx] = surface[(pop_idx * year_cnt + year_idx) * age_cnt + age_idx];
+        }
+        x += nx[age_idx];
+    }
+    return diagonal;
+}
+
+
+// Equal, or both NaN.
+bool Same(double a, double b)
+{
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+}
+
+
+TEST(COHORT, matches_period_kernel_on_diagonals)
+{
+    const int year_cnt = 37;
+    const size_t pop_cnt = 3;
+    for (auto nx: {std::vector<double>(100, 1.0), GbdWidths<double>()}) {
+        const int age_cnt = nx.size();
+        auto mx = SilerSurface(nx, year_cnt, pop_cnt);
+        std::vector<double> lx(mx.size()), dx(mx.size()), ex(mx.size());
+        LifeTableColumns<double> columns;
+        columns.lx = &lx[0];
+        columns.dx = &dx[0];
+        columns.ex = &ex[0];
+        CohortLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], columns,
+                age_cnt, year_cnt, pop_cnt);
+
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            for (int cohort_idx = 0; cohort_idx < year_cnt; cohort_idx++) {
+                auto m = Diagonal(mx, nx, year_cnt, pop_idx, cohort_idx);
+                std::vector<double> l(age_cnt), d(age_cnt), e(age_cnt);
+                LifeTableColumns<double> expected;
+                expected.lx = &l[0];
+                expected.dx = &d[0];
+                expected.ex = &e[0];
+                FullLifeTable(&m[0], static_cast<double*>(nullptr), &nx[0], expected, age_cnt, 1);
+                const size_t offset = (pop_idx * year_cnt + cohort_idx) * age_cnt;
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    ASSERT_TRUE(Same(lx[offset + age_idx], l[age_idx]));
+                    ASSERT_TRUE(Same(dx[offset + age_idx], d[age_idx]));
+                    ASSERT_TRUE(Same(ex[offset + age_idx], e[age_idx]));
+                }
+            }
+        }
+    }
+}
+
+
+TEST(COHORT, unchanging_surface_is_period)
+{
+    auto nx = GbdWidths<double>();
+    const int age_cnt = nx.size();
+    // The open interval starts at 95, so cohorts 0 to 4 are complete.
+    const int year_cnt = 100;
+    auto mx = SilerSurface(nx, 1, 1);
+    std::vector<double> period_ex(age_cnt);
+    LifeTableColumns<double> period;
+    period.ex = &period_ex[0];
+    FullLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], period, age_cnt, 1);
+
+    std::vector<double> surface;
+    for (int year_idx = 0; year_idx < year_cnt; year_idx++) {
+        surface.insert(surface.end(), mx.begin(), mx.end());
+    }
+    std::vector<double> ex(surface.size());
+    LifeTableColumns<double> cohort;
+    cohort.ex = &ex[0];
+    CohortLifeTable(&surface[0], static_cast<double*>(nullptr), &nx[0], cohort,
+            age_cnt, year_cnt, 1);
+    for (int cohort_idx = 0; cohort_idx < 5; cohort_idx++) {
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            EXPECT_EQ(ex[cohort_idx * age_cnt + age_idx], period_ex[age_idx]);
+        }
+    }
+    EXPECT_TRUE(std::isnan(ex[5 * age_cnt]));
+}
+
+
+TEST(COHORT, values_past_the_surface_are_nan)
+{
+    std::vector<double> nx(20, 5.0);
+    const int age_cnt = nx.size();
+    const int year_cnt = 40;
+    auto mx = SilerSurface(nx, year_cnt, 1);
+    std::vector<double> ax(mx.size()), lx(mx.size()), Lx(mx.size()), ex(mx.size());
+    LifeTableColumns<double> columns;
+    columns.ax = &ax[0];
+    columns.lx = &lx[0];
+    columns.Lx = &Lx[0];
+    columns.ex = &ex[0];
+    CohortLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], columns,
+            age_cnt, year_cnt, 1);
+
+    // Cohort 10 is in age group 6, centered on 32.5, in year 42.
+    const size_t offset = 10 * age_cnt;
+    for (int age_idx = 0; age_idx < 6; age_idx++) {
+        EXPECT_TRUE(std::isfinite(ax[offset + age_idx]));
+        EXPECT_TRUE(std::isfinite(Lx[offset + age_idx]));
+        EXPECT_TRUE(std::isnan(ex[offset + age_idx]));
+    }
+    EXPECT_TRUE(std::isfinite(lx[offset + 6]));
+    EXPECT_TRUE(std::isnan(ax[offset + 6]));
+    EXPECT_TRUE(std::isnan(lx[offset + 7]));
+}
+
+
+TEST(COHORT, improving_mortality_lengthens_cohort_life)
+{
+    std::vector<double> nx(100, 1.0);
+    const int year_cnt = 100;
+    auto mx = SilerSurface(nx, year_cnt, 1);
+    std::vector<double> ex(mx.size());
+    LifeTableColumns<double> columns;
+    columns.ex = &ex[0];
+    CohortLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], columns, 100, year_cnt, 1);
+
+    std::vector<double> period_ex(100);
+    LifeTableColumns<double> period;
+    period.ex = &period_ex[0];
+    FullLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], period, 100, 1);
+    // The cohort born in the first year sees the improvements that follow.
+    EXPECT_GT(ex[0], period_ex[0]);
+}
+
+
+TEST(COHORT, parallel_matches_serial)
+{
+    auto nx = GbdWidths<double>();
+    const int age_cnt = nx.size();
+    const int year_cnt = 41;
+    const size_t pop_cnt = 4;
+    auto mx = SilerSurface(nx, year_cnt, pop_cnt);
+    std::vector<double> ax(mx.size());
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt * year_cnt);
+
+    std::vector<double> serial(mx.size()), parallel(mx.size());
+    LifeTableColumns<double> serial_columns, parallel_columns;
+    serial_columns.Tx = &serial[0];
+    parallel_columns.Tx = &parallel[0];
+    ThreadPool pool(3);
+    CohortLifeTable(&mx[0], &ax[0], &nx[0], serial_columns, age_cnt, year_cnt, pop_cnt);
+    CohortLifeTable(&mx[0], &ax[0], &nx[0], parallel_columns, age_cnt, year_cnt, pop_cnt, pool);
+    for (size_t value_idx = 0; value_idx < serial.size(); value_idx++) {
+        ASSERT_TRUE(Same(serial[value_idx], parallel[value_idx]));
+    }
+}
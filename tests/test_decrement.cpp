@@ -0,0 +1,266 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/decrement.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Seven causes, which don't fill the last group of lanes, that sum to
+// Siler all-cause mortality in five-year groups.
+struct Causes {
+    explicit Causes(size_t pop_cnt, double last_nx = 5)
+        : pop_cnt(pop_cnt), nx(age_cnt, 5.0), mx(SilerRates(nx, pop_cnt, 3.0)),
+          cause_mx(pop_cnt * cause_cnt * age_cnt)
+    {
+        nx[age_cnt - 1] = last_nx;
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                const double x = 5.0 * age_idx + 2.5;
+                const double total = mx[pop_idx * age_cnt + age_idx];
+                double weight_sum = 0;
+                std::vector<double> weight(cause_cnt);
+                for (int cause_idx = 0; cause_idx < cause_cnt; cause_idx++) {
+                    weight[cause_idx] = 1 + std::sin(0.3 * x + cause_idx + pop_idx);
+                    weight_sum += weight[cause_idx];
+                }
+                for (int cause_idx = 0; cause_idx < cause_cnt; cause_idx++) {
+                    cause_mx[(pop_idx * cause_cnt + cause_idx) * age_cnt + age_idx] =
+                            total * weight[cause_idx] / weight_sum;
+                }
+            }
+        }
+    }
+
+    static constexpr int age_cnt = 20;
+    static constexpr int cause_cnt = 7;
+    size_t pop_cnt;
+    std::vector<double> nx;
+    std::vector<double> mx;
+    std::vector<double> cause_mx;
+};
+
+
+struct Output {
+    explicit Output(size_t size) : qx(size), lx(size), ex(size), dx(size), cause_lx(size)
+    {
+        columns.deleted_qx = &qx[0];
+        columns.deleted_lx = &lx[0];
+        columns.deleted_ex = &ex[0];
+        columns.cause_dx = &dx[0];
+        columns.cause_lx = &cause_lx[0];
+    }
+
+    std::vector<double> qx, lx, ex, dx, cause_lx;
+    DecrementColumns<double> columns;
+};
+
+}
+
+
+TEST(DECREMENT, deleted_tables_match_full_lifetables)
+{
+    for (double last_nx: {5.0, std::numeric_limits<double>::infinity()}) {
+        Causes in(3, last_nx);
+        const int age_cnt = Causes::age_cnt;
+        const int cause_cnt = Causes::cause_cnt;
+        Output out(in.cause_mx.size());
+        CauseDeletedLifeTable(&in.mx[0], static_cast<const double*>(nullptr), &in.nx[0],
+                &in.cause_mx[0], out.columns, age_cnt, cause_cnt, in.pop_cnt);
+
+        std::vector<double> deleted(age_cnt), qx(age_cnt), lx(age_cnt), ex(age_cnt);
+        LifeTableColumns<double> expected;
+        expected.qx = &qx[0];
+        expected.lx = &lx[0];
+        expected.ex = &ex[0];
+        for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+            for (int cause_idx = 0; cause_idx < cause_cnt; cause_idx++) {
+                const size_t row = (pop_idx * cause_cnt + cause_idx) * age_cnt;
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    deleted[age_idx] = in.mx[pop_idx * age_cnt + age_idx] -
+                            in.cause_mx[row + age_idx];
+                }
+                FullLifeTable(&deleted[0], static_cast<const double*>(nullptr), &in.nx[0],
+                        expected, age_cnt, 1);
+                // At the oldest ages, mx nx is large enough that the
+                // lifetable's qx from mx and ax loses a few digits.
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    EXPECT_NEAR(out.lx[row + age_idx], lx[age_idx], 1e-11 * lx[age_idx]);
+                    EXPECT_NEAR(out.ex[row + age_idx], ex[age_idx], 1e-12 * ex[age_idx]);
+                    if (age_idx + 1 < age_cnt) {
+                        EXPECT_NEAR(out.qx[row + age_idx], qx[age_idx], 1e-12 * qx[age_idx]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+TEST(DECREMENT, cause_deaths_add_up)
+{
+    Causes in(2);
+    const int age_cnt = Causes::age_cnt;
+    const int cause_cnt = Causes::cause_cnt;
+    Output out(in.cause_mx.size());
+    CauseDeletedLifeTable(&in.mx[0], static_cast<const double*>(nullptr), &in.nx[0],
+            &in.cause_mx[0], out.columns, age_cnt, cause_cnt, in.pop_cnt);
+
+    std::vector<double> lx(in.mx.size()), dx(in.mx.size());
+    LifeTableColumns<double> all;
+    all.lx = &lx[0];
+    all.dx = &dx[0];
+    FullLifeTable(&in.mx[0], static_cast<const double*>(nullptr), &in.nx[0], all, age_cnt,
+            in.pop_cnt);
+    for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            double deaths = 0;
+            double eventual = 0;
+            for (int cause_idx = 0; cause_idx < cause_cnt; cause_idx++) {
+                const size_t value_idx = (pop_idx * cause_cnt + cause_idx) * age_cnt + age_idx;
+                deaths += out.dx[value_idx];
+                eventual += out.cause_lx[value_idx];
+                // Removing a cause never lowers survival.
+                EXPECT_GE(out.lx[value_idx], lx[pop_idx * age_cnt + age_idx] * (1 - 1e-14));
+            }
+            EXPECT_NEAR(deaths, dx[pop_idx * age_cnt + age_idx], 1e-15);
+            EXPECT_NEAR(eventual, lx[pop_idx * age_cnt + age_idx], 1e-14);
+        }
+    }
+}
+
+
+namespace {
+
+// Mean ages a tenth below constant mortality's, so that ax differs from
+// what graduation would give up and return.
+std::vector<double> ScaledMeanAges(const Causes& in)
+{
+    std::vector<double> ax(in.mx.size());
+    ConstantMortalityMeanAge(&in.mx[0], &in.nx[0], &ax[0], Causes::age_cnt, in.pop_cnt);
+    for (auto& a: ax) {
+        a *= 0.9;
+    }
+    return ax;
+}
+
+}
+
+
+TEST(DECREMENT, deleting_nothing_keeps_the_given_mean_ages)
+{
+    Causes in(2);
+    const int age_cnt = Causes::age_cnt;
+    const std::vector<double> ax = ScaledMeanAges(in);
+    std::vector<double> nothing(in.mx.size(), 0.0);
+    std::vector<double> ex(in.mx.size()), lx(in.mx.size());
+    DecrementColumns<double> columns;
+    columns.deleted_ex = &ex[0];
+    columns.deleted_lx = &lx[0];
+    CauseDeletedLifeTable(&in.mx[0], &ax[0], &in.nx[0], &nothing[0], columns, age_cnt, 1,
+            in.pop_cnt);
+
+    std::vector<double> expected_ex(in.mx.size()), expected_lx(in.mx.size());
+    LifeTableColumns<double> expected;
+    expected.ex = &expected_ex[0];
+    expected.lx = &expected_lx[0];
+    FullLifeTable(&in.mx[0], &ax[0], &in.nx[0], expected, age_cnt, in.pop_cnt);
+    for (size_t value_idx = 0; value_idx < ex.size(); value_idx++) {
+        EXPECT_NEAR(ex[value_idx], expected_ex[value_idx], 1e-12 * expected_ex[value_idx]);
+        EXPECT_NEAR(lx[value_idx], expected_lx[value_idx], 1e-14);
+    }
+}
+
+
+TEST(DECREMENT, deleted_person_years_use_the_shifted_mean_age)
+{
+    Causes in(2);
+    const int age_cnt = Causes::age_cnt;
+    const int cause_cnt = Causes::cause_cnt;
+    const int last = age_cnt - 1;
+    const std::vector<double> ax = ScaledMeanAges(in);
+    Output out(in.cause_mx.size());
+    CauseDeletedLifeTable(&in.mx[0], &ax[0], &in.nx[0], &in.cause_mx[0], out.columns,
+            age_cnt, cause_cnt, in.pop_cnt);
+
+    std::vector<double> px(in.mx.size()), constant_ax(in.mx.size());
+    LifeTableColumns<double> all;
+    all.px = &px[0];
+    FullLifeTable(&in.mx[0], &ax[0], &in.nx[0], all, age_cnt, in.pop_cnt);
+    ConstantMortalityMeanAge(&in.mx[0], &in.nx[0], &constant_ax[0], age_cnt, in.pop_cnt);
+    std::vector<double> deleted(age_cnt), deleted_ax(age_cnt);
+    for (size_t pop_idx = 0; pop_idx < in.pop_cnt; pop_idx++) {
+        const size_t all_row = pop_idx * age_cnt;
+        for (int cause_idx = 0; cause_idx < cause_cnt; cause_idx++) {
+            const size_t row = (pop_idx * cause_cnt + cause_idx) * age_cnt;
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                deleted[age_idx] = in.mx[all_row + age_idx] - in.cause_mx[row + age_idx];
+            }
+            ConstantMortalityMeanAge(&deleted[0], &in.nx[0], &deleted_ax[0], age_cnt, 1);
+            // Survival is px^R, and each deleted mean age moves from its
+            // constant-mortality value as far as ax moves from its own.
+            double l = 1;
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                EXPECT_NEAR(out.lx[row + age_idx], l, 1e-13 * l);
+                const double ratio = deleted[age_idx] / in.mx[all_row + age_idx];
+                l *= std::pow(px[all_row + age_idx], ratio);
+            }
+            double T = deleted_ax[last] * ax[all_row + last] / constant_ax[all_row + last] *
+                    out.lx[row + last];
+            EXPECT_NEAR(out.ex[row + last], T / out.lx[row + last], 1e-12 * out.ex[row + last]);
+            for (int age_idx = last - 1; age_idx >= 0; age_idx--) {
+                const double l_age = out.lx[row + age_idx];
+                const double l_next = out.lx[row + age_idx + 1];
+                const double a = deleted_ax[age_idx] + ax[all_row + age_idx] -
+                        constant_ax[all_row + age_idx];
+                T += in.nx[age_idx] * l_next + a * (l_age - l_next);
+                EXPECT_NEAR(out.ex[row + age_idx], T / l_age, 1e-12 * T / l_age);
+            }
+        }
+    }
+}
+
+
+TEST(DECREMENT, threads_and_precision)
+{
+    Causes in(41);
+    const int age_cnt = Causes::age_cnt;
+    const int cause_cnt = Causes::cause_cnt;
+    Output serial(in.cause_mx.size()), pooled(in.cause_mx.size());
+    CauseDeletedLifeTable(&in.mx[0], static_cast<const double*>(nullptr), &in.nx[0],
+            &in.cause_mx[0], serial.columns, age_cnt, cause_cnt, in.pop_cnt);
+    ThreadPool pool(3);
+    CauseDeletedLifeTable(&in.mx[0], static_cast<const double*>(nullptr), &in.nx[0],
+            &in.cause_mx[0], pooled.columns, age_cnt, cause_cnt, in.pop_cnt, pool);
+    EXPECT_EQ(pooled.ex, serial.ex);
+    EXPECT_EQ(pooled.cause_lx, serial.cause_lx);
+
+    std::vector<float> mx(in.mx.begin(), in.mx.end()), nx(in.nx.begin(), in.nx.end());
+    std::vector<float> cause_mx(in.cause_mx.begin(), in.cause_mx.end());
+    std::vector<float> ex(cause_mx.size());
+    DecrementColumns<float> columns;
+    columns.deleted_ex = &ex[0];
+    CauseDeletedLifeTable<float, double>(&mx[0], static_cast<const float*>(nullptr), &nx[0],
+            &cause_mx[0], columns, age_cnt, cause_cnt, in.pop_cnt, pool);
+    for (size_t value_idx = 0; value_idx < ex.size(); value_idx++) {
+        EXPECT_NEAR(ex[value_idx], serial.ex[value_idx], 1e-5 * serial.ex[value_idx]);
+    }
+}
+
+
+TEST(DECREMENT, causes_cannot_exceed_all_causes)
+{
+    Causes in(1);
+    in.cause_mx[Causes::age_cnt + 3] = 2 * in.mx[3];
+    Output out(in.cause_mx.size());
+    EXPECT_THROW(CauseDeletedLifeTable(&in.mx[0], static_cast<const double*>(nullptr),
+            &in.nx[0], &in.cause_mx[0], out.columns, Causes::age_cnt, Causes::cause_cnt, 1),
+            std::invalid_argument);
+}
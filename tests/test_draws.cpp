@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/draws.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Draws of Siler mortality, Array[draw,pop,age], each scaled by a
+// pseudo-random factor.
+std::vector<double> Draws(const std::vector<double>& nx, size_t pop_cnt, size_t draw_cnt)
+{
+    const int age_cnt = nx.size();
+    const auto siler = SilerRates(nx, pop_cnt, 3.0);
+    std::vector<double> mx(draw_cnt * pop_cnt * age_cnt);
+    for (size_t draw_idx = 0; draw_idx < draw_cnt; draw_idx++) {
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            const double scale = 1 + 0.3 * std::sin(12.9898 * draw_idx + 78.233 * pop_idx);
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                mx[(draw_idx * pop_cnt + pop_idx) * age_cnt + age_idx] =
+                        scale * siler[pop_idx * age_cnt + age_idx];
+            }
+        }
+    }
+    return mx;
+}
+
+
+double SortedQuantile(std::vector<double> values, double probability)
+{
+    std::sort(values.begin(), values.end());
+    double position = probability * (values.size() - 1);
+    size_t below = static_cast<size_t>(std::floor(position));
+    if (below + 1 >= values.size()) {
+        return values[below];
+    }
+    return values[below] + (position - below) * (values[below + 1] - values[below]);
+}
+
+}
+
+
+TEST(DRAWS, matches_full_output)
+{
+    std::vector<double> nx(20, 5.0);
+    const int age_cnt = nx.size();
+    const size_t pop_cnt = 7;
+    const size_t draw_cnt = 101;
+    auto mx = Draws(nx, pop_cnt, draw_cnt);
+
+    std::vector<double> ex(mx.size()), lx(mx.size());
+    LifeTableColumns<double> full;
+    full.ex = &ex[0];
+    full.lx = &lx[0];
+    FullLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], full, age_cnt,
+            pop_cnt * draw_cnt);
+
+    std::vector<double> ex_stats(pop_cnt * age_cnt * kDrawStatisticCount);
+    std::vector<double> lx_stats(ex_stats.size());
+    LifeTableColumns<double> summaries;
+    summaries.ex = &ex_stats[0];
+    summaries.lx = &lx_stats[0];
+    SummarizeDraws(&mx[0], static_cast<double*>(nullptr), &nx[0], summaries, age_cnt,
+            pop_cnt, draw_cnt, 0.1, 0.9);
+
+    for (auto column: {std::make_pair(&ex, &ex_stats), std::make_pair(&lx, &lx_stats)}) {
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                std::vector<double> values(draw_cnt);
+                double sum = 0;
+                for (size_t draw_idx = 0; draw_idx < draw_cnt; draw_idx++) {
+                    values[draw_idx] = (*column.first)[(draw_idx * pop_cnt + pop_idx) * age_cnt + age_idx];
+                    sum += values[draw_idx];
+                }
+                const double mean = sum / draw_cnt;
+                double squares = 0;
+                for (auto value: values) {
+                    squares += (value - mean) * (value - mean);
+                }
+                const double* stats = &(*column.second)[(pop_idx * age_cnt + age_idx) * kDrawStatisticCount];
+                EXPECT_NEAR(stats[kDrawMean], mean, 1e-13 * std::abs(mean));
+                EXPECT_NEAR(stats[kDrawVariance], squares / (draw_cnt - 1),
+                        1e-10 * squares / (draw_cnt - 1) + 1e-300);
+                EXPECT_EQ(stats[kDrawLower], SortedQuantile(values, 0.1));
+                EXPECT_EQ(stats[kDrawUpper], SortedQuantile(values, 0.9));
+            }
+        }
+    }
+}
+
+
+TEST(DRAWS, parallel_and_blocked_match_serial)
+{
+    std::vector<double> nx(100, 1.0);
+    const int age_cnt = nx.size();
+    const size_t draw_cnt = 250;
+    // Enough populations for several blocks.
+    const size_t pop_cnt = 3 * kDrawBlockValues / (draw_cnt * age_cnt) + 5;
+    auto mx = Draws(nx, pop_cnt, draw_cnt);
+    std::vector<double> ax(mx.size());
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt * draw_cnt);
+
+    std::vector<double> serial(pop_cnt * age_cnt * kDrawStatisticCount);
+    std::vector<double> parallel(serial.size());
+    LifeTableColumns<double> serial_columns, parallel_columns;
+    serial_columns.ex = &serial[0];
+    parallel_columns.ex = &parallel[0];
+    SummarizeDraws(&mx[0], &ax[0], &nx[0], serial_columns, age_cnt, pop_cnt, draw_cnt);
+    ThreadPool pool(4);
+    SummarizeDraws(&mx[0], &ax[0], &nx[0], parallel_columns, age_cnt, pop_cnt, draw_cnt, pool);
+    EXPECT_EQ(serial, parallel);
+
+    // The last population, in the last block, against a direct reduction.
+    const size_t pop_idx = pop_cnt - 1;
+    std::vector<double> e0(draw_cnt);
+    for (size_t draw_idx = 0; draw_idx < draw_cnt; draw_idx++) {
+        std::vector<double> le(age_cnt);
+        const size_t offset = (draw_idx * pop_cnt + pop_idx) * age_cnt;
+        FirstMomentPeriodLifeExpectancy(&mx[offset], &ax[offset], &nx[0], &le[0], age_cnt, 1);
+        e0[draw_idx] = le[0];
+    }
+    const double* stats = &serial[pop_idx * age_cnt * kDrawStatisticCount];
+    EXPECT_NEAR(stats[kDrawLower], SortedQuantile(e0, 0.025), 1e-10);
+    EXPECT_NEAR(stats[kDrawUpper], SortedQuantile(e0, 0.975), 1e-10);
+}
+
+
+TEST(DRAWS, few_draws_split_populations)
+{
+    // Fewer draws than threads, so threads have to share populations.
+    std::vector<double> nx(20, 5.0);
+    const int age_cnt = nx.size();
+    const size_t draw_cnt = 2;
+    const size_t pop_cnt = 37;
+    auto mx = Draws(nx, pop_cnt, draw_cnt);
+
+    std::vector<double> serial(pop_cnt * age_cnt * kDrawStatisticCount);
+    std::vector<double> parallel(serial.size());
+    LifeTableColumns<double> serial_columns, parallel_columns;
+    serial_columns.ex = &serial[0];
+    parallel_columns.ex = &parallel[0];
+    SummarizeDraws(&mx[0], static_cast<double*>(nullptr), &nx[0], serial_columns, age_cnt,
+            pop_cnt, draw_cnt);
+    ThreadPool pool(4);
+    SummarizeDraws(&mx[0], static_cast<double*>(nullptr), &nx[0], parallel_columns, age_cnt,
+            pop_cnt, draw_cnt, pool);
+    EXPECT_EQ(serial, parallel);
+
+    // Every item is written once, whatever the split.
+    std::vector<double> lx(draw_cnt * pop_cnt * age_cnt);
+    LifeTableColumns<double> buffers;
+    buffers.lx = &lx[0];
+    LifeTableWorkspace<double> workspace;
+    for (size_t item_idx = 0; item_idx < draw_cnt * pop_cnt; item_idx += 5) {
+        DrawBlockLifeTables(&mx[0], static_cast<double*>(nullptr), &nx[0], buffers, age_cnt,
+                pop_cnt, 0, pop_cnt, item_idx, std::min(item_idx + 5, draw_cnt * pop_cnt),
+                workspace);
+    }
+    std::vector<double> expected(lx.size());
+    LifeTableColumns<double> whole;
+    whole.lx = &expected[0];
+    FullLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], whole, age_cnt,
+            draw_cnt * pop_cnt);
+    EXPECT_EQ(lx, expected);
+}
+
+
+TEST(DRAWS, single_draw)
+{
+    std::vector<double> nx(20, 5.0);
+    auto mx = Draws(nx, 2, 1);
+    std::vector<double> stats(2 * 20 * kDrawStatisticCount);
+    LifeTableColumns<double> summaries;
+    summaries.qx = &stats[0];
+    SummarizeDraws(&mx[0], static_cast<double*>(nullptr), &nx[0], summaries, 20, 2, 1);
+    for (size_t cell_idx = 0; cell_idx < 40; cell_idx++) {
+        const double* cell = &stats[cell_idx * kDrawStatisticCount];
+        EXPECT_EQ(cell[kDrawVariance], 0);
+        EXPECT_EQ(cell[kDrawLower], cell[kDrawMean]);
+        EXPECT_EQ(cell[kDrawUpper], cell[kDrawMean]);
+    }
+    ASSERT_THROW(SummarizeDraws(&mx[0], static_cast<double*>(nullptr), &nx[0], summaries,
+            20, 2, 1, 0.9, 0.1), std::invalid_argument);
+}
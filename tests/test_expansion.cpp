@@ -0,0 +1,212 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/expansion.hpp"
+#include "fundem/hazards.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Ages 0, 1, 5, ..., 95+, and single years to 95+.
+std::vector<double> AbridgedWidths()
+{
+    std::vector<double> nx{1, 4};
+    nx.resize(21, 5.0);
+    return nx;
+}
+
+
+std::vector<double> SingleWidths()
+{
+    return std::vector<double>(96, 1.0);
+}
+
+
+// Rates that are exact interval averages of Siler hazards, so that
+// constant-mortality lifetables have the hazards' survival at every age.
+std::vector<double> SilerAverages(const std::vector<double>& nx, size_t pop_cnt)
+{
+    std::vector<double> parameters;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        const double siler[] = {0.05, 1.5, 5e-5 * std::exp(0.02 * pop_idx), 0.09, 5e-4};
+        parameters.insert(parameters.end(), siler, siler + 5);
+    }
+    std::vector<double> mx(pop_cnt * nx.size());
+    HazardRates<SilerHazard>(&parameters[0], &nx[0], &mx[0], nx.size(), pop_cnt);
+    return mx;
+}
+
+
+struct Columns {
+    explicit Columns(size_t size) : ax(size), lx(size), dx(size), Lx(size), ex(size)
+    {
+        columns.ax = &ax[0];
+        columns.lx = &lx[0];
+        columns.dx = &dx[0];
+        columns.Lx = &Lx[0];
+        columns.ex = &ex[0];
+    }
+
+    std::vector<double> ax, lx, dx, Lx, ex;
+    LifeTableColumns<double> columns;
+};
+
+}
+
+
+TEST(EXPANSION, single_years_are_smooth_and_monotone)
+{
+    const auto abridged = AbridgedWidths();
+    const auto single = SingleWidths();
+    const size_t pop_cnt = 3;
+    const auto mx = SilerAverages(abridged, pop_cnt);
+    const auto truth_mx = SilerAverages(single, pop_cnt);
+
+    ExpansionOperator<double> expand(&abridged[0], abridged.size(), &single[0], single.size());
+    EXPECT_EQ(expand.UnionCount(), 96);
+    Columns out(pop_cnt * single.size());
+    expand.Apply(&mx[0], static_cast<const double*>(nullptr), out.columns, pop_cnt);
+
+    double worst = 0;
+    double worst_flat = 0;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        double truth_hazard = 0;
+        for (size_t age_idx = 0; age_idx < single.size(); age_idx++) {
+            const size_t value_idx = pop_idx * single.size() + age_idx;
+            EXPECT_GE(out.dx[value_idx], 0);
+            if (age_idx + 1 < single.size()) {
+                EXPECT_GT(out.ax[value_idx], 0.45);
+                EXPECT_LT(out.ax[value_idx], 0.55);
+            }
+            const double truth = std::exp(-truth_hazard);
+            worst = std::max(worst, std::abs(out.lx[value_idx] / truth - 1));
+            truth_hazard += truth_mx[value_idx];
+            // Constant hazard within each five-year group, for comparison.
+            if (age_idx >= 5) {
+                const size_t group = 1 + age_idx / 5;
+                const size_t start = 5 * (group - 1);
+                const double lower = out.lx[pop_idx * single.size() + start];
+                const double flat = lower * std::exp(-mx[pop_idx * abridged.size() + group] *
+                        (age_idx - start));
+                worst_flat = std::max(worst_flat, std::abs(flat / truth - 1));
+            }
+        }
+    }
+    // Most of the error is in the last interval before the open age,
+    // where the spline has only one side to go on.
+    EXPECT_LT(worst, 2e-2);
+    EXPECT_LT(worst, worst_flat / 4);
+}
+
+
+TEST(EXPANSION, round_trip_recovers_the_source)
+{
+    const auto abridged = AbridgedWidths();
+    const auto single = SingleWidths();
+    const size_t pop_cnt = 4;
+    const auto mx = SilerAverages(abridged, pop_cnt);
+
+    Columns expected(mx.size());
+    FullLifeTable(&mx[0], static_cast<const double*>(nullptr), &abridged[0], expected.columns,
+            abridged.size(), pop_cnt);
+
+    auto expand = SharedExpansionOperator(&abridged[0], abridged.size(), &single[0],
+            single.size());
+    EXPECT_EQ(expand, SharedExpansionOperator(&abridged[0], abridged.size(), &single[0],
+            single.size()));
+    Columns out(pop_cnt * single.size());
+    expand->Apply(&mx[0], static_cast<const double*>(nullptr), out.columns, pop_cnt);
+
+    // Shared ages keep the source's lx. ex differs only by what each
+    // assumes about deaths within the source's intervals.
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        int start = 0;
+        for (size_t age_idx = 0; age_idx < abridged.size(); age_idx++) {
+            const size_t from = pop_idx * abridged.size() + age_idx;
+            const size_t to = pop_idx * single.size() + start;
+            EXPECT_NEAR(out.lx[to], expected.lx[from], 1e-14);
+            EXPECT_NEAR(out.ex[to], expected.ex[from], 0.03 * expected.ex[from]);
+            start += static_cast<int>(abridged[age_idx]);
+        }
+    }
+
+    // Back to abridged ages, from single-year mx and ax, gives the
+    // single-year table at the abridged ages.
+    std::vector<double> single_mx(out.lx.size());
+    for (size_t value_idx = 0; value_idx < single_mx.size(); value_idx++) {
+        single_mx[value_idx] = out.dx[value_idx] / out.Lx[value_idx];
+    }
+    Columns single_table(out.lx.size());
+    FullLifeTable(&single_mx[0], &out.ax[0], &single[0], single_table.columns, single.size(),
+            pop_cnt);
+    auto collapse = SharedExpansionOperator(&single[0], single.size(), &abridged[0],
+            abridged.size());
+    Columns back(mx.size());
+    ThreadPool pool(3);
+    collapse->Apply(&single_mx[0], &out.ax[0], back.columns, pop_cnt, pool);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        int start = 0;
+        for (size_t age_idx = 0; age_idx < abridged.size(); age_idx++) {
+            const size_t to = pop_idx * abridged.size() + age_idx;
+            const size_t from = pop_idx * single.size() + start;
+            EXPECT_NEAR(back.lx[to], expected.lx[to], 1e-13);
+            EXPECT_NEAR(back.lx[to], single_table.lx[from], 1e-13);
+            EXPECT_NEAR(back.ex[to], single_table.ex[from], 1e-10);
+            EXPECT_NEAR(out.ex[from], single_table.ex[from], 1e-10);
+            start += static_cast<int>(abridged[age_idx]);
+        }
+    }
+}
+
+
+TEST(EXPANSION, threads_match_serial)
+{
+    const auto abridged = AbridgedWidths();
+    const auto single = SingleWidths();
+    const size_t pop_cnt = 50;
+    const auto mx = SilerAverages(abridged, pop_cnt);
+    ExpansionOperator<double> expand(&abridged[0], abridged.size(), &single[0], single.size());
+    Columns serial(pop_cnt * single.size()), pooled(pop_cnt * single.size());
+    expand.Apply(&mx[0], static_cast<const double*>(nullptr), serial.columns, pop_cnt);
+    ThreadPool pool(4);
+    expand.Apply(&mx[0], static_cast<const double*>(nullptr), pooled.columns, pop_cnt, pool);
+    EXPECT_EQ(pooled.lx, serial.lx);
+    EXPECT_EQ(pooled.ex, serial.ex);
+}
+
+
+TEST(EXPANSION, schemas_must_share_the_open_age)
+{
+    const auto abridged = AbridgedWidths();
+    const std::vector<double> short_single(91, 1.0);
+    EXPECT_THROW(ExpansionOperator<double>(&abridged[0], abridged.size(), &short_single[0],
+            short_single.size()), std::invalid_argument);
+}
+
+
+TEST(EXPANSION, shared_operators_are_evicted)
+{
+    // Single years to ages 1, 2, ..., each expanded to itself.
+    std::vector<std::vector<double>> schemas;
+    for (size_t schema_idx = 0; schema_idx <= kSharedExpansionCacheSize; schema_idx++) {
+        schemas.emplace_back(schema_idx + 2, 1.0);
+    }
+    auto Shared = [&schemas](size_t schema_idx) {
+        const auto& nx = schemas[schema_idx];
+        return SharedExpansionOperator(&nx[0], nx.size(), &nx[0], nx.size());
+    };
+
+    auto first = Shared(0);
+    auto second = Shared(1);
+    for (size_t schema_idx = 2; schema_idx < schemas.size(); schema_idx++) {
+        Shared(schema_idx);
+    }
+    // The last pair pushed out the first, which is least recently used.
+    EXPECT_EQ(second, Shared(1));
+    EXPECT_NE(first, Shared(0));
+}
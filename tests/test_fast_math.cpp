@@ -0,0 +1,133 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/fast_math.hpp"
+#include "fundem/lifetable.hpp"
+
+
+using namespace fundem;
+
+
+TEST(FAST_MATH, expm1_matches_std)
+{
+    typedef Lanes<double, 4> V;
+    const double arguments[] = {-50, -3, -0.7, -1e-3, -1e-12, 0, 1e-15, 2e-6,
+                                0.01, 0.34, 0.35, 1, 7.5, 40, 300};
+    for (double x : arguments) {
+        V result = Expm1(V::Broadcast(x));
+        double expected = std::expm1(x);
+        EXPECT_NEAR(result[0], expected, 4e-16 * std::abs(expected)) << x;
+        EXPECT_EQ(result[0], result[3]);
+    }
+}
+
+
+TEST(FAST_MATH, expm1_single_precision)
+{
+    typedef Lanes<float, 8> V;
+    for (float x = -20; x < 20; x += 0.37f) {
+        V result = Expm1(V::Broadcast(x));
+        float expected = std::expm1(x);
+        EXPECT_NEAR(result[0], expected, 2.5e-7f * std::abs(expected)) << x;
+    }
+}
+
+
+TEST(FAST_MATH, exp_matches_std)
+{
+    typedef Lanes<double, 4> V;
+    for (double x = -700; x < 700; x += 0.731) {
+        V result = Exp(V::Broadcast(x));
+        double expected = std::exp(x);
+        EXPECT_NEAR(result[0], expected, 4e-16 * expected) << x;
+    }
+}
+
+
+TEST(FAST_MATH, log_matches_std)
+{
+    typedef Lanes<double, 4> V;
+    for (double x = 1e-300; x < 1e300; x *= 1.37) {
+        V result = Log(V::Broadcast(x));
+        double expected = std::log(x);
+        EXPECT_NEAR(result[0], expected, 4e-16 * std::abs(expected)) << x;
+    }
+    // Near one, where the exponent is zero and the series does it all.
+    for (double x = 0.5; x < 2; x += 1.3e-3) {
+        V result = Log(V::Broadcast(x));
+        double expected = std::log(x);
+        EXPECT_NEAR(result[0], expected, 5e-16 * std::abs(expected)) << x;
+    }
+    typedef Lanes<float, 8> F;
+    for (float x = 1e-37f; x < 1e37f; x *= 1.37f) {
+        F result = Log(F::Broadcast(x));
+        float expected = std::log(x);
+        EXPECT_NEAR(result[0], expected, 2.5e-7f * std::abs(expected)) << x;
+    }
+}
+
+
+TEST(CONSTANT_MORTALITY, vectorized_matches_scalar)
+{
+    // Seven ages leave a partial group of lanes, and the last is open.
+    std::vector<double> nx{7.0 / 365, 28.0 / 365, 330.0 / 365, 4, 5, 5,
+                           std::numeric_limits<double>::infinity()};
+    const int age_cnt = nx.size();
+    const size_t pop_cnt = 40;
+    std::vector<double> mx(age_cnt * pop_cnt);
+    for (size_t mx_idx = 0; mx_idx < mx.size(); mx_idx++) {
+        // Rates from 1e-6 to about 3 cover the series, blend, and exact forms.
+        mx[mx_idx] = 1e-6 * std::pow(1.5, static_cast<double>(mx_idx % 37));
+    }
+    std::vector<double> scalar(mx.size()), vectorized(mx.size());
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &scalar[0], age_cnt, pop_cnt);
+    ConstantMortalityMeanAgeVectorized(&mx[0], &nx[0], &vectorized[0], age_cnt, pop_cnt);
+
+    for (size_t cmp_idx = 0; cmp_idx < mx.size(); cmp_idx++) {
+        EXPECT_NEAR(vectorized[cmp_idx], scalar[cmp_idx], 1e-14 * scalar[cmp_idx]);
+        const double n = nx[cmp_idx % age_cnt];
+        if (std::isinf(n)) {
+            EXPECT_DOUBLE_EQ(scalar[cmp_idx], 1 / mx[cmp_idx]);
+        } else {
+            EXPECT_GT(scalar[cmp_idx], 0);
+            EXPECT_LT(scalar[cmp_idx], 0.5 * n);
+        }
+    }
+}
+
+
+TEST(CONSTANT_MORTALITY, continuous_across_blend)
+{
+    // Evaluated in long double, the exact form is good enough to check
+    // the series and blend where double would cancel.
+    const double n = 5;
+    for (double mx = 1e-4; mx < 0.1; mx *= 1.1) {
+        double ax;
+        ConstantMortalityMeanAge(&mx, &n, &ax, 1, 1);
+        long double x = static_cast<long double>(mx) * n;
+        long double expected = 1 / static_cast<long double>(mx) - n / std::expm1(x);
+        EXPECT_NEAR(ax, static_cast<double>(expected), 1e-14 * ax) << mx;
+    }
+}
+
+
+TEST(CONSTANT_MORTALITY, matches_closed_form_at_band_edges)
+{
+    // x = mx nx at the start of the blend, at its end, and inside it,
+    // with widths that are powers of two, so that x is exactly those.
+    for (double x: {1e-2, 5e-2, 3e-2}) {
+        for (double n: {0.25, 1.0, 4.0}) {
+            const double mx = x / n;
+            ASSERT_EQ(mx * n, x);
+            double scalar, vectorized;
+            ConstantMortalityMeanAge(&mx, &n, &scalar, 1, 1);
+            ConstantMortalityMeanAgeVectorized(&mx, &n, &vectorized, 1, 1);
+            long double expected = 1 / static_cast<long double>(mx) -
+                    n / std::expm1(static_cast<long double>(x));
+            EXPECT_NEAR(scalar, static_cast<double>(expected), 1e-14 * scalar) << x << " " << n;
+            EXPECT_NEAR(vectorized, static_cast<double>(expected), 1e-14 * vectorized)
+                    << x << " " << n;
+        }
+    }
+}
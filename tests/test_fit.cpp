@@ -0,0 +1,201 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/cholesky.hpp"
+#include "fundem/fit.hpp"
+#include "fundem/hazards.hpp"
+#include "fundem/thread_pool.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Checks LogGradient against central differences in log parameters.
+template<template<typename> class HAZARD>
+void ExpectLogGradient(const std::vector<double>& parameters, double x)
+{
+    const int count = HAZARD<double>::kParameterCount;
+    ASSERT_EQ(parameters.size(), size_t(count));
+    std::vector<double> gradient(count), ignored(count);
+    HAZARD<double>(&parameters[0]).LogGradient(x, &gradient[0]);
+    const double h = 1e-6;
+    for (int param_idx = 0; param_idx < count; param_idx++) {
+        auto up = parameters;
+        auto down = parameters;
+        up[param_idx] *= std::exp(h);
+        down[param_idx] *= std::exp(-h);
+        const double expected = (std::log(HAZARD<double>(&up[0]).LogGradient(x, &ignored[0])) -
+                std::log(HAZARD<double>(&down[0]).LogGradient(x, &ignored[0]))) / (2 * h);
+        EXPECT_NEAR(gradient[param_idx], expected, 1e-7 * (1 + std::abs(expected)))
+                << "parameter " << param_idx << " at " << x;
+    }
+}
+
+
+// Siler curves that drift from one population to the next, as draws do.
+std::vector<double> SilerParameters(size_t pop_cnt)
+{
+    std::vector<double> parameters;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        const double t = 0.5 * pop_idx;
+        const double siler[] = {
+                0.2 * std::exp(-0.015 * t), 1.0, 0.0002 * std::exp(-0.01 * t), 0.1,
+                0.003 * std::exp(-0.01 * t)};
+        parameters.insert(parameters.end(), siler, siler + 5);
+    }
+    return parameters;
+}
+
+}
+
+
+TEST(FIT, log_gradients_match_differences)
+{
+    for (double x: {0.01, 2.5, 42.5, 97.0}) {
+        ExpectLogGradient<GompertzHazard>({5e-5, 0.09}, x);
+        ExpectLogGradient<GompertzMakehamHazard>({5e-5, 0.09, 5e-4}, x);
+        ExpectLogGradient<SilerHazard>({0.2, 1.0, 2e-4, 0.1, 3e-3}, x);
+        ExpectLogGradient<HeligmanPollardHazard>(
+                {5.4e-4, 0.017, 0.101, 1.3e-4, 10.72, 18.67, 4.46e-5, 1.1011}, x);
+    }
+}
+
+
+/*! The solver reads only the lower triangle, and rows may be padded. */
+TEST(FIT, cholesky_solves_padded_lower_triangle)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    double A[3][4] = {{4, nan, nan, nan}, {2, 5, nan, nan}, {-2, 1, 6, nan}};
+    double b[3] = {-2, 7, 13};  // A times (0, 1, 2).
+    ASSERT_TRUE(CholeskySolve(&A[0][0], 4, b, 3));
+    EXPECT_NEAR(b[0], 0, 1e-14);
+    EXPECT_NEAR(b[1], 1, 1e-14);
+    EXPECT_NEAR(b[2], 2, 1e-14);
+
+    // A positive but tiny pivot fails against a tolerance.
+    double singular[2][2] = {{1, nan}, {1, 1 + 1e-14}};
+    double rhs[2] = {1, 1};
+    EXPECT_FALSE(CholeskySolve(&singular[0][0], 2, rhs, 2, 1e-10));
+}
+
+
+TEST(FIT, recovers_siler_parameters)
+{
+    std::vector<double> nx(20, 5.0);
+    const size_t pop_cnt = 6;
+    const auto truth = SilerParameters(pop_cnt);
+    std::vector<double> mx(pop_cnt * nx.size());
+    HazardRates<SilerHazard>(&truth[0], &nx[0], &mx[0], nx.size(), pop_cnt,
+            HazardSample::Midpoint);
+
+    std::vector<double> fit(truth);
+    for (size_t param_idx = 0; param_idx < fit.size(); param_idx++) {
+        fit[param_idx] *= (param_idx % 2) ? 1.3 : 0.7;
+    }
+    std::vector<int> outcome(pop_cnt, -1);
+    std::vector<double> cost(pop_cnt);
+    HazardFitRecord record;
+    record.outcome = &outcome[0];
+    record.cost = &cost[0];
+    FitHazard<SilerHazard>(&mx[0], &nx[0], &fit[0], record, nx.size(), pop_cnt);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        EXPECT_EQ(outcome[pop_idx], static_cast<int>(FitOutcome::Converged));
+        EXPECT_LT(cost[pop_idx], 1e-20);
+    }
+    for (size_t param_idx = 0; param_idx < fit.size(); param_idx++) {
+        EXPECT_NEAR(fit[param_idx], truth[param_idx], 1e-6 * truth[param_idx]);
+    }
+}
+
+
+TEST(FIT, recovers_heligman_pollard_with_gaps)
+{
+    std::vector<double> nx(100, 1.0);
+    nx.push_back(std::numeric_limits<double>::infinity());
+    const std::vector<double> truth{
+            5.4e-4, 0.017, 0.101, 1.3e-4, 10.72, 18.67, 4.46e-5, 1.1011};
+    std::vector<double> mx(nx.size());
+    HazardRates<HeligmanPollardHazard>(&truth[0], &nx[0], &mx[0], nx.size(), 1,
+            HazardSample::Midpoint);
+    // Missing and zero observations don't count.
+    mx[30] = std::numeric_limits<double>::quiet_NaN();
+    mx[31] = 0;
+
+    std::vector<double> fit(truth);
+    for (size_t param_idx = 0; param_idx < fit.size(); param_idx++) {
+        fit[param_idx] *= (param_idx % 2) ? 1.05 : 0.95;
+    }
+    int outcome = -1;
+    int iterations = 0;
+    HazardFitRecord record;
+    record.outcome = &outcome;
+    record.iterations = &iterations;
+    FitHazard<HeligmanPollardHazard>(&mx[0], &nx[0], &fit[0], record, nx.size(), 1);
+    EXPECT_EQ(outcome, static_cast<int>(FitOutcome::Converged));
+    EXPECT_GT(iterations, 0);
+    for (size_t param_idx = 0; param_idx < fit.size(); param_idx++) {
+        EXPECT_NEAR(fit[param_idx], truth[param_idx], 1e-4 * truth[param_idx]) << param_idx;
+    }
+}
+
+
+TEST(FIT, warm_chains_are_thread_independent)
+{
+    std::vector<double> nx(20, 5.0);
+    const size_t pop_cnt = 40;
+    const auto truth = SilerParameters(pop_cnt);
+    std::vector<double> mx(pop_cnt * nx.size());
+    HazardRates<SilerHazard>(&truth[0], &nx[0], &mx[0], nx.size(), pop_cnt,
+            HazardSample::Midpoint);
+    // Every population starts from the same rough guess.
+    std::vector<double> start;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        const double guess[] = {0.1, 0.5, 1e-4, 0.12, 1e-3};
+        start.insert(start.end(), guess, guess + 5);
+    }
+
+    std::vector<int> cold_iterations(pop_cnt), warm_iterations(pop_cnt);
+    std::vector<int> pooled_iterations(pop_cnt);
+    HazardFitRecord record;
+    auto cold = start;
+    record.iterations = &cold_iterations[0];
+    FitHazard<SilerHazard>(&mx[0], &nx[0], &cold[0], record, nx.size(), pop_cnt);
+    auto warm = start;
+    record.iterations = &warm_iterations[0];
+    FitHazard<SilerHazard>(&mx[0], &nx[0], &warm[0], record, nx.size(), pop_cnt, 10);
+    auto pooled = start;
+    record.iterations = &pooled_iterations[0];
+    ThreadPool pool(3);
+    FitHazard<SilerHazard>(&mx[0], &nx[0], &pooled[0], record, nx.size(), pop_cnt, pool, 10);
+
+    EXPECT_EQ(pooled, warm);
+    EXPECT_EQ(pooled_iterations, warm_iterations);
+    int cold_total = 0;
+    int warm_total = 0;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        cold_total += cold_iterations[pop_idx];
+        warm_total += warm_iterations[pop_idx];
+    }
+    EXPECT_LT(warm_total, cold_total);
+    for (size_t param_idx = 0; param_idx < warm.size(); param_idx++) {
+        EXPECT_NEAR(warm[param_idx], truth[param_idx], 1e-5 * truth[param_idx]);
+    }
+}
+
+
+TEST(FIT, unusable_start_fails)
+{
+    std::vector<float> nx(20, 5.0f);
+    std::vector<float> mx(20, 0.01f);
+    std::vector<float> parameters{0.2f, -1.0f, 2e-4f, 0.1f, 3e-3f};
+    const auto start = parameters;
+    int outcome = -1;
+    HazardFitRecord record;
+    record.outcome = &outcome;
+    FitHazard<SilerHazard>(&mx[0], &nx[0], &parameters[0], record, nx.size(), 1);
+    EXPECT_EQ(outcome, static_cast<int>(FitOutcome::Failed));
+    EXPECT_EQ(parameters, start);
+}
@@ -0,0 +1,152 @@
+#include <cmath>
+#include <numeric>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Siler mortality scaled from very low to very high, so that some
+// populations converge and some don't.
+void ScaledPopulations(std::vector<double>& mx, std::vector<double>& nx,
+        int age_cnt, size_t pop_cnt)
+{
+    nx.assign(age_cnt, 5.0);
+    mx = SilerRates(nx, pop_cnt, 0.1);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        const double scale = std::pow(10.0, -2.0 + 4.0 * pop_idx / pop_cnt);
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            mx[pop_idx * age_cnt + age_idx] *= scale;
+        }
+    }
+}
+
+
+struct Record {
+    explicit Record(size_t pop_cnt)
+        : iterations(pop_cnt, -1), difference(pop_cnt, -1), outcome(pop_cnt, -1),
+          seconds(pop_cnt, -1) {}
+
+    GraduationRecorder Recorder()
+    {
+        GraduationRecorder recorder;
+        recorder.iterations = &iterations[0];
+        recorder.difference = &difference[0];
+        recorder.outcome = &outcome[0];
+        recorder.seconds = &seconds[0];
+        return recorder;
+    }
+
+    std::vector<int> iterations;
+    std::vector<double> difference;
+    std::vector<int> outcome;
+    std::vector<double> seconds;
+};
+
+}
+
+
+TEST(GRADUATION_MONITOR, records_every_population)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 200;
+    std::vector<double> mx, nx;
+    ScaledPopulations(mx, nx, age_cnt, pop_cnt);
+    std::vector<double> ax_plain(mx.size()), ax_monitored(mx.size()), ax_constant(mx.size());
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &ax_constant[0], age_cnt, pop_cnt);
+
+    for (int steffen = 0; steffen < 2; steffen++) {
+        Record record(pop_cnt);
+        if (steffen) {
+            GraduationMethodSteffen(&mx[0], &nx[0], &ax_plain[0], age_cnt, pop_cnt);
+            GraduationMethodSteffen(&mx[0], &nx[0], &ax_monitored[0], age_cnt, pop_cnt,
+                    record.Recorder());
+        } else {
+            GraduationMethod(&mx[0], &nx[0], &ax_plain[0], age_cnt, pop_cnt);
+            GraduationMethod(&mx[0], &nx[0], &ax_monitored[0], age_cnt, pop_cnt,
+                    record.Recorder());
+        }
+        // Watching doesn't change the answer.
+        EXPECT_EQ(ax_plain, ax_monitored);
+
+        for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+            EXPECT_GE(record.iterations[pop_idx], 1);
+            EXPECT_LE(record.iterations[pop_idx], 20);
+            EXPECT_GE(record.difference[pop_idx], 0);
+            EXPECT_GE(record.seconds[pop_idx], 0);
+            auto outcome = static_cast<GraduationOutcome>(record.outcome[pop_idx]);
+            if (outcome == GraduationOutcome::Converged) {
+                EXPECT_LT(record.difference[pop_idx], 1e-5);
+            } else {
+                // Anything that didn't converge keeps constant-mortality ax.
+                for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+                    EXPECT_EQ(ax_monitored[pop_idx * age_cnt + age_idx],
+                            ax_constant[pop_idx * age_cnt + age_idx]);
+                }
+            }
+            if (outcome == GraduationOutcome::Fallback) {
+                EXPECT_EQ(record.iterations[pop_idx], 20);
+            }
+        }
+
+        auto summary = SummarizeGraduation(record.Recorder(), pop_cnt);
+        EXPECT_EQ(summary.converged_cnt + summary.diverged_cnt + summary.fallback_cnt, pop_cnt);
+        EXPECT_GT(summary.converged_cnt, 0u);
+        EXPECT_EQ(std::accumulate(summary.iteration_histogram.begin(),
+                summary.iteration_histogram.end(), size_t{0}), pop_cnt);
+        EXPECT_EQ(std::accumulate(summary.time_histogram.begin(),
+                summary.time_histogram.end(), size_t{0}), pop_cnt);
+        EXPECT_EQ(summary.max_seconds, record.seconds[summary.slowest_pop_idx]);
+        EXPECT_LE(summary.max_seconds, summary.total_seconds);
+    }
+}
+
+
+TEST(GRADUATION_MONITOR, parallel_matches_serial)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 257;
+    std::vector<double> mx, nx;
+    ScaledPopulations(mx, nx, age_cnt, pop_cnt);
+    std::vector<double> ax_serial(mx.size()), ax_parallel(mx.size());
+    ThreadPool pool(4);
+
+    Record serial(pop_cnt);
+    Record parallel(pop_cnt);
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax_serial[0], age_cnt, pop_cnt,
+            serial.Recorder());
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax_parallel[0], age_cnt, pop_cnt, pool,
+            parallel.Recorder());
+    EXPECT_EQ(ax_serial, ax_parallel);
+    EXPECT_EQ(serial.iterations, parallel.iterations);
+    EXPECT_EQ(serial.difference, parallel.difference);
+    EXPECT_EQ(serial.outcome, parallel.outcome);
+}
+
+
+TEST(GRADUATION_MONITOR, partial_records)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 10;
+    std::vector<double> mx, nx;
+    ScaledPopulations(mx, nx, age_cnt, pop_cnt);
+    std::vector<double> ax(mx.size());
+    std::vector<int> outcome(pop_cnt, -1);
+    GraduationRecorder recorder;
+    recorder.outcome = &outcome[0];
+    GraduationMethod(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt, recorder);
+    for (auto result: outcome) {
+        EXPECT_GE(result, 0);
+    }
+    auto summary = SummarizeGraduation(recorder, pop_cnt);
+    EXPECT_EQ(summary.converged_cnt + summary.diverged_cnt + summary.fallback_cnt, pop_cnt);
+    EXPECT_TRUE(summary.iteration_histogram.empty());
+    EXPECT_TRUE(summary.time_histogram.empty());
+}
@@ -0,0 +1,175 @@
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/hazards.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// The mean of a hazard over [x, x + n) by Simpson's rule in long double.
+double SimpsonAverage(const std::function<long double(long double)>& hazard, double x, double n,
+        int step_cnt)
+{
+    const long double h = static_cast<long double>(n) / step_cnt;
+    long double sum = hazard(x) + hazard(x + n);
+    for (int step_idx = 1; step_idx < step_cnt; step_idx++) {
+        sum += ((step_idx % 2) ? 4 : 2) * hazard(x + step_idx * h);
+    }
+    return static_cast<double>(sum * h / 3 / n);
+}
+
+
+// Each model's hazard, written out directly.
+long double Gompertz(const double* p, long double x)
+{
+    return p[0] * std::exp(p[1] * x);
+}
+
+
+long double Makeham(const double* p, long double x)
+{
+    return p[2] + Gompertz(p, x);
+}
+
+
+long double Siler(const double* p, long double x)
+{
+    return p[0] * std::exp(-p[1] * x) + p[2] * std::exp(p[3] * x) + p[4];
+}
+
+
+long double HeligmanPollard(const double* p, long double x)
+{
+    long double odds = std::pow(static_cast<long double>(p[0]), std::pow(x + p[1], p[2])) +
+            p[3] * std::exp(-p[4] * std::pow(std::log(x) - std::log(p[5]), 2)) +
+            p[6] * std::pow(static_cast<long double>(p[7]), x);
+    return std::log1p(odds);
+}
+
+
+// Checks every interval of two populations against Simpson's rule.
+template<template<typename> class HAZARD>
+void ExpectIntervalAverages(const std::vector<double>& parameters,
+        long double (*hazard)(const double*, long double), int step_cnt, double tolerance)
+{
+    const int count = HAZARD<double>::kParameterCount;
+    ASSERT_EQ(parameters.size(), size_t(2 * count));
+    auto nx = GbdWidths(std::numeric_limits<double>::infinity());
+    const int age_cnt = nx.size();
+    std::vector<double> mx(2 * age_cnt);
+    HazardRates<HAZARD>(&parameters[0], &nx[0], &mx[0], age_cnt, 2);
+
+    for (int pop_idx = 0; pop_idx < 2; pop_idx++) {
+        const double* p = &parameters[pop_idx * count];
+        double x = 0;
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            double expected;
+            if (std::isinf(nx[age_idx])) {
+                expected = static_cast<double>(hazard(p, x));
+            } else {
+                expected = SimpsonAverage(
+                        [=](long double t) { return hazard(p, t); }, x, nx[age_idx], step_cnt);
+            }
+            EXPECT_NEAR(mx[pop_idx * age_cnt + age_idx], expected, tolerance * expected)
+                    << pop_idx << " " << age_idx;
+            x += nx[age_idx];
+        }
+    }
+}
+
+}
+
+
+TEST(HAZARDS, siler_midpoint_matches_default)
+{
+    std::vector<double> nx(20, 5.0);
+    const size_t pop_cnt = 3;
+    std::vector<double> parameters;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        const double t = 10.0 * pop_idx;
+        const double siler[] = {
+                0.2 * std::exp(-0.015 * t), 1, 0.0002 * std::exp(-0.01 * t), 0.1,
+                0.003 * std::exp(-0.01 * t)};
+        parameters.insert(parameters.end(), siler, siler + 5);
+    }
+    std::vector<double> mx(pop_cnt * nx.size());
+    HazardRates<SilerHazard>(&parameters[0], &nx[0], &mx[0], nx.size(), pop_cnt,
+            HazardSample::Midpoint);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        for (size_t age_idx = 0; age_idx < nx.size(); age_idx++) {
+            const double expected = siler_default(5.0 * age_idx + 2.5, 10.0 * pop_idx);
+            EXPECT_NEAR(mx[pop_idx * nx.size() + age_idx], expected, 1e-14 * expected);
+        }
+    }
+}
+
+
+TEST(HAZARDS, interval_averages_match_quadrature)
+{
+    // The closed forms are exact, so only rounding separates them from a
+    // fine enough reference.
+    ExpectIntervalAverages<GompertzHazard>({5e-5, 0.09, 2e-4, 0.0}, Gompertz, 6000, 1e-13);
+    ExpectIntervalAverages<GompertzMakehamHazard>(
+            {5e-5, 0.09, 5e-4, 1e-4, 0.1, 0.0}, Makeham, 6000, 1e-13);
+    ExpectIntervalAverages<SilerHazard>(
+            {0.2, 1.0, 2e-4, 0.1, 3e-3, 0.05, 2.0, 1e-4, 0.08, 1e-3}, Siler, 6000, 1e-13);
+    ExpectIntervalAverages<HeligmanPollardHazard>(
+            {5.4e-4, 0.017, 0.101, 1.3e-4, 10.72, 18.67, 4.46e-5, 1.1011,
+             2e-3, 0.05, 0.12, 8e-4, 8.0, 21.0, 6e-5, 1.095}, HeligmanPollard, 2000, 1e-6);
+}
+
+TEST(HAZARDS, open_interval_from_birth_takes_hazard_at_zero)
+{
+    const std::vector<double> nx{std::numeric_limits<double>::infinity()};
+    const std::vector<double> gompertz{5e-5, 0.09};
+    const std::vector<double> siler{0.2, 1.0, 2e-4, 0.1, 3e-3};
+    const std::vector<double> heligman_pollard{
+            5.4e-4, 0.017, 0.101, 1.3e-4, 10.72, 18.67, 4.46e-5, 1.1011};
+    double mx;
+    HazardRates<GompertzHazard>(&gompertz[0], &nx[0], &mx, 1, 1);
+    EXPECT_DOUBLE_EQ(mx, 5e-5);
+    HazardRates<SilerHazard>(&siler[0], &nx[0], &mx, 1, 1);
+    EXPECT_DOUBLE_EQ(mx, 0.2 + 2e-4 + 3e-3);
+    for (auto sample: {HazardSample::IntervalAverage, HazardSample::Midpoint}) {
+        HazardRates<HeligmanPollardHazard>(&heligman_pollard[0], &nx[0], &mx, 1, 1, sample);
+        // Without the hump, which is zero at birth.
+        const double odds = std::pow(5.4e-4, std::pow(0.017, 0.101)) + 4.46e-5;
+        EXPECT_NEAR(mx, std::log1p(odds), 1e-13 * std::log1p(odds));
+    }
+}
+
+
+TEST(HAZARDS, float_and_threads)
+{
+    auto nx = GbdWidths(std::numeric_limits<double>::infinity());
+    const int age_cnt = nx.size();
+    const size_t pop_cnt = 101;
+    std::vector<double> parameters;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        const double heligman_pollard[] = {5.4e-4, 0.017, 0.101, 1.3e-4, 10.72,
+                                           18.67 + 0.01 * pop_idx, 4.46e-5, 1.1011};
+        parameters.insert(parameters.end(), heligman_pollard, heligman_pollard + 8);
+    }
+    std::vector<double> serial(pop_cnt * age_cnt), parallel(pop_cnt * age_cnt);
+    HazardRates<HeligmanPollardHazard>(&parameters[0], &nx[0], &serial[0], age_cnt, pop_cnt);
+    ThreadPool pool(4);
+    HazardRates<HeligmanPollardHazard>(&parameters[0], &nx[0], &parallel[0], age_cnt, pop_cnt,
+            pool);
+    EXPECT_EQ(parallel, serial);
+
+    std::vector<float> parameters_float(parameters.begin(), parameters.end());
+    std::vector<float> nx_float(nx.begin(), nx.end());
+    std::vector<float> single(pop_cnt * age_cnt);
+    HazardRates<HeligmanPollardHazard>(&parameters_float[0], &nx_float[0], &single[0],
+            age_cnt, pop_cnt);
+    for (size_t cmp_idx = 0; cmp_idx < serial.size(); cmp_idx++) {
+        EXPECT_NEAR(single[cmp_idx], serial[cmp_idx], 2e-5 * serial[cmp_idx]);
+    }
+}
@@ -0,0 +1,108 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/interleaved.hpp"
+#include "fundem/lifetable.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// A population count that leaves the last block partly empty.
+const size_t interleave_pop_cnt = 13;
+const int interleave_age_cnt = 20;
+
+void SilerInputs(std::vector<double>& mx, std::vector<double>& ax,
+        std::vector<double>& nx)
+{
+    const int age_cnt = interleave_age_cnt;
+    nx.assign(age_cnt, 5.0);
+    mx = SilerRates(nx, interleave_pop_cnt, 2.0);
+    ax.resize(mx.size());
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, interleave_pop_cnt);
+}
+
+}
+
+
+TEST(INTERLEAVED, round_trip)
+{
+    std::vector<double> mx, ax, nx;
+    SilerInputs(mx, ax, nx);
+    const size_t block_cnt = InterleavedBlockCount<4>(interleave_pop_cnt);
+    EXPECT_EQ(block_cnt, 4u);
+
+    std::vector<double> blocks(block_cnt * interleave_age_cnt * 4);
+    Interleave<4>(&mx[0], &blocks[0], interleave_age_cnt, interleave_pop_cnt);
+    // Population 5 is lane 1 of block 1.
+    EXPECT_EQ(blocks[(1 * interleave_age_cnt + 3) * 4 + 1],
+            mx[5 * interleave_age_cnt + 3]);
+
+    std::vector<double> back(mx.size());
+    Deinterleave<4>(&blocks[0], &back[0], interleave_age_cnt, interleave_pop_cnt);
+    EXPECT_EQ(back, mx);
+}
+
+
+TEST(INTERLEAVED, population_matches_row_major)
+{
+    std::vector<double> mx, ax, nx;
+    SilerInputs(mx, ax, nx);
+    const int age_cnt = interleave_age_cnt;
+    const size_t N = interleave_pop_cnt;
+
+    std::vector<double> lx(mx.size()), dx(mx.size());
+    FirstMomentPopulation(&mx[0], &ax[0], &nx[0], &lx[0], &dx[0], age_cnt, N);
+
+    const size_t block_cnt = InterleavedBlockCount<kInterleaveLanes>(N);
+    const size_t block_size = block_cnt * age_cnt * kInterleaveLanes;
+    std::vector<double> mx_block(block_size), ax_block(block_size);
+    std::vector<double> lx_block(block_size), dx_block(block_size);
+    Interleave<kInterleaveLanes>(&mx[0], &mx_block[0], age_cnt, N);
+    Interleave<kInterleaveLanes>(&ax[0], &ax_block[0], age_cnt, N);
+    FirstMomentPopulationInterleaved<kInterleaveLanes>(&mx_block[0], &ax_block[0],
+            &nx[0], &lx_block[0], &dx_block[0], age_cnt, block_cnt);
+
+    std::vector<double> lx_back(mx.size()), dx_back(mx.size());
+    Deinterleave<kInterleaveLanes>(&lx_block[0], &lx_back[0], age_cnt, N);
+    Deinterleave<kInterleaveLanes>(&dx_block[0], &dx_back[0], age_cnt, N);
+    for (size_t check_idx = 0; check_idx < mx.size(); check_idx++) {
+        EXPECT_DOUBLE_EQ(lx_back[check_idx], lx[check_idx]);
+        EXPECT_DOUBLE_EQ(dx_back[check_idx], dx[check_idx]);
+    }
+}
+
+
+TEST(INTERLEAVED, survival_and_life_expectancy_match_row_major)
+{
+    std::vector<double> mx, ax, nx;
+    SilerInputs(mx, ax, nx);
+    const int age_cnt = interleave_age_cnt;
+    const size_t N = interleave_pop_cnt;
+
+    std::vector<double> px(mx.size()), le(mx.size());
+    FirstMomentSurvival(&mx[0], &ax[0], &nx[0], &px[0], age_cnt, N);
+    FirstMomentPeriodLifeExpectancy(&mx[0], &ax[0], &nx[0], &le[0], age_cnt, N);
+
+    const size_t block_cnt = InterleavedBlockCount<4>(N);
+    const size_t block_size = block_cnt * age_cnt * 4;
+    std::vector<double> mx_block(block_size), ax_block(block_size);
+    std::vector<double> px_block(block_size), le_block(block_size);
+    Interleave<4>(&mx[0], &mx_block[0], age_cnt, N);
+    Interleave<4>(&ax[0], &ax_block[0], age_cnt, N);
+    ThreadPool pool(2);
+    FirstMomentSurvivalInterleaved<4>(&mx_block[0], &ax_block[0], &nx[0],
+            &px_block[0], age_cnt, block_cnt, pool);
+    FirstMomentPeriodLifeExpectancyInterleaved<4>(&mx_block[0], &ax_block[0],
+            &nx[0], &le_block[0], age_cnt, block_cnt, pool);
+
+    std::vector<double> px_back(mx.size()), le_back(mx.size());
+    Deinterleave<4>(&px_block[0], &px_back[0], age_cnt, N);
+    Deinterleave<4>(&le_block[0], &le_back[0], age_cnt, N);
+    for (size_t check_idx = 0; check_idx < mx.size(); check_idx++) {
+        EXPECT_DOUBLE_EQ(px_back[check_idx], px[check_idx]);
+        EXPECT_DOUBLE_EQ(le_back[check_idx], le[check_idx]);
+    }
+}
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 #include <ostream>
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
@@ -212,3 +214,147 @@ TEST(GRADUATION_STEFFEN_AGE_INCONSISTENT, graduation_steffen_age_inconsistent)
         EXPECT_LT(0, ax[check_idx]);
     }
 }
+
+
+
+/*! The fused lifetable should agree with the single-column kernels.
+ */
+TEST(FULL_LIFETABLE, matches_kernels)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 3;
+    std::vector<double> mx(age_cnt * pop_cnt);
+    std::vector<double> nx(age_cnt, 5.0);
+
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        double x = 0;
+        for (int mx_init = 0; mx_init < age_cnt; mx_init++) {
+            mx[pop_idx * age_cnt + mx_init] = siler_default(x + 0.5 * nx[mx_init], 10.0 * pop_idx);
+            x += nx[mx_init];
+        }
+    }
+    std::vector<double> ax(mx.size());
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt);
+
+    std::vector<double> px(mx.size()), lx(mx.size()), dx(mx.size()), le(mx.size());
+    FirstMomentSurvival(&mx[0], &ax[0], &nx[0], &px[0], age_cnt, pop_cnt);
+    FirstMomentPopulation(&mx[0], &ax[0], &nx[0], &lx[0], &dx[0], age_cnt, pop_cnt);
+    FirstMomentPeriodLifeExpectancy(&mx[0], &ax[0], &nx[0], &le[0], age_cnt, pop_cnt);
+
+    std::vector<double> qx_full(mx.size()), px_full(mx.size()), lx_full(mx.size());
+    std::vector<double> dx_full(mx.size()), Lx_full(mx.size()), Tx_full(mx.size());
+    std::vector<double> ex_full(mx.size());
+    LifeTableColumns<double> columns;
+    columns.qx = &qx_full[0];
+    columns.px = &px_full[0];
+    columns.lx = &lx_full[0];
+    columns.dx = &dx_full[0];
+    columns.Lx = &Lx_full[0];
+    columns.Tx = &Tx_full[0];
+    columns.ex = &ex_full[0];
+    FullLifeTable(&mx[0], &ax[0], &nx[0], columns, age_cnt, pop_cnt);
+
+    for (size_t check_idx = 0; check_idx < mx.size(); check_idx++) {
+        EXPECT_EQ(px_full[check_idx], px[check_idx]);
+        EXPECT_DOUBLE_EQ(qx_full[check_idx], 1 - px[check_idx]);
+        EXPECT_EQ(lx_full[check_idx], lx[check_idx]);
+        EXPECT_EQ(dx_full[check_idx], dx[check_idx]);
+        EXPECT_LT(std::abs(ex_full[check_idx] - le[check_idx]),
+                epsilon * std::abs(le[check_idx]));
+        EXPECT_DOUBLE_EQ(Tx_full[check_idx], ex_full[check_idx] * lx_full[check_idx]);
+    }
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        size_t last = pop_idx * age_cnt + age_cnt - 1;
+        EXPECT_EQ(le[last], ax[last]);
+        EXPECT_EQ(ex_full[last], ax[last]);
+        EXPECT_DOUBLE_EQ(Tx_full[pop_idx * age_cnt],
+                std::accumulate(&Lx_full[pop_idx * age_cnt], &Lx_full[last + 1], 0.0));
+    }
+}
+
+
+/*! Asking for one column without ax uses constant-mortality ax.
+ */
+TEST(FULL_LIFETABLE, single_column_constant_mortality)
+{
+    const int age_cnt = 20;
+    std::vector<double> mx(age_cnt);
+    std::vector<double> nx(age_cnt, 5.0);
+    double x = 0;
+    for (int mx_init = 0; mx_init < age_cnt; mx_init++) {
+        mx[mx_init] = siler_default(x + 0.5 * nx[mx_init], 0.0);
+        x += nx[mx_init];
+    }
+    std::vector<double> ax(age_cnt);
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, 1);
+    std::vector<double> le(age_cnt);
+    FirstMomentPeriodLifeExpectancy(&mx[0], &ax[0], &nx[0], &le[0], age_cnt, 1);
+
+    std::vector<double> ex(age_cnt);
+    LifeTableColumns<double> columns;
+    columns.ex = &ex[0];
+    FullLifeTable(&mx[0], static_cast<double*>(nullptr), &nx[0], columns, age_cnt, 1);
+    for (int check_idx = 0; check_idx < age_cnt; check_idx++) {
+        EXPECT_LT(std::abs(ex[check_idx] - le[check_idx]), epsilon * le[check_idx]);
+    }
+}
+
+
+/*! Float storage with double accumulation stays within float rounding
+ *  of the double lifetable, while float accumulation of lx drifts to
+ *  several times that error over 110 ages.
+ */
+TEST(FULL_LIFETABLE, mixed_precision)
+{
+    const int age_cnt = 110;
+    const size_t pop_cnt = 4;
+    std::vector<float> mx(age_cnt * pop_cnt);
+    std::vector<float> nx(age_cnt, 1.0f);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        for (int mx_init = 0; mx_init < age_cnt; mx_init++) {
+            mx[pop_idx * age_cnt + mx_init] = siler_default(mx_init + 0.5, 5.0 * pop_idx);
+        }
+    }
+    std::vector<float> ax(mx.size());
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt);
+    // The double lifetable sees exactly the same inputs.
+    std::vector<double> mxd(mx.begin(), mx.end()), axd(ax.begin(), ax.end());
+    std::vector<double> nxd(nx.begin(), nx.end());
+
+    std::vector<double> lx(mx.size()), Tx(mx.size());
+    LifeTableColumns<double> columns;
+    columns.lx = &lx[0];
+    columns.Tx = &Tx[0];
+    FullLifeTable(&mxd[0], &axd[0], &nxd[0], columns, age_cnt, pop_cnt);
+
+    std::vector<float> lx_mixed(mx.size()), Tx_mixed(mx.size());
+    LifeTableColumns<float> mixed_columns;
+    mixed_columns.lx = &lx_mixed[0];
+    mixed_columns.Tx = &Tx_mixed[0];
+    FullLifeTable<float, double>(&mx[0], &ax[0], &nx[0], mixed_columns, age_cnt, pop_cnt);
+
+    std::vector<float> lx_float(mx.size());
+    LifeTableColumns<float> float_columns;
+    float_columns.lx = &lx_float[0];
+    FullLifeTable<float, float>(&mx[0], &ax[0], &nx[0], float_columns, age_cnt, pop_cnt);
+
+    std::vector<float> le_mixed(mx.size());
+    std::vector<double> le(mx.size());
+    FirstMomentPeriodLifeExpectancy<float, double>(
+            &mx[0], &ax[0], &nx[0], &le_mixed[0], age_cnt, pop_cnt);
+    FirstMomentPeriodLifeExpectancy(&mxd[0], &axd[0], &nxd[0], &le[0], age_cnt, pop_cnt);
+
+    double mixed_error = 0;
+    double float_error = 0;
+    for (size_t check_idx = 0; check_idx < mx.size(); check_idx++) {
+        if (lx[check_idx] < 1e-6) {
+            continue;
+        }
+        mixed_error = std::max(mixed_error, std::abs(lx_mixed[check_idx] / lx[check_idx] - 1));
+        float_error = std::max(float_error, std::abs(lx_float[check_idx] / lx[check_idx] - 1));
+        EXPECT_NEAR(lx_mixed[check_idx], lx[check_idx], 2.5e-7 * lx[check_idx]);
+        EXPECT_NEAR(Tx_mixed[check_idx], Tx[check_idx], 2.5e-7 * Tx[check_idx]);
+        EXPECT_NEAR(le_mixed[check_idx], le[check_idx], 2.5e-7 * le[check_idx]);
+    }
+    EXPECT_GT(float_error, 2 * mixed_error);
+}
@@ -1,13 +1,14 @@
 import numpy as np
+import pytest
 
 from fundem import lifetable
 
 
 def test_first_moment_survival():
     N = 23
-    mx = np.full((N,), 0.1, dtype=np.float)
-    ax = np.full((N,), 2.5, dtype=np.float)
-    nx = np.full((N,), 5, dtype=np.float)
+    mx = np.full((N,), 0.1, dtype=np.float64)
+    ax = np.full((N,), 2.5, dtype=np.float64)
+    nx = np.full((N,), 5, dtype=np.float64)
     survival = lifetable.first_moment_survival(mx, ax, nx)
     assert len(survival) == N
     assert np.all(survival < 1.0)
@@ -16,10 +17,447 @@ def test_first_moment_survival():
 
 def test_multiple_survival():
     N = 23
-    mx = np.full((2, N), 0.1, dtype=np.float)
-    ax = np.full((2, N), 2.5, dtype=np.float)
-    nx = np.full((N,), 5, dtype=np.float)
+    mx = np.full((2, N), 0.1, dtype=np.float64)
+    ax = np.full((2, N), 2.5, dtype=np.float64)
+    nx = np.full((N,), 5, dtype=np.float64)
     survival = lifetable.first_moment_survival(mx, ax, nx)
     assert survival.size == mx.size
     assert np.all(survival < 1.0)
     assert np.all(survival > 0)
+
+
+def test_threads_match_serial():
+    N = 23
+    mx = np.linspace(0.001, 0.3, 500 * N).reshape((500, N))
+    ax = np.full((500, N), 2.5, dtype=np.float64)
+    nx = np.full((N,), 5, dtype=np.float64)
+    lx, dx = lifetable.first_moment_population(mx, ax, nx)
+    lx_threaded, dx_threaded = lifetable.first_moment_population(
+        mx, ax, nx, thread_cnt=4)
+    assert np.array_equal(lx, lx_threaded)
+    assert np.array_equal(dx, dx_threaded)
+
+
+def test_single_and_mixed_precision():
+    N = 23
+    mx = np.linspace(0.001, 0.3, 50 * N).reshape((50, N))
+    ax = np.full((50, N), 2.5, dtype=np.float64)
+    nx = np.full((N,), 5, dtype=np.float64)
+    lx, dx = lifetable.first_moment_population(mx, ax, nx)
+    arrays = [a.astype(np.float32) for a in (mx, ax, nx)]
+    lx_float, dx_float = lifetable.first_moment_population(*arrays)
+    lx_mixed, dx_mixed = lifetable.first_moment_population(
+        *arrays, mixed=True)
+    assert lx_float.dtype == np.float32
+    assert lx_mixed.dtype == np.float32
+    assert np.allclose(lx_float, lx, rtol=1e-5, atol=0)
+    assert np.allclose(lx_mixed, lx, rtol=1e-5, atol=0)
+
+    survival = lifetable.first_moment_survival(*arrays)
+    assert survival.dtype == np.float32
+
+
+def siler_inputs(pop_cnt, age_cnt=20):
+    nx = np.full((age_cnt,), 5.0)
+    age = 5.0 * np.arange(age_cnt) + 2.5
+    shift = np.linspace(0, 20, pop_cnt)[:, np.newaxis]
+    mx = 0.01 * np.exp(-age) + 0.0005 + 5e-5 * np.exp(0.09 * (age + shift))
+    return mx, nx
+
+
+def every_other_age(array):
+    """The same values at twice the age stride, which the library copies
+    around kernels that take whole arrays."""
+    wide = np.zeros(array.shape[:-1] + (2 * array.shape[-1],), dtype=array.dtype)
+    wide[..., ::2] = array
+    return wide[..., ::2]
+
+
+def test_every_kernel_is_reachable():
+    mx, nx = siler_inputs(7)
+    ax = lifetable.constant_mortality_mean_age(mx, nx)
+    assert np.all((ax > 0) & (ax < 2.5))
+    for graduate in (lifetable.graduation_method,
+                     lifetable.graduation_method_steffen):
+        graduated = graduate(mx, nx, thread_cnt=2)
+        assert graduated.shape == mx.shape
+        assert np.all((graduated > 0) & (graduated < 5))
+    le = lifetable.first_moment_period_life_expectancy(mx, ax, nx)
+    table = lifetable.full_lifetable(mx, nx, ax=ax)
+    assert set(table) == set(lifetable.LIFETABLE_COLUMNS)
+    assert np.allclose(table["ex"], le, rtol=1e-12)
+    assert np.array_equal(table["ax"], ax)
+
+
+def test_graduation_monitor():
+    mx, nx = siler_inputs(12)
+    mx = mx.reshape((3, 4, 20))
+    constant = lifetable.constant_mortality_mean_age(mx, nx)
+    for graduate in (lifetable.graduation_method,
+                     lifetable.graduation_method_steffen):
+        monitor = lifetable.GraduationMonitor()
+        ax = graduate(mx, nx, thread_cnt=2, monitor=monitor)
+        assert np.array_equal(ax, graduate(mx, nx))
+        assert monitor.iterations.shape == (3, 4)
+        assert np.all((monitor.iterations >= 1) & (monitor.iterations <= 20))
+        assert np.all(monitor.seconds >= 0)
+        converged = monitor.outcome == 0
+        assert np.all(monitor.difference[converged] < 1e-5)
+        assert np.array_equal(ax[~converged], constant[~converged])
+        summary = monitor.summary()
+        assert sum(summary[name] for name in monitor.OUTCOMES) == 12
+        assert summary["iteration_histogram"].sum() == 12
+        assert summary["time_histogram"].sum() == 12
+        assert summary["max_seconds"] == monitor.seconds[summary["slowest"]]
+    # Buckets match the C++ and R summaries, with under 2 ns in the first.
+    monitor.seconds.flat[:6] = 1.5e-9
+    monitor.seconds.flat[6:] = 3e-9
+    assert monitor.summary()["time_histogram"].tolist() == [6, 6]
+
+
+def test_cohort_lifetable():
+    year_cnt = 100
+    mx, nx = siler_inputs(year_cnt)
+    surface = np.stack([mx, 0.9 * mx])
+    table = lifetable.cohort_lifetable(surface, nx, thread_cnt=2)
+    assert set(table) == {"lx", "dx", "ex"}
+    assert table["ex"].shape == surface.shape
+    # Follow cohort 3 of the second population by hand.
+    offsets = np.floor(np.cumsum(nx) - nx / 2).astype(int)
+    offsets[-1] = int(nx[:-1].sum())
+    diagonal = surface[1, 3 + offsets, np.arange(nx.shape[0])]
+    expected = lifetable.full_lifetable(diagonal, nx, columns=["ex"])["ex"]
+    assert np.allclose(table["ex"][1, 3], expected, rtol=1e-14)
+    # Cohorts after 4 outlive the surface, which has no rates for them.
+    assert np.all(np.isnan(table["ex"][:, 5:]))
+    assert np.all(np.isfinite(table["lx"][:, 5:, 0]))
+    single = lifetable.cohort_lifetable(surface.astype(np.float32), nx,
+                                        columns=["ex"], mixed=True)
+    assert single["ex"].dtype == np.float32
+    assert np.allclose(single["ex"], table["ex"], rtol=1e-5, equal_nan=True)
+    ex_out = every_other_age(np.zeros_like(surface))
+    strided = lifetable.cohort_lifetable(every_other_age(surface), nx, columns=["lx"],
+                                         out={"ex": ex_out}, thread_cnt=2)
+    assert strided["ex"] is ex_out
+    assert np.array_equal(ex_out, table["ex"], equal_nan=True)
+    assert np.array_equal(strided["lx"], table["lx"], equal_nan=True)
+    with pytest.raises(ValueError, match="ax"):
+        lifetable.cohort_lifetable(surface, nx, ax=mx)
+    with pytest.raises(ValueError, match="ex output"):
+        lifetable.cohort_lifetable(surface, nx, out={"ex": mx})
+
+
+def test_adjoint_matches_differences():
+    mx, nx = siler_inputs(4)
+    ax = lifetable.constant_mortality_mean_age(mx, nx)
+    mx_grad, ax_grad = lifetable.first_moment_period_life_expectancy_adjoint(
+        mx, ax, nx, thread_cnt=2)
+    step = 1e-6 * mx[:, 6]
+    above, below = mx.copy(), mx.copy()
+    above[:, 6] += step
+    below[:, 6] -= step
+    e0 = [lifetable.first_moment_period_life_expectancy(m, ax, nx)[:, 0]
+          for m in (above, below)]
+    assert np.allclose(mx_grad[:, 6], (e0[0] - e0[1]) / (2 * step), rtol=1e-6)
+    assert ax_grad.shape == mx.shape
+
+    survival = np.zeros_like(mx)
+    survival[:, 10] = 1
+    mx_grad, _ = lifetable.first_moment_population_adjoint(
+        mx, ax, nx, lx_weights=survival)
+    assert np.all(mx_grad[:, :10] < 0)
+    assert np.all(mx_grad[:, 10:] == 0)
+
+
+def test_summarize_draws():
+    mx, nx = siler_inputs(6)
+    scale = 1 + 0.2 * np.sin(np.arange(200))[:, np.newaxis, np.newaxis]
+    draws = scale * mx
+    summary = lifetable.summarize_draws(draws, nx, columns=["ex", "lx"],
+                                        thread_cnt=2)
+    assert summary["ex"].shape == (6, 20, 4)
+    full = lifetable.full_lifetable(draws, nx, columns=["ex"])["ex"]
+    assert np.allclose(summary["ex"][..., 0], full.mean(axis=0), rtol=1e-12)
+    assert np.allclose(summary["ex"][..., 1], full.var(axis=0, ddof=1), rtol=1e-9)
+    assert np.allclose(summary["ex"][..., 2:],
+                       np.moveaxis(np.quantile(full, [0.025, 0.975], axis=0), 0, -1),
+                       rtol=1e-14)
+    with pytest.raises(RuntimeError, match="Quantiles"):
+        lifetable.summarize_draws(draws, nx, quantiles=(0.9, 0.1))
+    # Draws at twice the age stride, summarized into a strided out.
+    summary_out = every_other_age(np.zeros(summary["ex"].shape))
+    given = lifetable.summarize_draws(every_other_age(draws), nx, out={"ex": summary_out})
+    assert given["ex"] is summary_out
+    assert np.array_equal(summary_out, summary["ex"])
+    with pytest.raises(ValueError, match="ax"):
+        lifetable.summarize_draws(draws, nx, ax=mx)
+
+
+def test_scenario_lifetable():
+    mx, nx = siler_inputs(1)
+    base = mx[0]
+    ages = [0, 1, 2]
+    reduction = np.linspace(1, 0.5, 11)[:, np.newaxis]
+    scenario_mx = reduction * base[ages]
+    scenarios = lifetable.scenario_lifetable(base, nx, ages, scenario_mx,
+                                             columns=["ex", "lx"], thread_cnt=2)
+    assert scenarios["ex"].shape == (11, 20)
+    full_mx = np.tile(base, (11, 1))
+    full_mx[:, ages] = scenario_mx
+    full = lifetable.full_lifetable(full_mx, nx, columns=["ex", "lx"])
+    assert np.allclose(scenarios["ex"], full["ex"], rtol=1e-12)
+    assert np.allclose(scenarios["lx"], full["lx"], rtol=1e-12)
+    with pytest.raises(RuntimeError, match="outside"):
+        lifetable.scenario_lifetable(base, nx, [20], scenario_mx[:, :1])
+    ex_out = every_other_age(np.zeros_like(scenarios["ex"]))
+    given = lifetable.scenario_lifetable(every_other_age(base), nx, ages,
+                                         every_other_age(scenario_mx), out={"ex": ex_out})
+    assert given["ex"] is ex_out
+    assert np.array_equal(ex_out, scenarios["ex"])
+
+
+def test_expand_lifetable():
+    mx, nx = siler_inputs(3)
+    single = np.ones(96)
+    expanded = lifetable.expand_lifetable(mx, nx, single, columns=["lx", "dx", "ax"],
+                                          thread_cnt=2)
+    assert expanded["lx"].shape == (3, 96)
+    full = lifetable.full_lifetable(mx, nx, columns=["lx"])
+    assert np.allclose(expanded["lx"][:, ::5], full["lx"], rtol=1e-12)
+    assert np.all(expanded["dx"] >= 0)
+    single_mx = expanded["dx"] / (expanded["lx"] - expanded["dx"] * (1 - expanded["ax"]))
+    back = lifetable.expand_lifetable(single_mx, single, nx, ax=expanded["ax"],
+                                      columns=["lx"])
+    assert np.allclose(back["lx"], full["lx"], rtol=1e-12)
+    with pytest.raises(RuntimeError, match="open"):
+        lifetable.expand_lifetable(mx, nx, np.ones(91))
+    lx_out = every_other_age(np.zeros_like(expanded["lx"]))
+    given = lifetable.expand_lifetable(every_other_age(mx), nx, single, columns=[],
+                                       out={"lx": lx_out})
+    assert given["lx"] is lx_out
+    assert np.array_equal(lx_out, expanded["lx"])
+
+
+def test_cause_deleted_lifetable():
+    mx, nx = siler_inputs(3)
+    share = np.array([0.1, 0.3, 0.6])
+    cause_mx = mx[:, np.newaxis, :] * share[np.newaxis, :, np.newaxis]
+    tables = lifetable.cause_deleted_lifetable(
+        mx, nx, cause_mx, columns=["deleted_lx", "deleted_ex", "cause_lx"],
+        thread_cnt=2)
+    assert tables["deleted_ex"].shape == (3, 3, 20)
+    for cause_idx in range(3):
+        full = lifetable.full_lifetable(mx - cause_mx[:, cause_idx], nx,
+                                        columns=["lx", "ex"])
+        assert np.allclose(tables["deleted_lx"][:, cause_idx], full["lx"], rtol=1e-11)
+        assert np.allclose(tables["deleted_ex"][:, cause_idx], full["ex"], rtol=1e-11)
+    # Everyone alive at birth dies of some cause.
+    assert np.allclose(tables["cause_lx"][:, :, 0].sum(axis=1), 1)
+    with pytest.raises(RuntimeError, match="all-cause"):
+        lifetable.cause_deleted_lifetable(mx, nx, 2 * cause_mx)
+    deleted_out = every_other_age(np.zeros_like(cause_mx))
+    given = lifetable.cause_deleted_lifetable(
+        every_other_age(mx), nx, every_other_age(cause_mx), columns=[],
+        out={"deleted_ex": deleted_out})
+    assert given["deleted_ex"] is deleted_out
+    assert np.array_equal(deleted_out, tables["deleted_ex"])
+
+
+def test_project_population():
+    mx, nx = siler_inputs(3)
+    Lx = lifetable.full_lifetable(mx, nx, columns=["Lx"])["Lx"]
+    steps = np.repeat(mx[:, np.newaxis, :], 4, axis=1)
+    # A stationary population, b Lx with n b births a step, stays put.
+    stationary = lifetable.project_population(
+        1000 * Lx, nx, mx=steps, births=np.full((3, 4), 5000.0), thread_cnt=2)
+    assert stationary["population"].shape == (3, 4, 20)
+    assert np.allclose(stationary["population"], 1000 * Lx[:, np.newaxis, :], rtol=1e-10)
+
+    fertility = np.zeros_like(steps)
+    fertility[..., 3:10] = 0.04
+    projected = lifetable.project_population(
+        1000 * Lx, nx, mx=steps, fertility=fertility, birth_fraction=0.49)
+    given = lifetable.project_population(
+        1000 * Lx, nx, Lx=np.repeat(Lx[:, np.newaxis, :], 4, axis=1), fertility=fertility,
+        birth_fraction=0.49)
+    assert np.allclose(projected["population"], given["population"], rtol=1e-12)
+    assert np.all(projected["births"] > 0)
+    single = lifetable.project_population(
+        np.float32(1000 * Lx), nx, mx=steps, fertility=fertility, birth_fraction=0.49,
+        mixed=True)
+    assert single["population"].dtype == np.float32
+    assert np.allclose(single["population"], projected["population"], rtol=1e-5)
+    with pytest.raises(RuntimeError, match="equal width"):
+        lifetable.project_population(1000 * Lx, np.r_[1.0, nx[1:]], mx=steps)
+    with pytest.raises(ValueError):
+        lifetable.project_population(1000 * Lx, nx, mx=steps[:, 0])
+    with pytest.raises(ValueError, match="fertility"):
+        lifetable.project_population(1000 * Lx, nx, mx=steps, fertility=fertility[:, 0])
+    population_out = every_other_age(np.zeros_like(steps))
+    births_out = every_other_age(np.zeros((3, 4)))
+    given = lifetable.project_population(
+        every_other_age(1000 * Lx), nx, mx=every_other_age(steps),
+        births=every_other_age(np.full((3, 4), 5000.0)),
+        out={"population": population_out, "births": births_out})
+    assert given["population"] is population_out
+    assert np.array_equal(population_out, stationary["population"])
+    assert np.array_equal(births_out, stationary["births"])
+
+
+def test_ragged_lifetable():
+    five, nx = siler_inputs(3)
+    single = np.repeat(five, 5, axis=1) * 1.1
+    schemas = [nx, np.ones(100)]
+    schema = [0, 1, 1, 0, 0, 1]
+    rows = [five[0], single[0], single[1], five[1], five[2], single[2]]
+    mx = np.concatenate(rows)
+    ragged = lifetable.ragged_lifetable(mx, schema, schemas, columns=["ex", "lx"],
+                                        thread_cnt=2)
+    assert ragged["ex"].shape == mx.shape
+    splits = np.cumsum([schemas[s].size for s in schema])[:-1]
+    for row, s, ex in zip(rows, schema, np.split(ragged["ex"], splits)):
+        dense = lifetable.full_lifetable(row, schemas[s], columns=["ex"])["ex"]
+        assert np.array_equal(ex, dense)
+    ax = lifetable.ragged_graduation(mx, schema, schemas, thread_cnt=2)
+    for row, s, a in zip(rows, schema, np.split(ax, splits)):
+        assert np.array_equal(a, lifetable.graduation_method_steffen(row, schemas[s]))
+    with pytest.raises(ValueError, match="end to end"):
+        lifetable.ragged_lifetable(mx[1:], schema, schemas)
+    ex_out = every_other_age(np.zeros_like(mx))
+    given = lifetable.ragged_lifetable(every_other_age(mx), schema, schemas, columns=[],
+                                       out={"ex": ex_out})
+    assert given["ex"] is ex_out
+    assert np.array_equal(ex_out, ragged["ex"])
+    ax_out = every_other_age(np.zeros_like(mx))
+    assert lifetable.ragged_graduation(every_other_age(mx), schema, schemas,
+                                       out=ax_out) is ax_out
+    assert np.array_equal(ax_out, ax)
+
+
+def test_hazard_rates():
+    mx, nx = siler_inputs(3)
+    shift = np.linspace(0, 20, 3)
+    siler = np.stack([np.full(3, 0.01), np.ones(3), 5e-5 * np.exp(0.09 * shift),
+                      np.full(3, 0.09), np.full(3, 0.0005)], axis=-1)
+    midpoint = lifetable.hazard_rates("siler", siler, nx, midpoint=True,
+                                      thread_cnt=2)
+    assert np.allclose(midpoint, mx, rtol=1e-14)
+    # Interval averages give the hazard's survival exactly.
+    gompertz = np.array([[5e-5, 0.09]])
+    average = lifetable.hazard_rates("gompertz", gompertz, nx)
+    x = np.arange(20) * 5.0
+    cumulative = 5e-5 / 0.09 * (np.exp(0.09 * (x + 5)) - np.exp(0.09 * x))
+    assert np.allclose(average[0] * 5, cumulative, rtol=1e-13)
+    single = lifetable.hazard_rates("gompertz", gompertz.astype(np.float32), nx)
+    assert single.dtype == np.float32
+    with pytest.raises(ValueError, match="takes 8"):
+        lifetable.hazard_rates("heligman_pollard", gompertz, nx)
+    rates_out = np.zeros(midpoint.shape, order="F")
+    given = lifetable.hazard_rates("siler", np.asfortranarray(siler), nx, midpoint=True,
+                                   out=rates_out)
+    assert given is rates_out
+    assert np.array_equal(rates_out, midpoint)
+
+
+def test_fit_hazard():
+    mx, nx = siler_inputs(3)
+    shift = np.linspace(0, 20, 3)
+    siler = np.stack([np.full(3, 0.01), np.ones(3), 5e-5 * np.exp(0.09 * shift),
+                      np.full(3, 0.09), np.full(3, 0.0005)], axis=-1)
+    start = np.tile([0.02, 0.7, 1e-4, 0.08, 0.001], (3, 1))
+    fit = lifetable.fit_hazard("siler", mx, nx, start, chain_cnt=3, thread_cnt=2)
+    assert np.all(fit["outcome"] == lifetable.FIT_OUTCOMES.index("converged"))
+    assert np.allclose(fit["parameters"], siler, rtol=1e-6)
+    assert start[0, 0] == 0.02
+    with pytest.raises(ValueError, match="takes 2"):
+        lifetable.fit_hazard("gompertz", mx, nx, start)
+    # A Fortran-ordered start, fitted in place from strided rates.
+    in_place = np.asfortranarray(start)
+    given = lifetable.fit_hazard("siler", every_other_age(mx), nx, in_place, chain_cnt=3,
+                                 out=in_place)
+    assert given["parameters"] is in_place
+    assert np.array_equal(in_place, fit["parameters"])
+    with pytest.raises(ValueError, match="parameters output"):
+        lifetable.fit_hazard("siler", mx, nx, start, out=start.T)
+
+
+def test_strided_inputs_match_contiguous():
+    mx, nx = siler_inputs(9)
+    ax = lifetable.constant_mortality_mean_age(mx, nx)
+    lx, dx = lifetable.first_moment_population(mx, ax, nx)
+
+    # Every other population of a Fortran-ordered array, with nx reversed
+    # twice, isn't contiguous in any direction.
+    mx_wide = np.asfortranarray(np.repeat(mx, 2, axis=0))
+    ax_wide = np.asfortranarray(np.repeat(ax, 2, axis=0))
+    nx_wide = np.repeat(nx, 2)[::-2][::-1]
+    lx_out = np.zeros((18, 20), order="F")[::2]
+    dx_out = np.zeros((9, 40))[:, ::2]
+    lx_strided, dx_strided = lifetable.first_moment_population(
+        mx_wide[::2], ax_wide[::2], nx_wide, thread_cnt=3,
+        out=(lx_out, dx_out))
+    assert lx_strided is lx_out
+    assert dx_strided is dx_out
+    assert np.array_equal(lx_out, lx)
+    assert np.array_equal(dx_out, dx)
+
+
+def test_reversed_views_have_negative_strides():
+    mx, nx = siler_inputs(9)
+    table = lifetable.full_lifetable(mx, nx, columns=["lx", "ex"])
+    # Populations and ages both run backward in memory, in and out.
+    lx_out = np.zeros((9, 20))[::-1]
+    ex_out = np.zeros((9, 20))[:, ::-1]
+    reversed_table = lifetable.full_lifetable(
+        mx[::-1, ::-1][:, ::-1], nx[::-1][::-1], columns=["lx", "ex"],
+        thread_cnt=2, out={"lx": lx_out, "ex": ex_out})
+    assert reversed_table["lx"] is lx_out
+    assert np.array_equal(lx_out, table["lx"][::-1])
+    assert np.array_equal(ex_out, table["ex"][::-1])
+
+
+def test_leading_axes_collapse():
+    mx, nx = siler_inputs(12)
+    ax = lifetable.constant_mortality_mean_age(mx, nx)
+    survival = lifetable.first_moment_survival(mx, ax, nx)
+    cube = lifetable.first_moment_survival(
+        mx.reshape((3, 4, 20)), ax.reshape((3, 4, 20)), nx)
+    assert cube.shape == (3, 4, 20)
+    assert np.array_equal(cube.reshape((12, 20)), survival)
+    # Axes that don't collapse get copied.
+    swapped = lifetable.first_moment_survival(
+        mx.reshape((3, 4, 20)).swapaxes(0, 1),
+        ax.reshape((3, 4, 20)).swapaxes(0, 1), nx)
+    assert np.array_equal(swapped.swapaxes(0, 1).reshape((12, 20)), survival)
+
+
+def test_out_is_reused():
+    mx, nx = siler_inputs(5)
+    ax = lifetable.constant_mortality_mean_age(mx, nx)
+    out = np.empty_like(mx)
+    le = lifetable.first_moment_period_life_expectancy(mx, ax, nx, out=out)
+    assert le is out
+    with pytest.raises(ValueError):
+        lifetable.first_moment_period_life_expectancy(
+            mx, ax, nx, out=np.empty_like(mx, dtype=np.float32))
+    table = lifetable.full_lifetable(mx, nx, columns=["lx"],
+                                     out={"ex": np.empty_like(mx)})
+    assert set(table) == {"lx", "ex"}
+
+
+def test_shape_mismatches_raise_value_error():
+    mx, nx = siler_inputs(3)
+    ax = lifetable.constant_mortality_mean_age(mx, nx)
+    with pytest.raises(ValueError, match="ax"):
+        lifetable.first_moment_survival(mx, ax[:2], nx)
+    with pytest.raises(ValueError, match="age groups"):
+        lifetable.first_moment_survival(mx, ax, nx[:-1])
+    with pytest.raises(ValueError, match="lx_weights"):
+        lifetable.first_moment_population_adjoint(mx, ax, nx, lx_weights=ax[0])
+
+
+def test_errors_raise():
+    mx, nx = siler_inputs(3)
+    nx[2] = 4
+    with pytest.raises(RuntimeError, match="intervals must match"):
+        lifetable.graduation_method(mx, nx)
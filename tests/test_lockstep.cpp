@@ -0,0 +1,110 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/lockstep.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Siler mortality with multiplicative noise, like small-population draws,
+// so that some populations converge quickly, some slowly, and some fall back.
+std::vector<double> NoisySiler(const std::vector<double>& nx, size_t pop_cnt)
+{
+    const int age_cnt = nx.size();
+    auto mx = SilerRates(nx, pop_cnt, 1.0);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            mx[pop_idx * age_cnt + age_idx] *= 1 + 0.4 * std::sin(7.0 * pop_idx + 3.0 * age_idx);
+        }
+    }
+    return mx;
+}
+
+}
+
+
+TEST(LOCKSTEP, graduation_matches_scalar)
+{
+    std::vector<double> nx(20, 5.0);
+    const size_t pop_cnt = 21;
+    auto mx = NoisySiler(nx, pop_cnt);
+
+    std::vector<double> expected(mx.size()), ax(mx.size());
+    GraduationMethod(&mx[0], &nx[0], &expected[0], nx.size(), pop_cnt);
+    GraduationMethodLockstep(&mx[0], &nx[0], &ax[0], nx.size(), pop_cnt);
+    EXPECT_EQ(ax, expected);
+
+    std::vector<double> ax_four(mx.size());
+    ThreadPool pool(3);
+    GraduationMethodLockstep<double, 4>(&mx[0], &nx[0], &ax_four[0], nx.size(),
+            pop_cnt, pool);
+    EXPECT_EQ(ax_four, expected);
+}
+
+
+TEST(LOCKSTEP, graduation_requires_equal_intervals)
+{
+    std::vector<double> nx(20, 5.0);
+    nx[0] = 1;
+    auto mx = NoisySiler(nx, 2);
+    std::vector<double> ax(mx.size());
+    ASSERT_THROW(GraduationMethodLockstep(&mx[0], &nx[0], &ax[0], nx.size(), 2),
+            std::runtime_error);
+}
+
+
+TEST(LOCKSTEP, steffen_matches_scalar)
+{
+    std::vector<double> nx(23, 5.0);
+    nx[0] = 7.0/365.0;
+    nx[1] = 28.0/365.0;
+    nx[2] = (365 - 7 - 28) / 365.0;
+    nx[3] = 4;
+    const size_t pop_cnt = 37;
+    auto mx = NoisySiler(nx, pop_cnt);
+
+    std::vector<double> expected(mx.size()), ax(mx.size());
+    GraduationMethodSteffen(&mx[0], &nx[0], &expected[0], nx.size(), pop_cnt);
+    GraduationMethodSteffenLockstep(&mx[0], &nx[0], &ax[0], nx.size(), pop_cnt);
+    EXPECT_EQ(ax, expected);
+
+    std::vector<double> ax_parallel(mx.size());
+    ThreadPool pool(4);
+    GraduationMethodSteffenLockstep(&mx[0], &nx[0], &ax_parallel[0], nx.size(),
+            pop_cnt, pool);
+    EXPECT_EQ(ax_parallel, expected);
+}
+
+
+TEST(LOCKSTEP, iteration_is_plain_only)
+{
+    // The lockstep kernels take only the plain arguments, and they match
+    // the one-at-a-time kernels with plain iteration, whatever workspace
+    // and monitor those have.
+    typedef void (*Plain)(const double*, const double*, double*, int, size_t);
+    Plain lockstep = &GraduationMethodLockstep<double>;
+    Plain steffen_lockstep = &GraduationMethodSteffenLockstep<double>;
+
+    std::vector<double> nx(20, 5.0);
+    const size_t pop_cnt = 13;
+    auto mx = NoisySiler(nx, pop_cnt);
+    LifeTableWorkspace<double> workspace;
+    std::vector<int> iterations(pop_cnt);
+    GraduationRecorder recorder;
+    recorder.iterations = &iterations[0];
+    std::vector<double> expected(mx.size()), ax(mx.size());
+    GraduationMethod(&mx[0], &nx[0], &expected[0], nx.size(), pop_cnt, workspace, recorder,
+            GraduationIteration::Plain);
+    lockstep(&mx[0], &nx[0], &ax[0], nx.size(), pop_cnt);
+    EXPECT_EQ(ax, expected);
+    GraduationMethodSteffen(&mx[0], &nx[0], &expected[0], nx.size(), pop_cnt, workspace,
+            recorder, GraduationIteration::Plain);
+    steffen_lockstep(&mx[0], &nx[0], &ax[0], nx.size(), pop_cnt);
+    EXPECT_EQ(ax, expected);
+}
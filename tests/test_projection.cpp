@@ -0,0 +1,272 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/lifetable.hpp"
+#include "fundem/projection.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+const int kAgeCnt = 18;
+const double kWidth = 5.0;
+
+
+// Siler mortality that falls over the steps, in five-year groups.
+std::vector<double> SilerSteps(int step_cnt, size_t pop_cnt)
+{
+    const std::vector<double> nx(kAgeCnt, kWidth);
+    std::vector<double> mx;
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        // Each step is a population of the surface.
+        const auto steps = SilerRates(nx, step_cnt, kWidth, 3.0 * pop_idx);
+        mx.insert(mx.end(), steps.begin(), steps.end());
+    }
+    return mx;
+}
+
+
+// Fertility between ages 15 and 50, and migration that is negative for
+// some populations, both varying with step and population.
+void FertilityMigration(std::vector<double>& fertility, std::vector<double>& migration,
+        int step_cnt, size_t pop_cnt)
+{
+    fertility.assign(pop_cnt * step_cnt * kAgeCnt, 0.0);
+    migration.assign(pop_cnt * step_cnt * kAgeCnt, 0.0);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        for (int step_idx = 0; step_idx < step_cnt; step_idx++) {
+            const size_t row = (pop_idx * step_cnt + step_idx) * kAgeCnt;
+            for (int age_idx = 3; age_idx < 10; age_idx++) {
+                fertility[row + age_idx] = 0.05 * (1 + 0.1 * std::sin(pop_idx + step_idx)) *
+                        std::exp(-0.1 * (age_idx - 5) * (age_idx - 5));
+            }
+            for (int age_idx = 0; age_idx < kAgeCnt; age_idx++) {
+                migration[row + age_idx] = 10 * std::cos(0.7 * pop_idx + 0.3 * age_idx);
+            }
+        }
+    }
+}
+
+
+std::vector<double> StartingPopulation(size_t pop_cnt)
+{
+    std::vector<double> population(pop_cnt * kAgeCnt);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        for (int age_idx = 0; age_idx < kAgeCnt; age_idx++) {
+            population[pop_idx * kAgeCnt + age_idx] =
+                    1000 * std::exp(-0.03 * age_idx) * (1 + 0.05 * pop_idx);
+        }
+    }
+    return population;
+}
+
+}
+
+
+TEST(PROJECTION, stationary_population_stays_put)
+{
+    // A population of b L_x with n b births each step is stationary.
+    const int step_cnt = 5;
+    const double annual_births = 2000;
+    std::vector<double> nx(kAgeCnt, kWidth);
+    std::vector<double> mx = SilerSteps(1, 1);
+    std::vector<double> Lx(kAgeCnt);
+    LifeTableColumns<double> columns;
+    columns.Lx = &Lx[0];
+    FullLifeTable<double>(&mx[0], nullptr, &nx[0], columns, kAgeCnt, 1);
+
+    std::vector<double> population(kAgeCnt), repeated, births(step_cnt, kWidth * annual_births);
+    for (int age_idx = 0; age_idx < kAgeCnt; age_idx++) {
+        population[age_idx] = annual_births * Lx[age_idx];
+    }
+    for (int step_idx = 0; step_idx < step_cnt; step_idx++) {
+        repeated.insert(repeated.end(), mx.begin(), mx.end());
+    }
+    ProjectionRates<double> rates;
+    rates.mx = &repeated[0];
+    rates.births = &births[0];
+    std::vector<double> projected(step_cnt * kAgeCnt);
+    ProjectPopulation<double>(&population[0], rates, &nx[0], 1.0, &projected[0], nullptr,
+            kAgeCnt, step_cnt, 1);
+    for (int step_idx = 0; step_idx < step_cnt; step_idx++) {
+        for (int age_idx = 0; age_idx < kAgeCnt; age_idx++) {
+            EXPECT_NEAR(projected[step_idx * kAgeCnt + age_idx], population[age_idx],
+                    1e-9 * population[0]);
+        }
+    }
+}
+
+
+TEST(PROJECTION, matches_leslie_matrix)
+{
+    // More steps than a block and more populations than a group of lanes.
+    const int step_cnt = kProjectionStepBlock + 5;
+    const size_t pop_cnt = 7;
+    const double girls = 0.488;
+    std::vector<double> nx(kAgeCnt, kWidth);
+    std::vector<double> mx = SilerSteps(step_cnt, pop_cnt);
+    std::vector<double> fertility, migration;
+    FertilityMigration(fertility, migration, step_cnt, pop_cnt);
+    std::vector<double> population = StartingPopulation(pop_cnt);
+
+    ProjectionRates<double> rates;
+    rates.mx = &mx[0];
+    rates.fertility = &fertility[0];
+    rates.migration = &migration[0];
+    std::vector<double> projected(pop_cnt * step_cnt * kAgeCnt);
+    std::vector<double> births(pop_cnt * step_cnt);
+    ProjectPopulation<double>(&population[0], rates, &nx[0], girls, &projected[0], &births[0],
+            kAgeCnt, step_cnt, pop_cnt);
+
+    std::vector<double> Lx(mx.size());
+    LifeTableColumns<double> columns;
+    columns.Lx = &Lx[0];
+    FullLifeTable<double>(&mx[0], nullptr, &nx[0], columns, kAgeCnt, pop_cnt * step_cnt);
+    for (size_t pop_idx = 0; pop_idx < pop_cnt; pop_idx++) {
+        std::vector<double> now(&population[pop_idx * kAgeCnt],
+                &population[(pop_idx + 1) * kAgeCnt]);
+        for (int step_idx = 0; step_idx < step_cnt; step_idx++) {
+            const size_t row = (pop_idx * step_cnt + step_idx) * kAgeCnt;
+            const double* L = &Lx[row];
+            // The survival part of the Leslie matrix, with half of each
+            // age group's migrants surviving alongside its cohort.
+            std::vector<double> leslie(kAgeCnt * kAgeCnt, 0.0);
+            for (int age_idx = 1; age_idx < kAgeCnt - 1; age_idx++) {
+                leslie[age_idx * kAgeCnt + age_idx - 1] = L[age_idx] / L[age_idx - 1];
+            }
+            const double open = L[kAgeCnt - 1] / (L[kAgeCnt - 2] + L[kAgeCnt - 1]);
+            leslie[(kAgeCnt - 1) * kAgeCnt + kAgeCnt - 2] = open;
+            leslie[(kAgeCnt - 1) * kAgeCnt + kAgeCnt - 1] = open;
+            std::vector<double> next(kAgeCnt, 0.0);
+            for (int to_idx = 1; to_idx < kAgeCnt; to_idx++) {
+                for (int from_idx = 0; from_idx < kAgeCnt; from_idx++) {
+                    next[to_idx] += leslie[to_idx * kAgeCnt + from_idx] * now[from_idx];
+                }
+                const double early = 0.5 * migration[row + to_idx];
+                next[to_idx] += leslie[to_idx * kAgeCnt + to_idx - 1] * early + early;
+            }
+            double born = 0;
+            for (int age_idx = 1; age_idx < kAgeCnt; age_idx++) {
+                born += 0.5 * kWidth * fertility[row + age_idx] * (now[age_idx] + next[age_idx]);
+            }
+            next[0] = L[0] / kWidth * (girls * born + 0.5 * migration[row]) +
+                    0.5 * migration[row];
+
+            EXPECT_NEAR(births[pop_idx * step_cnt + step_idx], born, 1e-9 * born);
+            for (int age_idx = 0; age_idx < kAgeCnt; age_idx++) {
+                EXPECT_NEAR(projected[row + age_idx], next[age_idx], 1e-9 * population[0])
+                        << pop_idx << " " << step_idx << " " << age_idx;
+            }
+            now = next;
+        }
+    }
+}
+
+
+TEST(PROJECTION, person_years_stand_in_for_mortality)
+{
+    const int step_cnt = 4;
+    const size_t pop_cnt = 5;
+    std::vector<double> nx(kAgeCnt, kWidth);
+    std::vector<double> mx = SilerSteps(step_cnt, pop_cnt);
+    std::vector<double> fertility, migration;
+    FertilityMigration(fertility, migration, step_cnt, pop_cnt);
+    std::vector<double> population = StartingPopulation(pop_cnt);
+    std::vector<double> Lx(mx.size());
+    LifeTableColumns<double> columns;
+    columns.Lx = &Lx[0];
+    FullLifeTable<double>(&mx[0], nullptr, &nx[0], columns, kAgeCnt, pop_cnt * step_cnt);
+
+    ProjectionRates<double> rates;
+    rates.fertility = &fertility[0];
+    rates.migration = &migration[0];
+    rates.mx = &mx[0];
+    std::vector<double> from_mx(mx.size()), from_Lx(mx.size());
+    ProjectPopulation<double>(&population[0], rates, &nx[0], 0.5, &from_mx[0], nullptr,
+            kAgeCnt, step_cnt, pop_cnt);
+    rates.mx = nullptr;
+    rates.Lx = &Lx[0];
+    ProjectPopulation<double>(&population[0], rates, &nx[0], 0.5, &from_Lx[0], nullptr,
+            kAgeCnt, step_cnt, pop_cnt);
+    EXPECT_EQ(from_mx, from_Lx);
+
+    std::vector<double> ratios(Lx.size());
+    SurvivalRatios(&Lx[0], kWidth, &ratios[0], kAgeCnt, pop_cnt * step_cnt);
+    EXPECT_DOUBLE_EQ(ratios[0], Lx[0] / kWidth);
+    EXPECT_DOUBLE_EQ(ratios[3], Lx[3] / Lx[2]);
+}
+
+
+TEST(PROJECTION, parallel_and_precisions_match_serial)
+{
+    const int step_cnt = 20;
+    const size_t pop_cnt = 37;
+    std::vector<double> nx(kAgeCnt, kWidth);
+    std::vector<double> mx = SilerSteps(step_cnt, pop_cnt);
+    std::vector<double> fertility, migration;
+    FertilityMigration(fertility, migration, step_cnt, pop_cnt);
+    std::vector<double> population = StartingPopulation(pop_cnt);
+    ProjectionRates<double> rates;
+    rates.mx = &mx[0];
+    rates.fertility = &fertility[0];
+    rates.migration = &migration[0];
+
+    std::vector<double> serial(mx.size()), parallel(mx.size());
+    std::vector<double> births_serial(pop_cnt * step_cnt), births_parallel(pop_cnt * step_cnt);
+    ProjectPopulation<double>(&population[0], rates, &nx[0], 0.5, &serial[0],
+            &births_serial[0], kAgeCnt, step_cnt, pop_cnt);
+    ThreadPool pool(4);
+    ProjectPopulation<double>(&population[0], rates, &nx[0], 0.5, &parallel[0],
+            &births_parallel[0], kAgeCnt, step_cnt, pop_cnt, pool);
+    EXPECT_EQ(serial, parallel);
+    EXPECT_EQ(births_serial, births_parallel);
+
+    auto to_float = [](const std::vector<double>& values) {
+        return std::vector<float>(values.begin(), values.end());
+    };
+    std::vector<float> nx_f = to_float(nx), mx_f = to_float(mx);
+    std::vector<float> fertility_f = to_float(fertility), migration_f = to_float(migration);
+    std::vector<float> population_f = to_float(population);
+    ProjectionRates<float> rates_f;
+    rates_f.mx = &mx_f[0];
+    rates_f.fertility = &fertility_f[0];
+    rates_f.migration = &migration_f[0];
+    std::vector<float> single(mx.size()), mixed(mx.size());
+    ProjectPopulation<float>(&population_f[0], rates_f, &nx_f[0], 0.5f, &single[0], nullptr,
+            kAgeCnt, step_cnt, pop_cnt);
+    ProjectPopulation<float, double>(&population_f[0], rates_f, &nx_f[0], 0.5f, &mixed[0],
+            nullptr, kAgeCnt, step_cnt, pop_cnt);
+    double single_error = 0, mixed_error = 0;
+    for (size_t value_idx = 0; value_idx < serial.size(); value_idx++) {
+        const double scale = std::abs(serial[value_idx]) + 1;
+        single_error = std::max(single_error, std::abs(single[value_idx] - serial[value_idx]) /
+                scale);
+        mixed_error = std::max(mixed_error, std::abs(mixed[value_idx] - serial[value_idx]) /
+                scale);
+    }
+    EXPECT_LT(single_error, 1e-4);
+    EXPECT_LT(mixed_error, 1e-5);
+}
+
+
+TEST(PROJECTION, rejects_unequal_widths)
+{
+    std::vector<double> nx(kAgeCnt, kWidth);
+    nx[0] = 1;
+    std::vector<double> mx = SilerSteps(1, 1);
+    std::vector<double> population = StartingPopulation(1), projected(kAgeCnt);
+    ProjectionRates<double> rates;
+    rates.mx = &mx[0];
+    EXPECT_THROW(ProjectPopulation<double>(&population[0], rates, &nx[0], 1.0,
+            &projected[0], nullptr, kAgeCnt, 1, 1), std::invalid_argument);
+    // The open interval's width doesn't matter.
+    nx[0] = kWidth;
+    nx[kAgeCnt - 1] = 1;
+    EXPECT_NO_THROW(ProjectPopulation<double>(&population[0], rates, &nx[0], 1.0,
+            &projected[0], nullptr, kAgeCnt, 1, 1));
+}
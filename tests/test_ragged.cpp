@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/graduation_monitor.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/ragged.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Abridged five-year, neonatal-split, and single-year schemas, with
+// populations in no particular order, as they come from mixed sources.
+struct RaggedInputs {
+    RaggedInputs()
+    {
+        std::vector<std::vector<double>> schemas(3);
+        schemas[0].assign(20, 5.0);
+        schemas[1] = {7 / 365.0, 28 / 365.0, (365 - 7 - 28) / 365.0, 4};
+        schemas[1].resize(23, 5.0);
+        schemas[2].assign(101, 1.0);
+        nx_offsets.push_back(0);
+        for (const auto& widths: schemas) {
+            nx.insert(nx.end(), widths.begin(), widths.end());
+            nx_offsets.push_back(nx.size());
+        }
+        schema = {0, 0, 2, 1, 1, 1, 0, 2, 2, 1, 0, 0, 0, 2, 1, 0, 0, 1, 2, 0};
+        offsets.push_back(0);
+        for (size_t pop_idx = 0; pop_idx < schema.size(); pop_idx++) {
+            const auto rates = SilerRates(schemas[schema[pop_idx]], 1, 0.0, 1.5 * pop_idx);
+            mx.insert(mx.end(), rates.begin(), rates.end());
+            offsets.push_back(mx.size());
+        }
+        batch.offsets = &offsets[0];
+        batch.schema = &schema[0];
+        batch.nx = &nx[0];
+        batch.nx_offsets = &nx_offsets[0];
+        batch.N = schema.size();
+        batch.schema_cnt = schemas.size();
+    }
+
+    std::vector<double> nx;
+    std::vector<size_t> nx_offsets;
+    std::vector<int> schema;
+    std::vector<size_t> offsets;
+    std::vector<double> mx;
+    RaggedBatch<double> batch;
+};
+
+}
+
+
+TEST(RAGGED, lifetables_match_each_population)
+{
+    RaggedInputs in;
+    const size_t size = in.mx.size();
+    std::vector<double> ax(size), lx(size), ex(size), le(size);
+    LifeTableColumns<double> columns;
+    columns.ax = &ax[0];
+    columns.lx = &lx[0];
+    columns.ex = &ex[0];
+    FullLifeTableRagged(&in.mx[0], static_cast<const double*>(nullptr), columns, in.batch);
+    FirstMomentPeriodLifeExpectancyRagged(&in.mx[0], &ax[0], &le[0], in.batch);
+
+    for (size_t pop_idx = 0; pop_idx < in.batch.N; pop_idx++) {
+        const size_t offset = in.offsets[pop_idx];
+        const int age_cnt = in.batch.AgeCount(pop_idx);
+        std::vector<double> expected_lx(age_cnt), expected_ex(age_cnt);
+        LifeTableColumns<double> expected;
+        expected.lx = &expected_lx[0];
+        expected.ex = &expected_ex[0];
+        FullLifeTable(&in.mx[offset], static_cast<const double*>(nullptr),
+                in.batch.Widths(pop_idx), expected, age_cnt, 1);
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            EXPECT_EQ(lx[offset + age_idx], expected_lx[age_idx]);
+            EXPECT_EQ(ex[offset + age_idx], expected_ex[age_idx]);
+            EXPECT_NEAR(le[offset + age_idx], expected_ex[age_idx], 1e-10);
+        }
+    }
+}
+
+
+TEST(RAGGED, threads_match_serial)
+{
+    RaggedInputs in;
+    const size_t size = in.mx.size();
+    std::vector<double> serial(size), pooled(size), serial_ex(size), pooled_ex(size);
+    LifeTableWorkspace<double> workspace;
+    std::vector<LifeTableWorkspace<double>> workspaces;
+    std::vector<int> outcome(in.batch.N, -1);
+    GraduationRecorder recorder;
+    recorder.outcome = &outcome[0];
+    ThreadPool pool(3);
+
+    GraduationMethodSteffenRagged(&in.mx[0], &serial[0], in.batch, workspace);
+    GraduationMethodSteffenRagged(&in.mx[0], &pooled[0], in.batch, pool, workspaces,
+            recorder);
+    EXPECT_EQ(pooled, serial);
+    for (int pop_outcome: outcome) {
+        EXPECT_NE(pop_outcome, -1);
+    }
+    EXPECT_EQ(workspaces.size(), size_t(pool.ThreadCount()));
+
+    LifeTableColumns<double> serial_columns, pooled_columns;
+    serial_columns.ex = &serial_ex[0];
+    pooled_columns.ex = &pooled_ex[0];
+    FullLifeTableRagged(&in.mx[0], &serial[0], serial_columns, in.batch);
+    FullLifeTableRagged(&in.mx[0], &serial[0], pooled_columns, in.batch, pool);
+    EXPECT_EQ(pooled_ex, serial_ex);
+
+    // A population's Steffen ax is the same alone as in the batch.
+    const size_t pop_idx = 3;
+    std::vector<double> alone(in.batch.AgeCount(pop_idx));
+    GraduationMethodSteffen(&in.mx[in.offsets[pop_idx]], in.batch.Widths(pop_idx), &alone[0],
+            in.batch.AgeCount(pop_idx), 1);
+    EXPECT_TRUE(std::equal(alone.begin(), alone.end(), &serial[in.offsets[pop_idx]]));
+}
+
+
+TEST(RAGGED, nested_single_population_keeps_worker)
+{
+    // Each outer chunk runs one population at a time on the same pool,
+    // so the ragged call takes its one-chunk path inside a pool body and
+    // must use the outer worker's workspace.
+    RaggedInputs in;
+    const size_t size = in.mx.size();
+    std::vector<double> serial(size), nested(size);
+    LifeTableWorkspace<double> workspace;
+    GraduationMethodSteffenRagged(&in.mx[0], &serial[0], in.batch, workspace);
+
+    ThreadPool pool(4);
+    std::vector<LifeTableWorkspace<double>> workspaces(pool.ThreadCount());
+    std::atomic<bool> same_worker{true};
+    std::atomic<int> started{0};
+    pool.ParallelForWorker(in.batch.N, 1, [&](size_t begin, size_t end, int worker_idx) {
+        // The first chunks wait for one another, so every thread gets one.
+        started++;
+        while (started < pool.ThreadCount()) {
+            std::this_thread::yield();
+        }
+        for (size_t pop_idx = begin; pop_idx < end; pop_idx++) {
+            const size_t pop_offsets[2] = {0, size_t(in.batch.AgeCount(pop_idx))};
+            RaggedBatch<double> alone = in.batch;
+            alone.offsets = pop_offsets;
+            alone.schema = &in.schema[pop_idx];
+            alone.N = 1;
+            RaggedFor(alone, pool, [&](size_t, size_t, int inner_idx) {
+                same_worker = same_worker && (inner_idx == worker_idx);
+            });
+            GraduationMethodSteffenRagged(&in.mx[in.offsets[pop_idx]],
+                    &nested[in.offsets[pop_idx]], alone, pool, workspaces);
+        }
+    });
+    EXPECT_EQ(nested, serial);
+    EXPECT_TRUE(same_worker);
+}
+
+
+TEST(RAGGED, graduation_needs_uniform_schemas)
+{
+    RaggedInputs in;
+    std::vector<double> ax(in.mx.size());
+    LifeTableWorkspace<double> workspace;
+    EXPECT_THROW(GraduationMethodRagged(&in.mx[0], &ax[0], in.batch, workspace),
+            std::runtime_error);
+
+    // Without the neonatal schema, widths differ only between schemas.
+    std::vector<int> uniform(in.schema);
+    std::vector<size_t> offsets{0};
+    std::vector<double> mx;
+    for (size_t pop_idx = 0; pop_idx < in.batch.N; pop_idx++) {
+        if (1 != in.schema[pop_idx]) {
+            mx.insert(mx.end(), &in.mx[in.offsets[pop_idx]], &in.mx[in.offsets[pop_idx + 1]]);
+            offsets.push_back(mx.size());
+        }
+    }
+    uniform.erase(std::remove(uniform.begin(), uniform.end(), 1), uniform.end());
+    RaggedBatch<double> batch = in.batch;
+    batch.schema = &uniform[0];
+    batch.offsets = &offsets[0];
+    batch.N = uniform.size();
+    ax.resize(mx.size());
+    ThreadPool pool(2);
+    std::vector<LifeTableWorkspace<double>> workspaces;
+    GraduationMethodRagged(&mx[0], &ax[0], batch, pool, workspaces);
+    for (size_t pop_idx = 0; pop_idx < batch.N; pop_idx++) {
+        const double* widths = batch.Widths(pop_idx);
+        for (size_t value_idx = offsets[pop_idx]; value_idx < offsets[pop_idx + 1];
+                value_idx++) {
+            EXPECT_LT(0, ax[value_idx]);
+            EXPECT_LT(ax[value_idx], widths[value_idx - offsets[pop_idx]]);
+        }
+    }
+}
+
+
+TEST(RAGGED, inconsistent_offsets_throw)
+{
+    RaggedInputs in;
+    std::vector<double> ax(in.mx.size());
+    in.offsets[4] += 1;
+    EXPECT_THROW(ConstantMortalityMeanAgeRagged(&in.mx[0], &ax[0], in.batch),
+            std::invalid_argument);
+    in.offsets[4] -= 1;
+    in.schema[2] = 3;
+    EXPECT_THROW(ConstantMortalityMeanAgeRagged(&in.mx[0], &ax[0], in.batch),
+            std::invalid_argument);
+}
@@ -0,0 +1,160 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/lifetable.hpp"
+#include "fundem/scenario.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Compares every column of the scenario with a full lifetable on `mx`.
+void ExpectFullLifeTable(const ScenarioLifeTable<double>& scenario,
+        const std::vector<double>& mx, const std::vector<double>& nx)
+{
+    const size_t age_cnt = nx.size();
+    std::vector<std::vector<double>> expected(8, std::vector<double>(age_cnt));
+    std::vector<std::vector<double>> actual(8, std::vector<double>(age_cnt));
+    LifeTableColumns<double> expected_columns, actual_columns;
+    double** expected_pointers[] = {&expected_columns.ax, &expected_columns.qx,
+            &expected_columns.px, &expected_columns.lx, &expected_columns.dx,
+            &expected_columns.Lx, &expected_columns.Tx, &expected_columns.ex};
+    double** actual_pointers[] = {&actual_columns.ax, &actual_columns.qx,
+            &actual_columns.px, &actual_columns.lx, &actual_columns.dx,
+            &actual_columns.Lx, &actual_columns.Tx, &actual_columns.ex};
+    for (int column_idx = 0; column_idx < 8; column_idx++) {
+        *expected_pointers[column_idx] = &expected[column_idx][0];
+        *actual_pointers[column_idx] = &actual[column_idx][0];
+    }
+    FullLifeTable(&mx[0], static_cast<const double*>(nullptr), &nx[0], expected_columns,
+            age_cnt, 1);
+    scenario.Write(actual_columns);
+    for (int column_idx = 0; column_idx < 8; column_idx++) {
+        for (size_t age_idx = 0; age_idx < age_cnt; age_idx++) {
+            const double want = expected[column_idx][age_idx];
+            EXPECT_NEAR(actual[column_idx][age_idx], want, 1e-12 * (1 + std::abs(want)))
+                    << "column " << column_idx << " age " << age_idx;
+        }
+    }
+    EXPECT_DOUBLE_EQ(scenario.LifeExpectancy(0), expected[7][0]);
+}
+
+}
+
+
+TEST(SCENARIO, base_matches_full_lifetable)
+{
+    const auto nx = GbdWidths<double>();
+    const auto mx = SilerRates(nx, 1, 0.0);
+    ScenarioLifeTable<double> scenario(&mx[0], nullptr, &nx[0], nx.size());
+    ExpectFullLifeTable(scenario, mx, nx);
+}
+
+
+TEST(SCENARIO, sparse_changes_match_full_lifetable)
+{
+    const auto nx = GbdWidths<double>();
+    const auto base = SilerRates(nx, 1, 0.0);
+    ScenarioLifeTable<double> scenario(&base[0], nullptr, &nx[0], nx.size());
+    // Under-5 mortality, one adult age, the open interval, and all
+    // of them out of order with a repeat.
+    const std::vector<std::vector<int>> age_sets{
+            {0, 1, 2, 3}, {12}, {22}, {15, 0, 15, 7}, {}};
+    for (const auto& ages: age_sets) {
+        auto mx = base;
+        std::vector<double> changed;
+        for (size_t change_idx = 0; change_idx < ages.size(); change_idx++) {
+            changed.push_back(0.9 * base[ages[change_idx]] - 1e-5 * change_idx);
+            mx[ages[change_idx]] = changed.back();
+        }
+        scenario.Apply(ages.empty() ? nullptr : &ages[0],
+                changed.empty() ? nullptr : &changed[0], nullptr, ages.size());
+        ExpectFullLifeTable(scenario, mx, nx);
+    }
+    scenario.Reset();
+    ExpectFullLifeTable(scenario, base, nx);
+}
+
+
+TEST(SCENARIO, rebase_stacks_scenarios)
+{
+    const auto nx = GbdWidths<double>();
+    auto mx = SilerRates(nx, 1, 0.0);
+    ScenarioLifeTable<double> scenario(&mx[0], nullptr, &nx[0], nx.size());
+    const int first[] = {2, 5};
+    const double first_mx[] = {0.5 * mx[2], 0.5 * mx[5]};
+    scenario.Apply(first, first_mx, nullptr, 2);
+    scenario.Rebase();
+    mx[2] = first_mx[0];
+    mx[5] = first_mx[1];
+    const int second[] = {10};
+    const double second_mx[] = {2 * mx[10]};
+    scenario.Apply(second, second_mx, nullptr, 1);
+    mx[10] = second_mx[0];
+    ExpectFullLifeTable(scenario, mx, nx);
+
+    const int outside[] = {23};
+    EXPECT_THROW(scenario.Apply(outside, second_mx, nullptr, 1), std::out_of_range);
+}
+
+
+TEST(SCENARIO, survivors_return_where_base_has_none)
+{
+    const auto nx = GbdWidths<double>();
+    auto mx = SilerRates(nx, 1, 0.0);
+    const double siler_mx = mx[12];
+    mx[12] = 100;
+    std::vector<double> base_lx(nx.size());
+    LifeTableColumns<double> base_columns;
+    base_columns.lx = &base_lx[0];
+    FullLifeTable(&mx[0], static_cast<const double*>(nullptr), &nx[0], base_columns,
+            nx.size(), 1);
+    ASSERT_EQ(base_lx[13], 0);
+
+    ScenarioLifeTable<double> scenario(&mx[0], nullptr, &nx[0], nx.size());
+    const int ages[] = {12, 3};
+    const double changed[] = {siler_mx, 0.5 * mx[3]};
+    scenario.Apply(ages, changed, nullptr, 2);
+    mx[12] = changed[0];
+    mx[3] = changed[1];
+    ExpectFullLifeTable(scenario, mx, nx);
+    EXPECT_GT(scenario.Survivors(22), 0);
+}
+
+
+TEST(SCENARIO, batches_match_one_at_a_time)
+{
+    const auto nx = GbdWidths<double>();
+    const auto base = SilerRates(nx, 1, 0.0);
+    const int age_cnt = nx.size();
+    const std::vector<int> ages{0, 1, 2, 3};
+    const size_t scenario_cnt = 50;
+    std::vector<double> scenario_mx;
+    for (size_t scenario_idx = 0; scenario_idx < scenario_cnt; scenario_idx++) {
+        for (int age: ages) {
+            scenario_mx.push_back(base[age] * (1 - 0.01 * scenario_idx));
+        }
+    }
+    std::vector<double> ex(scenario_cnt * age_cnt), lx(scenario_cnt * age_cnt);
+    LifeTableColumns<double> columns;
+    columns.ex = &ex[0];
+    columns.lx = &lx[0];
+    ThreadPool pool(3);
+    ScenarioLifeTables(&base[0], static_cast<const double*>(nullptr), &nx[0], &ages[0],
+            &scenario_mx[0], columns, age_cnt, ages.size(), scenario_cnt, pool);
+
+    ScenarioLifeTable<double> scenario(&base[0], nullptr, &nx[0], age_cnt);
+    for (size_t scenario_idx = 0; scenario_idx < scenario_cnt; scenario_idx++) {
+        scenario.Apply(&ages[0], &scenario_mx[scenario_idx * ages.size()], nullptr, ages.size());
+        for (int age_idx = 0; age_idx < age_cnt; age_idx++) {
+            EXPECT_EQ(ex[scenario_idx * age_cnt + age_idx], scenario.LifeExpectancy(age_idx));
+            EXPECT_EQ(lx[scenario_idx * age_cnt + age_idx], scenario.Survivors(age_idx));
+        }
+    }
+    // Lower child mortality raises life expectancy at birth.
+    EXPECT_GT(ex[(scenario_cnt - 1) * age_cnt], ex[0]);
+}
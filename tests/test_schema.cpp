@@ -0,0 +1,132 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/lifetable.hpp"
+#include "fundem/schema.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Tells which specialization the dispatcher picked.
+struct SchemaProbe {
+    int* age_cnt;
+    int* width;
+
+    template<int AGE_CNT, int WIDTH>
+    void Run() const
+    {
+        *age_cnt = AGE_CNT;
+        *width = WIDTH;
+    }
+};
+
+
+// Equal values, where float lx that underflows to zero makes a NaN ex
+// in both.
+template<typename REAL>
+void ExpectIdentical(const std::vector<REAL>& actual, const std::vector<REAL>& expected)
+{
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t idx = 0; idx < actual.size(); idx++) {
+        if (!(std::isnan(actual[idx]) && std::isnan(expected[idx]))) {
+            EXPECT_EQ(actual[idx], expected[idx]) << "at " << idx;
+        }
+    }
+}
+
+
+// Every kernel, dispatched, matches the generic kernel exactly.
+template<typename REAL, typename ACCUM>
+void ExpectSameAsGeneric(const std::vector<REAL>& nx)
+{
+    const int age_cnt = nx.size();
+    const size_t pop_cnt = 7;
+    const size_t cnt = pop_cnt * age_cnt;
+    auto mx = SilerRates(nx, pop_cnt, 3.0);
+    std::vector<REAL> ax(cnt);
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &ax[0], age_cnt, pop_cnt);
+
+    std::vector<REAL> expected(cnt), actual(cnt);
+    FirstMomentSurvival(&mx[0], &ax[0], &nx[0], &expected[0], age_cnt, pop_cnt);
+    FirstMomentSurvivalDispatch(&mx[0], &ax[0], &nx[0], &actual[0], age_cnt, pop_cnt);
+    ExpectIdentical(actual, expected);
+
+    std::vector<REAL> expected_dx(cnt), actual_dx(cnt);
+    FirstMomentPopulation<REAL, ACCUM>(&mx[0], &ax[0], &nx[0], &expected[0], &expected_dx[0],
+            age_cnt, pop_cnt);
+    FirstMomentPopulationDispatch<REAL, ACCUM>(&mx[0], &ax[0], &nx[0], &actual[0], &actual_dx[0],
+            age_cnt, pop_cnt);
+    ExpectIdentical(actual, expected);
+    ExpectIdentical(actual_dx, expected_dx);
+
+    FirstMomentPeriodLifeExpectancy<REAL, ACCUM>(&mx[0], &ax[0], &nx[0], &expected[0],
+            age_cnt, pop_cnt);
+    FirstMomentPeriodLifeExpectancyDispatch<REAL, ACCUM>(&mx[0], &ax[0], &nx[0], &actual[0],
+            age_cnt, pop_cnt);
+    ExpectIdentical(actual, expected);
+
+    // Only some columns, so the rest come from scratch rows.
+    std::vector<REAL> expected_Tx(cnt), actual_Tx(cnt);
+    LifeTableColumns<REAL> expected_columns, actual_columns;
+    expected_columns.ex = &expected[0];
+    expected_columns.Tx = &expected_Tx[0];
+    actual_columns.ex = &actual[0];
+    actual_columns.Tx = &actual_Tx[0];
+    FullLifeTable<REAL, ACCUM>(&mx[0], nullptr, &nx[0], expected_columns, age_cnt, pop_cnt);
+    ThreadPool pool(3);
+    FullLifeTableDispatch<REAL, ACCUM>(&mx[0], nullptr, &nx[0], actual_columns, age_cnt,
+            pop_cnt, pool);
+    ExpectIdentical(actual, expected);
+    ExpectIdentical(actual_Tx, expected_Tx);
+}
+
+}
+
+
+TEST(Schema, dispatch_picks_specialization)
+{
+    int age_cnt = -1;
+    int width = -1;
+    const SchemaProbe probe{&age_cnt, &width};
+
+    std::vector<double> five(20, 5.0);
+    EXPECT_TRUE(DispatchAgeSchema(&five[0], 20, probe));
+    EXPECT_EQ(age_cnt, 20);
+    EXPECT_EQ(width, 5);
+
+    auto gbd = GbdWidths<double>();
+    EXPECT_TRUE(DispatchAgeSchema(&gbd[0], 23, probe));
+    EXPECT_EQ(age_cnt, 23);
+    EXPECT_EQ(width, 0);
+
+    std::vector<float> single(111, 1.0f);
+    EXPECT_TRUE(DispatchAgeSchema(&single[0], 111, probe));
+    EXPECT_EQ(width, 1);
+    single[110] = 9;
+    EXPECT_TRUE(DispatchAgeSchema(&single[0], 111, probe));
+    EXPECT_EQ(age_cnt, 111);
+    EXPECT_EQ(width, 0);
+
+    std::vector<double> other(19, 5.0);
+    age_cnt = -1;
+    EXPECT_FALSE(DispatchAgeSchema(&other[0], 19, probe));
+    EXPECT_EQ(age_cnt, -1);
+}
+
+
+TEST(Schema, specializations_match_generic)
+{
+    ExpectSameAsGeneric<double, double>(std::vector<double>(20, 5.0));
+    ExpectSameAsGeneric<double, double>(GbdWidths<double>());
+    ExpectSameAsGeneric<double, double>(std::vector<double>(111, 1.0));
+    ExpectSameAsGeneric<double, double>(std::vector<double>(14, 5.0));
+    ExpectSameAsGeneric<float, float>(std::vector<float>(20, 5.0f));
+    ExpectSameAsGeneric<float, float>(GbdWidths<float>());
+    ExpectSameAsGeneric<float, double>(std::vector<float>(111, 1.0f));
+    ExpectSameAsGeneric<float, double>(GbdWidths<float>());
+}
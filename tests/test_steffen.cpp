@@ -0,0 +1,141 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/steffen.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+/*! Interval averages computed the way GSL's steffen.c builds its cubic,
+ *  then integrated with Simpson's rule, which is exact for cubics.
+ */
+std::vector<double> ReferenceAverages(const std::vector<double>& x,
+        const std::vector<double>& y)
+{
+    const size_t size = x.size();
+    auto sign = [](double value) { return std::copysign(1.0, value); };
+    std::vector<double> y_prime(size);
+    y_prime[0] = (y[1] - y[0]) / (x[1] - x[0]);
+    for (size_t i = 1; i < size - 1; i++) {
+        double hi = x[i + 1] - x[i];
+        double him1 = x[i] - x[i - 1];
+        double si = (y[i + 1] - y[i]) / hi;
+        double sim1 = (y[i] - y[i - 1]) / him1;
+        double pi = (sim1 * hi + si * him1) / (him1 + hi);
+        y_prime[i] = (sign(sim1) + sign(si)) *
+                std::min(std::abs(sim1), std::min(std::abs(si), 0.5 * std::abs(pi)));
+    }
+    y_prime[size - 1] = (y[size - 1] - y[size - 2]) / (x[size - 1] - x[size - 2]);
+
+    std::vector<double> average(size - 1);
+    for (size_t i = 0; i < size - 1; i++) {
+        double h = x[i + 1] - x[i];
+        double s = (y[i + 1] - y[i]) / h;
+        double a = (y_prime[i] + y_prime[i + 1] - 2 * s) / (h * h);
+        double b = (3 * s - 2 * y_prime[i] - y_prime[i + 1]) / h;
+        auto cubic = [&](double dx) {
+            return ((a * dx + b) * dx + y_prime[i]) * dx + y[i];
+        };
+        average[i] = (cubic(0) + 4 * cubic(0.5 * h) + cubic(h)) / 6;
+    }
+    return average;
+}
+
+
+// Survivorship from Siler mortality on the GBD age groups.
+void SilerSurvivorship(std::vector<double>& x, std::vector<double>& y)
+{
+    std::vector<double> nx(23, 5.0);
+    nx[0] = 7.0 / 365.0;
+    nx[1] = 28.0 / 365.0;
+    nx[2] = (365 - 7 - 28) / 365.0;
+    nx[3] = 4;
+    const auto mx = SilerRates(nx, 1, 0.0);
+    x.assign(24, 0.0);
+    y.assign(24, 1.0);
+    for (int age_idx = 0; age_idx < 23; age_idx++) {
+        x[age_idx + 1] = x[age_idx] + nx[age_idx];
+        y[age_idx + 1] = y[age_idx] * std::exp(-mx[age_idx] * nx[age_idx]);
+    }
+}
+
+}
+
+
+TEST(STEFFEN, linear_is_exact)
+{
+    std::vector<double> x{0, 1, 1.5, 4, 9, 10};
+    std::vector<double> y(x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        y[i] = 3 - 0.25 * x[i];
+    }
+    SteffenSpline<double> spline(&x[0], x.size());
+    std::vector<double> average(x.size() - 1);
+    spline.IntervalAverages(&y[0], &average[0]);
+    for (size_t i = 0; i < average.size(); i++) {
+        EXPECT_NEAR(average[i], 3 - 0.125 * (x[i] + x[i + 1]), 1e-14);
+    }
+}
+
+
+TEST(STEFFEN, matches_reference)
+{
+    std::vector<double> x, y;
+    SilerSurvivorship(x, y);
+    SteffenSpline<double> spline(&x[0], x.size());
+    std::vector<double> average(x.size() - 1);
+    spline.IntervalAverages(&y[0], &average[0]);
+
+    auto expected = ReferenceAverages(x, y);
+    for (size_t i = 0; i < average.size(); i++) {
+        EXPECT_NEAR(average[i], expected[i], 1e-14);
+        // Monotone data give a monotone interpolant.
+        EXPECT_LE(average[i], y[i]);
+        EXPECT_GE(average[i], y[i + 1]);
+    }
+}
+
+
+TEST(STEFFEN, single_precision)
+{
+    std::vector<double> x, y;
+    SilerSurvivorship(x, y);
+    std::vector<float> xf(x.begin(), x.end()), yf(y.begin(), y.end());
+    SteffenSpline<float> spline(&xf[0], xf.size());
+    std::vector<float> average(xf.size() - 1);
+    spline.IntervalAverages(&yf[0], &average[0]);
+
+    auto expected = ReferenceAverages(x, y);
+    for (size_t i = 0; i < average.size(); i++) {
+        EXPECT_NEAR(average[i], expected[i], 1e-6);
+    }
+}
+
+
+TEST(STEFFEN, negative_zero_slope_takes_sign_bit)
+{
+    // Survivors that reach zero, with secants of -0, where the sign bit
+    // decides Steffen's limiter as GSL's copysign does.
+    std::vector<double> x{0, 1, 2, 3, 4, 5};
+    std::vector<double> y{1, 0.5, 0.0, -0.0, -0.0, 0.0};
+    SteffenSpline<double> spline(&x[0], x.size());
+    std::vector<double> average(x.size() - 1);
+    spline.IntervalAverages(&y[0], &average[0]);
+    auto expected = ReferenceAverages(x, y);
+
+    typedef Lanes<double, 4> V;
+    std::vector<V> y_lanes, average_lanes(x.size() - 1);
+    for (double value: y) {
+        y_lanes.push_back(V::Broadcast(value));
+    }
+    spline.IntervalAverages(&y_lanes[0], &average_lanes[0]);
+    for (size_t i = 0; i < average.size(); i++) {
+        EXPECT_EQ(average[i], expected[i]);
+        EXPECT_EQ(std::signbit(average[i]), std::signbit(expected[i])) << i;
+        EXPECT_EQ(std::signbit(average_lanes[i][0]), std::signbit(expected[i])) << i;
+    }
+}
@@ -0,0 +1,127 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/lifetable.hpp"
+#include "fundem/streaming.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+namespace {
+
+const int stream_age_cnt = 20;
+
+std::string TempPath(const std::string& name)
+{
+    return ::testing::TempDir() + "fundem_stream_" + name;
+}
+
+
+// Writes Siler mortality to a file of the given shape and returns it.
+std::vector<double> WriteSiler(const std::string& path, const std::vector<size_t>& shape,
+        bool npy)
+{
+    auto file = MappedArray<double>::Create(path, shape, npy);
+    const std::vector<double> nx(stream_age_cnt, 5.0);
+    const auto mx = SilerRates(nx, file.Size() / stream_age_cnt, 0.7);
+    std::copy(mx.begin(), mx.end(), file.Data());
+    return mx;
+}
+
+
+std::vector<double> ReadAll(const std::string& path)
+{
+    auto file = MappedArray<double>::Open(path);
+    return std::vector<double>(file.Data(), file.Data() + file.Size());
+}
+
+}
+
+
+TEST(STREAMING, npy_round_trip)
+{
+    const std::string path = TempPath("round_trip.npy");
+    {
+        auto file = MappedArray<float>::Create(path, {3, 4, 5}, true);
+        for (size_t value_idx = 0; value_idx < file.Size(); value_idx++) {
+            file.Data()[value_idx] = 0.5f * value_idx;
+        }
+    }
+    auto file = MappedArray<float>::Open(path);
+    EXPECT_TRUE(file.IsNpy());
+    EXPECT_EQ(file.Shape(), (std::vector<size_t>{3, 4, 5}));
+    // NumPy puts the data on a 64-byte boundary.
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(file.Data()) % 64, 0u);
+    EXPECT_EQ(file.Data()[59], 29.5f);
+    EXPECT_THROW(MappedArray<double>::Open(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+
+TEST(STREAMING, matches_in_memory)
+{
+    // 21 populations in chunks of two leave a short last chunk.
+    const std::vector<size_t> shape{7, 3, stream_age_cnt};
+    const std::string mx_path = TempPath("mx.npy");
+    auto mx = WriteSiler(mx_path, shape, true);
+    const size_t pop_cnt = mx.size() / stream_age_cnt;
+    std::vector<double> nx(stream_age_cnt, 5.0);
+
+    LifeTableFiles files;
+    files.mx = mx_path;
+    files.ax = TempPath("ax.npy");
+    files.lx = TempPath("lx.npy");
+    files.ex = TempPath("ex.npy");
+    // mx, three outputs, and scratch dx, for the current and next chunk.
+    const size_t limit = 2 * 2 * 5 * stream_age_cnt * sizeof(double);
+    ThreadPool pool(3);
+    StreamLifeTable(files, &nx[0], stream_age_cnt, MeanAgeMethod::Graduation, limit, pool);
+
+    std::vector<double> ax(mx.size()), lx(mx.size()), dx(mx.size()), ex(mx.size());
+    GraduationMethod(&mx[0], &nx[0], &ax[0], stream_age_cnt, pop_cnt);
+    FirstMomentPopulation(&mx[0], &ax[0], &nx[0], &lx[0], &dx[0], stream_age_cnt, pop_cnt);
+    FirstMomentPeriodLifeExpectancy(&mx[0], &ax[0], &nx[0], &ex[0], stream_age_cnt, pop_cnt);
+
+    EXPECT_EQ(ReadAll(files.ax), ax);
+    EXPECT_EQ(ReadAll(files.lx), lx);
+    EXPECT_EQ(ReadAll(files.ex), ex);
+    EXPECT_EQ(MappedArray<double>::Open(files.ex).Shape(), shape);
+    for (auto path: {files.mx, files.ax, files.lx, files.ex}) {
+        std::remove(path.c_str());
+    }
+}
+
+
+TEST(STREAMING, raw_files)
+{
+    const std::string mx_path = TempPath("mx.raw");
+    auto mx = WriteSiler(mx_path, {5 * stream_age_cnt}, false);
+    std::vector<double> nx(stream_age_cnt, 5.0);
+    nx[0] = 1;
+    nx[1] = 4;
+
+    LifeTableFiles files;
+    files.mx = mx_path;
+    files.dx = TempPath("dx.raw");
+    ThreadPool pool(2);
+    StreamLifeTable(files, &nx[0], stream_age_cnt, MeanAgeMethod::GraduationSteffen,
+            size_t{1} << 20, pool);
+
+    std::vector<double> ax(mx.size()), lx(mx.size()), dx(mx.size());
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax[0], stream_age_cnt, 5);
+    FirstMomentPopulation(&mx[0], &ax[0], &nx[0], &lx[0], &dx[0], stream_age_cnt, 5);
+    auto streamed = MappedArray<double>::Open(files.dx);
+    EXPECT_FALSE(streamed.IsNpy());
+    EXPECT_EQ(std::vector<double>(streamed.Data(), streamed.Data() + streamed.Size()), dx);
+
+    EXPECT_THROW(StreamLifeTable(files, &nx[0], stream_age_cnt,
+            MeanAgeMethod::ConstantMortality, 100, pool), std::runtime_error);
+    EXPECT_THROW(StreamLifeTable(files, &nx[0], 19,
+            MeanAgeMethod::ConstantMortality, size_t{1} << 20, pool), std::runtime_error);
+    std::remove(mx_path.c_str());
+    std::remove(files.dx.c_str());
+}
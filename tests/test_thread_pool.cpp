@@ -0,0 +1,145 @@
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+using namespace fundem;
+
+
+TEST(THREAD_POOL, covers_every_population_once)
+{
+    ThreadPool pool(4);
+    const size_t N = 1001;
+    std::vector<std::atomic<int>> visits(N);
+    for (auto& visit: visits) {
+        visit = 0;
+    }
+    pool.ParallelFor(N, 7, [&visits](size_t begin, size_t end) {
+        for (size_t idx = begin; idx < end; idx++) {
+            visits[idx]++;
+        }
+    });
+    for (size_t check_idx = 0; check_idx < N; check_idx++) {
+        EXPECT_EQ(visits[check_idx], 1);
+    }
+}
+
+
+TEST(THREAD_POOL, rethrows_from_worker)
+{
+    ThreadPool pool(3);
+    ASSERT_THROW(pool.ParallelFor(100, 1, [](size_t begin, size_t) {
+        if (begin == 57) {
+            throw std::runtime_error("population 57");
+        }
+    }), std::runtime_error);
+
+    // The pool is still usable afterwards.
+    std::atomic<size_t> total{0};
+    pool.ParallelFor(100, 1, [&total](size_t begin, size_t end) {
+        total += end - begin;
+    });
+    EXPECT_EQ(total, 100u);
+}
+
+
+TEST(THREAD_POOL, nested_call_runs_inline)
+{
+    // Each outer chunk calls a kernel's pool overload on the same pool,
+    // which would wait forever for the outer job if it queued.
+    const int age_cnt = 20;
+    const size_t pop_cnt = 64;
+    std::vector<double> nx(age_cnt, 5.0);
+    auto mx = SilerRates(nx, pop_cnt, 0.1);
+    std::vector<double> serial(mx.size()), nested(mx.size());
+    ConstantMortalityMeanAge(&mx[0], &nx[0], &serial[0], age_cnt, pop_cnt);
+
+    ThreadPool pool(4);
+    std::atomic<bool> same_worker{true};
+    std::atomic<int> started{0};
+    pool.ParallelForWorker(pop_cnt, 16, [&](size_t begin, size_t end, int worker_idx) {
+        // Hold each chunk until all four run, so every thread gets one.
+        started++;
+        while (started < pool.ThreadCount()) {
+            std::this_thread::yield();
+        }
+        const size_t offset = begin * age_cnt;
+        ConstantMortalityMeanAge(&mx[offset], &nx[0], &nested[offset], age_cnt,
+                end - begin, pool);
+        pool.ParallelForWorker(age_cnt, 1, [&](size_t, size_t, int inner_idx) {
+            same_worker = same_worker && (inner_idx == worker_idx);
+        });
+        // A single population takes the serial path, which must still
+        // keep the caller's worker index.
+        pool.ParallelForWorker(1, 0, [&](size_t, size_t, int inner_idx) {
+            same_worker = same_worker && (inner_idx == worker_idx);
+        });
+    });
+    EXPECT_EQ(serial, nested);
+    EXPECT_TRUE(same_worker);
+}
+
+
+TEST(THREAD_POOL, kernels_match_serial)
+{
+    const int age_cnt = 20;
+    const size_t pop_cnt = 257;
+    std::vector<double> nx(age_cnt, 5.0);
+    auto mx = SilerRates(nx, pop_cnt, 0.1);
+    ThreadPool pool(4);
+
+    std::vector<double> ax_serial(mx.size()), ax_parallel(mx.size());
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax_serial[0], age_cnt, pop_cnt);
+    GraduationMethodSteffen(&mx[0], &nx[0], &ax_parallel[0], age_cnt, pop_cnt, pool);
+    EXPECT_EQ(ax_serial, ax_parallel);
+
+    GraduationMethod(&mx[0], &nx[0], &ax_serial[0], age_cnt, pop_cnt);
+    GraduationMethod(&mx[0], &nx[0], &ax_parallel[0], age_cnt, pop_cnt, pool);
+    EXPECT_EQ(ax_serial, ax_parallel);
+
+    const auto& ax = ax_serial;
+    std::vector<double> lx_serial(mx.size()), dx_serial(mx.size());
+    std::vector<double> lx_parallel(mx.size()), dx_parallel(mx.size());
+    FirstMomentPopulation(&mx[0], &ax[0], &nx[0], &lx_serial[0], &dx_serial[0],
+            age_cnt, pop_cnt);
+    FirstMomentPopulation(&mx[0], &ax[0], &nx[0], &lx_parallel[0], &dx_parallel[0],
+            age_cnt, pop_cnt, pool);
+    EXPECT_EQ(lx_serial, lx_parallel);
+    EXPECT_EQ(dx_serial, dx_parallel);
+
+    std::vector<double> le_serial(mx.size()), le_parallel(mx.size());
+    FirstMomentPeriodLifeExpectancy(&mx[0], &ax[0], &nx[0], &le_serial[0],
+            age_cnt, pop_cnt);
+    FirstMomentPeriodLifeExpectancy(&mx[0], &ax[0], &nx[0], &le_parallel[0],
+            age_cnt, pop_cnt, pool);
+    EXPECT_EQ(le_serial, le_parallel);
+}
+
+
+TEST(THREAD_POOL, graduation_error_reaches_caller)
+{
+    const int age_cnt = 23;
+    std::vector<double> nx(age_cnt, 5.0);
+    auto mx = SilerRates(nx, 64, 0.1);
+    nx[0] = 1.0;
+    std::vector<double> ax(mx.size());
+    ThreadPool pool(4);
+    ASSERT_THROW(GraduationMethod(&mx[0], &nx[0], &ax[0], age_cnt, 64, pool),
+            std::runtime_error);
+}
+
+
+TEST(THREAD_POOL, shared_pools_persist_per_thread_count)
+{
+    auto two = SharedThreadPool(2);
+    auto three = SharedThreadPool(3);
+    EXPECT_EQ(two->ThreadCount(), 2);
+    EXPECT_EQ(three->ThreadCount(), 3);
+    EXPECT_EQ(SharedThreadPool(2), two);
+    EXPECT_EQ(SharedThreadPool(3), three);
+}
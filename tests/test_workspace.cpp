@@ -0,0 +1,167 @@
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "gtest/gtest.h"
+#include "fundem/cohort.hpp"
+#include "fundem/lifetable.hpp"
+#include "fundem/thread_pool.hpp"
+#include "siler_rates.hpp"
+
+
+// Counts heap allocations on threads that ask for it. This replaces
+// operator new for the whole test program, but counts nothing until
+// a test turns counting on. GCC inlines the replacements and then
+// sees free() on memory from new, which is what they intend.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+thread_local bool counting = false;
+thread_local size_t allocation_cnt = 0;
+}
+
+
+void* operator new(std::size_t size)
+{
+    if (counting) {
+        allocation_cnt++;
+    }
+    void* memory = std::malloc((size > 0) ? size : 1);
+    if (nullptr == memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+using namespace fundem;
+
+
+namespace {
+
+// Allocations that `body` makes on this thread.
+template<typename FUNC>
+size_t CountAllocations(FUNC body)
+{
+    allocation_cnt = 0;
+    counting = true;
+    body();
+    counting = false;
+    return allocation_cnt;
+}
+
+}
+
+
+TEST(WORKSPACE, steady_state_calls_do_not_allocate)
+{
+    std::vector<double> five(20, 5.0);
+    const auto gbd = GbdWidths<double>();
+    const size_t pop_cnt = 4;
+    auto mx_five = SilerRates(five, pop_cnt, 2.0);
+    auto mx_gbd = SilerRates(gbd, pop_cnt, 2.0);
+    std::vector<double> ax(pop_cnt * gbd.size()), ex(pop_cnt * gbd.size());
+    LifeTableColumns<double> columns;
+    columns.ex = &ex[0];
+
+    LifeTableWorkspace<double> workspace(23);
+    auto calls = [&]() {
+        GraduationMethod(&mx_five[0], &five[0], &ax[0], five.size(), pop_cnt, workspace);
+        GraduationMethodSteffen(&mx_gbd[0], &gbd[0], &ax[0], gbd.size(), pop_cnt, workspace);
+        GraduationMethodSteffen(&mx_five[0], &five[0], &ax[0], five.size(), pop_cnt,
+                workspace);
+        FullLifeTable(&mx_gbd[0], static_cast<const double*>(nullptr), &gbd[0], columns,
+                gbd.size(), pop_cnt, workspace);
+    };
+    // A reserved workspace doesn't allocate even on its first call.
+    EXPECT_EQ(CountAllocations(calls), 0u);
+    EXPECT_EQ(CountAllocations(calls), 0u);
+    // The wrappers without a workspace do.
+    EXPECT_GT(CountAllocations([&]() {
+        GraduationMethod(&mx_five[0], &five[0], &ax[0], five.size(), pop_cnt);
+    }), 0u);
+}
+
+
+TEST(WORKSPACE, cohort_blocks_reuse_gathered_rows)
+{
+    std::vector<double> five(20, 5.0);
+    const int year_cnt = 30;
+    auto mx = SilerRates(five, year_cnt, 1.0);
+    std::vector<double> ex(mx.size());
+    LifeTableColumns<double> columns;
+    columns.ex = &ex[0];
+    const auto year_offsets = CohortYearOffsets(&five[0], five.size());
+    const size_t block_cnt = (year_cnt + kCohortBlock - 1) / kCohortBlock;
+
+    LifeTableWorkspace<double> workspace;
+    auto blocks = [&]() {
+        CohortLifeTableBlocks(&mx[0], &mx[0], &five[0], columns, five.size(), year_cnt,
+                year_offsets, 0, block_cnt, workspace);
+    };
+    blocks();
+    EXPECT_EQ(CountAllocations(blocks), 0u);
+}
+
+
+TEST(WORKSPACE, results_match_wrappers)
+{
+    const auto gbd = GbdWidths<double>();
+    std::vector<double> five(20, 5.0);
+    const size_t pop_cnt = 33;
+    auto mx_gbd = SilerRates(gbd, pop_cnt, 2.0);
+    auto mx_five = SilerRates(five, pop_cnt, 2.0);
+
+    // One workspace across kernels and grids, then many per thread.
+    LifeTableWorkspace<double> workspace;
+    std::vector<LifeTableWorkspace<double>> workspaces;
+    ThreadPool pool(3);
+    for (int repeat_idx = 0; repeat_idx < 2; repeat_idx++) {
+        std::vector<double> expected(mx_five.size()), actual(mx_five.size());
+        GraduationMethod(&mx_five[0], &five[0], &expected[0], five.size(), pop_cnt);
+        GraduationMethod(&mx_five[0], &five[0], &actual[0], five.size(), pop_cnt, workspace);
+        EXPECT_EQ(actual, expected);
+        GraduationMethod(&mx_five[0], &five[0], &actual[0], five.size(), pop_cnt, pool,
+                workspaces);
+        EXPECT_EQ(actual, expected);
+
+        GraduationMethodSteffen(&mx_five[0], &five[0], &expected[0], five.size(), pop_cnt);
+        GraduationMethodSteffen(&mx_five[0], &five[0], &actual[0], five.size(), pop_cnt,
+                workspace);
+        EXPECT_EQ(actual, expected);
+
+        expected.resize(mx_gbd.size());
+        actual.resize(mx_gbd.size());
+        GraduationMethodSteffen(&mx_gbd[0], &gbd[0], &expected[0], gbd.size(), pop_cnt);
+        GraduationMethodSteffen(&mx_gbd[0], &gbd[0], &actual[0], gbd.size(), pop_cnt, pool,
+                workspaces);
+        EXPECT_EQ(actual, expected);
+
+        std::vector<double> expected_lx(mx_gbd.size()), actual_lx(mx_gbd.size());
+        LifeTableColumns<double> expected_columns, actual_columns;
+        expected_columns.ex = &expected[0];
+        expected_columns.lx = &expected_lx[0];
+        actual_columns.ex = &actual[0];
+        actual_columns.lx = &actual_lx[0];
+        FullLifeTable(&mx_gbd[0], static_cast<const double*>(nullptr), &gbd[0],
+                expected_columns, gbd.size(), pop_cnt);
+        FullLifeTable(&mx_gbd[0], static_cast<const double*>(nullptr), &gbd[0],
+                actual_columns, gbd.size(), pop_cnt, pool, workspaces);
+        EXPECT_EQ(actual, expected);
+        EXPECT_EQ(actual_lx, expected_lx);
+    }
+    EXPECT_EQ(workspaces.size(), size_t(pool.ThreadCount()));
+}